@@ -0,0 +1,105 @@
+-- Draws llay.new_render_batches() output with Raylib.
+--
+-- Raylib already queues shapes into one vertex buffer and only flushes it (one GPU
+-- draw call) when the texture or scissor changes, so a rectangle followed by text
+-- followed by a rectangle costs three draws. Walking batches instead of commands
+-- keeps every rectangle of a batch, and every glyph of a text batch, in one flush.
+--
+-- Usage:
+--   local draw_batches = require("batch_draw")
+--   local batches = llay.new_render_batches()
+--   batches:build(llay.end_layout())
+--   local draws = draw_batches(batches, custom_fn)  -- custom_fn(batches, instance)
+
+local ffi = require("ffi")
+local llay = require("init")
+
+local RenderCommandType = llay.RenderCommandType
+
+local temp_rect = ffi.new("Rectangle")
+local temp_color = ffi.new("Color")
+local scissor_stack = {}
+
+local function set_instance(batches, i)
+	local o = i * 4
+	temp_rect.x = batches.rect[o]
+	temp_rect.y = batches.rect[o + 1]
+	temp_rect.width = batches.rect[o + 2]
+	temp_rect.height = batches.rect[o + 3]
+	temp_color.r = batches.color[o]
+	temp_color.g = batches.color[o + 1]
+	temp_color.b = batches.color[o + 2]
+	temp_color.a = batches.color[o + 3]
+end
+
+-- Raylib takes the largest corner as a 0-1 roundness of the shorter side
+local function roundness(batches, i)
+	local o = i * 4
+	local radius = math.max(batches.radius[o], batches.radius[o + 1], batches.radius[o + 2], batches.radius[o + 3])
+	local short = math.min(batches.rect[o + 2], batches.rect[o + 3])
+	if radius <= 0 or short <= 0 then
+		return 0
+	end
+	return math.min(1, radius * 2 / short)
+end
+
+-- Returns the number of batches that reached the GPU
+return function(batches, custom_fn)
+	local draws = 0
+	for k in pairs(scissor_stack) do
+		scissor_stack[k] = nil
+	end
+	for b = 0, batches.count - 1 do
+		local batch = batches.batch[b]
+		local first, last = batch.first, batch.first + batch.count - 1
+		local kind = batch.kind
+
+		if kind == RenderCommandType.RECTANGLE or kind == RenderCommandType.IMAGE then
+			for i = first, last do
+				set_instance(batches, i)
+				local r = roundness(batches, i)
+				if r > 0 then
+					rl.DrawRectangleRounded(temp_rect, r, 8, temp_color)
+				else
+					rl.DrawRectangleRec(temp_rect, temp_color)
+				end
+			end
+			draws = draws + 1
+		elseif kind == RenderCommandType.BORDER then
+			for i = first, last do
+				set_instance(batches, i)
+				rl.DrawRectangleLinesEx(temp_rect, math.max(1, batches.extra[i * 4]), temp_color)
+			end
+			draws = draws + 1
+		elseif kind == RenderCommandType.TEXT then
+			-- DrawText needs NUL-terminated strings; arena text is not
+			for i = first, last do
+				set_instance(batches, i)
+				rl.DrawText(batches:text(i), temp_rect.x, temp_rect.y, batches.extra[i * 4], temp_color)
+			end
+			draws = draws + 1
+		elseif kind == RenderCommandType.SCISSOR_START then
+			local o = first * 4
+			local x, y, w, h = batches.rect[o], batches.rect[o + 1], batches.rect[o + 2], batches.rect[o + 3]
+			scissor_stack[#scissor_stack + 1] = { x, y, w, h }
+			rl.BeginScissorMode(math.floor(x), math.floor(y), math.ceil(w), math.ceil(h))
+		elseif kind == RenderCommandType.SCISSOR_END then
+			scissor_stack[#scissor_stack] = nil
+			local top = scissor_stack[#scissor_stack]
+			if top then
+				rl.BeginScissorMode(math.floor(top[1]), math.floor(top[2]), math.ceil(top[3]), math.ceil(top[4]))
+			else
+				rl.EndScissorMode()
+			end
+		elseif kind == RenderCommandType.CUSTOM then
+			if custom_fn then
+				for i = first, last do
+					custom_fn(batches, i)
+				end
+			end
+			draws = draws + 1
+		end
+	end
+	rl.EndScissorMode()
+	return draws
+end
@@ -6,6 +6,7 @@ package.path = "../src/?.lua;" .. package.path
 
 local ffi = require("ffi")
 local llay = require("init")
+local draw_batches = require("batch_draw")
 
 -- ==================================================================================
 -- Theme Configuration
@@ -49,6 +50,36 @@ local function iround(x)
 	return math.floor(x + 0.5)
 end
 
+local function draw_custom(cmd)
+	local draw_fn = llay.get_render_callback(cmd.id)
+	if draw_fn then
+		local b = cmd.boundingBox
+		local rect = { x = b.x, y = b.y, width = b.width, height = b.height }
+		local painter = {
+			rect = function(self, r, color, radius)
+				temp_rect.x = iround(r.x)
+				temp_rect.y = iround(r.y)
+				temp_rect.width = iround(r.width)
+				temp_rect.height = iround(r.height)
+				rl.DrawRectangleRounded(
+					temp_rect,
+					(radius or 0) / math.max(r.width, r.height),
+					4,
+					ColorFromTable(color)
+				)
+			end,
+			circle = function(self, center, radius, color)
+				rl.DrawCircleV(
+					ffi.new("Vector2", { x = center.x, y = center.y }),
+					radius,
+					ColorFromTable(color)
+				)
+			end,
+		}
+		draw_fn(rect, painter)
+	end
+end
+
 -- ==================================================================================
 -- State
 -- ==================================================================================
@@ -58,6 +89,20 @@ local screen_w, screen_h = 1024, 768
 local scroll_dy = 0
 local last_gc_time = 0
 
+-- B toggles drawing from llay.new_render_batches() instead of command by command
+local batched = false
+local batches = llay.new_render_batches()
+local function draw_batched_custom(b, instance)
+	draw_custom(commands.internalArray[b.command[instance]])
+end
+
+-- The sidebar is declared with layer = true, so its commands arrive between
+-- LAYER_BEGIN and LAYER_END. A clean layer is drawn from the texture it was
+-- rendered into on an earlier frame; L toggles the cache
+local layer_cache = true
+local layer_textures = {}
+local layer_stats = { drawn = 0, cached = 0 }
+
 -- Mock Data
 local tasks = {}
 local task_ids = {}
@@ -156,6 +201,7 @@ local function render_ui()
 		-- SIDEBAR
 		llay.Element({
 			id = "sidebar",
+			layer = true,
 			layout = {
 				sizing = { width = 240, height = "GROW" },
 				layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM,
@@ -279,6 +325,108 @@ local function render_ui()
 	commands = llay.end_layout()
 end
 
+-- ==================================================================================
+-- Command Drawing
+-- ==================================================================================
+
+local function begin_top_scissor()
+	local top = scissor_stack[#scissor_stack]
+	if top then
+		rl.BeginScissorMode(math.floor(top.x), math.floor(top.y), math.ceil(top.width), math.ceil(top.height))
+	else
+		rl.EndScissorMode()
+	end
+end
+
+local draw_layer
+
+-- Draws commands first..last moved by (-dx, -dy); inside a layer texture, nested
+-- layers are drawn inline
+local function draw_commands(first, last, dx, dy, in_layer)
+	local i = first
+	while i <= last do
+		local cmd = commands.internalArray[i]
+		local b = cmd.boundingBox
+
+		if cmd.commandType == llay.RenderCommandType.RECTANGLE then
+			local c = cmd.renderData.rectangle.backgroundColor
+			temp_rect.x = iround(b.x - dx)
+			temp_rect.y = iround(b.y - dy)
+			temp_rect.width = iround(b.width)
+			temp_rect.height = iround(b.height)
+			rl.DrawRectangleRec(temp_rect, ColorFromTable(c))
+
+		elseif cmd.commandType == llay.RenderCommandType.BORDER then
+			local c = cmd.renderData.border.color
+			local w = cmd.renderData.border.width
+			temp_rect.x = iround(b.x - dx)
+			temp_rect.y = iround(b.y - dy)
+			temp_rect.width = iround(b.width)
+			temp_rect.height = iround(b.height)
+			rl.DrawRectangleLinesEx(temp_rect, w.left or 1, ColorFromTable(c))
+
+		elseif cmd.commandType == llay.RenderCommandType.TEXT then
+			local d = cmd.renderData.text
+			local c = d.textColor
+			local text = ffi.string(d.stringContents.chars, d.stringContents.length)
+			local font_size = d.fontSize or 20
+			rl.DrawText(text, iround(b.x - dx), iround(b.y - dy), font_size, ColorFromTable(c))
+
+		elseif cmd.commandType == llay.RenderCommandType.SCISSOR_START then
+			table.insert(scissor_stack, { x = b.x - dx, y = b.y - dy, width = b.width, height = b.height })
+			begin_top_scissor()
+
+		elseif cmd.commandType == llay.RenderCommandType.SCISSOR_END then
+			table.remove(scissor_stack)
+			begin_top_scissor()
+
+		elseif cmd.commandType == llay.RenderCommandType.CUSTOM then
+			draw_custom(cmd)
+
+		elseif cmd.commandType == llay.RenderCommandType.LAYER_BEGIN and layer_cache and not in_layer then
+			i = draw_layer(i, cmd)
+		end
+		i = i + 1
+	end
+end
+
+-- Draws the layer starting at command i; returns the index of its LAYER_END
+function draw_layer(i, cmd)
+	local b = cmd.boundingBox
+	local layer = cmd.renderData.layer
+	local last = i + layer.commandCount
+	local w, h = math.ceil(b.width), math.ceil(b.height)
+	local texture = layer_textures[cmd.id]
+	if texture and (texture.texture.width ~= w or texture.texture.height ~= h) then
+		rl.UnloadRenderTexture(texture)
+		texture = nil
+	end
+	if not texture or layer.dirty then
+		if not texture then
+			texture = rl.LoadRenderTexture(w, h)
+			layer_textures[cmd.id] = texture
+		end
+		-- Scissors inside the layer are relative to it; the screen's come back after
+		local outer = scissor_stack
+		scissor_stack = {}
+		rl.EndScissorMode()
+		rl.BeginTextureMode(texture)
+		rl.ClearBackground(rl.BLANK)
+		draw_commands(i + 1, last, b.x, b.y, true)
+		rl.EndTextureMode()
+		scissor_stack = outer
+		begin_top_scissor()
+		layer_stats.drawn = layer_stats.drawn + 1
+	else
+		layer_stats.cached = layer_stats.cached + 1
+	end
+	-- Render textures are stored upside down
+	temp_rect.x, temp_rect.y = 0, 0
+	temp_rect.width, temp_rect.height = w, -h
+	rl.DrawTextureRec(texture.texture, temp_rect, ffi.new("Vector2", iround(b.x), iround(b.y)), rl.WHITE)
+	return last + 1
+end
+
 -- ==================================================================================
 -- Initialization
 -- ==================================================================================
@@ -301,6 +449,13 @@ while not rl.WindowShouldClose() do
 		llay.set_dimensions(screen_w, screen_h)
 	end
 
+	if rl.IsKeyPressed(rl.KEY_B) then
+		batched = not batched
+	end
+	if rl.IsKeyPressed(rl.KEY_L) then
+		layer_cache = not layer_cache
+	end
+
 	-- Handle scroll input
 	local wheel = rl.GetMouseWheelMove()
 	if wheel ~= 0 then
@@ -347,81 +502,22 @@ while not rl.WindowShouldClose() do
 	end
 
 	-- Process render commands
-	if commands then
-		for i = 0, commands.length - 1 do
-			local cmd = commands.internalArray[i]
-			local b = cmd.boundingBox
-
-			if cmd.commandType == llay._core.Llay_RenderCommandType.RECTANGLE then
-				local c = cmd.renderData.rectangle.backgroundColor
-				temp_rect.x = iround(b.x)
-				temp_rect.y = iround(b.y)
-				temp_rect.width = iround(b.width)
-				temp_rect.height = iround(b.height)
-				rl.DrawRectangleRec(temp_rect, ColorFromTable(c))
-				
-			elseif cmd.commandType == llay._core.Llay_RenderCommandType.BORDER then
-				local c = cmd.renderData.border.color
-				local w = cmd.renderData.border.width
-				temp_rect.x = iround(b.x)
-				temp_rect.y = iround(b.y)
-				temp_rect.width = iround(b.width)
-				temp_rect.height = iround(b.height)
-				rl.DrawRectangleLinesEx(temp_rect, w.left or 1, ColorFromTable(c))
-				
-			elseif cmd.commandType == llay._core.Llay_RenderCommandType.TEXT then
-				local d = cmd.renderData.text
-				local c = d.textColor
-				local text = ffi.string(d.stringContents.chars, d.stringContents.length)
-				local font_size = d.fontSize or 20
-				rl.DrawText(text, iround(b.x), iround(b.y), font_size, ColorFromTable(c))
-				
-			elseif cmd.commandType == llay._core.Llay_RenderCommandType.SCISSOR_START then
-				table.insert(scissor_stack, { x = b.x, y = b.y, width = b.width, height = b.height })
-				rl.BeginScissorMode(math.floor(b.x), math.floor(b.y), math.ceil(b.width), math.ceil(b.height))
-				
-			elseif cmd.commandType == llay._core.Llay_RenderCommandType.SCISSOR_END then
-				table.remove(scissor_stack)
-				if #scissor_stack > 0 then
-					local prev = scissor_stack[#scissor_stack]
-					rl.BeginScissorMode(prev.x, prev.y, prev.width, prev.height)
-				else
-					rl.EndScissorMode()
-				end
-				
-			elseif cmd.commandType == llay._core.Llay_RenderCommandType.CUSTOM then
-				local draw_fn = llay.get_render_callback(cmd.id)
-				if draw_fn then
-					local rect = { x = b.x, y = b.y, width = b.width, height = b.height }
-					local painter = {
-						rect = function(self, r, color, radius)
-							temp_rect.x = iround(r.x)
-							temp_rect.y = iround(r.y)
-							temp_rect.width = iround(r.width)
-							temp_rect.height = iround(r.height)
-							rl.DrawRectangleRounded(
-								temp_rect,
-								(radius or 0) / math.max(r.width, r.height),
-								4,
-								ColorFromTable(color)
-							)
-						end,
-						circle = function(self, center, radius, color)
-							rl.DrawCircleV(
-								ffi.new("Vector2", { x = center.x, y = center.y }),
-								radius,
-								ColorFromTable(color)
-							)
-						end,
-					}
-					draw_fn(rect, painter)
-				end
-			end
-		end
+	if commands and batched then
+		local draws = draw_batches(batches:build(commands), draw_batched_custom)
+		rl.DrawFPS(10, 10)
+		rl.DrawText(string.format("batched: %d draws for %d commands (B)", draws, tonumber(commands.length)), 10, 34, 16, rl.LIME)
+	elseif commands then
+		layer_stats.drawn, layer_stats.cached = 0, 0
+		draw_commands(0, commands.length - 1, 0, 0, false)
 
 		-- Safety cleanup
 		rl.EndScissorMode()
 		rl.DrawFPS(10, 10)
+		rl.DrawText(string.format("per command: %d commands (B)", tonumber(commands.length)), 10, 34, 16, rl.LIME)
+		rl.DrawText(
+			string.format("layers: %d redrawn, %d from cache (L: %s)", layer_stats.drawn, layer_stats.cached, layer_cache and "on" or "off"),
+			10, 54, 16, rl.LIME
+		)
 	end
 
 	rl.EndDrawing()
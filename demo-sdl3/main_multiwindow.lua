@@ -23,9 +23,12 @@ local function measure_text(text_str, config)
 	return { width = #text_str * (font_size * 0.6), height = font_size }
 end
 
--- Initialize llay (shared for all windows)
-llay.init(1024 * 1024 * 16, { width = WINDOW_WIDTH, height = WINDOW_HEIGHT })
-llay.set_measure_text_function(measure_text)
+-- Each window gets its own llay context (arena, text cache, scroll and pointer state)
+local function new_window_context()
+	local ctx = llay.new_context({ capacity = 1024 * 1024 * 16, dims = { width = WINDOW_WIDTH, height = WINDOW_HEIGHT } })
+	ctx:set_measure_text_function(measure_text)
+	return ctx
+end
 
 -- Create multiple windows
 local windows = {}
@@ -50,9 +53,10 @@ table.insert(windows, {
 sdl.setWindowPosition(windows[1].window, 100, 100)
 sdl.setWindowPosition(windows[2].window, 950, 100)
 
--- Create renderers for each window
+-- Create renderers and layout contexts for each window
 for i, win_data in ipairs(windows) do
 	assert(win_data.window ~= nil, "Failed to create window " .. i)
+	win_data.layout = new_window_context()
 	win_data.renderer = sdl.createRenderer(win_data.window, nil)
 	assert(win_data.renderer ~= nil, "Failed to create renderer " .. i)
 end
@@ -73,7 +77,8 @@ while running do
 
 	-- Render each window
 	for win_idx, win_data in ipairs(windows) do
-		-- Build layout for this window
+		-- Build layout for this window in its own context
+		win_data.layout:use()
 		llay.set_dimensions(WINDOW_WIDTH, WINDOW_HEIGHT)
 		llay.begin_layout()
 
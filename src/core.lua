@@ -1,6 +1,7 @@
 local ffi = require("ffi")
 local bit = require("bit")
 require("llay_ffi")
+local cull = require("llay_cull")
 
 local M = {}
 
@@ -35,6 +36,8 @@ local Llay_RenderCommandType = {
 	CUSTOM = 5,
 	SCISSOR_START = 6,
 	SCISSOR_END = 7,
+	LAYER_BEGIN = 8,
+	LAYER_END = 9,
 }
 local Llay_TextElementConfigWrapMode = { WORDS = 0, NEWLINES = 1, NONE = 2 }
 local Llay_TextAlignment = { LEFT = 0, CENTER = 1, RIGHT = 2 }
@@ -61,12 +64,39 @@ local _ANCHORS = {
 
 local context = nil
 local measure_text_fn = nil
+local measure_text_batch_fn = nil
+local measure_text_batch_user_data = nil
+-- fontId -> { [fontSize] = glyph table, scalable = glyph table }
+local glyph_tables = {}
 local query_scroll_offset_fn = nil
 local next_element_id = 1
 local DEBUG_MODE = os.getenv("LLAY_DEBUG") == "1"
 
 local _CMD_TEMPLATE = ffi.new("Clay_RenderCommand")
-local _openChildrenCounts = nil
+
+-- Zeroed templates copied into arena slots (avoids an ffi.new per array_add)
+local _EMPTY_STRING = ffi.new("Clay_String")
+local _EMPTY_DEBUG_DATA = ffi.new("Clay__DebugElementData")
+local _EMPTY_LAYOUT_ELEMENT = ffi.new("Clay_LayoutElement")
+local _EMPTY_ELEMENT_CONFIG = ffi.new("Clay_ElementConfig")
+local _EMPTY_SHARED_CONFIG = ffi.new("Clay_SharedElementConfig")
+local _EMPTY_TREE_ROOT = ffi.new("Clay__LayoutElementTreeRoot")
+local _EMPTY_TREE_NODE = ffi.new("Clay__LayoutElementTreeNode")
+local _EMPTY_SCROLL_DATA = ffi.new("Clay__ScrollContainerDataInternal")
+local _EMPTY_TEXT_DATA = ffi.new("Clay__TextElementData")
+local _EMPTY_WRAPPED_LINE = ffi.new("Clay__WrappedTextLine")
+local _EMPTY_LAYOUT_CONFIG = ffi.new("Clay_LayoutConfig")
+local _ZERO_CORNER_RADIUS = ffi.new("Clay_CornerRadius")
+local _ZERO_COLOR = ffi.new("Clay_Color")
+-- Per-frame scratch for the final layout pass; assigning Lua tables to cdata
+-- instead would allocate and abort the JIT trace
+local _SCRATCH_BBOX = ffi.new("Clay_BoundingBox")
+local _SWAP_TREE_NODE = ffi.new("Clay__LayoutElementTreeNode")
+local _rootNeedsExtraScissorEnd = {}
+-- Root container declaration, refilled by every begin_layout()
+local _ROOT_DECLARATION = ffi.new("Clay_ElementDeclaration")
+-- Scratch ID for anonymous and text elements, consumed before the next hash
+local _SCRATCH_ELEMENT_ID = ffi.new("Clay_ElementId")
 
 -- ==================================================================================
 -- Helpers: Math & Memory
@@ -78,6 +108,7 @@ end
 local function LLAY__MIN(a, b)
 	return a < b and a or b
 end
+
 local function Llay__FloatEqual(a, b)
 	return math.abs(a - b) < LLAY__EPSILON
 end
@@ -93,6 +124,20 @@ local function Llay__MemCmp(p1, p2, length)
 	return true
 end
 
+-- Autosize only: a full ephemeral block spills into a fresh chunk instead of failing
+-- the frame. The next begin_layout folds the spill back into a single block.
+local function Llay__AllocateArenaChunk(sizing, arena, size)
+	sizing.spilledBytes = sizing.spilledBytes + tonumber(arena.nextAllocation)
+	local chunkSize = LLAY__MAX(size + 64, sizing.capacity.text)
+	local chunk = ffi.new("uint8_t[?]", chunkSize)
+	sizing.chunks[#sizing.chunks + 1] = chunk
+	sizing.chunkBytes = sizing.chunkBytes + chunkSize
+	arena.memory = ffi.cast("char*", chunk)
+	arena.capacity = chunkSize
+	arena.nextAllocation = size
+	return ffi.cast("void*", chunk)
+end
+
 local function Llay__Array_Allocate_Arena(capacity, item_size, arena)
 	local total_size = capacity * item_size
 	-- Safe 64-byte alignment using 64-bit aware arithmetic
@@ -102,6 +147,10 @@ local function Llay__Array_Allocate_Arena(capacity, item_size, arena)
 	
 	local next_alloc = aligned_ptr + total_size
 	if next_alloc > tonumber(arena.capacity) then
+		local sizing = _ANCHORS.sizing
+		if sizing and sizing.block then
+			return Llay__AllocateArenaChunk(sizing, arena, total_size)
+		end
 		error("Clay Arena capacity exceeded: Requested " .. total_size .. " bytes. Allocated: " .. next_alloc .. " of " .. tonumber(arena.capacity))
 	end
 	arena.nextAllocation = next_alloc
@@ -110,10 +159,27 @@ local function Llay__Array_Allocate_Arena(capacity, item_size, arena)
 	return ffi.cast("void*", result)
 end
 
+-- Bytes used and reserved by the active layout. Under autosize that is the per-array
+-- persistent buffers plus the frame block and any chunks it spilled into.
+local function Llay__ArenaUsage()
+	local arena = context.internalArena
+	local sizing = _ANCHORS.sizing
+	if sizing == nil then
+		return tonumber(arena.nextAllocation), tonumber(arena.capacity)
+	end
+	local persistentBytes = 0
+	for _, buffer in pairs(sizing.persistent) do
+		persistentBytes = persistentBytes + ffi.sizeof(buffer)
+	end
+	local used = persistentBytes + sizing.spilledBytes + tonumber(arena.nextAllocation)
+	return used, persistentBytes + sizing.blockSize + sizing.chunkBytes
+end
+
 -- NEW HELPER: Allocate strings in arena to prevent GC corruption
-local function Llay__AllocateStringInArena(str)
+-- str is a Lua string, or a char pointer when len is given
+local function Llay__AllocateStringInArena(str, len)
 	if not str then return nil, 0 end
-	local len = #str
+	len = len or #str
 	local ptr = ffi.cast("char*", Llay__Array_Allocate_Arena(len + 1, 1, context.internalArena))
 	ffi.copy(ptr, str, len)
 	ptr[len] = 0
@@ -179,6 +245,103 @@ function Inspector.trace_stack()
 	end
 end
 
+-- Per-phase profiler. Every probe sits behind the `profiling` upvalue, so a disabled
+-- profiler costs one branch per phase. Stats accumulate in _frameStats and are
+-- published at end_layout into _lastFrameStats and the history ring.
+local profiling = false
+local _frameStats = ffi.new("Llay_FrameStats")
+local _lastFrameStats = ffi.new("Llay_FrameStats")
+local _statsRing = nil
+local _statsRingCapacity = 0
+local _statsRingCount = 0
+local _statsRingHead = -1
+local _profileFrame = 0
+local _declareStart = 0
+
+local Llay__ProfileNow = os.clock
+if ffi.os ~= "Windows" then
+	local ok = pcall(ffi.typeof, "Llay__Timespec")
+		or pcall(ffi.cdef, [[
+			typedef struct { long tv_sec; long tv_nsec; } Llay__Timespec;
+			int clock_gettime(int clk_id, Llay__Timespec *tp);
+		]])
+	if ok and pcall(function() return ffi.C.clock_gettime end) then
+		local clock_gettime = ffi.C.clock_gettime
+		local CLOCK_MONOTONIC = ffi.os == "OSX" and 6 or 1
+		local ts = ffi.new("Llay__Timespec")
+		Llay__ProfileNow = function()
+			clock_gettime(CLOCK_MONOTONIC, ts)
+			return tonumber(ts.tv_sec) + tonumber(ts.tv_nsec) * 1e-9
+		end
+	end
+end
+
+-- Adds the time since `start` to a phase field and returns the new start
+local function Llay__ProfilePhase(field, start)
+	local now = Llay__ProfileNow()
+	_frameStats[field] = _frameStats[field] + (now - start) * 1000
+	return now
+end
+
+local function Llay__ProfileFinishFrame()
+	local stats = _frameStats
+	_profileFrame = _profileFrame + 1
+	stats.frame = _profileFrame
+	stats.elementCount = context.layoutElements.length
+	stats.textElementCount = context.textElementData.length
+	stats.renderCommandCount = context.renderCommands.length
+	stats.wrappedLines = context.wrappedTextLines.length
+	-- Slot 0 of the measure cache is the null entry
+	stats.measureCacheOccupancy = context.measureTextHashMapInternal.length
+		- context.measureTextHashMapInternalFreeList.length - 1
+	stats.measureCacheCapacity = context.measureTextHashMapInternal.capacity
+	stats.hashMapOccupancy = context.layoutElementsHashMapInternal.length
+		- context.layoutElementsHashMapFreeList.length
+	stats.hashMapCapacity = context.layoutElementsHashMapInternal.capacity
+	stats.arenaBytesUsed, stats.arenaCapacity = Llay__ArenaUsage()
+
+	ffi.copy(_lastFrameStats, stats, ffi.sizeof("Llay_FrameStats"))
+	_statsRingHead = (_statsRingHead + 1) % _statsRingCapacity
+	ffi.copy(_statsRing + _statsRingHead, stats, ffi.sizeof("Llay_FrameStats"))
+	if _statsRingCount < _statsRingCapacity then
+		_statsRingCount = _statsRingCount + 1
+	end
+	ffi.fill(stats, ffi.sizeof("Llay_FrameStats"))
+end
+
+-- Turns the profiler on or off. historyFrames sizes the ring (default 120); the ring
+-- is only reallocated when that size changes.
+function Inspector.set_profiling(enabled, historyFrames)
+	profiling = enabled and true or false
+	if not profiling then
+		return
+	end
+	historyFrames = historyFrames or 120
+	if _statsRing == nil or historyFrames ~= _statsRingCapacity then
+		_statsRing = ffi.new("Llay_FrameStats[?]", historyFrames)
+		_statsRingCapacity = historyFrames
+		_statsRingCount = 0
+		_statsRingHead = -1
+	end
+	ffi.fill(_frameStats, ffi.sizeof("Llay_FrameStats"))
+	_declareStart = Llay__ProfileNow()
+end
+
+function Inspector.is_profiling()
+	return profiling
+end
+
+-- Stats of the last completed frame. The same struct is reused every frame.
+function Inspector.get_frame_stats()
+	return _lastFrameStats
+end
+
+-- Returns ring, capacity, count, newest. ring is a 0-based Llay_FrameStats array;
+-- frame i back from the newest is ring[(newest - i) % capacity] for i < count.
+function Inspector.get_stats_history()
+	return _statsRing, _statsRingCapacity, _statsRingCount, _statsRingHead
+end
+
 M.Inspector = Inspector
 
 -- Debug helper - get layout element by index
@@ -208,30 +371,147 @@ function M._debug_print_element(idx, indent)
 	end
 end
 
-local function Llay__GetHashMapItem(id)
+local function Llay__GetHashMapIndex(id)
 	if context.layoutElementsHashMap.internalArray == nil then
-		return nil
+		return -1
 	end
 	local hashBucket = id % context.layoutElementsHashMap.capacity
 	local elementIndex = context.layoutElementsHashMap.internalArray[hashBucket]
 	while elementIndex ~= -1 do
 		local hashEntry = context.layoutElementsHashMapInternal.internalArray + elementIndex
 		if hashEntry.elementId.id == id then
-			return hashEntry
+			return elementIndex
 		end
 		elementIndex = hashEntry.nextIndex
 	end
-	return nil
+	return -1
 end
 
-local function Llay__ElementIsOffscreen(boundingBox)
-	if context.disableCulling then
-		return false
+local function Llay__GetHashMapItem(id)
+	local elementIndex = Llay__GetHashMapIndex(id)
+	if elementIndex == -1 then
+		return nil
+	end
+	return context.layoutElementsHashMapInternal.internalArray + elementIndex
+end
+
+-- ==================================================================================
+-- Arena Sizing
+-- ==================================================================================
+-- Per-frame arrays, reset by every begin_layout. perElement arrays are addressed by
+-- layout element index and always share the layoutElements capacity; the others are
+-- sized on their own (maxElementCount, or their high-water mark under autosize).
+local LLAY__EPHEMERAL_ARRAYS = {
+	{ field = "layoutElementChildrenBuffer", ctype = "int32_t", perElement = true },
+	{ field = "layoutElements", ctype = "Clay_LayoutElement" },
+	{ field = "renderCommands", ctype = "Clay_RenderCommand" },
+	{ field = "layoutConfigs", ctype = "Clay_LayoutConfig" },
+	{ field = "elementConfigs", ctype = "Clay_ElementConfig" },
+	{ field = "textElementConfigs", ctype = "Clay_TextElementConfig" },
+	{ field = "sharedElementConfigs", ctype = "Clay_SharedElementConfig" },
+	{ field = "aspectRatioElementConfigs", ctype = "Clay_AspectRatioElementConfig" },
+	{ field = "imageElementConfigs", ctype = "Clay_ImageElementConfig" },
+	{ field = "floatingElementConfigs", ctype = "Clay_FloatingElementConfig" },
+	{ field = "clipElementConfigs", ctype = "Clay_ClipElementConfig" },
+	{ field = "customElementConfigs", ctype = "Clay_CustomElementConfig" },
+	{ field = "borderElementConfigs", ctype = "Clay_BorderElementConfig" },
+	{ field = "warnings", ctype = "Clay__Warning", fixed = 100 },
+	{ field = "dynamicStringData", ctype = "char" },
+	{ field = "layoutElementIdStrings", ctype = "Clay_String" },
+	{ field = "wrappedTextLines", ctype = "Clay__WrappedTextLine" },
+	{ field = "layoutElementTreeNodeArray1", ctype = "Clay__LayoutElementTreeNode", perElement = true },
+	{ field = "layoutElementTreeRoots", ctype = "Clay__LayoutElementTreeRoot", perElement = true },
+	{ field = "layoutElementTreeRootsScratch", ctype = "Clay__LayoutElementTreeRoot", perElement = true },
+	{ field = "layoutElementChildren", ctype = "int32_t", perElement = true },
+	{ field = "openLayoutElementStack", ctype = "int32_t", perElement = true },
+	{ field = "textElementData", ctype = "Clay__TextElementData" },
+	{ field = "aspectRatioElementIndexes", ctype = "int32_t", perElement = true },
+	{ field = "treeNodeVisited", ctype = "bool", perElement = true },
+	{ field = "treeNodeElementIndexes", ctype = "int32_t", perElement = true },
+	{ field = "layoutElementConfigIndexes", ctype = "Llay__ElementConfigIndex", perElement = true },
+	{ field = "openClipElementStack", ctype = "int32_t", perElement = true },
+	{ field = "reusableElementIndexBuffer", ctype = "int32_t", perElement = true },
+	{ field = "layoutElementClipElementIds", ctype = "int32_t", perElement = true },
+	{ field = "layoutElementContentHashes", ctype = "int32_t", perElement = true },
+	{ field = "layoutElementMemoIndexes", ctype = "int32_t", perElement = true },
+	{ field = "layoutElementMemoFlags", ctype = "int32_t", perElement = true },
+	{ field = "hitTestNodes", ctype = "Llay__HitTestNode", perElement = true },
+	{ field = "openLayerStack", ctype = "Llay__OpenLayer", fixed = 64 },
+	{ field = "cullClipStack", ctype = "Llay__CullClip", fixed = 64 },
+}
+
+-- Cross-frame arrays. count is "elements" (maxElementCount), "words"
+-- (maxMeasureTextCacheWordCount), "buckets" (the measure cache bucket table, which
+-- must cover maxMeasureTextCacheWordCount / 32) or a fixed number. When autosize
+-- enlarges them between frames, grow arrays keep their contents and rehash bucket
+-- tables are rebuilt from the item chains.
+local LLAY__PERSISTENT_ARRAYS = {
+	{ field = "scrollContainerDatas", ctype = "Clay__ScrollContainerDataInternal", count = 100 },
+	{ field = "layoutElementsHashMapInternal", ctype = "Clay_LayoutElementHashMapItem", count = "elements", grow = true },
+	{ field = "layoutElementsHashMap", ctype = "int32_t", count = "elements", rehash = true },
+	{ field = "layoutElementsHashMapFreeList", ctype = "int32_t", count = "elements", grow = true },
+	{ field = "measureTextHashMapInternal", ctype = "Clay__MeasureTextCacheItem", count = "elements", grow = true },
+	{ field = "measureTextHashMapInternalFreeList", ctype = "int32_t", count = "elements", grow = true },
+	{ field = "measuredWordsFreeList", ctype = "int32_t", count = "words", grow = true },
+	{ field = "measureTextHashMap", ctype = "int32_t", count = "buckets", rehash = true },
+	{ field = "measuredWords", ctype = "Clay__MeasuredWord", count = "words", grow = true },
+	-- A wrap has no more lines than its text has words
+	{ field = "wrappedLineCache", ctype = "Llay__WrappedLineSpan", count = "words", grow = true },
+	{ field = "wrappedLineCacheFreeList", ctype = "int32_t", count = "words", grow = true },
+	{ field = "pointerOverIds", ctype = "Clay_ElementId", count = "elements", grow = true },
+	{ field = "debugElementData", ctype = "Clay__DebugElementData", count = "elements", grow = true },
+	-- Parallel to layoutElementsHashMapInternal (same index), so it survives across frames.
+	{ field = "layoutMemo", ctype = "Llay__LayoutMemoItem", count = "elements", grow = true },
+	-- Each element's slot in the id hash map (-1 if it has none), indexed like
+	-- layoutElements. Kept across frames: see Llay__AddHashMapItem
+	{ field = "layoutElementHashMapIndexes", ctype = "int32_t", count = "elements", grow = true },
+}
+
+-- Arrays autosize tunes from their own high-water mark
+local LLAY__TUNED_ARRAYS = {}
+-- Arrays whose dropped adds are counted on overflow: the tuned ones plus the measure
+-- cache, which autosize grows with the persistent memory
+local LLAY__COUNTED_ARRAYS = {}
+
+local _overflowScratchSize = 0
+for _, specs in ipairs({ LLAY__EPHEMERAL_ARRAYS, LLAY__PERSISTENT_ARRAYS }) do
+	for _, spec in ipairs(specs) do
+		spec.size = ffi.sizeof(spec.ctype)
+		spec.ptrType = ffi.typeof("$*", ffi.typeof(spec.ctype))
+		spec.bufferType = ffi.typeof("$[?]", ffi.typeof(spec.ctype))
+		_overflowScratchSize = LLAY__MAX(_overflowScratchSize, spec.size)
+	end
+end
+for _, spec in ipairs(LLAY__EPHEMERAL_ARRAYS) do
+	if not spec.perElement and not spec.fixed then
+		LLAY__TUNED_ARRAYS[#LLAY__TUNED_ARRAYS + 1] = spec.field
+		LLAY__COUNTED_ARRAYS[#LLAY__COUNTED_ARRAYS + 1] = spec.field
 	end
-	return (boundingBox.x > context.layoutDimensions.width)
-		or (boundingBox.y > context.layoutDimensions.height)
-		or (boundingBox.x + boundingBox.width < 0)
-		or (boundingBox.y + boundingBox.height < 0)
+end
+LLAY__COUNTED_ARRAYS[#LLAY__COUNTED_ARRAYS + 1] = "measureTextHashMapInternal"
+LLAY__COUNTED_ARRAYS[#LLAY__COUNTED_ARRAYS + 1] = "measuredWords"
+
+-- Where adds to a full array land; read by nobody
+local _overflowScratch = ffi.new("uint8_t[?]", _overflowScratchSize)
+
+-- A full array never fails the frame: like Clay's maxElementsExceeded, the rest of the
+-- declaration is dropped and end_layout returns no commands. Autosize counts the
+-- dropped adds and sizes the array to fit before the next frame.
+local function Llay__ArrayOverflow(array)
+	context.booleanWarnings.maxElementsExceeded = true
+	local sizing = _ANCHORS.sizing
+	if sizing then
+		local key = "layoutElements"
+		for i = 1, #LLAY__COUNTED_ARRAYS do
+			if context[LLAY__COUNTED_ARRAYS[i]].internalArray == array.internalArray then
+				key = LLAY__COUNTED_ARRAYS[i]
+				break
+			end
+		end
+		sizing.dropped[key] = sizing.dropped[key] + 1
+	end
+	ffi.fill(_overflowScratch, _overflowScratchSize)
+	return ffi.cast(ffi.typeof(array.internalArray), _overflowScratch)
 end
 
 -- ==================================================================================
@@ -240,7 +520,7 @@ end
 
 local function array_add(array, item)
 	if array.length >= array.capacity then
-		error("Array capacity exceeded")
+		return Llay__ArrayOverflow(array)
 	end
 	if item == nil then
 		local ptr = array.internalArray + array.length
@@ -256,7 +536,8 @@ end
 
 local function int32_array_add(array, value)
 	if array.length >= array.capacity then
-		error("Int32 Array capacity exceeded")
+		Llay__ArrayOverflow(array)
+		return
 	end
 	array.internalArray[array.length] = value
 	array.length = array.length + 1
@@ -285,74 +566,179 @@ local function int32_array_remove_swapback(array, index)
 	return removed
 end
 
-local function element_id_array_add(array, item)
+-- pointerOverIds is the only element id array. Adds also hash the hovered set, so
+-- set_pointer_state can tell when it changed without another pass over it.
+local function pointer_over_ids_add(item)
+	local array = context.pointerOverIds
 	if array.length >= array.capacity then
 		return
 	end
 	array.internalArray[array.length] = item
 	array.length = array.length + 1
+	local hash = bit.tobit(context.pointerOverHash + item.id)
+	hash = hash + bit.lshift(hash, 10)
+	context.pointerOverHash = bit.bxor(hash, bit.rshift(hash, 6))
 end
 
-local function element_id_array_get(array, index)
-	return array.internalArray + index
+local function Llay__TouchHashMapItem(hashItem, layoutElement)
+	-- COLLISION CHECK: If we already touched this item in the current frame, it's a duplicate ID error.
+	if hashItem.generation == context.generation + 1 then
+		if DEBUG_MODE then
+			print("[LLAY WARNING] Duplicate ID collision in same frame: " .. hashItem.elementId.id)
+		end
+	else
+		context.hashMapSeenCount = context.hashMapSeenCount + 1
+	end
+
+	hashItem.generation = context.generation + 1
+	hashItem.layoutElement = layoutElement
+	hashItem.debugData.collision = false
+	return hashItem
 end
 
-local function Llay__AddHashMapItem(elementId, layoutElement)
-	if context.layoutElementsHashMapInternal.length >= context.layoutElementsHashMapInternal.capacity - 1 then
-		return nil
-	end
+-- Current capture target (an element id), kept here so eviction can spare it; the
+-- capture API is further down
+local current_capture = nil
+local _capture_is_manual = false
 
-	local hashBucket = elementId.id % context.layoutElementsHashMap.capacity
-	local hashItemIndex = context.layoutElementsHashMap.internalArray[hashBucket]
-	local previousIndex = -1
+-- Looks at up to slotCount slots from where the last sweep stopped and evicts ids
+-- that have not been declared for more than hashMapEvictAfter frames
+local Llay__SweepHashMap
+do
+	-- Whether an evicted id would take state with it: the capture target and scroll
+	-- containers keep referring to their id across frames
+	local function Llay__HashMapItemIsPinned(id)
+		if id == current_capture then
+			return true
+		end
+		local scrollDatas = context.scrollContainerDatas
+		for i = 0, scrollDatas.length - 1 do
+			if scrollDatas.internalArray[i].elementId == id then
+				return true
+			end
+		end
+		return false
+	end
 
-	while hashItemIndex ~= -1 do
-		local hashItem = context.layoutElementsHashMapInternal.internalArray + hashItemIndex
-		if hashItem.elementId.id == elementId.id then
-			-- COLLISION CHECK: If we already touched this item in the current frame, it's a duplicate ID error.
-			if hashItem.generation == context.generation + 1 then
-				if DEBUG_MODE then
-					print("[LLAY WARNING] Duplicate ID collision in same frame: " .. elementId.id)
+	-- Unlinks a slot from its bucket chain and puts it on the free list
+	local function Llay__EvictHashMapItem(itemIndex)
+		local items = context.layoutElementsHashMapInternal.internalArray
+		local item = items + itemIndex
+		local buckets = context.layoutElementsHashMap.internalArray
+		local bucket = item.elementId.id % context.layoutElementsHashMap.capacity
+		local index = buckets[bucket]
+		if index == itemIndex then
+			buckets[bucket] = item.nextIndex
+		else
+			while index ~= -1 do
+				local link = items + index
+				if link.nextIndex == itemIndex then
+					link.nextIndex = item.nextIndex
+					break
 				end
+				index = link.nextIndex
 			end
+		end
+		-- generation 0 marks a free slot; the memo in the parallel slot is dead too
+		item.generation = 0
+		item.nextIndex = -1
+		item.layoutElement = nil
+		ffi.fill(context.layoutMemo.internalArray + itemIndex, ffi.sizeof("Llay__LayoutMemoItem"))
+		int32_array_add(context.layoutElementsHashMapFreeList, itemIndex)
+		context.hashMapEvictionCount = context.hashMapEvictionCount + 1
+		if profiling then
+			_frameStats.hashMapEvictions = _frameStats.hashMapEvictions + 1
+		end
+	end
 
-			hashItem.generation = context.generation + 1
-			hashItem.layoutElement = layoutElement
-			hashItem.debugData.collision = false
-			return hashItem
+	function Llay__SweepHashMap(slotCount)
+		local map = context.layoutElementsHashMapInternal
+		local slots = map.length
+		local stamp = context.generation + 1
+		local evictAfter = context.hashMapEvictAfter
+		local cursor = context.hashMapSweepCursor
+		for _ = 1, LLAY__MIN(slotCount, slots) do
+			if cursor >= slots then
+				cursor = 0
+			end
+			local generation = map.internalArray[cursor].generation
+			if generation ~= 0 and stamp - generation > evictAfter
+				and not Llay__HashMapItemIsPinned(map.internalArray[cursor].elementId.id) then
+				Llay__EvictHashMapItem(cursor)
+			end
+			cursor = cursor + 1
 		end
-		previousIndex = hashItemIndex
-		hashItemIndex = hashItem.nextIndex
+		context.hashMapSweepCursor = cursor
 	end
+end
 
-	local itemIndex = context.layoutElementsHashMapInternal.length
-	context.layoutElementsHashMapInternal.length = context.layoutElementsHashMapInternal.length + 1
-	local item = context.layoutElementsHashMapInternal.internalArray + itemIndex
+-- elemIdx is the element's index in layoutElements; the slot is recorded in
+-- layoutElementHashMapIndexes. A steady UI declares the same ids in the same order
+-- every frame, so the slot that index held last frame is checked before the bucket
+-- chain is walked.
+local function Llay__AddHashMapItem(elementId, layoutElement, elemIdx)
+	local id = elementId.id
+	local slots = context.layoutElementHashMapIndexes.internalArray
+	local items = context.layoutElementsHashMapInternal
+	local existingIndex = slots[elemIdx]
+	if existingIndex < 0 or existingIndex >= items.length
+		or items.internalArray[existingIndex].generation == 0
+		or items.internalArray[existingIndex].elementId.id ~= id then
+		existingIndex = Llay__GetHashMapIndex(id)
+	end
+	slots[elemIdx] = existingIndex
+	if existingIndex ~= -1 then
+		return Llay__TouchHashMapItem(items.internalArray + existingIndex, layoutElement)
+	end
 
-	local elementIdStruct = ffi.new("Clay_ElementId")
-	elementIdStruct.id = elementId.id
-	elementIdStruct.offset = elementId.offset
-	elementIdStruct.baseId = elementId.baseId
-	elementIdStruct.stringId.length = elementId.stringId.length
-	local charsValue = elementId.stringId.chars
-	if type(charsValue) == "table" then
-		charsValue = charsValue.chars or charsValue[1] or ""
+	local freeList = context.layoutElementsHashMapFreeList
+	if freeList.length == 0 and context.layoutElementsHashMapInternal.length >= context.layoutElementsHashMapInternal.capacity - 1 then
+		-- Full: reclaim every stale id now rather than wait for the incremental sweep
+		if context.hashMapEvictAfter > 0 then
+			Llay__SweepHashMap(context.layoutElementsHashMapInternal.length)
+		end
+		if freeList.length == 0 then
+			return nil
+		end
+	end
+
+	local itemIndex
+	local item
+	if freeList.length > 0 then
+		itemIndex = int32_array_remove_swapback(freeList, freeList.length - 1)
+		item = context.layoutElementsHashMapInternal.internalArray + itemIndex
+		-- The slot keeps its debug data; everything else starts over
+		local debugData = item.debugData
+		ffi.fill(item, ffi.sizeof("Clay_LayoutElementHashMapItem"))
+		ffi.copy(debugData, _EMPTY_DEBUG_DATA, ffi.sizeof("Clay__DebugElementData"))
+		item.debugData = debugData
+	else
+		itemIndex = context.layoutElementsHashMapInternal.length
+		context.layoutElementsHashMapInternal.length = context.layoutElementsHashMapInternal.length + 1
+		item = context.layoutElementsHashMapInternal.internalArray + itemIndex
+		item.debugData = array_add(context.debugElementData, _EMPTY_DEBUG_DATA)
 	end
-	elementIdStruct.stringId.chars = charsValue
-	elementIdStruct.stringId.isStaticallyAllocated = false
+	context.hashMapSeenCount = context.hashMapSeenCount + 1
+
+	local itemId = item.elementId
+	itemId.id = elementId.id
+	itemId.offset = elementId.offset
+	itemId.baseId = elementId.baseId
+	-- The item outlives the ID's string (a Lua string, or one owned by an interned
+	-- handle the ID cache may drop), so it keeps no pointer to it; the frame's copy
+	-- is in layoutElementIdStrings
+	itemId.stringId.length = 0
+	itemId.stringId.chars = nil
+	itemId.stringId.isStaticallyAllocated = false
 
-	item.elementId = elementIdStruct
 	item.layoutElement = layoutElement
-	item.nextIndex = -1
 	item.generation = context.generation + 1
 
-	item.debugData = array_add(context.debugElementData, ffi.new("Clay__DebugElementData"))
-
-	if previousIndex ~= -1 then
-		context.layoutElementsHashMapInternal.internalArray[previousIndex].nextIndex = itemIndex
-	else
-		context.layoutElementsHashMap.internalArray[hashBucket] = itemIndex
-	end
+	-- New items go in front of the bucket's chain, so adding never walks it
+	local hashBucket = id % context.layoutElementsHashMap.capacity
+	item.nextIndex = context.layoutElementsHashMap.internalArray[hashBucket]
+	context.layoutElementsHashMap.internalArray[hashBucket] = itemIndex
+	slots[elemIdx] = itemIndex
 
 	return item
 end
@@ -376,7 +762,8 @@ local function Llay__HashString(str, seed)
 	return { id = hash + 1, offset = 0, baseId = seed or 0, stringId = { length = len, chars = str } }
 end
 
-local function Llay__HashNumber(offset, seed)
+-- Scalar form of Llay__HashNumber for hot paths that only need the id
+local function Llay__HashNumberId(offset, seed)
 	local hash = seed
 	hash = hash + (offset + 48)
 	hash = (hash + bit.lshift(hash, 10)) % 4294967296
@@ -384,7 +771,22 @@ local function Llay__HashNumber(offset, seed)
 	hash = (hash + bit.lshift(hash, 3)) % 4294967296
 	hash = bit.bxor(hash, bit.rshift(hash, 11))
 	hash = (hash + bit.lshift(hash, 15)) % 4294967296
-	return { id = hash + 1, offset = offset, baseId = seed, stringId = { length = 0, chars = nil } }
+	return hash + 1
+end
+
+local function Llay__HashNumber(offset, seed)
+	return { id = Llay__HashNumberId(offset, seed), offset = offset, baseId = seed, stringId = { length = 0, chars = nil } }
+end
+
+-- Fills an existing Clay_ElementId with Llay__HashNumber's result
+local function Llay__HashNumberInto(out, offset, seed)
+	out.id = Llay__HashNumberId(offset, seed)
+	out.offset = offset
+	out.baseId = seed
+	out.stringId.length = 0
+	out.stringId.chars = nil
+	out.stringId.isStaticallyAllocated = false
+	return out
 end
 
 -- Accurate implementation of Clay's HashStringWithOffset
@@ -423,258 +825,402 @@ local function Llay__HashStringWithOffset(str, offset, seed)
 end
 
 -- ==================================================================================
--- Context & Initialization
+-- Interned Element IDs
 -- ==================================================================================
+-- A string, or a (string, index) pair, is hashed once into a Clay_ElementId cdata
+-- that is reused for every later lookup. Hashes come from the functions above, so
+-- they stay identical to Clay's. stringId.chars points into the Lua string, which
+-- the weak-keyed anchor table keeps alive for as long as the handle is; the cache
+-- may drop a handle at any time, so open_element_with_id copies the string.
+
+local LLAY__ID_CACHE_MAX = 16384
+local _id_cache = {}
+local _idi_cache = {}
+local _id_cache_count = 0
+local _id_string_anchors = setmetatable({}, { __mode = "k" })
+
+local function Llay__ReserveIdCacheSlot()
+	-- Dynamically built ID strings must not grow the cache without bound;
+	-- handles already given out stay valid.
+	if _id_cache_count >= LLAY__ID_CACHE_MAX then
+		_id_cache = {}
+		_idi_cache = {}
+		_id_cache_count = 0
+	end
+	_id_cache_count = _id_cache_count + 1
+end
 
-local function Llay__InitializeEphemeralMemory(ctx)
-	local max = ctx.maxElementCount
-	local arena = ctx.internalArena
+local function Llay__InternElementId(hashed, str)
+	local handle = ffi.new("Clay_ElementId")
+	handle.id = hashed.id
+	handle.offset = hashed.offset
+	handle.baseId = hashed.baseId
+	handle.stringId.length = hashed.stringId.length
+	handle.stringId.chars = str
+	handle.stringId.isStaticallyAllocated = true
+	_id_string_anchors[handle] = str
+	return handle
+end
 
-	-- Reset Arena
-	arena.nextAllocation = ffi.cast("uintptr_t", ctx.arenaResetOffset)
+local function Llay__GetInternedId(str)
+	local handle = _id_cache[str]
+	if handle then
+		return handle
+	end
+	Llay__ReserveIdCacheSlot()
+	handle = Llay__InternElementId(Llay__HashString(str, 0), str)
+	_id_cache[str] = handle
+	return handle
+end
 
-	-- Reset command template to clean state
-	ffi.fill(_CMD_TEMPLATE, ffi.sizeof("Clay_RenderCommand"))
+local function Llay__GetInternedIdWithIndex(str, index)
+	local byIndex = _idi_cache[str]
+	local handle = byIndex and byIndex[index]
+	if handle then
+		return handle
+	end
+	Llay__ReserveIdCacheSlot()
+	byIndex = _idi_cache[str]
+	if not byIndex then
+		byIndex = {}
+		_idi_cache[str] = byIndex
+	end
+	handle = Llay__InternElementId(Llay__HashStringWithOffset(str, index, 0), str)
+	byIndex[index] = handle
+	return handle
+end
 
-	-- Initialize open children counts tracker
-	_openChildrenCounts = ffi.new("uint16_t[?]", max)
-	for i = 0, max - 1 do _openChildrenCounts[i] = 0 end
-
-	ctx.layoutElementChildrenBuffer =
-		{ capacity = max, length = 0, internalArray = ffi.cast("int32_t*", Llay__Array_Allocate_Arena(max, 4, arena)) }
-	ctx.layoutElements = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay_LayoutElement*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay_LayoutElement"), arena)
-		),
-	}
-	ctx.renderCommands = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay_RenderCommand*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay_RenderCommand"), arena)
-		),
-	}
+-- ==================================================================================
+-- Context & Initialization
+-- ==================================================================================
 
-	ctx.layoutConfigs = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay_LayoutConfig*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay_LayoutConfig"), arena)
-		),
-	}
+local LLAY__MIN_ARRAY_CAPACITY = 16
+local LLAY__MIN_TEXT_BYTES = 4096
+
+local function Llay__PersistentCount(ctx, spec)
+	local count = spec.count
+	if count == "elements" then
+		return ctx.maxElementCount
+	elseif count == "words" then
+		return ctx.maxMeasureTextCacheWordCount
+	elseif count == "buckets" then
+		return LLAY__MAX(ctx.maxElementCount, ctx.maxMeasureTextCacheWordCount / 32)
+	end
+	return count
+end
 
-	-- Reserve index 0 as the default layout config.
-	-- Many code paths (e.g. text elements) assume `layoutConfigs.internalArray` points
-	-- at a sane FIT-sized config, not the root container's fixed-size config.
-	array_add(ctx.layoutConfigs, ffi.new("Clay_LayoutConfig"))
-
-	ctx.elementConfigs = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay_ElementConfig*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay_ElementConfig"), arena)
-		),
-	}
-	ctx.textElementConfigs = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay_TextElementConfig*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay_TextElementConfig"), arena)
-		),
-	}
-	ctx.sharedElementConfigs = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay_SharedElementConfig*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay_SharedElementConfig"), arena)
-		),
-	}
-	ctx.aspectRatioElementConfigs = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay_AspectRatioElementConfig*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay_AspectRatioElementConfig"), arena)
-		),
-	}
-	ctx.imageElementConfigs = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay_ImageElementConfig*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay_ImageElementConfig"), arena)
-		),
-	}
-	ctx.floatingElementConfigs = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay_FloatingElementConfig*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay_FloatingElementConfig"), arena)
-		),
-	}
-	ctx.clipElementConfigs = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay_ClipElementConfig*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay_ClipElementConfig"), arena)
-		),
-	}
-	ctx.customElementConfigs = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay_CustomElementConfig*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay_CustomElementConfig"), arena)
-		),
-	}
-	ctx.borderElementConfigs = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay_BorderElementConfig*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay_BorderElementConfig"), arena)
-		),
-	}
-	ctx.warnings = {
-		capacity = 100,
-		length = 0,
-		internalArray = ffi.cast("Clay__Warning*", Llay__Array_Allocate_Arena(100, ffi.sizeof("Clay__Warning"), arena)),
-	}
-	ctx.dynamicStringData = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast("char*", Llay__Array_Allocate_Arena(max, 1, arena)),
-	}
+local function Llay__EphemeralCapacity(ctx, sizing, spec)
+	if spec.fixed then
+		return spec.fixed
+	elseif sizing == nil then
+		return ctx.maxElementCount
+	end
+	return sizing.capacity[spec.perElement and "layoutElements" or spec.field]
+end
 
-	ctx.layoutElementIdStrings = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast("Clay_String*", Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay_String"), arena)),
-	}
-	ctx.wrappedTextLines = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay__WrappedTextLine*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay__WrappedTextLine"), arena)
-		),
-	}
-	ctx.layoutElementTreeNodeArray1 = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay__LayoutElementTreeNode*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay__LayoutElementTreeNode"), arena)
-		),
-	}
-	ctx.layoutElementTreeRoots = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay__LayoutElementTreeRoot*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay__LayoutElementTreeRoot"), arena)
-		),
+-- Autosize state; lives in the context's anchors. Every tuned array starts at
+-- `elements` and then follows its own high-water mark.
+local function Llay__NewArenaSizing(options, elements)
+	options = type(options) == "table" and options or {}
+	local sizing = {
+		headroom = options.headroom or 1.5,
+		shrinkAfter = options.shrink_after or 300,
+		capacity = { text = LLAY__MAX(LLAY__MIN_TEXT_BYTES, elements * 16) },
+		peak = { text = 0 },
+		dropped = {},
+		block = nil,
+		blockSize = 0,
+		arrayBytes = 0,
+		chunks = {},
+		chunkBytes = 0,
+		spilledBytes = 0,
+		persistent = {},
+		frames = 0,
+		overflows = 0,
+		resizes = 0,
 	}
-	ctx.layoutElementChildren =
-		{ capacity = max, length = 0, internalArray = ffi.cast("int32_t*", Llay__Array_Allocate_Arena(max, 4, arena)) }
-	ctx.openLayoutElementStack =
-		{ capacity = max, length = 0, internalArray = ffi.cast("int32_t*", Llay__Array_Allocate_Arena(max, 4, arena)) }
-	ctx.textElementData = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay__TextElementData*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay__TextElementData"), arena)
-		),
-	}
-	ctx.aspectRatioElementIndexes =
-		{ capacity = max, length = 0, internalArray = ffi.cast("int32_t*", Llay__Array_Allocate_Arena(max, 4, arena)) }
-	ctx.treeNodeVisited =
-		{ capacity = max, length = 0, internalArray = ffi.cast("bool*", Llay__Array_Allocate_Arena(max, 1, arena)) }
-	ctx.openClipElementStack =
-		{ capacity = max, length = 0, internalArray = ffi.cast("int32_t*", Llay__Array_Allocate_Arena(max, 4, arena)) }
-	ctx.reusableElementIndexBuffer =
-		{ capacity = max, length = 0, internalArray = ffi.cast("int32_t*", Llay__Array_Allocate_Arena(max, 4, arena)) }
-	ctx.layoutElementClipElementIds =
-		{ capacity = max, length = 0, internalArray = ffi.cast("int32_t*", Llay__Array_Allocate_Arena(max, 4, arena)) }
+	for _, field in ipairs(LLAY__TUNED_ARRAYS) do
+		sizing.capacity[field] = elements
+		sizing.peak[field] = 0
+	end
+	for _, field in ipairs(LLAY__COUNTED_ARRAYS) do
+		sizing.dropped[field] = 0
+	end
+	return sizing
+end
+
+local function Llay__AllocatePersistentArray(ctx, spec, count)
+	local sizing = _ANCHORS.sizing
+	if sizing == nil then
+		return Llay__Array_Allocate_Arena(count, spec.size, ctx.internalArena)
+	end
+	-- Autosize gives each persistent array its own buffer so it can be replaced
+	local buffer = ffi.new(spec.bufferType, count)
+	sizing.persistent[spec.field] = buffer
+	return buffer
 end
 
 local function Llay__InitializePersistentMemory(ctx)
-	local max = ctx.maxElementCount
-	local maxMeasure = ctx.maxMeasureTextCacheWordCount
-	local arena = ctx.internalArena
+	for _, spec in ipairs(LLAY__PERSISTENT_ARRAYS) do
+		local count = Llay__PersistentCount(ctx, spec)
+		local array = ctx[spec.field]
+		array.capacity = count
+		array.length = 0
+		array.internalArray = ffi.cast(spec.ptrType, Llay__AllocatePersistentArray(ctx, spec, count))
+	end
+	ffi.fill(ctx.layoutMemo.internalArray, ctx.layoutMemo.capacity * ffi.sizeof("Llay__LayoutMemoItem"))
 
-	ctx.scrollContainerDatas = {
-		capacity = 100,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay__ScrollContainerDataInternal*",
-			Llay__Array_Allocate_Arena(100, ffi.sizeof("Clay__ScrollContainerDataInternal"), arena)
-		),
-	}
-	ctx.layoutElementsHashMapInternal = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay_LayoutElementHashMapItem*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay_LayoutElementHashMapItem"), arena)
-		),
-	}
-	ctx.layoutElementsHashMap =
-		{ capacity = max, length = 0, internalArray = ffi.cast("int32_t*", Llay__Array_Allocate_Arena(max, 4, arena)) }
-	ctx.measureTextHashMapInternal = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay__MeasureTextCacheItem*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay__MeasureTextCacheItem"), arena)
-		),
-	}
-	ctx.measureTextHashMapInternalFreeList =
-		{ capacity = max, length = 0, internalArray = ffi.cast("int32_t*", Llay__Array_Allocate_Arena(max, 4, arena)) }
-	ctx.measuredWordsFreeList = {
-		capacity = maxMeasure,
-		length = 0,
-		internalArray = ffi.cast("int32_t*", Llay__Array_Allocate_Arena(maxMeasure, 4, arena)),
-	}
-	ctx.measureTextHashMap =
-		{ capacity = max, length = 0, internalArray = ffi.cast("int32_t*", Llay__Array_Allocate_Arena(max, 4, arena)) }
-	ctx.measuredWords = {
-		capacity = maxMeasure,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay__MeasuredWord*",
-			Llay__Array_Allocate_Arena(maxMeasure, ffi.sizeof("Clay__MeasuredWord"), arena)
-		),
-	}
-	ctx.pointerOverIds = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay_ElementId*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay_ElementId"), arena)
-		),
-	}
-	ctx.debugElementData = {
-		capacity = max,
-		length = 0,
-		internalArray = ffi.cast(
-			"Clay__DebugElementData*",
-			Llay__Array_Allocate_Arena(max, ffi.sizeof("Clay__DebugElementData"), arena)
-		),
+	ctx.arenaResetOffset = tonumber(ctx.internalArena.nextAllocation)
+end
+
+-- Enlarges the persistent arrays to the new element and measured word counts, keeping
+-- their contents. Item indices stay valid; both hash tables are re-bucketed.
+local function Llay__GrowPersistentMemory(ctx, sizing, elements, words)
+	local oldElementBuckets = ctx.layoutElementsHashMap.internalArray
+	local oldElementBucketCount = ctx.layoutElementsHashMap.capacity
+	local oldMeasureBuckets = ctx.measureTextHashMap.internalArray
+	local oldMeasureBucketCount = ctx.maxMeasureTextCacheWordCount / 32
+	local oldDebugData = ctx.debugElementData.internalArray
+	local oldDebugCapacity = ctx.debugElementData.capacity
+	-- Replaced buffers stay referenced until everything is re-linked
+	local retired = {}
+	sizing.retired = retired
+
+	ctx.maxElementCount = elements
+	ctx.maxMeasureTextCacheWordCount = words
+	for _, spec in ipairs(LLAY__PERSISTENT_ARRAYS) do
+		local array = ctx[spec.field]
+		local count = Llay__PersistentCount(ctx, spec)
+		if spec.rehash or count > array.capacity then
+			local buffer = ffi.new(spec.bufferType, count)
+			if spec.grow then
+				ffi.copy(buffer, array.internalArray, array.capacity * spec.size)
+			end
+			retired[#retired + 1] = sizing.persistent[spec.field]
+			sizing.persistent[spec.field] = buffer
+			array.internalArray = ffi.cast(spec.ptrType, buffer)
+			array.capacity = count
+		end
+	end
+
+	local items = ctx.layoutElementsHashMapInternal.internalArray
+	local buckets = ctx.layoutElementsHashMap.internalArray
+	local bucketCount = ctx.layoutElementsHashMap.capacity
+	for i = 0, bucketCount - 1 do
+		buckets[i] = -1
+	end
+	for b = 0, oldElementBucketCount - 1 do
+		local index = oldElementBuckets[b]
+		while index ~= -1 do
+			local item = items + index
+			local nextIndex = item.nextIndex
+			local bucket = item.elementId.id % bucketCount
+			item.nextIndex = buckets[bucket]
+			buckets[bucket] = index
+			index = nextIndex
+		end
+	end
+
+	local measureItems = ctx.measureTextHashMapInternal.internalArray
+	local measureBuckets = ctx.measureTextHashMap.internalArray
+	local measureBucketCount = words / 32
+	for b = 0, oldMeasureBucketCount - 1 do
+		local index = oldMeasureBuckets[b]
+		while index ~= 0 do
+			local item = measureItems + index
+			local nextIndex = item.nextIndex
+			local bucket = item.id % measureBucketCount
+			item.nextIndex = measureBuckets[bucket]
+			measureBuckets[bucket] = index
+			index = nextIndex
+		end
+	end
+
+	-- Hash map items point at their debug data
+	local debugData = ctx.debugElementData.internalArray
+	if debugData ~= oldDebugData then
+		for i = 0, ctx.layoutElementsHashMapInternal.length - 1 do
+			local item = items + i
+			local offset = tonumber(item.debugData - oldDebugData)
+			if offset >= 0 and offset < oldDebugCapacity then
+				item.debugData = debugData + offset
+			else
+				item.debugData = array_add(ctx.debugElementData, _EMPTY_DEBUG_DATA)
+			end
+		end
+	end
+end
+
+local function Llay__AllocateEphemeralBlock(ctx, sizing)
+	local bytes = sizing.capacity.text + sizing.capacity.layoutElements * 2 + 64
+	for _, spec in ipairs(LLAY__EPHEMERAL_ARRAYS) do
+		bytes = bytes + Llay__EphemeralCapacity(ctx, sizing, spec) * spec.size + 64
+	end
+	if sizing.block then
+		sizing.resizes = sizing.resizes + 1
+	end
+	sizing.block = ffi.new("uint8_t[?]", bytes)
+	sizing.blockSize = bytes
+	sizing.chunks = {}
+	sizing.chunkBytes = 0
+end
+
+-- Autosize, between frames: records the high-water mark of each array for the frame
+-- that just ended, grows whatever overflowed or spilled, and after shrinkAfter frames
+-- re-fits every array to its peak over that window.
+local function Llay__TuneArenaSizing(ctx, sizing)
+	local capacity, peak, dropped = sizing.capacity, sizing.peak, sizing.dropped
+	local headroom = sizing.headroom
+	sizing.retired = nil
+	if sizing.block == nil then
+		Llay__AllocateEphemeralBlock(ctx, sizing)
+		return
+	end
+
+	local text = sizing.spilledBytes + tonumber(ctx.internalArena.nextAllocation) - sizing.arrayBytes
+	peak.text = LLAY__MAX(peak.text, text)
+	for i = 1, #LLAY__TUNED_ARRAYS do
+		local field = LLAY__TUNED_ARRAYS[i]
+		peak[field] = LLAY__MAX(peak[field], ctx[field].length + dropped[field])
+	end
+
+	local resize = false
+	local scale = 1
+	if ctx.booleanWarnings.maxElementsExceeded then
+		-- Declarations after the first full array were dropped, so every count is short
+		-- by about the share of elements that never made it in
+		local declared = LLAY__MAX(ctx.layoutElements.length, 1)
+		scale = (declared + dropped.layoutElements) / declared
+		for i = 1, #LLAY__TUNED_ARRAYS do
+			local field = LLAY__TUNED_ARRAYS[i]
+			peak[field] = LLAY__MAX(peak[field], math.ceil(ctx[field].length * scale))
+		end
+		peak.text = LLAY__MAX(peak.text, math.ceil(text * scale))
+		-- Layout-phase arrays are empty when declaration overflowed: assume at least a
+		-- line per text element and a command per element
+		peak.wrappedTextLines = LLAY__MAX(peak.wrappedTextLines, peak.textElementData)
+		peak.renderCommands = LLAY__MAX(peak.renderCommands, peak.layoutElements)
+		for key, cap in pairs(capacity) do
+			capacity[key] = LLAY__MAX(cap, math.ceil(peak[key] * headroom))
+		end
+		sizing.overflows = sizing.overflows + 1
+		resize = true
+	elseif #sizing.chunks > 0 then
+		capacity.text = LLAY__MAX(capacity.text, math.ceil(peak.text * headroom))
+		resize = true
+	end
+
+	sizing.frames = sizing.frames + 1
+	if sizing.frames >= sizing.shrinkAfter then
+		for key, cap in pairs(capacity) do
+			local minimum = key == "text" and LLAY__MIN_TEXT_BYTES or LLAY__MIN_ARRAY_CAPACITY
+			local fitted = LLAY__MAX(minimum, math.ceil(peak[key] * headroom))
+			if fitted < cap / 2 then
+				capacity[key] = fitted
+				resize = true
+			end
+			peak[key] = 0
+		end
+		sizing.frames = 0
+	end
+
+	-- Persistent arrays only grow: they hold ids and cached measurements across frames
+	local elements = ctx.maxElementCount
+	local words = ctx.maxMeasureTextCacheWordCount
+	local items = LLAY__MAX(ctx.layoutElementsHashMapInternal.length,
+		math.ceil((ctx.measureTextHashMapInternal.length + dropped.measureTextHashMapInternal) * scale))
+	local measuredWords = math.ceil((ctx.measuredWords.length + dropped.measuredWords) * scale)
+	while elements < capacity.layoutElements or items * 4 > elements * 3 do
+		elements = elements * 2
+	end
+	while measuredWords * 4 > words * 3 do
+		words = words * 2
+	end
+	if elements ~= ctx.maxElementCount or words ~= ctx.maxMeasureTextCacheWordCount then
+		Llay__GrowPersistentMemory(ctx, sizing, elements, words)
+	end
+
+	if resize then
+		Llay__AllocateEphemeralBlock(ctx, sizing)
+	end
+end
+
+-- Carves every per-frame array out of the arena and remembers where they went
+local function Llay__CarveEphemeralArrays(ctx, sizing, block)
+	local arena = ctx.internalArena
+	if sizing then
+		arena.memory = ffi.cast("char*", sizing.block)
+		arena.capacity = sizing.blockSize
+		arena.nextAllocation = 0
+	else
+		-- Reset Arena
+		arena.nextAllocation = ffi.cast("uintptr_t", ctx.arenaResetOffset)
+	end
+	-- The array references are kept, so resetting them later creates no cdata
+	local arrays = {}
+	for i = 1, #LLAY__EPHEMERAL_ARRAYS do
+		local spec = LLAY__EPHEMERAL_ARRAYS[i]
+		local capacity = Llay__EphemeralCapacity(ctx, sizing, spec)
+		local array = ctx[spec.field]
+		array.capacity = capacity
+		array.length = 0
+		array.internalArray = ffi.cast(spec.ptrType, Llay__Array_Allocate_Arena(capacity, spec.size, arena))
+		arrays[i] = array
+	end
+	local carved = {
+		context = ctx,
+		block = block,
+		elements = ctx.maxElementCount,
+		nextAllocation = tonumber(arena.nextAllocation),
+		arrays = arrays,
 	}
+	-- Arrays that spilled out of the block are not reused: the next frame resizes
+	if not (sizing and #sizing.chunks > 0) then
+		_ANCHORS.carvedArrays = carved
+	end
+	return carved
+end
+
+local function Llay__InitializeEphemeralMemory(ctx)
+	local sizing = _ANCHORS.sizing
+	if sizing then
+		Llay__TuneArenaSizing(ctx, sizing)
+	end
+	ctx.booleanWarnings.maxElementsExceeded = false
+
+	-- Reset command template to clean state
+	ffi.fill(_CMD_TEMPLATE, ffi.sizeof("Clay_RenderCommand"))
+
+	-- Arrays are carved from the arena in the same order every frame: while the block
+	-- and the capacities stay put, last frame's pointers are still right and only the
+	-- lengths need resetting
+	local block = sizing and sizing.block or _ANCHORS.arena_memory
+	local carved = _ANCHORS.carvedArrays
+	if carved and carved.context == ctx and carved.block == block and carved.elements == ctx.maxElementCount then
+		ctx.internalArena.nextAllocation = carved.nextAllocation
+		local arrays = carved.arrays
+		for i = 1, #arrays do
+			arrays[i].length = 0
+		end
+	else
+		carved = Llay__CarveEphemeralArrays(ctx, sizing, block)
+	end
+
+	-- Reserve index 0 as the default layout config.
+	-- Many code paths (e.g. text elements) assume `layoutConfigs.internalArray` points
+	-- at a sane FIT-sized config, not the root container's fixed-size config.
+	array_add(ctx.layoutConfigs, _EMPTY_LAYOUT_CONFIG)
+
+	ctx.layoutMemoReusedCount = 0
+	ctx.hitTestIndexValid = false
 
-	ctx.arenaResetOffset = tonumber(arena.nextAllocation)
+	if sizing then
+		sizing.arrayBytes = carved.nextAllocation
+		sizing.spilledBytes = 0
+		for i = 1, #LLAY__COUNTED_ARRAYS do
+			sizing.dropped[LLAY__COUNTED_ARRAYS[i]] = 0
+		end
+	end
 end
 
 -- ==================================================================================
@@ -744,22 +1290,28 @@ local function Llay__StoreClipElementConfig(config)
 	return array_add(context.clipElementConfigs, config)
 end
 
+-- Config lookups read the presence mask and slot indices that
+-- Llay__AttachElementConfig / open_text_element fill in layoutElementConfigIndexes,
+-- instead of scanning the slice. A pointer outside this frame's elements (the
+-- overflow scratch) has no configs.
 local function Llay__ElementHasConfig(element, configType)
-	for i = 0, element.elementConfigs.length - 1 do
-		if element.elementConfigs.internalArray[i].type == configType then
-			return true
-		end
+	local index = tonumber(element - context.layoutElements.internalArray)
+	if index < 0 or index >= context.layoutElements.length then
+		return false
 	end
-	return false
+	return bit.band(context.layoutElementConfigIndexes.internalArray[index].mask, bit.lshift(1, configType)) ~= 0
 end
 
 local function Llay__FindElementConfigWithType(element, configType)
-	for i = 0, element.elementConfigs.length - 1 do
-		if element.elementConfigs.internalArray[i].type == configType then
-			return element.elementConfigs.internalArray[i].config
-		end
+	local index = tonumber(element - context.layoutElements.internalArray)
+	if index < 0 or index >= context.layoutElements.length then
+		return nil
 	end
-	return nil
+	local configIndex = context.layoutElementConfigIndexes.internalArray[index]
+	if bit.band(configIndex.mask, bit.lshift(1, configType)) == 0 then
+		return nil
+	end
+	return element.elementConfigs.internalArray[configIndex.slots[configType]].config
 end
 
 local function Llay__GetOpenLayoutElement()
@@ -784,7 +1336,8 @@ local function Llay__UpdateAspectRatioBox(element)
 	end
 end
 
-local function Llay__AttachElementConfig(configUnion, typeVal)
+-- field names the member of the config union that config is stored in
+local function Llay__AttachElementConfig(field, config, typeVal)
 	if context.booleanWarnings.maxElementsExceeded then
 		return
 	end
@@ -797,10 +1350,19 @@ local function Llay__AttachElementConfig(configUnion, typeVal)
 		openElement.elementConfigs.internalArray = context.elementConfigs.internalArray + context.elementConfigs.length
 	end
 
-	openElement.elementConfigs.length = openElement.elementConfigs.length + 1
-	local elemConfig = array_add(context.elementConfigs, ffi.new("Clay_ElementConfig"))
+	local slot = openElement.elementConfigs.length
+	openElement.elementConfigs.length = slot + 1
+	local elemConfig = array_add(context.elementConfigs, _EMPTY_ELEMENT_CONFIG)
 	elemConfig.type = typeVal
-	elemConfig.config = configUnion
+	elemConfig.config[field] = config
+
+	local typeBit = bit.lshift(1, typeVal)
+	local configIndex = context.layoutElementConfigIndexes.internalArray[
+		context.openLayoutElementStack.internalArray[context.openLayoutElementStack.length - 1]]
+	if bit.band(configIndex.mask, typeBit) == 0 then
+		configIndex.mask = bit.bor(configIndex.mask, typeBit)
+		configIndex.slots[typeVal] = slot
+	end
 end
 
 local function Llay__ConfigureOpenElement(declaration)
@@ -811,26 +1373,19 @@ local function Llay__ConfigureOpenElement(declaration)
 
 	openLayoutElement.layoutConfig = Llay__StoreLayoutConfig(declaration.layout)
 
-	local sharedConfig = nil
-	if declaration.backgroundColor.a > 0 then
-		sharedConfig = Llay__StoreSharedElementConfig({
-			backgroundColor = declaration.backgroundColor,
-			cornerRadius = declaration.cornerRadius,
-			userData = declaration.userData,
-		})
-		Llay__AttachElementConfig({ sharedElementConfig = sharedConfig }, Llay__ElementConfigType.SHARED)
-	elseif declaration.cornerRadius.topLeft > 0 or declaration.userData ~= nil then
-		sharedConfig = Llay__StoreSharedElementConfig({
-			backgroundColor = declaration.backgroundColor,
-			cornerRadius = declaration.cornerRadius,
-			userData = declaration.userData,
-		})
-		Llay__AttachElementConfig({ sharedElementConfig = sharedConfig }, Llay__ElementConfigType.SHARED)
+	if declaration.backgroundColor.a > 0 or declaration.cornerRadius.topLeft > 0 or declaration.userData ~= nil
+		or declaration.layer then
+		local sharedConfig = Llay__StoreSharedElementConfig(_EMPTY_SHARED_CONFIG)
+		sharedConfig.backgroundColor = declaration.backgroundColor
+		sharedConfig.cornerRadius = declaration.cornerRadius
+		sharedConfig.userData = declaration.userData
+		sharedConfig.layer = declaration.layer
+		Llay__AttachElementConfig("sharedElementConfig", sharedConfig, Llay__ElementConfigType.SHARED)
 	end
 
 	if declaration.image.imageData ~= nil then
 		local imageConfig = Llay__StoreImageElementConfig(declaration.image)
-		Llay__AttachElementConfig({ imageElementConfig = imageConfig }, Llay__ElementConfigType.IMAGE)
+		Llay__AttachElementConfig("imageElementConfig", imageConfig, Llay__ElementConfigType.IMAGE)
 	end
 
 	if declaration.floating.attachTo ~= 0 then
@@ -853,28 +1408,32 @@ local function Llay__ConfigureOpenElement(declaration)
 
 		local currentElemIdx = context.openLayoutElementStack.internalArray[context.openLayoutElementStack.length - 1]
 
-		local root = array_add(context.layoutElementTreeRoots, ffi.new("Clay__LayoutElementTreeRoot"))
+		local root = array_add(context.layoutElementTreeRoots, _EMPTY_TREE_ROOT)
 		root.layoutElementIndex = currentElemIdx
 		root.parentId = floatingConfig.parentId
 		root.clipElementId = clipElementId
 		root.zIndex = floatingConfig.zIndex
-		
+		if root.zIndex < context.layoutElementTreeRoots.internalArray[context.layoutElementTreeRoots.length - 2].zIndex then
+			context.treeRootsUnsorted = true
+		end
+
 		int32_array_add(context.openClipElementStack, openLayoutElement.id)
 
 		Llay__AttachElementConfig(
-			{ floatingElementConfig = Llay__StoreFloatingElementConfig(floatingConfig) },
+			"floatingElementConfig",
+			Llay__StoreFloatingElementConfig(floatingConfig),
 			Llay__ElementConfigType.FLOATING
 		)
 	end
 
 	if declaration.custom.customData ~= nil then
 		local customConfig = Llay__StoreCustomElementConfig(declaration.custom)
-		Llay__AttachElementConfig({ customElementConfig = customConfig }, Llay__ElementConfigType.CUSTOM)
+		Llay__AttachElementConfig("customElementConfig", customConfig, Llay__ElementConfigType.CUSTOM)
 	end
 
 	if declaration.clip.horizontal or declaration.clip.vertical then
 		local clipConfig = Llay__StoreClipElementConfig(declaration.clip)
-		Llay__AttachElementConfig({ clipElementConfig = clipConfig }, Llay__ElementConfigType.CLIP)
+		Llay__AttachElementConfig("clipElementConfig", clipConfig, Llay__ElementConfigType.CLIP)
 
 		int32_array_add(context.openClipElementStack, openLayoutElement.id)
 
@@ -883,15 +1442,18 @@ local function Llay__ConfigureOpenElement(declaration)
 			if context.scrollContainerDatas.internalArray[i].elementId == openLayoutElement.id then
 				context.scrollContainerDatas.internalArray[i].layoutElement = openLayoutElement
 				context.scrollContainerDatas.internalArray[i].openThisFrame = true
+				context.scrollContainerDatas.internalArray[i].openGeneration = context.generation
 				found = true
 			end
 		end
 		if not found then
-			local scrollData = array_add(context.scrollContainerDatas, ffi.new("Clay__ScrollContainerDataInternal"))
+			local scrollData = array_add(context.scrollContainerDatas, _EMPTY_SCROLL_DATA)
 			scrollData.layoutElement = openLayoutElement
 			scrollData.elementId = openLayoutElement.id
 			scrollData.openThisFrame = true
-			scrollData.scrollOrigin = { x = -1, y = -1 }
+			scrollData.openGeneration = context.generation
+			scrollData.scrollOrigin.x = -1
+			scrollData.scrollOrigin.y = -1
 		end
 	end
 
@@ -903,12 +1465,12 @@ local function Llay__ConfigureOpenElement(declaration)
 		or declaration.border.width.betweenChildren > 0
 	then
 		local borderConfig = Llay__StoreBorderElementConfig(declaration.border)
-		Llay__AttachElementConfig({ borderElementConfig = borderConfig }, Llay__ElementConfigType.BORDER)
+		Llay__AttachElementConfig("borderElementConfig", borderConfig, Llay__ElementConfigType.BORDER)
 	end
 
 	if declaration.aspectRatio.aspectRatio > 0 then
 		local aspectConfig = Llay__StoreAspectRatioElementConfig(declaration.aspectRatio)
-		Llay__AttachElementConfig({ aspectRatioElementConfig = aspectConfig }, Llay__ElementConfigType.ASPECT)
+		Llay__AttachElementConfig("aspectRatioElementConfig", aspectConfig, Llay__ElementConfigType.ASPECT)
 		int32_array_add(context.aspectRatioElementIndexes, context.layoutElements.length - 1)
 	end
 end
@@ -917,17 +1479,36 @@ end
 -- Text Measurement & Caching
 -- ==================================================================================
 
-local function Llay__HashStringContentsWithConfig(text, config)
-	local hash = 0
-	local offset = 0
-	-- Hash Text Chars
-	for i = 0, text.length - 1 do
-		local c = text.chars[i]  -- Direct access to char pointer
+-- Llay__HashChars() of every Lua string open_text_element() has seen, so a steady
+-- frame never runs the character loop; dropped whole once it outgrows the cache
+local _charsHashes = { byString = {}, count = 0 }
+
+-- str, when given, is the Lua string chars was copied from
+local function Llay__HashChars(chars, length, str)
+	local hash = str and _charsHashes.byString[str]
+	if hash then
+		return hash
+	end
+	hash = 0
+	for i = 0, length - 1 do
+		local c = chars[i]  -- Direct access to char pointer
 		hash = hash + c
 		hash = hash + bit.lshift(hash, 10)
 		hash = bit.bxor(hash, bit.rshift(hash, 6))
 	end
-	-- Hash Config
+	if str then
+		if _charsHashes.count >= context.maxMeasureTextCacheWordCount then
+			_charsHashes.byString = {}
+			_charsHashes.count = 0
+		end
+		_charsHashes.byString[str] = hash
+		_charsHashes.count = _charsHashes.count + 1
+	end
+	return hash
+end
+
+-- Finishes a Llay__HashChars() result into a measure cache id
+local function Llay__HashWithConfig(hash, config)
 	hash = hash + config.fontId
 	hash = hash + bit.lshift(hash, 10)
 	hash = bit.bxor(hash, bit.rshift(hash, 6))
@@ -940,10 +1521,11 @@ local function Llay__HashStringContentsWithConfig(text, config)
 	hash = hash + bit.lshift(hash, 10)
 	hash = bit.bxor(hash, bit.rshift(hash, 6))
 
-	hash = hash + bit.lshift(hash, 3)
+	hash = (hash + bit.lshift(hash, 3)) % 4294967296
 	hash = bit.bxor(hash, bit.rshift(hash, 11))
-	hash = hash + bit.lshift(hash, 15)
-	return hash + 1
+	hash = (hash + bit.lshift(hash, 15)) % 4294967296
+	-- Must fit the uint32_t id field or cache lookups never match
+	return (hash + 1) % 4294967296
 end
 
 local function Llay__AddMeasuredWord(word, previousWord)
@@ -953,38 +1535,218 @@ local function Llay__AddMeasuredWord(word, previousWord)
 		context.measuredWords.internalArray[newItemIndex] = word
 		previousWord.next = newItemIndex
 		return context.measuredWords.internalArray + newItemIndex
+	elseif context.measuredWords.length >= context.measuredWords.capacity then
+		-- Keep the chain terminated; the overflow slot takes the word
+		previousWord.next = -1
+		return Llay__ArrayOverflow(context.measuredWords)
 	else
 		previousWord.next = context.measuredWords.length
 		return array_add(context.measuredWords, word)
 	end
 end
 
-local function Llay__MeasureTextCached(text, config)
-	if not measure_text_fn then
-		return nil
-	end
+local _SCRATCH_MEASURED_WORD = ffi.new("Clay__MeasuredWord")
+local _MEASURED_WORDS_HEAD = ffi.new("Clay__MeasuredWord")
 
-	local id = Llay__HashStringContentsWithConfig(text, config)
-	local hashBucket = id % (context.maxMeasureTextCacheWordCount / 32)
-	local elementIndexPrevious = 0
-	local elementIndex = context.measureTextHashMap.internalArray[hashBucket]
+local function Llay__AddMeasuredWordValues(startOffset, length, width, previousWord)
+	local word = _SCRATCH_MEASURED_WORD
+	word.startOffset = startOffset
+	word.length = length
+	word.width = width
+	word.next = -1
+	return Llay__AddMeasuredWord(word, previousWord)
+end
 
-	-- Check Cache with Eviction Logic
-	while elementIndex ~= 0 do
-		local hashEntry = context.measureTextHashMapInternal.internalArray + elementIndex
-		if hashEntry.id == id then
-			hashEntry.generation = context.generation
-			return hashEntry
-		end
+-- Word spans for batched/glyph measurement. Grows by doubling, never per call.
+local _wordSpanCapacity = 256
+local _wordSpans = ffi.new("Llay_MeasureTextWord[?]", _wordSpanCapacity)
 
-		-- Eviction Logic: If item is old, free its words and remove from map
-		if context.generation - hashEntry.generation > 2 then
-			local nextWordIdx = hashEntry.measuredWordsStartIndex
+local function Llay__PushWordSpan(count, startOffset, length)
+	if count >= _wordSpanCapacity then
+		local grown = ffi.new("Llay_MeasureTextWord[?]", _wordSpanCapacity * 2)
+		ffi.copy(grown, _wordSpans, ffi.sizeof("Llay_MeasureTextWord") * _wordSpanCapacity)
+		_wordSpans = grown
+		_wordSpanCapacity = _wordSpanCapacity * 2
+	end
+	local span = _wordSpans[count]
+	span.startOffset = startOffset
+	span.length = length
+	span.width = 0
+	span.height = 0
+	return count + 1
+end
+
+-- Exact fontSize first, then a scalable table registered for the font
+local function Llay__FindGlyphTable(config)
+	local byFont = glyph_tables[config.fontId]
+	if not byFont then
+		return nil, 1
+	end
+	local glyphs = byFont[config.fontSize]
+	if glyphs then
+		return glyphs, 1
+	end
+	glyphs = byFont.scalable
+	if glyphs then
+		return glyphs, config.fontSize / glyphs.baseSize
+	end
+	return nil, 1
+end
+
+local function Llay__MeasureSpanWithGlyphs(span, bytes, config, glyphs, scale)
+	local advances = glyphs.advances
+	local kerning = glyphs.kerning
+	local letterSpacing = config.letterSpacing
+	local width = 0
+	local previous = -1
+	for i = span.startOffset, span.startOffset + span.length - 1 do
+		local c = bytes[i]
+		width = width + advances[c] * scale + letterSpacing
+		if kerning and previous >= 0 then
+			width = width + kerning(previous, c, config.fontId, config.fontSize)
+		end
+		previous = c
+	end
+	span.width = width
+	span.height = glyphs.lineHeight * scale
+end
+
+-- Measures every word of a string in one pass (glyph tables) or one callback (batch),
+-- then builds the same measured-word list as the per-word path below.
+local function Llay__MeasureWordsBatched(measured, text, config, glyphs, scale)
+	local chars = text.chars
+	local length = text.length
+
+	-- Pass 1: split into words at spaces/newlines, plus one space sample at the end
+	local count = 0
+	local firstSpace = -1
+	local start = 0
+	for current = 0, length - 1 do
+		local char = chars[current]
+		if char == 32 or char == 10 then
+			count = Llay__PushWordSpan(count, start, current - start)
+			if char == 32 and firstSpace < 0 then
+				firstSpace = current
+			end
+			start = current + 1
+		end
+	end
+	local trailing = length - start
+	if trailing > 0 then
+		count = Llay__PushWordSpan(count, start, trailing)
+	end
+	if firstSpace >= 0 then
+		count = Llay__PushWordSpan(count, firstSpace, 1)
+	end
+
+	-- Pass 2: widths
+	local spans = _wordSpans
+	if glyphs then
+		-- Index the tables by unsigned byte: chars is signed, so UTF-8 bytes would be negative
+		local bytes = ffi.cast("const uint8_t*", chars)
+		for i = 0, count - 1 do
+			Llay__MeasureSpanWithGlyphs(spans[i], bytes, config, glyphs, scale)
+		end
+	elseif count > 0 then
+		measure_text_batch_fn(text, spans, count, config, measure_text_batch_user_data)
+		if profiling then
+			_frameStats.measureTextCalls = _frameStats.measureTextCalls + 1
+		end
+	end
+	local spaceWidth = firstSpace >= 0 and spans[count - 1].width or 0
+
+	-- Pass 3: word list
+	local previousWord = _MEASURED_WORDS_HEAD
+	previousWord.next = -1
+	local lineWidth = 0
+	local measuredWidth = 0
+	local measuredHeight = 0
+	local spanIndex = 0
+	start = 0
+	for current = 0, length - 1 do
+		local char = chars[current]
+		if char == 32 or char == 10 then
+			local span = spans[spanIndex]
+			spanIndex = spanIndex + 1
+			local len = span.length
+			local width = 0
+			if len > 0 then
+				width = span.width
+				measuredHeight = LLAY__MAX(measuredHeight, span.height)
+			end
+			measured.minWidth = LLAY__MAX(width, measured.minWidth)
+
+			if char == 32 then
+				width = width + spaceWidth
+				previousWord = Llay__AddMeasuredWordValues(start, len + 1, width, previousWord)
+				lineWidth = lineWidth + width
+			else
+				if len > 0 then
+					previousWord = Llay__AddMeasuredWordValues(start, len, width, previousWord)
+				end
+				previousWord = Llay__AddMeasuredWordValues(current + 1, 0, 0, previousWord)
+				lineWidth = lineWidth + width
+				measuredWidth = LLAY__MAX(lineWidth, measuredWidth)
+				measured.containsNewlines = true
+				lineWidth = 0
+			end
+			start = current + 1
+		end
+	end
+
+	if trailing > 0 then
+		local span = spans[spanIndex]
+		Llay__AddMeasuredWordValues(start, trailing, span.width, previousWord)
+		lineWidth = lineWidth + span.width
+		measuredHeight = LLAY__MAX(measuredHeight, span.height)
+		measured.minWidth = LLAY__MAX(span.width, measured.minWidth)
+	end
+
+	measuredWidth = LLAY__MAX(lineWidth, measuredWidth) - config.letterSpacing
+	measured.measuredWordsStartIndex = _MEASURED_WORDS_HEAD.next
+	measured.unwrappedDimensions.width = measuredWidth
+	measured.unwrappedDimensions.height = measuredHeight
+	measured.spaceWidth = spaceWidth
+end
+
+-- id is Llay__HashWithConfig() of the text and config
+local function Llay__MeasureTextCached(text, config, id)
+	local glyphs, glyphScale = Llay__FindGlyphTable(config)
+	if not glyphs and not measure_text_batch_fn and not measure_text_fn then
+		return nil
+	end
+
+	local hashBucket = id % (context.maxMeasureTextCacheWordCount / 32)
+	local elementIndexPrevious = 0
+	local elementIndex = context.measureTextHashMap.internalArray[hashBucket]
+
+	-- Check Cache with Eviction Logic
+	while elementIndex ~= 0 do
+		local hashEntry = context.measureTextHashMapInternal.internalArray + elementIndex
+		if hashEntry.id == id then
+			hashEntry.generation = context.generation
+			if profiling then
+				_frameStats.measureCacheHits = _frameStats.measureCacheHits + 1
+			end
+			return hashEntry
+		end
+
+		-- Eviction Logic: If item is old, free its words and remove from map
+		if context.generation - hashEntry.generation > 2 then
+			if profiling then
+				_frameStats.measureCacheEvictions = _frameStats.measureCacheEvictions + 1
+			end
+			local nextWordIdx = hashEntry.measuredWordsStartIndex
 			while nextWordIdx ~= -1 do
 				local word = context.measuredWords.internalArray + nextWordIdx
 				int32_array_add(context.measuredWordsFreeList, nextWordIdx)
 				nextWordIdx = word.next
 			end
+			local nextLineIdx = hashEntry.wrappedLinesStartIndex
+			while nextLineIdx ~= -1 do
+				int32_array_add(context.wrappedLineCacheFreeList, nextLineIdx)
+				nextLineIdx = context.wrappedLineCache.internalArray[nextLineIdx].next
+			end
 
 			local nextIdx = hashEntry.nextIndex
 			hashEntry.measuredWordsStartIndex = -1
@@ -1003,25 +1765,45 @@ local function Llay__MeasureTextCached(text, config)
 	end
 
 	-- Create New Cache Item
+	if profiling then
+		_frameStats.measureCacheMisses = _frameStats.measureCacheMisses + 1
+	end
 	local newItemIndex = 0
 	if context.measureTextHashMapInternalFreeList.length > 0 then
 		newItemIndex = int32_array_remove_swapback(
 			context.measureTextHashMapInternalFreeList,
 			context.measureTextHashMapInternalFreeList.length - 1
 		)
+	elseif context.measureTextHashMapInternal.length >= context.measureTextHashMapInternal.capacity then
+		-- Cache full: this frame is dropped and the entry stays empty
+		local measured = Llay__ArrayOverflow(context.measureTextHashMapInternal)
+		measured.measuredWordsStartIndex = -1
+		measured.wrappedLinesStartIndex = -1
+		return measured
 	else
 		newItemIndex = context.measureTextHashMapInternal.length
 		context.measureTextHashMapInternal.length = context.measureTextHashMapInternal.length + 1
 	end
 
 	local measured = context.measureTextHashMapInternal.internalArray + newItemIndex
+	-- A slot off the free list still holds the evicted text's results
 	measured.measuredWordsStartIndex = -1
+	measured.minWidth = 0
+	measured.containsNewlines = false
+	measured.wrappedLinesStartIndex = -1
+	measured.wrappedLineCount = 0
+	measured.textLength = text.length
 	measured.id = id
 	measured.generation = context.generation
 	measured.nextIndex = context.measureTextHashMap.internalArray[hashBucket]
 	context.measureTextHashMap.internalArray[hashBucket] = newItemIndex
 
-	-- Measure Logic
+	if glyphs or measure_text_batch_fn then
+		Llay__MeasureWordsBatched(measured, text, config, glyphs, glyphScale)
+		return measured
+	end
+
+	-- Measure Logic (per-word callback fallback)
 	local start = 0
 	local current = 0
 	local lineWidth = 0
@@ -1029,8 +1811,10 @@ local function Llay__MeasureTextCached(text, config)
 	local measuredHeight = 0
 	local spaceWidth =
 		measure_text_fn(ffi.string(LLAY__SPACECHAR_CHARS), config, context.measureTextUserData).width
+	local measureCalls = 1
 
-	local tempWord = ffi.new("Clay__MeasuredWord", { next = -1 })
+	local tempWord = _MEASURED_WORDS_HEAD
+	tempWord.next = -1
 	local previousWord = tempWord
 
 	while current < text.length do
@@ -1040,6 +1824,7 @@ local function Llay__MeasureTextCached(text, config)
 			local dims = { width = 0, height = 0 }
 			if len > 0 then
 				dims = measure_text_fn(ffi.string(text.chars + start, len), config, context.measureTextUserData)
+				measureCalls = measureCalls + 1
 			end
 
 			measured.minWidth = LLAY__MAX(dims.width, measured.minWidth)
@@ -1047,22 +1832,15 @@ local function Llay__MeasureTextCached(text, config)
 
 			if char == 32 then
 				dims.width = dims.width + spaceWidth
-				previousWord = Llay__AddMeasuredWord(
-					{ startOffset = start, length = len + 1, width = dims.width, next = -1 },
-					previousWord
-				)
+				previousWord = Llay__AddMeasuredWordValues(start, len + 1, dims.width, previousWord)
 				lineWidth = lineWidth + dims.width
 			end
 
 			if char == 10 then
 				if len > 0 then
-					previousWord = Llay__AddMeasuredWord(
-						{ startOffset = start, length = len, width = dims.width, next = -1 },
-						previousWord
-					)
+					previousWord = Llay__AddMeasuredWordValues(start, len, dims.width, previousWord)
 				end
-				previousWord =
-					Llay__AddMeasuredWord({ startOffset = current + 1, length = 0, width = 0, next = -1 }, previousWord)
+				previousWord = Llay__AddMeasuredWordValues(current + 1, 0, 0, previousWord)
 				lineWidth = lineWidth + dims.width
 				measuredWidth = LLAY__MAX(lineWidth, measuredWidth)
 				measured.containsNewlines = true
@@ -1075,10 +1853,8 @@ local function Llay__MeasureTextCached(text, config)
 
 	if current - start > 0 then
 		local dims = measure_text_fn(ffi.string(text.chars + start, current - start), config, context.measureTextUserData)
-		Llay__AddMeasuredWord(
-			{ startOffset = start, length = current - start, width = dims.width, next = -1 },
-			previousWord
-		)
+		measureCalls = measureCalls + 1
+		Llay__AddMeasuredWordValues(start, current - start, dims.width, previousWord)
 		lineWidth = lineWidth + dims.width
 		measuredHeight = LLAY__MAX(measuredHeight, dims.height)
 		measured.minWidth = LLAY__MAX(dims.width, measured.minWidth)
@@ -1088,93 +1864,395 @@ local function Llay__MeasureTextCached(text, config)
 	measured.measuredWordsStartIndex = tempWord.next
 	measured.unwrappedDimensions.width = measuredWidth
 	measured.unwrappedDimensions.height = measuredHeight
+	measured.spaceWidth = spaceWidth
+	if profiling then
+		_frameStats.measureTextCalls = _frameStats.measureTextCalls + measureCalls
+	end
 
 	return measured
 end
 
+-- ==================================================================================
+-- Incremental Layout (Subtree Memoization)
+-- ==================================================================================
+-- Every element gets a content hash covering its id, layout config, attached configs
+-- and its children's hashes. Sizing results are stored per hash map slot, so a subtree
+-- whose hash and incoming size match the previous frame copies its sizes back instead
+-- of re-running the distribution passes.
+
+local LLAY__MEMO_HIT_X = 1
+local LLAY__MEMO_HIT_Y = 2
+
+local LLAY__MEMO_APPLY_WIDTH = 0
+local LLAY__MEMO_APPLY_CONTENT_HEIGHT = 1
+local LLAY__MEMO_APPLY_HEIGHT = 2
+
+local LLAY__LAYOUT_CONFIG_WORDS = ffi.sizeof("Clay_LayoutConfig") / 4
+local LLAY__TEXT_CONFIG_WORDS = ffi.sizeof("Clay_TextElementConfig") / 4
+
+local Llay__ConfigWords = {
+	[Llay__ElementConfigType.BORDER] = ffi.sizeof("Clay_BorderElementConfig") / 4,
+	[Llay__ElementConfigType.FLOATING] = ffi.sizeof("Clay_FloatingElementConfig") / 4,
+	[Llay__ElementConfigType.CLIP] = ffi.sizeof("Clay_ClipElementConfig") / 4,
+	[Llay__ElementConfigType.ASPECT] = ffi.sizeof("Clay_AspectRatioElementConfig") / 4,
+	[Llay__ElementConfigType.IMAGE] = ffi.sizeof("Clay_ImageElementConfig") / 4,
+	[Llay__ElementConfigType.TEXT] = LLAY__TEXT_CONFIG_WORDS,
+	[Llay__ElementConfigType.CUSTOM] = ffi.sizeof("Clay_CustomElementConfig") / 4,
+	[Llay__ElementConfigType.SHARED] = ffi.sizeof("Clay_SharedElementConfig") / 4,
+}
+
+local function Llay__HashWord(hash, word)
+	hash = bit.tobit(hash + word)
+	hash = bit.tobit(hash + bit.lshift(hash, 10))
+	return bit.bxor(hash, bit.rshift(hash, 6))
+end
+
+local function Llay__HashWords(hash, ptr, wordCount)
+	local words = ffi.cast("int32_t*", ptr)
+	for i = 0, wordCount - 1 do
+		hash = Llay__HashWord(hash, words[i])
+	end
+	return hash
+end
+
+local function Llay__FinalizeContentHash(hash)
+	hash = bit.tobit(hash + bit.lshift(hash, 3))
+	hash = bit.bxor(hash, bit.rshift(hash, 11))
+	hash = bit.tobit(hash + bit.lshift(hash, 15))
+	-- 0 is reserved for "cannot be memoized"
+	if hash == 0 then
+		hash = 1
+	end
+	return hash
+end
+
+local function Llay__HashTextElement(elemIdx, measured, textConfig)
+	local elem = context.layoutElements.internalArray + elemIdx
+	local memoIndex = context.layoutElementHashMapIndexes.internalArray[elemIdx]
+	context.layoutElementMemoIndexes.internalArray[elemIdx] = memoIndex
+	context.layoutElementMemoFlags.internalArray[elemIdx] = 0
+	if memoIndex < 0 then
+		context.layoutElementContentHashes.internalArray[elemIdx] = 0
+		return
+	end
+
+	local hash = Llay__HashWord(0, bit.tobit(elem.id))
+	hash = Llay__HashWord(hash, bit.tobit(measured.id))
+	hash = Llay__HashWords(hash, textConfig, LLAY__TEXT_CONFIG_WORDS)
+	context.layoutElementContentHashes.internalArray[elemIdx] = Llay__FinalizeContentHash(hash)
+end
+
+-- Called from close_element once the children slice is final.
+local function Llay__HashLayoutElement(elemIdx)
+	local elem = context.layoutElements.internalArray + elemIdx
+	local hashes = context.layoutElementContentHashes.internalArray
+	local memoIndex = context.layoutElementHashMapIndexes.internalArray[elemIdx]
+	context.layoutElementMemoIndexes.internalArray[elemIdx] = memoIndex
+	context.layoutElementMemoFlags.internalArray[elemIdx] = 0
+	hashes[elemIdx] = 0
+	if memoIndex < 0 then
+		return
+	end
+
+	local hash = Llay__HashWord(0, bit.tobit(elem.id))
+	hash = Llay__HashWords(hash, elem.layoutConfig, LLAY__LAYOUT_CONFIG_WORDS)
+	for i = 0, elem.elementConfigs.length - 1 do
+		local elementConfig = elem.elementConfigs.internalArray + i
+		local configType = tonumber(elementConfig.type)
+		hash = Llay__HashWord(hash, configType)
+		hash = Llay__HashWords(hash, elementConfig.config.sharedElementConfig, Llay__ConfigWords[configType] or 0)
+	end
+	for i = 0, elem.childrenOrTextContent.children.length - 1 do
+		local childHash = hashes[elem.childrenOrTextContent.children.elements[i]]
+		if childHash == 0 then
+			return
+		end
+		hash = Llay__HashWord(hash, childHash)
+	end
+	hash = Llay__HashWord(hash, elem.childrenOrTextContent.children.length)
+	hash = Llay__HashWord(hash, elem.floatingChildrenCount)
+	hashes[elemIdx] = Llay__FinalizeContentHash(hash)
+end
+
+-- Copies memoized results onto elemIdx and all of its descendants.
+local function Llay__ApplyMemoizedSubtree(elemIdx, mode)
+	local stack = context.reusableElementIndexBuffer
+	local memoArray = context.layoutMemo.internalArray
+	local memoIndexes = context.layoutElementMemoIndexes.internalArray
+	local flags = context.layoutElementMemoFlags.internalArray
+
+	stack.length = 0
+	int32_array_add(stack, elemIdx)
+	while stack.length > 0 do
+		stack.length = stack.length - 1
+		local idx = stack.internalArray[stack.length]
+		local elem = context.layoutElements.internalArray + idx
+		local memo = memoArray + memoIndexes[idx]
+
+		if mode == LLAY__MEMO_APPLY_WIDTH then
+			elem.dimensions.width = memo.dimensions.width
+			flags[idx] = LLAY__MEMO_HIT_X
+			if idx ~= elemIdx then
+				context.layoutMemoReusedCount = context.layoutMemoReusedCount + 1
+			end
+		elseif mode == LLAY__MEMO_APPLY_CONTENT_HEIGHT then
+			elem.dimensions.height = memo.contentHeight
+		else
+			elem.dimensions.height = memo.dimensions.height
+			flags[idx] = bit.bor(flags[idx], LLAY__MEMO_HIT_Y)
+		end
+
+		if not Llay__ElementHasConfig(elem, Llay__ElementConfigType.TEXT) then
+			for j = 0, elem.childrenOrTextContent.children.length - 1 do
+				int32_array_add(stack, elem.childrenOrTextContent.children.elements[j])
+			end
+		end
+	end
+end
+
+-- Sizing-pass hook: returns true if the subtree under elemIdx was restored from the memo
+-- and its children must not be pushed to the BFS.
+local function Llay__ReuseMemoizedSubtree(elemIdx, xAxis)
+	local hash = context.layoutElementContentHashes.internalArray[elemIdx]
+	local memoIndex = context.layoutElementMemoIndexes.internalArray[elemIdx]
+	if hash == 0 or memoIndex < 0 then
+		return false
+	end
+	local elem = context.layoutElements.internalArray + elemIdx
+	local memo = context.layoutMemo.internalArray + memoIndex
+	local flags = context.layoutElementMemoFlags.internalArray
+
+	if xAxis then
+		if
+			memo.contentHash ~= hash
+			or memo.generation ~= context.generation - 1
+			or memo.dimensions.width ~= elem.dimensions.width
+		then
+			return false
+		end
+		Llay__ApplyMemoizedSubtree(elemIdx, LLAY__MEMO_APPLY_WIDTH)
+	else
+		if bit.band(flags[elemIdx], LLAY__MEMO_HIT_X) == 0 or memo.dimensions.height ~= elem.dimensions.height then
+			return false
+		end
+		Llay__ApplyMemoizedSubtree(elemIdx, LLAY__MEMO_APPLY_HEIGHT)
+	end
+	return true
+end
+
+local function Llay__RecordLayoutMemo(contentHeightOnly)
+	local memoIndexes = context.layoutElementMemoIndexes.internalArray
+	local hashes = context.layoutElementContentHashes.internalArray
+	for i = 0, context.layoutElements.length - 1 do
+		local memoIndex = memoIndexes[i]
+		if memoIndex >= 0 and hashes[i] ~= 0 then
+			local elem = context.layoutElements.internalArray + i
+			local memo = context.layoutMemo.internalArray + memoIndex
+			if contentHeightOnly then
+				memo.contentHeight = elem.dimensions.height
+			else
+				memo.contentHash = hashes[i]
+				memo.generation = context.generation
+				memo.dimensions.width = elem.dimensions.width
+				memo.dimensions.height = elem.dimensions.height
+			end
+		end
+	end
+end
+
 -- ==================================================================================
 -- Sizing Algorithm
 -- ==================================================================================
 
-	local function Llay__SizeContainersAlongAxis(xAxis)
-	local bfsBuffer = context.layoutElementChildrenBuffer
-	local resizableContainerBuffer = context.openLayoutElementStack -- Reuse buffer as scratch
+-- Free space goes to children by water-filling: every child below the water level
+-- is raised to it, clamped to its own limit, and the level is set so the raised
+-- amounts add up to the space available. Clay reaches the same sizes by repeatedly
+-- nudging the smallest children toward the second smallest, which rescans all k
+-- children per step (O(k^2)); sorting starts and limits once makes it O(k log k).
+-- Compression is the same problem with sizes negated.
+
+local _fillStarts, _fillCaps = nil, nil
+local _fillCapacity = 0
+
+local function Llay__FillScratch(count)
+	if count > _fillCapacity then
+		_fillCapacity = LLAY__MAX(count, LLAY__MAX(_fillCapacity * 2, 64))
+		_fillStarts = ffi.new("double[?]", _fillCapacity)
+		_fillCaps = ffi.new("double[?]", _fillCapacity)
+	end
+	return _fillStarts, _fillCaps
+end
 
-	for rootIndex = 0, context.layoutElementTreeRoots.length - 1 do
-		bfsBuffer.length = 0
-		local root = context.layoutElementTreeRoots.internalArray[rootIndex]
-		local rootElement = context.layoutElements.internalArray + root.layoutElementIndex
-		int32_array_add(bfsBuffer, root.layoutElementIndex)
-		
-		if DEBUG_MODE then
-			print("[SIZE] Processing root " .. rootIndex .. " (element " .. root.layoutElementIndex .. ")")
-			print("[SIZE] Root has " .. rootElement.childrenOrTextContent.children.length .. " children")
-			for ci = 0, rootElement.childrenOrTextContent.children.length - 1 do
-				local childIdx = rootElement.childrenOrTextContent.children.elements[ci]
-				print("[SIZE]   Child " .. ci .. " is element index " .. childIdx)
+local function Llay__SiftDown(a, root, last)
+	local value = a[root]
+	while true do
+		local child = root * 2 + 1
+		if child > last then
+			break
+		end
+		if child < last and a[child] < a[child + 1] then
+			child = child + 1
+		end
+		if value >= a[child] then
+			break
+		end
+		a[root] = a[child]
+		root = child
+	end
+	a[root] = value
+end
+
+-- In-place ascending heapsort, no allocation
+local function Llay__SortDoubles(a, n)
+	for root = math.floor(n / 2) - 1, 0, -1 do
+		Llay__SiftDown(a, root, n - 1)
+	end
+	for last = n - 1, 1, -1 do
+		a[0], a[last] = a[last], a[0]
+		Llay__SiftDown(a, 0, last - 1)
+	end
+end
+
+-- Level L with sum(clamp(L - starts[i], 0, caps[i] - starts[i])) == amount, where
+-- caps[i] >= starts[i]. Sorts both arrays. Returns the highest cap when everything
+-- saturates before amount is used up.
+local function Llay__WaterLevel(starts, caps, count, amount)
+	Llay__SortDoubles(starts, count)
+	Llay__SortDoubles(caps, count)
+	local level = starts[0]
+	local filled = 0
+	local active = 0
+	local s, c = 0, 0
+	-- A cap never precedes its own start, so caps run out last
+	while c < count do
+		local x = caps[c]
+		if s < count and starts[s] <= x then
+			x = starts[s]
+		end
+		if active > 0 then
+			local room = active * (x - level)
+			if filled + room >= amount then
+				return level + (amount - filled) / active
 			end
+			filled = filled + room
 		end
+		level = x
+		while s < count and starts[s] == x do
+			active = active + 1
+			s = s + 1
+		end
+		while c < count and caps[c] == x do
+			active = active - 1
+			c = c + 1
+		end
+	end
+	return level
+end
 
-		-- Size floating containers to parent
-		if Llay__ElementHasConfig(rootElement, Llay__ElementConfigType.FLOATING) then
-			local floatingConfig =
-				Llay__FindElementConfigWithType(rootElement, Llay__ElementConfigType.FLOATING).floatingElementConfig
-			local parentItem = Llay__GetHashMapItem(floatingConfig.parentId)
-			if parentItem ~= nil then
-				local parentElement = parentItem.layoutElement
-				if rootElement.layoutConfig.sizing.width.type == Llay__SizingType.GROW then
-					rootElement.dimensions.width = parentElement.dimensions.width
-				elseif rootElement.layoutConfig.sizing.width.type == Llay__SizingType.PERCENT then
-					rootElement.dimensions.width = parentElement.dimensions.width
-						* rootElement.layoutConfig.sizing.width.size.percent
+-- Element pointers in the BFS below are scoped so none is in scope at an inner loop:
+-- loops get element indices and re-derive pointers from context. A cdata pointer
+-- held in a local across a loop is boxed on the heap every time a JIT trace links
+-- into that loop, since LuaJIT treats every local in scope at a jump as live.
+local function Llay__ElementAt(index)
+	return context.layoutElements.internalArray + index
+end
+
+	local function Llay__SizeContainersAlongAxis(xAxis)
+	for rootIndex = 0, context.layoutElementTreeRoots.length - 1 do
+		context.layoutElementChildrenBuffer.length = 0
+		local rootElementIndex = context.layoutElementTreeRoots.internalArray[rootIndex].layoutElementIndex
+		int32_array_add(context.layoutElementChildrenBuffer, rootElementIndex)
+
+		do
+			local rootElement = Llay__ElementAt(rootElementIndex)
+		
+			if DEBUG_MODE then
+				print("[SIZE] Processing root " .. rootIndex .. " (element " .. rootElementIndex .. ")")
+				print("[SIZE] Root has " .. rootElement.childrenOrTextContent.children.length .. " children")
+				for ci = 0, rootElement.childrenOrTextContent.children.length - 1 do
+					local childIdx = rootElement.childrenOrTextContent.children.elements[ci]
+					print("[SIZE]   Child " .. ci .. " is element index " .. childIdx)
 				end
-				if rootElement.layoutConfig.sizing.height.type == Llay__SizingType.GROW then
-					rootElement.dimensions.height = parentElement.dimensions.height
-				elseif rootElement.layoutConfig.sizing.height.type == Llay__SizingType.PERCENT then
-					rootElement.dimensions.height = parentElement.dimensions.height
-						* rootElement.layoutConfig.sizing.height.size.percent
+			end
+
+			-- Size floating containers to parent
+			if Llay__ElementHasConfig(rootElement, Llay__ElementConfigType.FLOATING) then
+				local floatingConfig =
+					Llay__FindElementConfigWithType(rootElement, Llay__ElementConfigType.FLOATING).floatingElementConfig
+				local parentItem = Llay__GetHashMapItem(floatingConfig.parentId)
+				if parentItem ~= nil then
+					local parentElement = parentItem.layoutElement
+					if rootElement.layoutConfig.sizing.width.type == Llay__SizingType.GROW then
+						rootElement.dimensions.width = parentElement.dimensions.width
+					elseif rootElement.layoutConfig.sizing.width.type == Llay__SizingType.PERCENT then
+						rootElement.dimensions.width = parentElement.dimensions.width
+							* rootElement.layoutConfig.sizing.width.size.percent
+					end
+					if rootElement.layoutConfig.sizing.height.type == Llay__SizingType.GROW then
+						rootElement.dimensions.height = parentElement.dimensions.height
+					elseif rootElement.layoutConfig.sizing.height.type == Llay__SizingType.PERCENT then
+						rootElement.dimensions.height = parentElement.dimensions.height
+							* rootElement.layoutConfig.sizing.height.size.percent
+					end
 				end
 			end
-		end
 
-		-- Size root
-		local rootSizing = xAxis and rootElement.layoutConfig.sizing.width or rootElement.layoutConfig.sizing.height
-		if rootSizing.type ~= Llay__SizingType.PERCENT then
-			local val = xAxis and rootElement.dimensions.width or rootElement.dimensions.height
-			val = LLAY__MIN(LLAY__MAX(val, rootSizing.size.minMax.min), rootSizing.size.minMax.max)
-			if xAxis then
-				rootElement.dimensions.width = val
-			else
-				rootElement.dimensions.height = val
+			-- Size root
+			local rootSizing = xAxis and rootElement.layoutConfig.sizing.width or rootElement.layoutConfig.sizing.height
+			if rootSizing.type ~= Llay__SizingType.PERCENT then
+				local val = xAxis and rootElement.dimensions.width or rootElement.dimensions.height
+				val = LLAY__MIN(LLAY__MAX(val, rootSizing.size.minMax.min), rootSizing.size.minMax.max)
+				if xAxis then
+					rootElement.dimensions.width = val
+				else
+					rootElement.dimensions.height = val
+				end
 			end
 		end
 
 		local i = 0
-		while i < bfsBuffer.length do
-			local parentIndex = int32_array_get(bfsBuffer, i)
-			local parent = context.layoutElements.internalArray + parentIndex
-			local parentConfig = parent.layoutConfig
+		while i < context.layoutElementChildrenBuffer.length do
+			local parentIndex = int32_array_get(context.layoutElementChildrenBuffer, i)
+			i = i + 1
 			
 			if DEBUG_MODE then
-				print("[BFS] Processing parent " .. parentIndex .. " (" .. bfsBuffer.length .. " in buffer)")
+				print("[BFS] Processing parent " .. parentIndex .. " (" .. context.layoutElementChildrenBuffer.length .. " in buffer)")
+			end
+
+			-- Unchanged subtree with unchanged incoming size: restore it and don't descend
+			if context.incrementalLayoutEnabled and Llay__ReuseMemoizedSubtree(parentIndex, xAxis) then
+				goto continue_parent
 			end
 
+			local childCount, parentSize, parentPadding, childGap, sizingAlongAxis
+			local parentClips = false
+			do
+				local parent = Llay__ElementAt(parentIndex)
+				local parentConfig = parent.layoutConfig
+				childCount = parent.childrenOrTextContent.children.length
+				parentSize = xAxis and parent.dimensions.width or parent.dimensions.height
+				parentPadding = xAxis and (parentConfig.padding.left + parentConfig.padding.right)
+					or (parentConfig.padding.top + parentConfig.padding.bottom)
+				sizingAlongAxis = (xAxis and parentConfig.layoutDirection == Llay_LayoutDirection.LEFT_TO_RIGHT)
+					or (not xAxis and parentConfig.layoutDirection == Llay_LayoutDirection.TOP_TO_BOTTOM)
+				childGap = parentConfig.childGap
+				-- If parent scrolls, grow elements expand to content size, not parent size
+				local clipConfig = Llay__FindElementConfigWithType(parent, Llay__ElementConfigType.CLIP)
+				if clipConfig ~= nil then
+					parentClips = (xAxis and clipConfig.clipElementConfig.horizontal)
+						or (not xAxis and clipConfig.clipElementConfig.vertical)
+				end
+			end
 			local growContainerCount = 0
-			local parentSize = xAxis and parent.dimensions.width or parent.dimensions.height
-			local parentPadding = xAxis and (parentConfig.padding.left + parentConfig.padding.right)
-				or (parentConfig.padding.top + parentConfig.padding.bottom)
 			local innerContentSize = 0
 			local totalPaddingAndGap = parentPadding
-			local sizingAlongAxis = (xAxis and parentConfig.layoutDirection == Llay_LayoutDirection.LEFT_TO_RIGHT)
-				or (not xAxis and parentConfig.layoutDirection == Llay_LayoutDirection.TOP_TO_BOTTOM)
-			local childGap = parentConfig.childGap
 
-			resizableContainerBuffer.length = 0
+			context.openLayoutElementStack.length = 0 -- Reused as the resizable container buffer
 
 			-- Pass 1: Identification & Content Calculation
-			for j = 0, parent.childrenOrTextContent.children.length - 1 do
-				local childIdx = parent.childrenOrTextContent.children.elements[j]
-				local child = context.layoutElements.internalArray + childIdx
+			for j = 0, childCount - 1 do
+				local childIdx = Llay__ElementAt(parentIndex).childrenOrTextContent.children.elements[j]
+				local child = Llay__ElementAt(childIdx)
 				local childSizing = xAxis and child.layoutConfig.sizing.width or child.layoutConfig.sizing.height
 				local childSize = xAxis and child.dimensions.width or child.dimensions.height
 
@@ -1192,9 +2270,9 @@ end
 					and child.childrenOrTextContent.children.length > 0
 				then
 					if DEBUG_MODE then
-						print("[BFS] Adding child " .. childIdx .. " (buffer size: " .. bfsBuffer.length .. "/" .. bfsBuffer.capacity .. ")")
+						print("[BFS] Adding child " .. childIdx .. " (buffer size: " .. context.layoutElementChildrenBuffer.length .. "/" .. context.layoutElementChildrenBuffer.capacity .. ")")
 					end
-					int32_array_add(bfsBuffer, childIdx)
+					int32_array_add(context.layoutElementChildrenBuffer, childIdx)
 				end
 
 				local isText = Llay__ElementHasConfig(child, Llay__ElementConfigType.TEXT)
@@ -1209,7 +2287,7 @@ end
 						)
 					)
 				then
-					int32_array_add(resizableContainerBuffer, childIdx)
+					int32_array_add(context.openLayoutElementStack, childIdx)
 				end
 
 				if sizingAlongAxis then
@@ -1229,9 +2307,9 @@ end
 			end
 
 			-- Pass 2: Percent Sizing
-			for j = 0, parent.childrenOrTextContent.children.length - 1 do
-				local childIdx = parent.childrenOrTextContent.children.elements[j]
-				local child = context.layoutElements.internalArray + childIdx
+			for j = 0, childCount - 1 do
+				local childIdx = Llay__ElementAt(parentIndex).childrenOrTextContent.children.elements[j]
+				local child = Llay__ElementAt(childIdx)
 				local childSizing = xAxis and child.layoutConfig.sizing.width or child.layoutConfig.sizing.height
 				if childSizing.type == Llay__SizingType.PERCENT then
 					local size = (parentSize - totalPaddingAndGap) * childSizing.size.percent
@@ -1253,158 +2331,76 @@ end
 				-- Compress
 				if sizeToDistribute < 0 then
 					-- If parent clips, don't compress children
-					local clipConfig = Llay__FindElementConfigWithType(parent, Llay__ElementConfigType.CLIP)
-					local canClip = clipConfig
-						and (
-							(xAxis and clipConfig.clipElementConfig.horizontal)
-							or (not xAxis and clipConfig.clipElementConfig.vertical)
-						)
-
-					if not canClip then
-						while sizeToDistribute < -LLAY__EPSILON and resizableContainerBuffer.length > 0 do
-							local largest = 0.0
-							local secondLargest = 0.0
-							local widthToAdd = sizeToDistribute -- negative value
-
-							-- Find largest and second largest to determine safe compression step
-							for k = 0, resizableContainerBuffer.length - 1 do
-								local idx = int32_array_get(resizableContainerBuffer, k)
-								local child = context.layoutElements.internalArray + idx
-								local childSize = xAxis and child.dimensions.width or child.dimensions.height
-								if not Llay__FloatEqual(childSize, largest) then
-									if childSize > largest then
-										secondLargest = largest
-										largest = childSize
-									elseif childSize > secondLargest then
-										secondLargest = childSize
-									end
-								end
-							end
-
-							if secondLargest > 0 then
-								widthToAdd = secondLargest - largest
-							end
-							widthToAdd = LLAY__MAX(widthToAdd, sizeToDistribute / resizableContainerBuffer.length)
-
-							local k = 0
-							while k < resizableContainerBuffer.length do
-								local idx = int32_array_get(resizableContainerBuffer, k)
-								local child = context.layoutElements.internalArray + idx
-								local current = xAxis and child.dimensions.width or child.dimensions.height
-								local min = xAxis and child.minDimensions.width or child.minDimensions.height
-
-								if Llay__FloatEqual(current, largest) then
-									local target = current + widthToAdd
-									if target <= min then
-										target = min
-										int32_array_remove_swapback(resizableContainerBuffer, k)
-										-- Don't increment k so we check swapped element
-									else
-										k = k + 1
-									end
-
-									if xAxis then
-										child.dimensions.width = target
-									else
-										child.dimensions.height = target
-									end
-
-									sizeToDistribute = sizeToDistribute - (target - current)
-								else
-									k = k + 1
-								end
+					if not parentClips and sizeToDistribute < -LLAY__EPSILON and context.openLayoutElementStack.length > 0 then
+						-- Lower the largest children to a common level, none below its minimum
+						local count = context.openLayoutElementStack.length
+						local starts, caps = Llay__FillScratch(count)
+						for k = 0, count - 1 do
+							local child = Llay__ElementAt(int32_array_get(context.openLayoutElementStack, k))
+							local current = xAxis and child.dimensions.width or child.dimensions.height
+							local min = xAxis and child.minDimensions.width or child.minDimensions.height
+							starts[k] = -current
+							caps[k] = -LLAY__MIN(min, current)
+						end
+						local level = -Llay__WaterLevel(starts, caps, count, -sizeToDistribute)
+						for k = 0, count - 1 do
+							local child = Llay__ElementAt(int32_array_get(context.openLayoutElementStack, k))
+							if xAxis then
+								child.dimensions.width = LLAY__MIN(child.dimensions.width, LLAY__MAX(level, child.minDimensions.width))
+							else
+								child.dimensions.height = LLAY__MIN(child.dimensions.height, LLAY__MAX(level, child.minDimensions.height))
 							end
 						end
 					end
 
 				-- Expand
-				elseif sizeToDistribute > 0 and growContainerCount > 0 then
+				elseif sizeToDistribute > LLAY__EPSILON and growContainerCount > 0 then
 					-- Filter buffer to only include GROW elements
 					local k = 0
-					while k < resizableContainerBuffer.length do
-						local idx = int32_array_get(resizableContainerBuffer, k)
-						local child = context.layoutElements.internalArray + idx
+					while k < context.openLayoutElementStack.length do
+						local child = Llay__ElementAt(int32_array_get(context.openLayoutElementStack, k))
 						local sType = xAxis and child.layoutConfig.sizing.width.type
 							or child.layoutConfig.sizing.height.type
 						if sType ~= Llay__SizingType.GROW then
-							int32_array_remove_swapback(resizableContainerBuffer, k)
+							int32_array_remove_swapback(context.openLayoutElementStack, k)
 						else
 							k = k + 1
 						end
 					end
 
-					while sizeToDistribute > LLAY__EPSILON and resizableContainerBuffer.length > 0 do
-						local smallest = LLAY__MAXFLOAT
-						local secondSmallest = LLAY__MAXFLOAT
-						local widthToAdd = sizeToDistribute
-
-						for k = 0, resizableContainerBuffer.length - 1 do
-							local idx = int32_array_get(resizableContainerBuffer, k)
-							local child = context.layoutElements.internalArray + idx
-							local childSize = xAxis and child.dimensions.width or child.dimensions.height
-							if not Llay__FloatEqual(childSize, smallest) then
-								if childSize < smallest then
-									secondSmallest = smallest
-									smallest = childSize
-								elseif childSize < secondSmallest then
-									secondSmallest = childSize
-								end
-							end
-						end
-
-						if secondSmallest ~= LLAY__MAXFLOAT then
-							widthToAdd = secondSmallest - smallest
-						end
-						widthToAdd = LLAY__MIN(widthToAdd, sizeToDistribute / resizableContainerBuffer.length)
-
-						local k = 0
-						while k < resizableContainerBuffer.length do
-							local idx = int32_array_get(resizableContainerBuffer, k)
-							local child = context.layoutElements.internalArray + idx
+					-- Raise the smallest children to a common level, none above its maximum
+					local count = context.openLayoutElementStack.length
+					if count > 0 then
+						local starts, caps = Llay__FillScratch(count)
+						for k = 0, count - 1 do
+							local child = Llay__ElementAt(int32_array_get(context.openLayoutElementStack, k))
 							local current = xAxis and child.dimensions.width or child.dimensions.height
 							local max = xAxis and child.layoutConfig.sizing.width.size.minMax.max
 								or child.layoutConfig.sizing.height.size.minMax.max
-
-							if Llay__FloatEqual(current, smallest) then
-								local target = current + widthToAdd
-								if target >= max then
-									target = max
-									int32_array_remove_swapback(resizableContainerBuffer, k)
-								else
-									k = k + 1
-								end
-
-								if xAxis then
-									child.dimensions.width = target
-								else
-									child.dimensions.height = target
-								end
-
-								sizeToDistribute = sizeToDistribute - (target - current)
+							starts[k] = current
+							caps[k] = LLAY__MAX(max, current)
+						end
+						local level = Llay__WaterLevel(starts, caps, count, sizeToDistribute)
+						for k = 0, count - 1 do
+							local child = Llay__ElementAt(int32_array_get(context.openLayoutElementStack, k))
+							if xAxis then
+								child.dimensions.width = LLAY__MAX(child.dimensions.width, LLAY__MIN(level, child.layoutConfig.sizing.width.size.minMax.max))
 							else
-								k = k + 1
+								child.dimensions.height = LLAY__MAX(child.dimensions.height, LLAY__MIN(level, child.layoutConfig.sizing.height.size.minMax.max))
 							end
 						end
 					end
 				end
 			else
 				-- Off-Axis Sizing
-				for k = 0, resizableContainerBuffer.length - 1 do
-					local idx = int32_array_get(resizableContainerBuffer, k)
-					local child = context.layoutElements.internalArray + idx
+				local maxSize = parentSize - parentPadding
+				if parentClips then
+					maxSize = LLAY__MAX(maxSize, innerContentSize)
+				end
+				for k = 0, context.openLayoutElementStack.length - 1 do
+					local child = Llay__ElementAt(int32_array_get(context.openLayoutElementStack, k))
 					local childSizing = xAxis and child.layoutConfig.sizing.width or child.layoutConfig.sizing.height
 					local minSize = xAxis and child.minDimensions.width or child.minDimensions.height
-					local maxSize = parentSize - parentPadding
-
-					-- If parent scrolls, grow elements expand to content size, not parent size
-					if Llay__ElementHasConfig(parent, Llay__ElementConfigType.CLIP) then
-						local clipConfig =
-							Llay__FindElementConfigWithType(parent, Llay__ElementConfigType.CLIP).clipElementConfig
-						local directionCheck = (xAxis and clipConfig.horizontal) or (not xAxis and clipConfig.vertical)
-						if directionCheck then
-							maxSize = LLAY__MAX(maxSize, innerContentSize)
-						end
-					end
 
 					local val = xAxis and child.dimensions.width or child.dimensions.height
 					if childSizing.type == Llay__SizingType.GROW then
@@ -1420,7 +2416,7 @@ end
 					end
 				end
 			end
-			i = i + 1
+			::continue_parent::
 		end
 	end
 end
@@ -1429,263 +2425,786 @@ end
 -- Final Layout Calculation
 -- ==================================================================================
 
-local function Clay__CalculateFinalLayout()
-	if context.layoutElements.length == 0 then
-		return
-	end
-
-	-- 0. Sort roots by Z-index
-	M.sort_roots_by_z()
+local function Llay__TreeNodeAt(nodeIdx)
+	return context.layoutElementTreeNodeArray1.internalArray + nodeIdx
+end
 
-	-- Track roots that need an extra scissor end (to balance root.clipElementId scissor starts)
-	local rootNeedsExtraScissorEnd = {}
+local function Llay__PushTreeNode(elemIdx)
+	context.treeNodeVisited.internalArray[context.layoutElementTreeNodeArray1.length] = false
+	context.treeNodeElementIndexes.internalArray[context.layoutElementTreeNodeArray1.length] = elemIdx
+	local node = array_add(context.layoutElementTreeNodeArray1, _EMPTY_TREE_NODE)
+	node.layoutElement = context.layoutElements.internalArray + elemIdx
+	return node
+end
 
-	-- 1. Size X
-	Llay__SizeContainersAlongAxis(true)
+-- Breaks one text element into wrapped lines. The lines are cached on the element's
+-- measure cache item, so the same text and config at the same width copies them back
+-- next frame instead of walking the words again.
+local Llay__WrapTextElement
+do
+	local function Llay__AddWrappedLine(width, height, length, chars)
+		local line = array_add(context.wrappedTextLines, _EMPTY_WRAPPED_LINE)
+		line.dimensions.width = width
+		line.dimensions.height = height
+		line.line.length = length
+		line.line.chars = chars
+	end
 
-	-- 2. Text Wrapping
-	for i = 0, context.textElementData.length - 1 do
-		local textData = context.textElementData.internalArray + i
-		local elem = context.layoutElements.internalArray + textData.elementIndex
-		local textConfigUnion = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.TEXT)
-		if textConfigUnion == nil then goto continue_text_wrap end
-		local config = textConfigUnion.textElementConfig
-		local measured = Llay__MeasureTextCached(textData.text, config)
-
-		local lineWidth = 0
-		local lineHeight = config.lineHeight > 0 and config.lineHeight or textData.preferredDimensions.height
-		local lineLength = 0
-		local lineStart = 0
-		local startWrappedLinesCount = context.wrappedTextLines.length
+	-- Replaces the item's cached lines with the ones just added from startLine. Gives
+	-- up (leaving nothing cached) when the span pool can't hold them.
+	local function Llay__CacheWrappedLines(measured, width, startLine, chars)
+		local spans = context.wrappedLineCache
+		local freeList = context.wrappedLineCacheFreeList
+		local spanIdx = measured.wrappedLinesStartIndex
+		while spanIdx ~= -1 do
+			int32_array_add(freeList, spanIdx)
+			spanIdx = spans.internalArray[spanIdx].next
+		end
+		measured.wrappedLinesStartIndex = -1
+		measured.wrappedLineCount = 0
 
-		local wordIdx = measured.measuredWordsStartIndex
-		while wordIdx ~= -1 do
-			local word = context.measuredWords.internalArray + wordIdx
-			local shouldWrap = false
-			if config.wrapMode == Llay_TextElementConfigWrapMode.WORDS then
-				shouldWrap = (lineWidth + word.width > elem.dimensions.width)
-			elseif config.wrapMode == Llay_TextElementConfigWrapMode.NEWLINES then
-				shouldWrap = (word.length == 0)
-			end
-
-			if shouldWrap and lineLength > 0 then
-				array_add(context.wrappedTextLines, {
-					dimensions = { width = lineWidth, height = lineHeight },
-					line = { length = lineLength, chars = textData.text.chars + lineStart },
-				})
-				lineWidth = 0
-				lineLength = 0
-				lineStart = word.startOffset
+		local lineCount = context.wrappedTextLines.length - startLine
+		if freeList.length + spans.capacity - spans.length < lineCount then
+			return
+		end
+		-- Chained back to front so each new span becomes the head
+		for i = context.wrappedTextLines.length - 1, startLine, -1 do
+			local line = context.wrappedTextLines.internalArray + i
+			if freeList.length > 0 then
+				spanIdx = int32_array_remove_swapback(freeList, freeList.length - 1)
+			else
+				spanIdx = spans.length
+				spans.length = spans.length + 1
 			end
+			local span = spans.internalArray + spanIdx
+			span.startOffset = line.line.chars - chars
+			span.length = line.line.length
+			span.width = line.dimensions.width
+			span.next = measured.wrappedLinesStartIndex
+			measured.wrappedLinesStartIndex = spanIdx
+		end
+		measured.wrapWidth = width
+		measured.wrappedLineCount = lineCount
+	end
 
-			if word.length == 0 then
-				wordIdx = word.next
-				goto continue_word
+	function Llay__WrapTextElement(dataIndex)
+		local startWrappedLinesCount = context.wrappedTextLines.length
+		local elemWidth, lineHeight, spaceWidth, letterSpacing, wordIdx, spanIdx
+		do
+			local textData = context.textElementData.internalArray + dataIndex
+			local elem = Llay__ElementAt(textData.elementIndex)
+			local textConfigUnion = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.TEXT)
+			if textConfigUnion == nil then
+				return
+			end
+			local config = textConfigUnion.textElementConfig
+			local measured = textData.measured
+			lineHeight = config.lineHeight > 0 and config.lineHeight or textData.preferredDimensions.height
+
+			-- Fits on one line as measured
+			if not measured.containsNewlines and textData.preferredDimensions.width <= elem.dimensions.width then
+				Llay__AddWrappedLine(elem.dimensions.width, elem.dimensions.height, textData.text.length, textData.text.chars)
+				textData.wrappedLines.internalArray = context.wrappedTextLines.internalArray + startWrappedLinesCount
+				textData.wrappedLines.length = 1
+				return
+			end
+			elemWidth = elem.dimensions.width
+			spaceWidth = measured.spaceWidth
+			letterSpacing = config.letterSpacing
+			wordIdx = measured.measuredWordsStartIndex
+			if measured.wrappedLineCount > 0 and measured.wrapWidth == elemWidth then
+				spanIdx = measured.wrappedLinesStartIndex
 			end
-
-			lineWidth = lineWidth + word.width
-			lineLength = lineLength + word.length
-			wordIdx = word.next
-			::continue_word::
 		end
 
-		if lineLength > 0 then
-			array_add(context.wrappedTextLines, {
-				dimensions = { width = lineWidth, height = lineHeight },
-				line = { length = lineLength, chars = textData.text.chars + lineStart },
-			})
+		if spanIdx then
+			-- Same text, config and width as a previous wrap
+			if profiling then
+				_frameStats.wrapCacheHits = _frameStats.wrapCacheHits + 1
+			end
+			while spanIdx ~= -1 do
+				local chars = context.textElementData.internalArray[dataIndex].text.chars
+				local span = context.wrappedLineCache.internalArray + spanIdx
+				Llay__AddWrappedLine(span.width, lineHeight, span.length, chars + span.startOffset)
+				spanIdx = span.next
+			end
+		else
+			if profiling then
+				_frameStats.wrapCacheMisses = _frameStats.wrapCacheMisses + 1
+			end
+			local lineWidth = 0
+			local lineLength = 0
+			local lineStart = 0
+			while wordIdx ~= -1 do
+				local chars = context.textElementData.internalArray[dataIndex].text.chars
+				local word = context.measuredWords.internalArray + wordIdx
+				if lineLength == 0 and lineWidth + word.width > elemWidth then
+					-- A word wider than the element gets a line to itself
+					Llay__AddWrappedLine(word.width, lineHeight, word.length, chars + word.startOffset)
+					wordIdx = word.next
+					lineStart = word.startOffset + word.length
+				elseif word.length == 0 or lineWidth + word.width > elemWidth then
+					-- Newline, or the word doesn't fit: close the line without its trailing space
+					local trailingSpace = lineLength > 0 and chars[lineStart + lineLength - 1] == 32
+					Llay__AddWrappedLine(
+						trailingSpace and lineWidth - spaceWidth or lineWidth,
+						lineHeight,
+						trailingSpace and lineLength - 1 or lineLength,
+						chars + lineStart
+					)
+					if lineLength == 0 or word.length == 0 then
+						wordIdx = word.next
+					end
+					lineWidth = 0
+					lineLength = 0
+					lineStart = word.startOffset
+				else
+					lineWidth = lineWidth + word.width + letterSpacing
+					lineLength = lineLength + word.length
+					wordIdx = word.next
+				end
+			end
+
+			local textData = context.textElementData.internalArray + dataIndex
+			if lineLength > 0 then
+				Llay__AddWrappedLine(lineWidth - letterSpacing, lineHeight, lineLength, textData.text.chars + lineStart)
+			end
+			-- A dropped frame's measure item may be the overflow scratch
+			if not context.booleanWarnings.maxElementsExceeded then
+				Llay__CacheWrappedLines(textData.measured, elemWidth, startWrappedLinesCount, textData.text.chars)
+			end
 		end
 
+		local textData = context.textElementData.internalArray + dataIndex
 		local wrappedCount = context.wrappedTextLines.length - startWrappedLinesCount
-		
 		textData.wrappedLines.internalArray = context.wrappedTextLines.internalArray + startWrappedLinesCount
 		textData.wrappedLines.length = wrappedCount
 
-		elem.dimensions.height = lineHeight * LLAY__MAX(wrappedCount, 1)
-		::continue_text_wrap::
+		Llay__ElementAt(textData.elementIndex).dimensions.height = lineHeight * wrappedCount
 	end
+end
 
-	-- 3. Aspect Ratio Height
-	for i = 0, context.aspectRatioElementIndexes.length - 1 do
-		local idx = int32_array_get(context.aspectRatioElementIndexes, i)
-		local elem = context.layoutElements.internalArray + idx
-		local config = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.ASPECT).aspectRatioElementConfig
-		elem.dimensions.height = elem.dimensions.width / config.aspectRatio
+-- Height DFS, backtracking: fits an element's height to its children
+local function Llay__FitHeightToChildren(nodeIdx)
+	local childCount, height, paddingTop, paddingBottom, gap, minHeight, maxHeight, leftToRight
+	do
+		local elem = Llay__TreeNodeAt(nodeIdx).layoutElement
+		local layoutConfig = elem.layoutConfig
+		if
+			layoutConfig.layoutDirection ~= Llay_LayoutDirection.LEFT_TO_RIGHT
+			and layoutConfig.layoutDirection ~= Llay_LayoutDirection.TOP_TO_BOTTOM
+		then
+			return
+		end
+		childCount = elem.childrenOrTextContent.children.length
+		height = elem.dimensions.height
+		paddingTop, paddingBottom = layoutConfig.padding.top, layoutConfig.padding.bottom
+		gap = layoutConfig.childGap
+		minHeight = layoutConfig.sizing.height.size.minMax.min
+		maxHeight = layoutConfig.sizing.height.size.minMax.max
+		leftToRight = layoutConfig.layoutDirection == Llay_LayoutDirection.LEFT_TO_RIGHT
 	end
 
-	-- 4. DFS for Height Propagation
-	local dfsBuffer = context.layoutElementTreeNodeArray1
-	local tempNode = ffi.new("Clay__LayoutElementTreeNode")
-	dfsBuffer.length = 0
-	for i = 0, context.layoutElementTreeRoots.length - 1 do
-		local root = context.layoutElementTreeRoots.internalArray + i
-		context.treeNodeVisited.internalArray[dfsBuffer.length] = false
-		local node = array_add(dfsBuffer, ffi.new("Clay__LayoutElementTreeNode"))
-		node.layoutElement = context.layoutElements.internalArray + root.layoutElementIndex
+	if leftToRight then
+		for j = 0, childCount - 1 do
+			local child = Llay__ElementAt(Llay__TreeNodeAt(nodeIdx).layoutElement.childrenOrTextContent.children.elements[j])
+			local h = LLAY__MAX(child.dimensions.height + paddingTop + paddingBottom, height)
+			height = LLAY__MIN(LLAY__MAX(h, minHeight), maxHeight)
+		end
+	else
+		local contentHeight = paddingTop + paddingBottom
+		for j = 0, childCount - 1 do
+			local child = Llay__ElementAt(Llay__TreeNodeAt(nodeIdx).layoutElement.childrenOrTextContent.children.elements[j])
+			contentHeight = contentHeight + child.dimensions.height
+		end
+		contentHeight = contentHeight + (LLAY__MAX(childCount - 1, 0) * gap)
+		height = LLAY__MIN(LLAY__MAX(contentHeight, minHeight), maxHeight)
 	end
+	Llay__TreeNodeAt(nodeIdx).layoutElement.dimensions.height = height
+end
 
-	while dfsBuffer.length > 0 do
-		local nodeIdx = dfsBuffer.length - 1
-		local node = dfsBuffer.internalArray + nodeIdx
-		local currentElement = node.layoutElement
+-- Render DFS, backtracking: rectangles between the children of a border element
+local function Llay__AddBetweenChildrenBorders(nodeIdx)
+	local x, y, borderOffsetX, borderOffsetY, scrollOffsetX, scrollOffsetY, childCount, childGap, leftToRight
+	do
+		local node = Llay__TreeNodeAt(nodeIdx)
+		local elem = node.layoutElement
+		local layoutConfig = elem.layoutConfig
+		local halfGap = layoutConfig.childGap / 2
+		x, y = node.position.x, node.position.y
+		borderOffsetX = layoutConfig.padding.left - halfGap
+		borderOffsetY = layoutConfig.padding.top - halfGap
+		scrollOffsetX, scrollOffsetY = 0, 0
+		local clipConfig = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.CLIP)
+		if clipConfig ~= nil then
+			scrollOffsetX = clipConfig.clipElementConfig.childOffset.x
+			scrollOffsetY = clipConfig.clipElementConfig.childOffset.y
+		end
+		childCount = elem.childrenOrTextContent.children.length
+		childGap = layoutConfig.childGap
+		leftToRight = layoutConfig.layoutDirection == Llay_LayoutDirection.LEFT_TO_RIGHT
+	end
 
-		if not context.treeNodeVisited.internalArray[nodeIdx] then
+	for i = 0, childCount - 1 do
+		local elem = Llay__TreeNodeAt(nodeIdx).layoutElement
+		local child = Llay__ElementAt(elem.childrenOrTextContent.children.elements[i])
+		if i > 0 then
+			local borderConfig = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.BORDER).borderElementConfig
+			local sharedConfig = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.SHARED)
+			local cmd = array_add(context.renderCommands, nil)
+			if leftToRight then
+				cmd.boundingBox.x = x + borderOffsetX + scrollOffsetX
+				cmd.boundingBox.y = y + scrollOffsetY
+				cmd.boundingBox.width = borderConfig.width.betweenChildren
+				cmd.boundingBox.height = elem.dimensions.height
+			else -- TOP_TO_BOTTOM
+				cmd.boundingBox.x = x + scrollOffsetX
+				cmd.boundingBox.y = y + borderOffsetY + scrollOffsetY
+				cmd.boundingBox.width = elem.dimensions.width
+				cmd.boundingBox.height = borderConfig.width.betweenChildren
+			end
+			cmd.renderData.rectangle.backgroundColor = borderConfig.color
+			cmd.userData = sharedConfig and sharedConfig.sharedElementConfig.userData or nil
+			cmd.id = Llay__HashNumberId(elem.id, childCount + 1 + i)
+			cmd.commandType = Llay_RenderCommandType.RECTANGLE
+		end
+		if leftToRight then
+			borderOffsetX = borderOffsetX + child.dimensions.width + childGap
+		else
+			borderOffsetY = borderOffsetY + child.dimensions.height + childGap
+		end
+	end
+end
+
+-- Render DFS: one TEXT command per wrapped line
+local function Llay__AddTextCommands(nodeIdx)
+	local x, y, width, lineHeight, yPos, lineCount, textAlignment
+	do
+		local node = Llay__TreeNodeAt(nodeIdx)
+		local elem = node.layoutElement
+		local textConfig = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.TEXT).textElementConfig
+		local textData = elem.childrenOrTextContent.textElementData
+		x, y, width = node.position.x, node.position.y, elem.dimensions.width
+		lineHeight = textConfig.lineHeight > 0 and textConfig.lineHeight or textData.preferredDimensions.height
+		yPos = (lineHeight - textData.preferredDimensions.height) / 2
+		lineCount = textData.wrappedLines.length
+		textAlignment = tonumber(textConfig.textAlignment)
+		-- Text commands only point at their characters, so the render fingerprint
+		-- takes the content from the text's measure cache id
+		local hash = bit.tobit(context.textFingerprint + textData.measureId)
+		hash = hash + bit.lshift(hash, 10)
+		context.textFingerprint = bit.bxor(hash, bit.rshift(hash, 6))
+	end
+
+	for i = 0, lineCount - 1 do
+		local elem = Llay__TreeNodeAt(nodeIdx).layoutElement
+		local line = elem.childrenOrTextContent.textElementData.wrappedLines.internalArray + i
+		if line.line.length > 0 then
+			local textConfig = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.TEXT).textElementConfig
+			local offset = 0
+			if textAlignment == Llay_TextAlignment.CENTER then
+				offset = (width - line.dimensions.width) / 2
+			elseif textAlignment == Llay_TextAlignment.RIGHT then
+				offset = width - line.dimensions.width
+			end
+
+			local cmd = array_add(context.renderCommands, nil)
+			cmd.boundingBox.x = x + offset
+			cmd.boundingBox.y = y + yPos
+			cmd.boundingBox.width = line.dimensions.width
+			cmd.boundingBox.height = line.dimensions.height
+			cmd.renderData.text.stringContents.length = line.line.length
+			cmd.renderData.text.stringContents.chars = line.line.chars
+			local textColor = textConfig.textColor
+			cmd.renderData.text.textColor.r = textColor.r or 0
+			cmd.renderData.text.textColor.g = textColor.g or 0
+			cmd.renderData.text.textColor.b = textColor.b or 0
+			cmd.renderData.text.textColor.a = textColor.a or 255
+			cmd.renderData.text.fontId = textConfig.fontId or 0
+			cmd.renderData.text.fontSize = textConfig.fontSize or 16
+			cmd.renderData.text.letterSpacing = textConfig.letterSpacing or 0
+			cmd.renderData.text.lineHeight = textConfig.lineHeight or 0
+			cmd.userData = textConfig.userData
+			cmd.id = elem.id
+			cmd.zIndex = 0
+			cmd.commandType = Llay_RenderCommandType.TEXT
+		end
+		yPos = yPos + lineHeight
+	end
+end
+
+-- Render DFS: an element declared with layer = true is wrapped in LAYER_BEGIN and
+-- LAYER_END. Both carry a fingerprint of the commands in between, taken relative to
+-- the layer's origin, so moving the layer (scrolling past it) leaves it clean, and
+-- dirty is set when the fingerprint differs from the layer's previous one. Nothing
+-- inside an open layer is culled, since the layer is drawn whole. Layers nested
+-- deeper than openLayerStack holds are drawn as plain commands.
+local Llay__OpenLayer, Llay__CloseLayer
+do
+	local COMMAND_WORDS = ffi.sizeof("Clay_RenderCommand") / 4
+	-- Text commands point at their characters; their content reaches the fingerprint
+	-- through the text fingerprint instead (see Llay__AddTextCommands)
+	local TEXT_POINTER_FIRST_WORD = (
+		ffi.offsetof("Clay_RenderCommand", "renderData")
+		+ ffi.offsetof("Clay_TextRenderData", "stringContents")
+		+ ffi.offsetof("Clay_StringSlice", "chars")
+	) / 4
+	local TEXT_POINTER_END_WORD = TEXT_POINTER_FIRST_WORD + ffi.sizeof("const char*") * 2 / 4
+
+	local function mix(hash, value)
+		hash = bit.tobit(hash + value)
+		hash = hash + bit.lshift(hash, 10)
+		return bit.bxor(hash, bit.rshift(hash, 6))
+	end
+
+	-- Positions are hashed in 1/64 px so float rounding of a moved layer doesn't
+	-- count as a change
+	local function relative(value, origin)
+		return math.floor((value - origin) * 64 + 0.5)
+	end
+
+	function Llay__OpenLayer(nodeIdx, bbox, userData)
+		if context.openLayerStack.length >= context.openLayerStack.capacity then
+			return
+		end
+		local cmd = array_add(context.renderCommands, nil)
+		cmd.boundingBox = bbox
+		cmd.userData = userData
+		cmd.id = Llay__TreeNodeAt(nodeIdx).layoutElement.id
+		cmd.commandType = Llay_RenderCommandType.LAYER_BEGIN
+		local stack = context.openLayerStack
+		local entry = stack.internalArray + stack.length
+		stack.length = stack.length + 1
+		entry.nodeIndex = nodeIdx
+		entry.commandIndex = context.renderCommands.length - 1
+		entry.outerTextFingerprint = context.textFingerprint
+		context.textFingerprint = 0
+	end
+
+	function Llay__CloseLayer()
+		context.openLayerStack.length = context.openLayerStack.length - 1
+		local beginIndex = context.openLayerStack.internalArray[context.openLayerStack.length].commandIndex
+		local endIndex = context.renderCommands.length
+		local originX, originY, hash
+		do
+			local first = context.renderCommands.internalArray + beginIndex
+			originX, originY = first.boundingBox.x, first.boundingBox.y
+			hash = mix(context.textFingerprint, context.layerEpoch)
+			hash = mix(hash, relative(first.boundingBox.width, 0))
+			hash = mix(hash, relative(first.boundingBox.height, 0))
+		end
+
+		local dirty = false
+		local i = beginIndex + 1
+		while i < endIndex do
+			local commandType
+			do
+				local cmd = context.renderCommands.internalArray + i
+				commandType = tonumber(cmd.commandType)
+				-- SCISSOR_END carries no box; its zero position would move with the layer.
+				-- Nested layers are skipped whole below, LAYER_END included
+				if commandType ~= Llay_RenderCommandType.SCISSOR_END then
+					hash = mix(hash, relative(cmd.boundingBox.x, originX))
+					hash = mix(hash, relative(cmd.boundingBox.y, originY))
+				end
+			end
+			if commandType == Llay_RenderCommandType.LAYER_BEGIN then
+				-- A nested layer counts by its size and fingerprint, and its pixels are
+				-- part of this layer's, so it being dirty makes this one dirty too
+				local layer = context.renderCommands.internalArray[i].renderData.layer
+				hash = mix(hash, relative(context.renderCommands.internalArray[i].boundingBox.width, 0))
+				hash = mix(hash, relative(context.renderCommands.internalArray[i].boundingBox.height, 0))
+				hash = mix(hash, layer.fingerprint)
+				dirty = dirty or layer.dirty
+				i = i + layer.commandCount + 2
+			else
+				-- Render callbacks can draw anything on any frame
+				dirty = dirty or commandType == Llay_RenderCommandType.CUSTOM
+				local isText = commandType == Llay_RenderCommandType.TEXT
+				for w = 2, COMMAND_WORDS - 1 do
+					if not isText or w < TEXT_POINTER_FIRST_WORD or w >= TEXT_POINTER_END_WORD then
+						hash = mix(hash, ffi.cast("int32_t*", context.renderCommands.internalArray)[i * COMMAND_WORDS + w])
+					end
+				end
+				i = i + 1
+			end
+		end
+		if hash == 0 then
+			hash = 1
+		end
+
+		local id = context.renderCommands.internalArray[beginIndex].id
+		local item = Llay__GetHashMapItem(id)
+		if item then
+			dirty = dirty or item.layerFingerprint ~= hash
+			item.layerFingerprint = hash
+		else
+			dirty = true
+		end
+		if profiling then
+			if dirty then
+				_frameStats.layersDirty = _frameStats.layersDirty + 1
+			else
+				_frameStats.layersClean = _frameStats.layersClean + 1
+			end
+		end
+
+		local layer = context.renderCommands.internalArray[beginIndex].renderData.layer
+		layer.fingerprint = hash
+		layer.commandCount = endIndex - beginIndex - 1
+		layer.dirty = dirty
+		local cmd = array_add(context.renderCommands, nil)
+		cmd.boundingBox = context.renderCommands.internalArray[beginIndex].boundingBox
+		cmd.renderData.layer = context.renderCommands.internalArray[beginIndex].renderData.layer
+		cmd.userData = context.renderCommands.internalArray[beginIndex].userData
+		cmd.id = id
+		cmd.commandType = Llay_RenderCommandType.LAYER_END
+
+		-- The enclosing text fingerprint still sees the layer's text
+		context.textFingerprint = mix(
+			context.openLayerStack.internalArray[context.openLayerStack.length].outerTextFingerprint,
+			context.textFingerprint
+		)
+	end
+end
+
+-- Render DFS: records the content size of scroll containers and moves the first
+-- child offset along the layout axis by the alignment's share of free space. Returns
+-- whether the children fit inside the element's box horizontally and vertically.
+local function Llay__AlignChildrenAlongAxis(nodeIdx)
+	local childCount, leftToRight, elemId, clips
+	do
+		local elem = Llay__TreeNodeAt(nodeIdx).layoutElement
+		childCount = elem.childrenOrTextContent.children.length
+		leftToRight = elem.layoutConfig.layoutDirection == Llay_LayoutDirection.LEFT_TO_RIGHT
+		elemId = elem.id
+		clips = Llay__ElementHasConfig(elem, Llay__ElementConfigType.CLIP)
+	end
+
+	local contentWidth, contentHeight = 0, 0
+	for i = 0, childCount - 1 do
+		local child = Llay__ElementAt(Llay__TreeNodeAt(nodeIdx).layoutElement.childrenOrTextContent.children.elements[i])
+		if leftToRight then
+			contentWidth = contentWidth + child.dimensions.width
+			contentHeight = LLAY__MAX(contentHeight, child.dimensions.height)
+		else
+			contentWidth = LLAY__MAX(contentWidth, child.dimensions.width)
+			contentHeight = contentHeight + child.dimensions.height
+		end
+	end
+
+	local node = Llay__TreeNodeAt(nodeIdx)
+	local elem = node.layoutElement
+	local config = elem.layoutConfig
+	local padW = config.padding.left + config.padding.right
+	local padH = config.padding.top + config.padding.bottom
+	if leftToRight then
+		contentWidth = contentWidth + (LLAY__MAX(childCount - 1, 0) * config.childGap)
+	else
+		contentHeight = contentHeight + (LLAY__MAX(childCount - 1, 0) * config.childGap)
+	end
+
+	if leftToRight then
+		local extraSpace = elem.dimensions.width - (config.padding.left + config.padding.right) - contentWidth
+		if config.childAlignment.x == Llay_AlignX.LEFT then
+			extraSpace = 0
+		elseif config.childAlignment.x == Llay_AlignX.CENTER then
+			extraSpace = extraSpace / 2
+		end
+		node.nextChildOffset.x = node.nextChildOffset.x + extraSpace
+	else
+		local extraSpace = elem.dimensions.height - (config.padding.top + config.padding.bottom) - contentHeight
+		if config.childAlignment.y == Llay_AlignY.TOP then
+			extraSpace = 0
+		elseif config.childAlignment.y == Llay_AlignY.CENTER then
+			extraSpace = extraSpace / 2
+		end
+		node.nextChildOffset.y = node.nextChildOffset.y + extraSpace
+	end
+
+	-- Update scroll container bookkeeping (persistent) now that we know the content extent.
+	if clips then
+		local x, y = node.position.x, node.position.y
+		local width, height = elem.dimensions.width, elem.dimensions.height
+		for si = 0, context.scrollContainerDatas.length - 1 do
+			local scrollData = context.scrollContainerDatas.internalArray + si
+			if scrollData.elementId == elemId then
+				scrollData.boundingBox.x = x
+				scrollData.boundingBox.y = y
+				scrollData.boundingBox.width = width
+				scrollData.boundingBox.height = height
+				scrollData.contentSize.width = contentWidth + padW
+				scrollData.contentSize.height = contentHeight + padH
+				break
+			end
+		end
+	end
+
+	return contentWidth + padW <= elem.dimensions.width + LLAY__EPSILON,
+		contentHeight + padH <= elem.dimensions.height + LLAY__EPSILON
+end
+
+-- Render DFS: pushes an element's children, positioned, so they pop in 0..N order
+local function Llay__PushChildNodes(nodeIdx)
+	local childCount, scrollOffsetX, scrollOffsetY, offsetX, offsetY
+	local reusePositions = false
+	do
+		local node = Llay__TreeNodeAt(nodeIdx)
+		local elem = node.layoutElement
+		childCount = elem.childrenOrTextContent.children.length
+		scrollOffsetX, scrollOffsetY = 0, 0
+		local clipCfgUnion = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.CLIP)
+		if clipCfgUnion ~= nil then
+			local clipCfg = clipCfgUnion.clipElementConfig
+			scrollOffsetX = clipCfg.childOffset.x
+			scrollOffsetY = clipCfg.childOffset.y
+		end
+		offsetX, offsetY = node.nextChildOffset.x, node.nextChildOffset.y
+
+		-- Fully memoized subtree: child positions relative to this element are unchanged,
+		-- provided last frame's render pass placed the children (culling may have
+		-- skipped them, leaving older positions in the memo)
+		if context.incrementalLayoutEnabled and childCount > 0 then
+			local elemIdx = elem - context.layoutElements.internalArray
+			local firstMemoIndex = context.layoutElementMemoIndexes.internalArray[elem.childrenOrTextContent.children.elements[0]]
+			reusePositions = bit.band(context.layoutElementMemoFlags.internalArray[elemIdx], LLAY__MEMO_HIT_Y) ~= 0
+				and cull.placed_last_frame(context, context.layoutElementsHashMapInternal.internalArray + firstMemoIndex)
+		end
+	end
+
+	for j = 0, childCount - 1 do
+		local node = Llay__TreeNodeAt(nodeIdx)
+		local elem = node.layoutElement
+		local config = elem.layoutConfig
+		local childIdx = elem.childrenOrTextContent.children.elements[j]
+		local child = Llay__ElementAt(childIdx)
+		local childMemoIndex = context.incrementalLayoutEnabled
+			and context.layoutElementMemoIndexes.internalArray[childIdx]
+			or -1
+
+		-- Alignment Logic for Child Axis
+		if reusePositions then
+			local memo = context.layoutMemo.internalArray + childMemoIndex
+			offsetX = memo.relativePosition.x
+			offsetY = memo.relativePosition.y
+		elseif config.layoutDirection == Llay_LayoutDirection.LEFT_TO_RIGHT then
+			offsetY = config.padding.top
+			local freeSpace = elem.dimensions.height
+				- config.padding.top
+				- config.padding.bottom
+				- child.dimensions.height
+			if config.childAlignment.y == Llay_AlignY.CENTER then
+				offsetY = offsetY + freeSpace / 2
+			elseif config.childAlignment.y == Llay_AlignY.BOTTOM then
+				offsetY = offsetY + freeSpace
+			end
+		else
+			offsetX = config.padding.left
+			local freeSpace = elem.dimensions.width
+				- config.padding.left
+				- config.padding.right
+				- child.dimensions.width
+			if config.childAlignment.x == Llay_AlignX.CENTER then
+				offsetX = offsetX + freeSpace / 2
+			elseif config.childAlignment.x == Llay_AlignX.RIGHT then
+				offsetX = offsetX + freeSpace
+			end
+		end
+
+		if not reusePositions and childMemoIndex >= 0 then
+			local memo = context.layoutMemo.internalArray + childMemoIndex
+			memo.relativePosition.x = offsetX
+			memo.relativePosition.y = offsetY
+		end
+
+		local childNode = Llay__PushTreeNode(childIdx)
+		childNode.position.x = node.position.x + offsetX + scrollOffsetX
+		childNode.position.y = node.position.y + offsetY + scrollOffsetY
+		childNode.nextChildOffset.x = child.layoutConfig.padding.left
+		childNode.nextChildOffset.y = child.layoutConfig.padding.top
+
+		if config.layoutDirection == Llay_LayoutDirection.LEFT_TO_RIGHT then
+			offsetX = offsetX + child.dimensions.width + config.childGap
+		else
+			offsetY = offsetY + child.dimensions.height + config.childGap
+		end
+	end
+
+	-- Reverse the added children so they are popped in 0..N order
+	if childCount > 1 then
+		local tempNode = _SWAP_TREE_NODE
+		local startIdx = context.layoutElementTreeNodeArray1.length - childCount
+		local endIdx = context.layoutElementTreeNodeArray1.length - 1
+		while startIdx < endIdx do
+			local nodes = context.layoutElementTreeNodeArray1.internalArray
+			-- Swap
+			tempNode.layoutElement = nodes[startIdx].layoutElement
+			tempNode.position.x = nodes[startIdx].position.x
+			tempNode.position.y = nodes[startIdx].position.y
+			tempNode.nextChildOffset.x = nodes[startIdx].nextChildOffset.x
+			tempNode.nextChildOffset.y = nodes[startIdx].nextChildOffset.y
+
+			nodes[startIdx].layoutElement = nodes[endIdx].layoutElement
+			nodes[startIdx].position.x = nodes[endIdx].position.x
+			nodes[startIdx].position.y = nodes[endIdx].position.y
+			nodes[startIdx].nextChildOffset.x = nodes[endIdx].nextChildOffset.x
+			nodes[startIdx].nextChildOffset.y = nodes[endIdx].nextChildOffset.y
+
+			nodes[endIdx].layoutElement = tempNode.layoutElement
+			nodes[endIdx].position.x = tempNode.position.x
+			nodes[endIdx].position.y = tempNode.position.y
+			nodes[endIdx].nextChildOffset.x = tempNode.nextChildOffset.x
+			nodes[endIdx].nextChildOffset.y = tempNode.nextChildOffset.y
+
+			local elementIndexes = context.treeNodeElementIndexes.internalArray
+			elementIndexes[startIdx], elementIndexes[endIdx] = elementIndexes[endIdx], elementIndexes[startIdx]
+
+			startIdx = startIdx + 1
+			endIdx = endIdx - 1
+		end
+	end
+end
+
+local function Clay__CalculateFinalLayout()
+	if context.layoutElements.length == 0 then
+		return
+	end
+
+	-- 0. Sort roots by Z-index
+	M.sort_roots_by_z()
+
+	-- Track roots that need an extra scissor end (to balance root.clipElementId scissor starts)
+	local rootNeedsExtraScissorEnd = _rootNeedsExtraScissorEnd
+	local phaseStart = profiling and Llay__ProfileNow() or 0
+
+	-- 1. Size X
+	Llay__SizeContainersAlongAxis(true)
+	if profiling then
+		phaseStart = Llay__ProfilePhase("sizeXMs", phaseStart)
+	end
+
+	-- 2. Text Wrapping
+	for i = 0, context.textElementData.length - 1 do
+		Llay__WrapTextElement(i)
+	end
+	if profiling then
+		phaseStart = Llay__ProfilePhase("textWrapMs", phaseStart)
+	end
+
+	-- 3. Aspect Ratio Height
+	for i = 0, context.aspectRatioElementIndexes.length - 1 do
+		local idx = int32_array_get(context.aspectRatioElementIndexes, i)
+		local elem = context.layoutElements.internalArray + idx
+		local config = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.ASPECT).aspectRatioElementConfig
+		elem.dimensions.height = elem.dimensions.width / config.aspectRatio
+	end
+	if profiling then
+		phaseStart = Llay__ProfilePhase("aspectRatioMs", phaseStart)
+	end
+
+	-- 4. DFS for Height Propagation
+	context.layoutElementTreeNodeArray1.length = 0
+	for i = 0, context.layoutElementTreeRoots.length - 1 do
+		local root = context.layoutElementTreeRoots.internalArray + i
+		Llay__PushTreeNode(root.layoutElementIndex)
+	end
+
+	while context.layoutElementTreeNodeArray1.length > 0 do
+		local nodeIdx = context.layoutElementTreeNodeArray1.length - 1
+
+		if not context.treeNodeVisited.internalArray[nodeIdx] then
 			context.treeNodeVisited.internalArray[nodeIdx] = true
-			if
-				Llay__ElementHasConfig(currentElement, Llay__ElementConfigType.TEXT)
-				or currentElement.childrenOrTextContent.children.length == 0
-			then
-				dfsBuffer.length = dfsBuffer.length - 1
-				goto continue_dfs
-			end
-			-- Push children (in reverse order so they are processed in correct order)
-			for i = currentElement.childrenOrTextContent.children.length - 1, 0, -1 do
-				context.treeNodeVisited.internalArray[dfsBuffer.length] = false
-				local childNode = array_add(dfsBuffer, ffi.new("Clay__LayoutElementTreeNode"))
-				childNode.layoutElement = context.layoutElements.internalArray
-					+ currentElement.childrenOrTextContent.children.elements[i]
-			end
-			goto continue_dfs
-		end
-
-		-- Visited (Backtracking)
-		dfsBuffer.length = dfsBuffer.length - 1
-		local layoutConfig = currentElement.layoutConfig
-		if layoutConfig.layoutDirection == Llay_LayoutDirection.LEFT_TO_RIGHT then
-			for j = 0, currentElement.childrenOrTextContent.children.length - 1 do
-				local child = context.layoutElements.internalArray
-					+ currentElement.childrenOrTextContent.children.elements[j]
-				local h = LLAY__MAX(
-					child.dimensions.height + layoutConfig.padding.top + layoutConfig.padding.bottom,
-					currentElement.dimensions.height
-				)
-				currentElement.dimensions.height = LLAY__MIN(
-					LLAY__MAX(h, layoutConfig.sizing.height.size.minMax.min),
-					layoutConfig.sizing.height.size.minMax.max
-				)
-			end
-		elseif layoutConfig.layoutDirection == Llay_LayoutDirection.TOP_TO_BOTTOM then
-			local contentHeight = layoutConfig.padding.top + layoutConfig.padding.bottom
-			for j = 0, currentElement.childrenOrTextContent.children.length - 1 do
-				local child = context.layoutElements.internalArray
-					+ currentElement.childrenOrTextContent.children.elements[j]
-				contentHeight = contentHeight + child.dimensions.height
-			end
-			contentHeight = contentHeight
-				+ (LLAY__MAX(currentElement.childrenOrTextContent.children.length - 1, 0) * layoutConfig.childGap)
-			currentElement.dimensions.height = LLAY__MIN(
-				LLAY__MAX(contentHeight, layoutConfig.sizing.height.size.minMax.min),
-				layoutConfig.sizing.height.size.minMax.max
-			)
-		end
-
-		::continue_dfs::
+			local childCount
+			do
+				local currentElement = Llay__TreeNodeAt(nodeIdx).layoutElement
+				childCount = currentElement.childrenOrTextContent.children.length
+				if Llay__ElementHasConfig(currentElement, Llay__ElementConfigType.TEXT) then
+					childCount = 0
+				elseif childCount > 0 and context.incrementalLayoutEnabled then
+					local elemIdx = currentElement - context.layoutElements.internalArray
+					if bit.band(context.layoutElementMemoFlags.internalArray[elemIdx], LLAY__MEMO_HIT_X) ~= 0 then
+						Llay__ApplyMemoizedSubtree(elemIdx, LLAY__MEMO_APPLY_CONTENT_HEIGHT)
+						childCount = 0
+					end
+				end
+			end
+			if childCount == 0 then
+				context.layoutElementTreeNodeArray1.length = context.layoutElementTreeNodeArray1.length - 1
+			else
+				-- Push children (in reverse order so they are processed in correct order)
+				for i = childCount - 1, 0, -1 do
+					local parent = Llay__TreeNodeAt(nodeIdx).layoutElement
+					Llay__PushTreeNode(parent.childrenOrTextContent.children.elements[i])
+				end
+			end
+		else
+			-- Visited (Backtracking)
+			context.layoutElementTreeNodeArray1.length = context.layoutElementTreeNodeArray1.length - 1
+			Llay__FitHeightToChildren(nodeIdx)
+		end
+	end
+
+	if context.incrementalLayoutEnabled then
+		Llay__RecordLayoutMemo(true)
+	end
+	if profiling then
+		phaseStart = Llay__ProfilePhase("heightDfsMs", phaseStart)
 	end
 
 	-- 5. Size Y
 	Llay__SizeContainersAlongAxis(false)
 
+	if context.incrementalLayoutEnabled then
+		Llay__RecordLayoutMemo(false)
+	end
+	if profiling then
+		phaseStart = Llay__ProfilePhase("sizeYMs", phaseStart)
+	end
+
 	-- 6. Render Commands
 	context.renderCommands.length = 0
-	dfsBuffer.length = 0
+	context.layoutElementTreeNodeArray1.length = 0
+	cull.begin_pass(context)
 
+	-- Roots are placed and pushed in one pass. Attach points index a 3x3 grid: the
+	-- point modulo 3 picks the horizontal step (0, 1/2 or 1 of the width) and the point
+	-- divided by 3 the vertical one. Floating markers usually share a parent, so the
+	-- last parent lookup is reused.
 	-- NOTE: We push roots back-to-front onto a LIFO stack.
 	-- The DFS pop order (LIFO) becomes the render order, so this must iterate front-to-back.
+	local lastParentId, parentItem = 0, nil
 	for i = context.layoutElementTreeRoots.length - 1, 0, -1 do
 		local root = context.layoutElementTreeRoots.internalArray + i
 		local elem = context.layoutElements.internalArray + root.layoutElementIndex
-
-		local rootPosition = { x = 0, y = 0 }
-
 		local floatingConfigUnion = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.FLOATING)
-		local floatingConfig = floatingConfigUnion ~= nil and floatingConfigUnion.floatingElementConfig or nil
-
-		-- Floating elements attached to ROOT are positioned in absolute coordinates.
-		if floatingConfig ~= nil and floatingConfig.attachTo == Llay_FloatingAttachToElement.ROOT then
-			rootPosition.x = floatingConfig.offset.x
-			rootPosition.y = floatingConfig.offset.y
+		local rootX, rootY = 0, 0
+		if floatingConfigUnion ~= nil and floatingConfigUnion.floatingElementConfig.attachTo == Llay_FloatingAttachToElement.ROOT then
+			-- Floating elements attached to ROOT are positioned in absolute coordinates.
+			rootX = floatingConfigUnion.floatingElementConfig.offset.x
+			rootY = floatingConfigUnion.floatingElementConfig.offset.y
 		elseif root.parentId ~= 0 then
-			local parentItem = Llay__GetHashMapItem(root.parentId)
+			if root.parentId ~= lastParentId then
+				lastParentId = root.parentId
+				parentItem = Llay__GetHashMapItem(root.parentId)
+			end
 			if parentItem then
-				local parentBB = parentItem.boundingBox
-
-				if
-					floatingConfig.attachPoints.parent == 0
-					or floatingConfig.attachPoints.parent == 3
-					or floatingConfig.attachPoints.parent == 6
-				then
-					rootPosition.x = parentBB.x
-				elseif
-					floatingConfig.attachPoints.parent == 1
-					or floatingConfig.attachPoints.parent == 4
-					or floatingConfig.attachPoints.parent == 7
-				then
-					rootPosition.x = parentBB.x + (parentBB.width / 2)
-				elseif
-					floatingConfig.attachPoints.parent == 2
-					or floatingConfig.attachPoints.parent == 5
-					or floatingConfig.attachPoints.parent == 8
-				then
-					rootPosition.x = parentBB.x + parentBB.width
-				end
-
-				if
-					floatingConfig.attachPoints.element == 1
-					or floatingConfig.attachPoints.element == 4
-					or floatingConfig.attachPoints.element == 7
-				then
-					rootPosition.x = rootPosition.x - (elem.dimensions.width / 2)
-				elseif
-					floatingConfig.attachPoints.element == 2
-					or floatingConfig.attachPoints.element == 5
-					or floatingConfig.attachPoints.element == 8
-				then
-					rootPosition.x = rootPosition.x - elem.dimensions.width
-				end
-
-				if
-					floatingConfig.attachPoints.parent == 0
-					or floatingConfig.attachPoints.parent == 1
-					or floatingConfig.attachPoints.parent == 2
-				then
-					rootPosition.y = parentBB.y
-				elseif
-					floatingConfig.attachPoints.parent == 3
-					or floatingConfig.attachPoints.parent == 4
-					or floatingConfig.attachPoints.parent == 5
-				then
-					rootPosition.y = parentBB.y + (parentBB.height / 2)
-				elseif
-					floatingConfig.attachPoints.parent == 6
-					or floatingConfig.attachPoints.parent == 7
-					or floatingConfig.attachPoints.parent == 8
-				then
-					rootPosition.y = parentBB.y + parentBB.height
-				end
-
-				if
-					floatingConfig.attachPoints.element == 3
-					or floatingConfig.attachPoints.element == 4
-					or floatingConfig.attachPoints.element == 5
-				then
-					rootPosition.y = rootPosition.y - (elem.dimensions.height / 2)
-				elseif
-					floatingConfig.attachPoints.element == 6
-					or floatingConfig.attachPoints.element == 7
-					or floatingConfig.attachPoints.element == 8
-				then
-					rootPosition.y = rootPosition.y - elem.dimensions.height
-				end
-
-				rootPosition.x = rootPosition.x + floatingConfig.offset.x
-				rootPosition.y = rootPosition.y + floatingConfig.offset.y
+				local floatingConfig = floatingConfigUnion.floatingElementConfig
+				local parentPoint = tonumber(floatingConfig.attachPoints.parent)
+				local elementPoint = tonumber(floatingConfig.attachPoints.element)
+				rootX = parentItem.boundingBox.x
+					+ parentItem.boundingBox.width * (parentPoint % 3) * 0.5
+					- elem.dimensions.width * (elementPoint % 3) * 0.5
+					+ floatingConfig.offset.x
+				rootY = parentItem.boundingBox.y
+					+ parentItem.boundingBox.height * math.floor(parentPoint / 3) * 0.5
+					- elem.dimensions.height * math.floor(elementPoint / 3) * 0.5
+					+ floatingConfig.offset.y
 			end
 		end
 
-		local node = array_add(dfsBuffer, ffi.new("Clay__LayoutElementTreeNode"))
-		node.layoutElement = elem
-		node.position.x = rootPosition.x
-		node.position.y = rootPosition.y
+		local node = Llay__PushTreeNode(root.layoutElementIndex)
+		node.position.x = rootX
+		node.position.y = rootY
 		node.nextChildOffset.x = elem.layoutConfig.padding.left
 		node.nextChildOffset.y = elem.layoutConfig.padding.top
 
@@ -1701,210 +3220,181 @@ local function Clay__CalculateFinalLayout()
 		end
 	end
 
-	-- Reset visited
-	for i = 0, dfsBuffer.capacity - 1 do
-		context.treeNodeVisited.internalArray[i] = false
-	end
+	-- Reset visited: only the roots are on the stack, later pushes clear their own flag
+	ffi.fill(context.treeNodeVisited.internalArray, context.layoutElementTreeNodeArray1.length * ffi.sizeof("bool"))
 
-	while dfsBuffer.length > 0 do
-		local nodeIdx = dfsBuffer.length - 1
-		local node = dfsBuffer.internalArray + nodeIdx
-		local elem = node.layoutElement
-		local config = elem.layoutConfig
+	while context.layoutElementTreeNodeArray1.length > 0 do
+		local nodeIdx = context.layoutElementTreeNodeArray1.length - 1
 
 		if context.treeNodeVisited.internalArray[nodeIdx] then
 			-- Backtracking: Handle End Scissor and Borders
-			local closeClipElement = false
-			if Llay__ElementHasConfig(elem, Llay__ElementConfigType.CLIP) then
-				closeClipElement = true
-			end
-
-			-- Borders
-			if Llay__ElementHasConfig(elem, Llay__ElementConfigType.BORDER) then
-				local bbox = {
-					x = node.position.x,
-					y = node.position.y,
-					width = elem.dimensions.width,
-					height = elem.dimensions.height,
-				}
-				if not Llay__ElementIsOffscreen(bbox) then
-					local borderConfig =
-						Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.BORDER).borderElementConfig
-					local sharedConfig = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.SHARED)
-					local cmd = array_add(context.renderCommands, nil)
-					cmd.boundingBox = bbox
-					cmd.renderData.border.color = borderConfig.color
-					cmd.renderData.border.cornerRadius = sharedConfig and sharedConfig.sharedElementConfig.cornerRadius
-						or ffi.new("Clay_CornerRadius")
-					cmd.renderData.border.width = borderConfig.width
-					cmd.userData = sharedConfig and sharedConfig.sharedElementConfig.userData or nil
-					cmd.id = elem.id
-					cmd.commandType = Llay_RenderCommandType.BORDER
-
-					-- Generate between-children borders (as rectangles, not border commands)
-					if borderConfig.width.betweenChildren > 0 and borderConfig.color.a > 0 then
-						local layoutConfig = elem.layoutConfig
-						local halfGap = layoutConfig.childGap / 2
-						local borderOffset = {
-							x = layoutConfig.padding.left - halfGap,
-							y = layoutConfig.padding.top - halfGap
-						}
-
-						local scrollOffset = { x = 0, y = 0 }
-						local clipConfig = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.CLIP)
-						if clipConfig ~= nil then
-							scrollOffset.x = clipConfig.clipElementConfig.childOffset.x
-							scrollOffset.y = clipConfig.clipElementConfig.childOffset.y
-						end
-
-						if layoutConfig.layoutDirection == Llay_LayoutDirection.LEFT_TO_RIGHT then
-							for i = 0, elem.childrenOrTextContent.children.length - 1 do
-								local childIdx = elem.childrenOrTextContent.children.elements[i]
-								local child = context.layoutElements.internalArray + childIdx
-								if i > 0 then
-									local cmd = array_add(context.renderCommands, nil)
-									cmd.boundingBox = {
-										x = bbox.x + borderOffset.x + scrollOffset.x,
-										y = bbox.y + scrollOffset.y,
-										width = borderConfig.width.betweenChildren,
-										height = elem.dimensions.height
-									}
-									cmd.renderData.rectangle.backgroundColor = borderConfig.color
-									cmd.userData = sharedConfig and sharedConfig.sharedElementConfig.userData or nil
-									cmd.id = Llay__HashNumber(elem.id, elem.childrenOrTextContent.children.length + 1 + i).id
-									cmd.commandType = Llay_RenderCommandType.RECTANGLE
-								end
-								borderOffset.x = borderOffset.x + child.dimensions.width + layoutConfig.childGap
-							end
-						else -- TOP_TO_BOTTOM
-							for i = 0, elem.childrenOrTextContent.children.length - 1 do
-								local childIdx = elem.childrenOrTextContent.children.elements[i]
-								local child = context.layoutElements.internalArray + childIdx
-								if i > 0 then
-									local cmd = array_add(context.renderCommands, nil)
-									cmd.boundingBox = {
-										x = bbox.x + scrollOffset.x,
-										y = bbox.y + borderOffset.y + scrollOffset.y,
-										width = elem.dimensions.width,
-										height = borderConfig.width.betweenChildren
-									}
-									cmd.renderData.rectangle.backgroundColor = borderConfig.color
-									cmd.userData = sharedConfig and sharedConfig.sharedElementConfig.userData or nil
-									cmd.id = Llay__HashNumber(elem.id, elem.childrenOrTextContent.children.length + 1 + i).id
-									cmd.commandType = Llay_RenderCommandType.RECTANGLE
-								end
-								borderOffset.y = borderOffset.y + child.dimensions.height + layoutConfig.childGap
-							end
-						end
+			local elemId, closeClipElement
+			local betweenChildren = false
+			do
+				local node = Llay__TreeNodeAt(nodeIdx)
+				local elem = node.layoutElement
+				elemId = elem.id
+				closeClipElement = Llay__ElementHasConfig(elem, Llay__ElementConfigType.CLIP)
+
+				-- Borders
+				if Llay__ElementHasConfig(elem, Llay__ElementConfigType.BORDER) then
+					local bbox = _SCRATCH_BBOX
+					bbox.x = node.position.x
+					bbox.y = node.position.y
+					bbox.width = elem.dimensions.width
+					bbox.height = elem.dimensions.height
+					local outsideX, outsideY = cull.offscreen_axes(context, bbox)
+					if context.openLayerStack.length > 0 or not (outsideX or outsideY) then
+						local borderConfig =
+							Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.BORDER).borderElementConfig
+						local sharedConfig = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.SHARED)
+						local cmd = array_add(context.renderCommands, nil)
+						cmd.boundingBox = bbox
+						cmd.renderData.border.color = borderConfig.color
+						cmd.renderData.border.cornerRadius = sharedConfig and sharedConfig.sharedElementConfig.cornerRadius
+							or _ZERO_CORNER_RADIUS
+						cmd.renderData.border.width = borderConfig.width
+						cmd.userData = sharedConfig and sharedConfig.sharedElementConfig.userData or nil
+						cmd.id = elem.id
+						cmd.commandType = Llay_RenderCommandType.BORDER
+						betweenChildren = borderConfig.width.betweenChildren > 0 and borderConfig.color.a > 0
 					end
 				end
 			end
 
+			-- Generate between-children borders (as rectangles, not border commands)
+			if betweenChildren then
+				Llay__AddBetweenChildrenBorders(nodeIdx)
+			end
+
 			if closeClipElement then
 				local cmd = array_add(context.renderCommands, nil)
 				cmd.commandType = Llay_RenderCommandType.SCISSOR_END
-				cmd.id = elem.id
+				cmd.id = elemId
+			end
+
+			cull.pop_clip(context, nodeIdx)
+
+			if context.openLayerStack.length > 0
+				and context.openLayerStack.internalArray[context.openLayerStack.length - 1].nodeIndex == nodeIdx then
+				Llay__CloseLayer()
 			end
 
-			if rootNeedsExtraScissorEnd[elem.id] then
+			if rootNeedsExtraScissorEnd[elemId] then
 				local cmd = array_add(context.renderCommands, nil)
 				cmd.commandType = Llay_RenderCommandType.SCISSOR_END
-				cmd.id = elem.id
-				rootNeedsExtraScissorEnd[elem.id] = nil
+				cmd.id = elemId
+				rootNeedsExtraScissorEnd[elemId] = nil
 			end
 
-			dfsBuffer.length = dfsBuffer.length - 1
+			context.layoutElementTreeNodeArray1.length = context.layoutElementTreeNodeArray1.length - 1
 		else
-			context.treeNodeVisited.internalArray[nodeIdx] = true
+			local shouldRender, isText, hasChildren
+			local aligned = false
+			local zIndex = 0 -- Assuming 0 if not tracked via tree root
+			do
+				local node = Llay__TreeNodeAt(nodeIdx)
+				local elem = node.layoutElement
+				local bbox = _SCRATCH_BBOX
+				bbox.x = node.position.x
+				bbox.y = node.position.y
+				bbox.width = elem.dimensions.width
+				bbox.height = elem.dimensions.height
+
+				-- Update Hash Map Bounding Box
+				local mapIndex = context.layoutElementHashMapIndexes.internalArray[
+					context.treeNodeElementIndexes.internalArray[nodeIdx]]
+				if mapIndex ~= -1 then
+					cull.place(context, context.layoutElementsHashMapInternal.internalArray + mapIndex, bbox)
+				end
 
-			local bbox = {
-				x = node.position.x,
-				y = node.position.y,
-				width = elem.dimensions.width,
-				height = elem.dimensions.height,
-			}
+				local outsideX, outsideY = cull.offscreen_axes(context, bbox)
+				shouldRender = context.openLayerStack.length > 0 or not (outsideX or outsideY)
+				isText = Llay__ElementHasConfig(elem, Llay__ElementConfigType.TEXT)
+				hasChildren = elem.childrenOrTextContent.children.length > 0
+
+				-- A culled element's children can only show where they overflow it (or are
+				-- scrolled out of it) on an axis it is outside of. Otherwise the element is
+				-- dropped without pushing its subtree and without a backtrack: it would emit
+				-- nothing there.
+				if not shouldRender then
+					local containedX, containedY = true, true
+					if not isText then
+						containedX, containedY = Llay__AlignChildrenAlongAxis(nodeIdx)
+						aligned = true
+					end
+					local clipUnion = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.CLIP)
+					if clipUnion ~= nil then
+						local clipConfig = clipUnion.clipElementConfig
+						containedX = clipConfig.horizontal or (containedX and clipConfig.childOffset.x == 0)
+						containedY = clipConfig.vertical or (containedY and clipConfig.childOffset.y == 0)
+					end
+					if (outsideX and containedX) or (outsideY and containedY) then
+						if profiling then
+							_frameStats.elementsCulled = _frameStats.elementsCulled + 1
+						end
+						if rootNeedsExtraScissorEnd[elem.id] then
+							local cmd = array_add(context.renderCommands, nil)
+							cmd.commandType = Llay_RenderCommandType.SCISSOR_END
+							cmd.id = elem.id
+							rootNeedsExtraScissorEnd[elem.id] = nil
+						end
+						context.layoutElementTreeNodeArray1.length = nodeIdx
+						goto continue_node
+					end
+				end
+				context.treeNodeVisited.internalArray[nodeIdx] = true
+				if profiling then
+					if shouldRender then
+						_frameStats.elementsEmitted = _frameStats.elementsEmitted + 1
+					else
+						_frameStats.elementsCulled = _frameStats.elementsCulled + 1
+					end
+				end
 
-			-- Update Hash Map Bounding Box
-			local hashMapItem = Llay__GetHashMapItem(elem.id)
-			if hashMapItem then
-				hashMapItem.boundingBox = bbox
-			end
+				local shared = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.SHARED)
+				if shouldRender and shared and shared.sharedElementConfig.layer then
+					Llay__OpenLayer(nodeIdx, bbox, shared.sharedElementConfig.userData)
+				end
 
-			local shouldRender = not Llay__ElementIsOffscreen(bbox)
-			local shared = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.SHARED)
-			local userData = shared and shared.sharedElementConfig.userData or nil
-			local zIndex = 0 -- Assuming 0 if not tracked via tree root
+				-- SCISSOR START
+				if Llay__ElementHasConfig(elem, Llay__ElementConfigType.CLIP) then
+					local clipConfig = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.CLIP).clipElementConfig
+					local cmd = array_add(context.renderCommands, nil)
+					cmd.boundingBox = bbox
+					cmd.renderData.clip.horizontal = clipConfig.horizontal
+					cmd.renderData.clip.vertical = clipConfig.vertical
+					cmd.commandType = Llay_RenderCommandType.SCISSOR_START
+					cmd.id = elem.id
+					cmd.zIndex = zIndex
 
-			-- SCISSOR START
-			if Llay__ElementHasConfig(elem, Llay__ElementConfigType.CLIP) then
-				local clipConfig = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.CLIP).clipElementConfig
-				local cmd = array_add(context.renderCommands, nil)
-				cmd.boundingBox = bbox
-				cmd.renderData.clip.horizontal = clipConfig.horizontal
-				cmd.renderData.clip.vertical = clipConfig.vertical
-				cmd.commandType = Llay_RenderCommandType.SCISSOR_START
-				cmd.id = elem.id
-				cmd.zIndex = zIndex
-			end
+					-- Narrow the cull rect to the clipped axes until the backtrack
+					cull.push_clip(context, nodeIdx, bbox, clipConfig)
+				end
 
-			if shouldRender then
 				-- RECTANGLE
-				if shared and shared.sharedElementConfig.backgroundColor.a > 0 then
+				if shouldRender and shared and shared.sharedElementConfig.backgroundColor.a > 0 then
 					local cmd = array_add(context.renderCommands, nil)
 					cmd.boundingBox = bbox
 					cmd.renderData.rectangle.backgroundColor = shared.sharedElementConfig.backgroundColor
 					cmd.renderData.rectangle.cornerRadius = shared.sharedElementConfig.cornerRadius
 					cmd.commandType = Llay_RenderCommandType.RECTANGLE
-					cmd.userData = userData
+					cmd.userData = shared.sharedElementConfig.userData
 					cmd.id = elem.id
 					cmd.zIndex = zIndex
 				end
+			end
 
-				-- TEXT
-				if Llay__ElementHasConfig(elem, Llay__ElementConfigType.TEXT) then
-					local textConfig =
-						Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.TEXT).textElementConfig
-					local textData = elem.childrenOrTextContent.textElementData
-
-					local lineHeight = textConfig.lineHeight > 0 and textConfig.lineHeight
-						or textData.preferredDimensions.height
-					local yPos = (lineHeight - textData.preferredDimensions.height) / 2
-
-					for i = 0, textData.wrappedLines.length - 1 do
-						local line = textData.wrappedLines.internalArray + i
-						if line.line.length > 0 then
-							local offset = 0
-							if textConfig.textAlignment == Llay_TextAlignment.CENTER then
-								offset = (elem.dimensions.width - line.dimensions.width) / 2
-							elseif textConfig.textAlignment == Llay_TextAlignment.RIGHT then
-								offset = elem.dimensions.width - line.dimensions.width
-							end
+			-- TEXT
+			if shouldRender and isText then
+				Llay__AddTextCommands(nodeIdx)
+			end
 
-							local cmd = array_add(context.renderCommands, nil)
-							cmd.boundingBox = {
-								x = bbox.x + offset,
-								y = bbox.y + yPos,
-								width = line.dimensions.width,
-								height = line.dimensions.height,
-							}
-							cmd.renderData.text.stringContents = { length = line.line.length, chars = line.line.chars }
-							local textColor = textConfig.textColor or ffi.new("Clay_Color")
-							cmd.renderData.text.textColor.r = textColor.r or 0
-							cmd.renderData.text.textColor.g = textColor.g or 0
-							cmd.renderData.text.textColor.b = textColor.b or 0
-							cmd.renderData.text.textColor.a = textColor.a or 255
-							cmd.renderData.text.fontId = textConfig.fontId or 0
-							cmd.renderData.text.fontSize = textConfig.fontSize or 16
-							cmd.renderData.text.letterSpacing = textConfig.letterSpacing or 0
-							cmd.renderData.text.lineHeight = textConfig.lineHeight or 0
-							cmd.userData = textConfig.userData
-							cmd.id = elem.id
-							cmd.zIndex = zIndex
-							cmd.commandType = Llay_RenderCommandType.TEXT
-						end
-						yPos = yPos + lineHeight
-					end
-				end
+			if shouldRender then
+				local elem = Llay__TreeNodeAt(nodeIdx).layoutElement
+				local bbox = _SCRATCH_BBOX
+				local shared = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.SHARED)
+				local userData = shared and shared.sharedElementConfig.userData or nil
 
 				-- IMAGE
 				if Llay__ElementHasConfig(elem, Llay__ElementConfigType.IMAGE) then
@@ -1914,9 +3404,9 @@ local function Clay__CalculateFinalLayout()
 					cmd.boundingBox = bbox
 					cmd.renderData.image.imageData = imageConfig.imageData
 					cmd.renderData.image.cornerRadius = shared and shared.sharedElementConfig.cornerRadius
-						or ffi.new("Clay_CornerRadius")
+						or _ZERO_CORNER_RADIUS
 					cmd.renderData.image.backgroundColor = shared and shared.sharedElementConfig.backgroundColor
-						or ffi.new("Clay_Color")
+						or _ZERO_COLOR
 					cmd.commandType = Llay_RenderCommandType.IMAGE
 					cmd.userData = userData
 					cmd.id = elem.id
@@ -1931,9 +3421,9 @@ local function Clay__CalculateFinalLayout()
 					cmd.boundingBox = bbox
 					cmd.renderData.custom.customData = customConfig.customData
 					cmd.renderData.custom.cornerRadius = shared and shared.sharedElementConfig.cornerRadius
-						or ffi.new("Clay_CornerRadius")
+						or _ZERO_CORNER_RADIUS
 					cmd.renderData.custom.backgroundColor = shared and shared.sharedElementConfig.backgroundColor
-						or ffi.new("Clay_Color")
+						or _ZERO_COLOR
 					cmd.commandType = Llay_RenderCommandType.CUSTOM
 					cmd.userData = userData
 					cmd.id = elem.id
@@ -1941,162 +3431,21 @@ local function Clay__CalculateFinalLayout()
 				end
 			end
 
-			if not Llay__ElementHasConfig(elem, Llay__ElementConfigType.TEXT) then
-				local contentSize = { width = 0, height = 0 }
-				local clipCfgUnion = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.CLIP)
-				local padW = config.padding.left + config.padding.right
-				local padH = config.padding.top + config.padding.bottom
-				if config.layoutDirection == Llay_LayoutDirection.LEFT_TO_RIGHT then
-					for i = 0, elem.childrenOrTextContent.children.length - 1 do
-						local child = context.layoutElements.internalArray + elem.childrenOrTextContent.children.elements[i]
-						contentSize.width = contentSize.width + child.dimensions.width
-						contentSize.height = LLAY__MAX(contentSize.height, child.dimensions.height)
-					end
-					contentSize.width = contentSize.width + (LLAY__MAX(elem.childrenOrTextContent.children.length - 1, 0) * config.childGap)
-
-					-- Update scroll container bookkeeping (persistent) now that we know the content extent.
-					if clipCfgUnion ~= nil then
-						for si = 0, context.scrollContainerDatas.length - 1 do
-							local scrollData = context.scrollContainerDatas.internalArray + si
-							if scrollData.elementId == elem.id then
-								scrollData.boundingBox = bbox
-								scrollData.contentSize.width = contentSize.width + padW
-								scrollData.contentSize.height = contentSize.height + padH
-								break
-							end
-						end
-					end
-
-					local extraSpace = elem.dimensions.width - (config.padding.left + config.padding.right) - contentSize.width
-					
-					if config.childAlignment.x == Llay_AlignX.LEFT then
-						extraSpace = 0
-					elseif config.childAlignment.x == Llay_AlignX.CENTER then
-						extraSpace = extraSpace / 2
-					end
-					
-					node.nextChildOffset.x = node.nextChildOffset.x + extraSpace
-				else
-					for i = 0, elem.childrenOrTextContent.children.length - 1 do
-						local child = context.layoutElements.internalArray + elem.childrenOrTextContent.children.elements[i]
-						contentSize.width = LLAY__MAX(contentSize.width, child.dimensions.width)
-						contentSize.height = contentSize.height + child.dimensions.height
-					end
-					contentSize.height = contentSize.height + (LLAY__MAX(elem.childrenOrTextContent.children.length - 1, 0) * config.childGap)
-
-					if clipCfgUnion ~= nil then
-						for si = 0, context.scrollContainerDatas.length - 1 do
-							local scrollData = context.scrollContainerDatas.internalArray + si
-							if scrollData.elementId == elem.id then
-								scrollData.boundingBox = bbox
-								scrollData.contentSize.width = contentSize.width + padW
-								scrollData.contentSize.height = contentSize.height + padH
-								break
-							end
-						end
-					end
-
-					local extraSpace = elem.dimensions.height - (config.padding.top + config.padding.bottom) - contentSize.height
-					
-					if config.childAlignment.y == Llay_AlignY.TOP then
-						extraSpace = 0
-					elseif config.childAlignment.y == Llay_AlignY.CENTER then
-						extraSpace = extraSpace / 2
-					end
-					
-					node.nextChildOffset.y = node.nextChildOffset.y + extraSpace
-				end
+			if not isText and not aligned then
+				Llay__AlignChildrenAlongAxis(nodeIdx)
 			end
 
-			if elem.childrenOrTextContent.children.length > 0 then
-				local scrollOffsetX = 0
-				local scrollOffsetY = 0
-				local clipCfgUnion = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.CLIP)
-				if clipCfgUnion ~= nil then
-					local clipCfg = clipCfgUnion.clipElementConfig
-					scrollOffsetX = clipCfg.childOffset.x
-					scrollOffsetY = clipCfg.childOffset.y
-				end
-
-				local currentOffset = { x = node.nextChildOffset.x, y = node.nextChildOffset.y }
-
-				for j = 0, elem.childrenOrTextContent.children.length - 1 do
-					local childIdx = elem.childrenOrTextContent.children.elements[j]
-					local child = context.layoutElements.internalArray + childIdx
-
-					-- Alignment Logic for Child Axis
-					if config.layoutDirection == Llay_LayoutDirection.LEFT_TO_RIGHT then
-						currentOffset.y = config.padding.top
-						local freeSpace = elem.dimensions.height
-							- config.padding.top
-							- config.padding.bottom
-							- child.dimensions.height
-						if config.childAlignment.y == Llay_AlignY.CENTER then
-							currentOffset.y = currentOffset.y + freeSpace / 2
-						elseif config.childAlignment.y == Llay_AlignY.BOTTOM then
-							currentOffset.y = currentOffset.y + freeSpace
-						end
-					else
-						currentOffset.x = config.padding.left
-						local freeSpace = elem.dimensions.width
-							- config.padding.left
-							- config.padding.right
-							- child.dimensions.width
-						if config.childAlignment.x == Llay_AlignX.CENTER then
-							currentOffset.x = currentOffset.x + freeSpace / 2
-						elseif config.childAlignment.x == Llay_AlignX.RIGHT then
-							currentOffset.x = currentOffset.x + freeSpace
-						end
-					end
-
-					local childNode = array_add(dfsBuffer, ffi.new("Clay__LayoutElementTreeNode"))
-					childNode.layoutElement = child
-					childNode.position.x = node.position.x + currentOffset.x + scrollOffsetX
-					childNode.position.y = node.position.y + currentOffset.y + scrollOffsetY
-					childNode.nextChildOffset.x = child.layoutConfig.padding.left
-					childNode.nextChildOffset.y = child.layoutConfig.padding.top
-					context.treeNodeVisited.internalArray[dfsBuffer.length - 1] = false
-
-					if config.layoutDirection == Llay_LayoutDirection.LEFT_TO_RIGHT then
-						currentOffset.x = currentOffset.x + child.dimensions.width + config.childGap
-					else
-						currentOffset.y = currentOffset.y + child.dimensions.height + config.childGap
-					end
-				end
-
-				-- Reverse the added children so they are popped in 0..N order
-				local childrenCount = elem.childrenOrTextContent.children.length
-				if childrenCount > 1 then
-					local startIdx = dfsBuffer.length - childrenCount
-					local endIdx = dfsBuffer.length - 1
-					while startIdx < endIdx do
-						-- Swap
-						tempNode.layoutElement = dfsBuffer.internalArray[startIdx].layoutElement
-						tempNode.position.x = dfsBuffer.internalArray[startIdx].position.x
-						tempNode.position.y = dfsBuffer.internalArray[startIdx].position.y
-						tempNode.nextChildOffset.x = dfsBuffer.internalArray[startIdx].nextChildOffset.x
-						tempNode.nextChildOffset.y = dfsBuffer.internalArray[startIdx].nextChildOffset.y
-
-						dfsBuffer.internalArray[startIdx].layoutElement = dfsBuffer.internalArray[endIdx].layoutElement
-						dfsBuffer.internalArray[startIdx].position.x = dfsBuffer.internalArray[endIdx].position.x
-						dfsBuffer.internalArray[startIdx].position.y = dfsBuffer.internalArray[endIdx].position.y
-						dfsBuffer.internalArray[startIdx].nextChildOffset.x =
-							dfsBuffer.internalArray[endIdx].nextChildOffset.x
-						dfsBuffer.internalArray[startIdx].nextChildOffset.y =
-							dfsBuffer.internalArray[endIdx].nextChildOffset.y
-
-						dfsBuffer.internalArray[endIdx].layoutElement = tempNode.layoutElement
-						dfsBuffer.internalArray[endIdx].position.x = tempNode.position.x
-						dfsBuffer.internalArray[endIdx].position.y = tempNode.position.y
-						dfsBuffer.internalArray[endIdx].nextChildOffset.x = tempNode.nextChildOffset.x
-						dfsBuffer.internalArray[endIdx].nextChildOffset.y = tempNode.nextChildOffset.y
-
-						startIdx = startIdx + 1
-						endIdx = endIdx - 1
-					end
-				end
+			if hasChildren then
+				Llay__PushChildNodes(nodeIdx)
 			end
 		end
+		::continue_node::
+	end
+	if profiling then
+		_frameStats.elementsSkipped = context.layoutElements.length
+			- _frameStats.elementsEmitted
+			- _frameStats.elementsCulled
+		Llay__ProfilePhase("renderCommandsMs", phaseStart)
 	end
 end
 
@@ -2104,21 +3453,45 @@ end
 -- Public API
 -- ==================================================================================
 
+-- dims may also carry the array sizing: elements (maxElementCount, default 8192),
+-- words (measured word cache, default 16384) and autosize (true or { headroom,
+-- shrink_after }). With autosize the arena grows and shrinks on its own and
+-- capacity is ignored. evict_after (frames, default 600; false keeps every id)
+-- frees the hash map slots of ids that stop being declared.
 function M.initialize(capacity, dims)
-	capacity = capacity or (1024 * 1024 * 16)
-	
+	local elements = dims and dims.elements or 8192
+	local words = dims and dims.words or 16384
+	local autosize = dims and dims.autosize
+	local evictAfter = 600
+	if dims and dims.evict_after ~= nil then
+		evictAfter = dims.evict_after or 0
+	end
+
 	-- ANCHOR THE MEMORY: Prevent GC from reclaiming the arena and context
-	_ANCHORS.arena_memory = ffi.new("uint8_t[?]", capacity)
 	_ANCHORS.context = ffi.new("Clay_Context")
-	
 	context = _ANCHORS.context
-	context.maxElementCount = 8192
-	context.maxMeasureTextCacheWordCount = 16384
-	context.internalArena.capacity = capacity
-	context.internalArena.memory = ffi.cast("char*", _ANCHORS.arena_memory)
-	context.internalArena.nextAllocation = 0
+	context.needsFrame = true
+	-- Handed out by every end_layout(), so returning it allocates nothing
+	_ANCHORS.renderCommands = context.renderCommands
+	context.maxElementCount = elements
+	-- The measure cache hashes into words / 32 buckets
+	context.maxMeasureTextCacheWordCount = math.ceil(words / 32) * 32
+	if autosize then
+		_ANCHORS.sizing = Llay__NewArenaSizing(autosize, elements)
+		_ANCHORS.arena_memory = nil
+	else
+		capacity = capacity or (1024 * 1024 * 16)
+		_ANCHORS.sizing = nil
+		_ANCHORS.arena_memory = ffi.new("uint8_t[?]", capacity)
+		context.internalArena.capacity = capacity
+		context.internalArena.memory = ffi.cast("char*", _ANCHORS.arena_memory)
+		context.internalArena.nextAllocation = 0
+	end
 	context.layoutDimensions.width = dims and dims.width or 800
 	context.layoutDimensions.height = dims and dims.height or 600
+	context.hashMapEvictAfter = evictAfter
+	-- Slots the sweep looks at per frame while some id is undeclared
+	context.hashMapSweepStep = 64
 
 	Llay__InitializePersistentMemory(context)
 	Llay__InitializeEphemeralMemory(context)
@@ -2139,76 +3512,286 @@ function M.initialize(capacity, dims)
 	return context
 end
 
-function M.begin_layout()
-	Llay__InitializeEphemeralMemory(context)
-	context.generation = context.generation + 1
-	next_element_id = 1
-	
-	local rootId = M.Llay__GetElementId("Clay__RootContainer")
-	M.open_element_with_id(rootId)
-	
-	M.configure_open_element(ffi.new("Clay_ElementDeclaration", {
-		layout = ffi.new("Clay_LayoutConfig", {
-			sizing = {
-				width = {
-					type = 3,
-					size = {
-						minMax = {
-							min = context.layoutDimensions.width,
-							max = context.layoutDimensions.width,
-						},
-					},
-				},
-				height = {
-					type = 3,
-					size = {
-						minMax = {
-							min = context.layoutDimensions.height,
-							max = context.layoutDimensions.height,
-						},
-					},
-				},
-			},
-		}),
-	}))
-	
-	-- initialize tree roots - root element is already at index 0 and on the stack
-	local treeRoot = context.layoutElementTreeRoots.internalArray
-	treeRoot[0].layoutElementIndex = 0
-	treeRoot[0].zIndex = 0
-	context.layoutElementTreeRoots.length = 1
+function M.begin_layout()
+	if profiling then
+		_declareStart = Llay__ProfileNow()
+	end
+	Llay__InitializeEphemeralMemory(context)
+	-- Whatever asked for this frame is handled by it; later requests (including
+	-- invalidate() from inside the declaration) wait for the next one
+	context.needsFrame = false
+	context.renderFingerprintPending = false
+	context.textFingerprint = 0
+	-- Sweep only while some ids went undeclared last frame, so an unchanged frame
+	-- never runs it
+	local map = context.layoutElementsHashMapInternal
+	if context.hashMapEvictAfter > 0
+		and map.length - context.layoutElementsHashMapFreeList.length > context.hashMapSeenCount then
+		Llay__SweepHashMap(context.hashMapSweepStep)
+	end
+	context.hashMapSeenCount = 0
+	context.generation = context.generation + 1
+	next_element_id = 1
+	
+	local rootId = M.Llay__GetElementId("Clay__RootContainer")
+	M.open_element_with_id(rootId)
+	
+	local sizing = _ROOT_DECLARATION.layout.sizing
+	sizing.width.type = Llay__SizingType.FIXED
+	sizing.width.size.minMax.min = context.layoutDimensions.width
+	sizing.width.size.minMax.max = context.layoutDimensions.width
+	sizing.height.type = Llay__SizingType.FIXED
+	sizing.height.size.minMax.min = context.layoutDimensions.height
+	sizing.height.size.minMax.max = context.layoutDimensions.height
+	M.configure_open_element(_ROOT_DECLARATION)
+	
+	-- initialize tree roots - root element is already at index 0 and on the stack
+	local treeRoot = context.layoutElementTreeRoots.internalArray
+	-- Sorting may have moved a floating root into slot 0 last frame
+	ffi.fill(treeRoot, ffi.sizeof(_EMPTY_TREE_ROOT))
+	context.layoutElementTreeRoots.length = 1
+	context.treeRootsUnsorted = false
+end
+
+-- ==================================================================================
+-- Hit-Test Index
+-- ==================================================================================
+-- Built once per layout so pointer queries skip whole subtrees whose bounds miss the
+-- point. Traversal order is the same as the plain tree walk, so results (and the
+-- front-to-back order of pointerOverIds) are identical.
+
+local LLAY__HIT_TEXT = 1
+local LLAY__HIT_PASSTHROUGH = 2
+local LLAY__HIT_CAPTURE_ROOT = 4
+
+-- Fills one element's node; its children's nodes are already filled
+local function Llay__BuildHitTestNode(elemIdx)
+	local childCount = 0
+	local minX, minY, maxX, maxY
+	do
+		local elem = Llay__ElementAt(elemIdx)
+		local node = context.hitTestNodes.internalArray + elemIdx
+		node.flags = 0
+		local mapIndex = context.layoutElementHashMapIndexes.internalArray[elemIdx]
+		-- Elements in subtrees the render pass skipped keep an old box; they can't be hit
+		if mapIndex ~= -1
+			and not cull.placed_this_frame(context, context.layoutElementsHashMapInternal.internalArray + mapIndex) then
+			mapIndex = -1
+		end
+		node.hashMapIndex = mapIndex
+		if mapIndex == -1 then
+			return
+		end
+		local floatingUnion = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.FLOATING)
+		if floatingUnion ~= nil then
+			local mode = floatingUnion.floatingElementConfig.pointerCaptureMode
+			if mode == Llay_PointerCaptureMode.PASSTHROUGH then
+				node.flags = LLAY__HIT_PASSTHROUGH
+			elseif mode == Llay_PointerCaptureMode.CAPTURE then
+				node.flags = LLAY__HIT_CAPTURE_ROOT
+			end
+		end
+
+		local box = context.layoutElementsHashMapInternal.internalArray[mapIndex].boundingBox
+		minX, minY = box.x, box.y
+		maxX, maxY = box.x + box.width, box.y + box.height
+		if Llay__ElementHasConfig(elem, Llay__ElementConfigType.TEXT) then
+			node.flags = bit.bor(node.flags, LLAY__HIT_TEXT)
+		else
+			childCount = elem.childrenOrTextContent.children.length
+		end
+	end
+
+	for i = 0, childCount - 1 do
+		local childIdx = Llay__ElementAt(elemIdx).childrenOrTextContent.children.elements[i]
+		local child = context.hitTestNodes.internalArray + childIdx
+		if child.hashMapIndex >= 0 and bit.band(child.flags, LLAY__HIT_PASSTHROUGH) == 0 then
+			local cb = child.subtreeBounds
+			minX = LLAY__MIN(minX, cb.x)
+			minY = LLAY__MIN(minY, cb.y)
+			maxX = LLAY__MAX(maxX, cb.x + cb.width)
+			maxY = LLAY__MAX(maxY, cb.y + cb.height)
+		end
+	end
+
+	local bounds = context.hitTestNodes.internalArray[elemIdx].subtreeBounds
+	bounds.x = minX
+	bounds.y = minY
+	bounds.width = maxX - minX
+	bounds.height = maxY - minY
+end
+
+local function Llay__BuildHitTestIndex()
+	local count = context.layoutElements.length
+	context.hitTestNodes.length = count
+
+	-- Children are always declared after their parent, so a reverse sweep sees every
+	-- child's subtree before the parent's.
+	for elemIdx = count - 1, 0, -1 do
+		Llay__BuildHitTestNode(elemIdx)
+	end
+
+	context.hitTestIndexValid = true
+end
+
+-- Appends hits to pointerOverIds, or to the Lua array `out` when given.
+local function Llay__HitTestIndexed(elemIdx, x, y, out)
+	local mapIndex, insideSelf, childCount
+	do
+		local node = context.hitTestNodes.internalArray + elemIdx
+		if node.hashMapIndex < 0 or bit.band(node.flags, LLAY__HIT_PASSTHROUGH) ~= 0 then
+			return false
+		end
+		local sb = node.subtreeBounds
+		if x < sb.x or x > sb.x + sb.width or y < sb.y or y > sb.y + sb.height then
+			return false
+		end
+
+		mapIndex = node.hashMapIndex
+		local box = context.layoutElementsHashMapInternal.internalArray[mapIndex].boundingBox
+		insideSelf = x >= box.x and x <= box.x + box.width and y >= box.y and y <= box.y + box.height
+
+		-- TEXT elements are transparent to the pointer: they report a hit but are not recorded
+		if bit.band(node.flags, LLAY__HIT_TEXT) ~= 0 then
+			return insideSelf
+		end
+		childCount = Llay__ElementAt(elemIdx).childrenOrTextContent.children.length
+	end
+
+	local hit = false
+	for i = childCount - 1, 0, -1 do
+		if Llay__HitTestIndexed(Llay__ElementAt(elemIdx).childrenOrTextContent.children.elements[i], x, y, out) then
+			hit = true
+			break
+		end
+	end
+
+	if hit or insideSelf then
+		local mapItem = context.layoutElementsHashMapInternal.internalArray + mapIndex
+		if out then
+			out[#out + 1] = mapItem.elementId.id
+		else
+			pointer_over_ids_add(mapItem.elementId)
+		end
+		return true
+	end
+	return false
+end
+
+-- Walks roots front to back; a hit on a CAPTURE floating root blocks the roots behind it.
+local function Llay__QueryHitTestIndex(x, y, out)
+	for rootIndex = context.layoutElementTreeRoots.length - 1, 0, -1 do
+		local elemIdx = context.layoutElementTreeRoots.internalArray[rootIndex].layoutElementIndex
+		if Llay__HitTestIndexed(elemIdx, x, y, out) then
+			if bit.band(context.hitTestNodes.internalArray[elemIdx].flags, LLAY__HIT_CAPTURE_ROOT) ~= 0 then
+				return
+			end
+		end
+	end
+end
+
+-- Hashes the last frame's render commands once, on first request: every byte of
+-- each command, plus the text they point at (collected by Llay__AddTextCommands,
+-- since the same pointer can hold new text). Output that differs from the previous
+-- hash may not have settled yet (hover, scroll extents and element data lag one
+-- frame), so it asks for one more frame.
+local Llay__UpdateRenderFingerprint
+do
+	local COMMAND_WORDS = ffi.sizeof("Clay_RenderCommand") / 4
+
+	function Llay__UpdateRenderFingerprint()
+		if not context.renderFingerprintPending then
+			return
+		end
+		context.renderFingerprintPending = false
+		local length = context.renderCommands.length
+		local hash = context.textFingerprint + length
+		for i = 0, length * COMMAND_WORDS - 1 do
+			hash = bit.tobit(hash + ffi.cast("int32_t*", context.renderCommands.internalArray)[i])
+			hash = hash + bit.lshift(hash, 10)
+			hash = bit.bxor(hash, bit.rshift(hash, 6))
+		end
+		if hash ~= context.renderFingerprint then
+			context.renderFingerprint = hash
+			context.needsFrame = true
+		end
+	end
 end
 
 function M.end_layout()
+	local endLayoutStart = 0
+	if profiling then
+		endLayoutStart = Llay__ProfilePhase("declareMs", _declareStart)
+	end
+
 	M.close_element()
-	Clay__CalculateFinalLayout()
+	if not context.booleanWarnings.maxElementsExceeded then
+		Clay__CalculateFinalLayout()
+	end
+	-- An array filled up during declaration or layout: the frame has no commands
+	if context.booleanWarnings.maxElementsExceeded then
+		context.renderCommands.length = 0
+		-- Autosize (or the host) gets another try at the frame
+		context.needsFrame = true
+	else
+		Llay__BuildHitTestIndex()
+	end
+	-- Hashed when needs_frame() or get_render_fingerprint() first asks
+	context.renderFingerprintPending = true
 	
 	if DEBUG_MODE then
 		Inspector.check_arena_health()
 	end
+
+	if profiling then
+		Llay__ProfilePhase("endLayoutMs", endLayoutStart)
+		Llay__ProfileFinishFrame()
+	end
 	
-	return context.renderCommands
+	return _ANCHORS.renderCommands
+end
+
+-- Whether a frame run now could differ from the last one: true after input that
+-- changes what is hovered, pressed, captured or scrolled, a resize, invalidate(), or
+-- a frame whose output changed. Hosts that skip frames while it is false still call
+-- set_pointer_state and update_scroll_containers every tick.
+function M.needs_frame()
+	Llay__UpdateRenderFingerprint()
+	return context.needsFrame
+end
+
+-- Equal for frames whose render commands are byte-identical (text compared by
+-- content); computed on the first call after end_layout
+function M.get_render_fingerprint()
+	Llay__UpdateRenderFingerprint()
+	return context.renderFingerprint
+end
+
+-- For changes the engine can't see: app state, fonts, images, animations
+function M.invalidate()
+	context.needsFrame = true
+	context.layerEpoch = context.layerEpoch + 1
 end
 
 local function Clay__GenerateIdForAnonymousElement(openLayoutElement)
 	local parentIdx = int32_array_get(context.openLayoutElementStack, context.openLayoutElementStack.length - 2)
 	local parent = context.layoutElements.internalArray + parentIdx
-	local slot = parentIdx
-	local offset = parent.childrenOrTextContent.children.length + parent.floatingChildrenCount + _openChildrenCounts[slot]
-	_openChildrenCounts[slot] = _openChildrenCounts[slot] + 1
-	local elementId = Llay__HashNumber(offset, parent.id)
+	local offset = parent.childrenOrTextContent.children.length + parent.floatingChildrenCount
+	local elementId = Llay__HashNumberInto(_SCRATCH_ELEMENT_ID, offset, parent.id)
 
 	openLayoutElement.id = elementId.id
-	Llay__AddHashMapItem(elementId, openLayoutElement)
+	Llay__AddHashMapItem(elementId, openLayoutElement, context.layoutElements.length - 1)
 	array_add(context.layoutElementIdStrings, elementId.stringId)
 	return elementId
 end
 
 function M.open_element()
 	local elemIdx = context.layoutElements.length
-	local elem = array_add(context.layoutElements, ffi.new("Clay_LayoutElement"))
-	
-	ffi.fill(elem, ffi.sizeof("Clay_LayoutElement"))
+	if context.booleanWarnings.maxElementsExceeded or elemIdx >= context.layoutElements.capacity then
+		return Llay__ArrayOverflow(context.layoutElements)
+	end
+	local elem = array_add(context.layoutElements, _EMPTY_LAYOUT_ELEMENT)
+	context.layoutElementConfigIndexes.internalArray[elemIdx].mask = 0
 	
 	int32_array_add(context.openLayoutElementStack, elemIdx)
 	
@@ -2226,56 +3809,117 @@ end
 
 function M.open_element_with_id(elementId)
 	local elem = M.open_element()
+	if context.booleanWarnings.maxElementsExceeded then
+		return elem
+	end
 	local elemIdx = context.layoutElements.length - 1
 
 	elem.id = elementId.id
-	Llay__AddHashMapItem(elementId, elem)
+	Llay__AddHashMapItem(elementId, elem, elemIdx)
 
-	local strId = ffi.new("Clay_String")
+	local strId = array_add(context.layoutElementIdStrings, _EMPTY_STRING)
 	strId.length = elementId.stringId.length
 	local charsValue = elementId.stringId.chars
-	if type(charsValue) == "table" then
-		charsValue = charsValue.chars or charsValue[1] or ""
+	if type(charsValue) == "cdata" then
+		-- An interned ID's string lives only as long as its handle, and the handle
+		-- can be collected mid-frame once the ID cache is wiped, so copy it too
+		strId.chars = Llay__AllocateStringInArena(charsValue, strId.length)
+	else
+		if type(charsValue) == "table" then
+			charsValue = charsValue.chars or charsValue[1] or ""
+		end
+		-- FIX: Copy ID string to arena to prevent GC corruption of debug strings
+		local charsPtr, _ = Llay__AllocateStringInArena(charsValue)
+		strId.chars = charsPtr
 	end
-
-	-- FIX: Copy ID string to arena to prevent GC corruption of debug strings
-	local charsPtr, _ = Llay__AllocateStringInArena(charsValue)
-	strId.chars = charsPtr
 	strId.isStaticallyAllocated = true
 
-	array_add(context.layoutElementIdStrings, strId)
-
 	return elem
 end
 
 function M.configure_open_element(declaration)
+	if context.booleanWarnings.maxElementsExceeded then
+		return
+	end
 	Llay__ConfigureOpenElement(declaration)
 end
 
-function M.close_element()
-	local closingIdx = int32_array_remove_swapback(context.openLayoutElementStack, context.openLayoutElementStack.length - 1)
-	local elem = context.layoutElements.internalArray + closingIdx
-	
-	if DEBUG_MODE then
-		print("[CLOSE] Closing element " .. closingIdx)
-		print("[CLOSE]   Stack before: " .. context.openLayoutElementStack.length .. " elements")
-		print("[CLOSE]   Buffer size before: " .. context.layoutElementChildrenBuffer.length)
+-- Sizes a closing element around its children, which are already closed
+local function Llay__FitToChildren(elemIdx, childCount)
+	local leftToRight, padW, padH, childGap
+	do
+		local config = Llay__ElementAt(elemIdx).layoutConfig
+		leftToRight = config.layoutDirection == Llay_LayoutDirection.LEFT_TO_RIGHT
+		padW = config.padding.left + config.padding.right
+		padH = config.padding.top + config.padding.bottom
+		childGap = config.childGap
 	end
-	
-	if elem.layoutConfig == nil then
-		elem.layoutConfig = context.layoutConfigs.internalArray
+
+	if leftToRight then
+		Llay__ElementAt(elemIdx).dimensions.width = padW
+		for i = 0, childCount - 1 do
+			local elem = Llay__ElementAt(elemIdx)
+			local child = Llay__ElementAt(elem.childrenOrTextContent.children.elements[i])
+			elem.dimensions.width = elem.dimensions.width + child.dimensions.width
+			-- For cross-axis (height in LEFT_TO_RIGHT), GROW children haven't been sized yet
+			-- Use minDimensions (intrinsic size) instead so FIT parent can calculate proper height
+			local childHeight = child.dimensions.height
+			if child.layoutConfig.sizing.height.type == Llay__SizingType.GROW then
+				childHeight = child.minDimensions.height
+			end
+			elem.dimensions.height = LLAY__MAX(elem.dimensions.height, childHeight + padH)
+		end
+		local elem = Llay__ElementAt(elemIdx)
+		elem.dimensions.width = elem.dimensions.width + (LLAY__MAX(childCount - 1, 0) * childGap)
+	else
+		Llay__ElementAt(elemIdx).dimensions.height = padH
+		for i = 0, childCount - 1 do
+			local elem = Llay__ElementAt(elemIdx)
+			local child = Llay__ElementAt(elem.childrenOrTextContent.children.elements[i])
+			elem.dimensions.height = elem.dimensions.height + child.dimensions.height
+			-- For cross-axis (width in TOP_TO_BOTTOM), GROW children haven't been sized yet
+			-- Use minDimensions (intrinsic size) instead so FIT parent can calculate proper width
+			local childWidth = child.dimensions.width
+			if child.layoutConfig.sizing.width.type == Llay__SizingType.GROW then
+				childWidth = child.minDimensions.width
+			end
+			elem.dimensions.width = LLAY__MAX(elem.dimensions.width, childWidth + padW)
+		end
+		local elem = Llay__ElementAt(elemIdx)
+		elem.dimensions.height = elem.dimensions.height + (LLAY__MAX(childCount - 1, 0) * childGap)
 	end
+end
 
-	if context.openClipElementStack.length > 0 then
-		if
-			Llay__ElementHasConfig(elem, Llay__ElementConfigType.CLIP)
-			or Llay__ElementHasConfig(elem, Llay__ElementConfigType.FLOATING)
-		then
-			int32_array_remove_swapback(context.openClipElementStack, context.openClipElementStack.length - 1)
+function M.close_element()
+	if context.booleanWarnings.maxElementsExceeded then
+		return
+	end
+	local closingIdx = int32_array_remove_swapback(context.openLayoutElementStack, context.openLayoutElementStack.length - 1)
+	local childCount
+	do
+		local elem = Llay__ElementAt(closingIdx)
+
+		if DEBUG_MODE then
+			print("[CLOSE] Closing element " .. closingIdx)
+			print("[CLOSE]   Stack before: " .. context.openLayoutElementStack.length .. " elements")
+			print("[CLOSE]   Buffer size before: " .. context.layoutElementChildrenBuffer.length)
+		end
+
+		if elem.layoutConfig == nil then
+			elem.layoutConfig = context.layoutConfigs.internalArray
+		end
+
+		if context.openClipElementStack.length > 0 then
+			if
+				Llay__ElementHasConfig(elem, Llay__ElementConfigType.CLIP)
+				or Llay__ElementHasConfig(elem, Llay__ElementConfigType.FLOATING)
+			then
+				int32_array_remove_swapback(context.openClipElementStack, context.openClipElementStack.length - 1)
+			end
 		end
+		childCount = elem.childrenOrTextContent.children.length
 	end
 
-	local childCount = elem.childrenOrTextContent.children.length
 	if childCount > 0 then
 		local baseIdx = context.layoutElementChildren.length
 		for i = 0, childCount - 1 do
@@ -2286,51 +3930,21 @@ function M.close_element()
 			end
 			int32_array_add(context.layoutElementChildren, childIdx)
 		end
-		elem.childrenOrTextContent.children.elements = context.layoutElementChildren.internalArray + baseIdx
+		Llay__ElementAt(closingIdx).childrenOrTextContent.children.elements = context.layoutElementChildren.internalArray + baseIdx
 		context.layoutElementChildrenBuffer.length = context.layoutElementChildrenBuffer.length - childCount
 		
 		if DEBUG_MODE then
 			print("[CLOSE]   Now has " .. childCount .. " children at indices: ")
 			for i = 0, childCount - 1 do
-				print("[CLOSE]     [" .. i .. "]=" .. elem.childrenOrTextContent.children.elements[i])
+				print("[CLOSE]     [" .. i .. "]=" .. Llay__ElementAt(closingIdx).childrenOrTextContent.children.elements[i])
 			end
 		end
 	end
 
-	local config = elem.layoutConfig
-	local padW = config.padding.left + config.padding.right
-	local padH = config.padding.top + config.padding.bottom
-	
-	if config.layoutDirection == Llay_LayoutDirection.LEFT_TO_RIGHT then
-		elem.dimensions.width = padW
-		for i = 0, childCount - 1 do
-			local child = context.layoutElements.internalArray + elem.childrenOrTextContent.children.elements[i]
-			elem.dimensions.width = elem.dimensions.width + child.dimensions.width
-			-- For cross-axis (height in LEFT_TO_RIGHT), GROW children haven't been sized yet
-			-- Use minDimensions (intrinsic size) instead so FIT parent can calculate proper height
-			local childHeight = child.dimensions.height
-			if child.layoutConfig.sizing.height.type == Llay__SizingType.GROW then
-				childHeight = child.minDimensions.height
-			end
-			elem.dimensions.height = LLAY__MAX(elem.dimensions.height, childHeight + padH)
-		end
-		elem.dimensions.width = elem.dimensions.width + (LLAY__MAX(childCount - 1, 0) * config.childGap)
-	else
-		elem.dimensions.height = padH
-		for i = 0, childCount - 1 do
-			local child = context.layoutElements.internalArray + elem.childrenOrTextContent.children.elements[i]
-			elem.dimensions.height = elem.dimensions.height + child.dimensions.height
-			-- For cross-axis (width in TOP_TO_BOTTOM), GROW children haven't been sized yet
-			-- Use minDimensions (intrinsic size) instead so FIT parent can calculate proper width
-			local childWidth = child.dimensions.width
-			if child.layoutConfig.sizing.width.type == Llay__SizingType.GROW then
-				childWidth = child.minDimensions.width
-			end
-			elem.dimensions.width = LLAY__MAX(elem.dimensions.width, childWidth + padW)
-		end
-		elem.dimensions.height = elem.dimensions.height + (LLAY__MAX(childCount - 1, 0) * config.childGap)
-	end
+	Llay__FitToChildren(closingIdx, childCount)
 
+	local elem = Llay__ElementAt(closingIdx)
+	local config = elem.layoutConfig
 	if context.openLayoutElementStack.length > 0 then
 		local parentIdx = int32_array_get(context.openLayoutElementStack, context.openLayoutElementStack.length - 1)
 		local parent = context.layoutElements.internalArray + parentIdx
@@ -2386,6 +4000,10 @@ function M.close_element()
 	end
 
 	Llay__UpdateAspectRatioBox(elem)
+
+	if context.incrementalLayoutEnabled then
+		Llay__HashLayoutElement(closingIdx)
+	end
 end
 
 function M.set_measure_text(fn, userData)
@@ -2393,6 +4011,62 @@ function M.set_measure_text(fn, userData)
 	context.measureTextUserData = userData
 end
 
+-- fn(text, words, count, config, userData): fill words[i].width/height for i in [0, count)
+function M.set_measure_text_batch(fn, userData)
+	measure_text_batch_fn = fn
+	measure_text_batch_user_data = userData
+end
+
+-- advances: float[256] cdata or a Lua table indexed by byte (0-255).
+-- fontSize = nil registers a scalable table measured at options.baseSize.
+-- options: { lineHeight, baseSize, kerning = function(prev, cur, fontId, fontSize) }
+function M.set_glyph_advances(fontId, fontSize, advances, options)
+	options = options or {}
+	local table_advances = ffi.new("float[256]")
+	if type(advances) == "cdata" then
+		ffi.copy(table_advances, advances, ffi.sizeof("float[256]"))
+	else
+		for c = 0, 255 do
+			table_advances[c] = advances[c] or 0
+		end
+	end
+
+	local baseSize = fontSize or options.baseSize
+	if not baseSize then
+		error("set_glyph_advances: scalable tables need options.baseSize")
+	end
+	local glyphs = {
+		advances = table_advances,
+		lineHeight = options.lineHeight or baseSize,
+		baseSize = baseSize,
+		kerning = options.kerning,
+	}
+
+	local byFont = glyph_tables[fontId]
+	if not byFont then
+		byFont = {}
+		glyph_tables[fontId] = byFont
+	end
+	byFont[fontSize or "scalable"] = glyphs
+end
+
+function M.clear_glyph_advances(fontId)
+	if fontId then
+		glyph_tables[fontId] = nil
+	else
+		glyph_tables = {}
+	end
+end
+
+-- Measure cache snapshots (see llay_measure_snapshot.lua)
+function M.snapshot_measure_cache(tag)
+	return require("llay_measure_snapshot").snapshot(context, tag)
+end
+
+function M.restore_measure_cache(bytes, tag)
+	return require("llay_measure_snapshot").restore(context, bytes, tag)
+end
+
 function M.set_query_scroll_offset(fn, userData)
 	query_scroll_offset_fn = fn
 	context.queryScrollOffsetUserData = userData
@@ -2548,6 +4222,7 @@ function M.set_scroll_offset_for(element_id, x, y)
 
 			mapping.scrollPosition.x = nx
 			mapping.scrollPosition.y = ny
+			context.needsFrame = true
 			mapping.scrollMomentum.x = 0
 			mapping.scrollMomentum.y = 0
 			mapping.pointerScrollActive = false
@@ -2561,10 +4236,17 @@ function M.set_scroll_offset_for(element_id, x, y)
 end
 
 function M.set_dimensions(w, h)
+	if w ~= context.layoutDimensions.width or h ~= context.layoutDimensions.height then
+		context.needsFrame = true
+	end
 	context.layoutDimensions.width = w
 	context.layoutDimensions.height = h
 end
 
+function M.get_layout_dimensions()
+	return context.layoutDimensions.width, context.layoutDimensions.height
+end
+
 -- ==================================================================================
 -- INTERACTION SYSTEM
 -- ==================================================================================
@@ -2574,7 +4256,52 @@ function M.point_is_inside_rect(point, rect)
 		   point.y >= rect.y and point.y <= rect.y + rect.height
 end
 
-function M.set_pointer_state(position, isPointerDown)
+-- Plain tree walk for hit testing mid-frame, before end_layout() built the index
+local function Llay__HitTestTree(elemIdx, position)
+	local elem = context.layoutElements.internalArray + elemIdx
+	local mapItem = Llay__GetHashMapItem(elem.id)
+	if not mapItem then return false end
+
+	-- Check for floating passthrough (ignore these for capture blocking)
+	local floatingUnion = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.FLOATING)
+	if floatingUnion ~= nil then
+		local floatingCfg = floatingUnion.floatingElementConfig
+		if floatingCfg.pointerCaptureMode == Llay_PointerCaptureMode.PASSTHROUGH then
+			return false
+		end
+	end
+
+	-- TEXT elements are transparent to mouse - don't add to pointerOverIds
+	local isTextElement = Llay__ElementHasConfig(elem, Llay__ElementConfigType.TEXT)
+
+	local hitChild = false
+	if not isTextElement then
+		for i = elem.childrenOrTextContent.children.length - 1, 0, -1 do
+			if Llay__HitTestTree(elem.childrenOrTextContent.children.elements[i], position) then
+				hitChild = true
+				break
+			end
+		end
+	end
+
+	if hitChild then
+		pointer_over_ids_add(mapItem.elementId)
+		return true
+	end
+
+	-- Text elements pass through hits to parent (don't capture)
+	if isTextElement then
+		return M.point_is_inside_rect(position, mapItem.boundingBox)
+	end
+
+	if M.point_is_inside_rect(position, mapItem.boundingBox) then
+		pointer_over_ids_add(mapItem.elementId)
+		return true
+	end
+	return false
+end
+
+local function Llay__SetPointerState(position, isPointerDown)
 	if context.booleanWarnings.maxElementsExceeded then return end
 
 	-- Ensure position matches C struct layout if passed as table
@@ -2586,9 +4313,14 @@ function M.set_pointer_state(position, isPointerDown)
 	end
 
 	-- CRITICAL: Sort roots first so we hit-test front-to-back
-	M.sort_roots_by_z()
+	-- (end_layout already sorted them when the index is valid)
+	if not context.hitTestIndexValid then
+		M.sort_roots_by_z()
+	end
 
 	context.pointerOverIds.length = 0
+	local previousOverHash = context.pointerOverHash
+	context.pointerOverHash = 0
 	local found_capture = false
 	
 	-- If we have a captured element, check if pointer is still over it
@@ -2596,12 +4328,13 @@ function M.set_pointer_state(position, isPointerDown)
 		local captured_item = Llay__GetHashMapItem(current_capture)
 		if captured_item then
 			-- Always add captured element to pointerOverIds (even if pointer outside)
-			element_id_array_add(context.pointerOverIds, captured_item.elementId)
+			pointer_over_ids_add(captured_item.elementId)
 		end
 		
 		-- Auto-release capture on mouse up if not manually captured
 		if not isPointerDown and not _capture_is_manual then
 			current_capture = nil
+			context.needsFrame = true
 		end
 		
 		-- If we have capture, we still do hit testing for the captured element
@@ -2609,68 +4342,29 @@ function M.set_pointer_state(position, isPointerDown)
 		-- (they're already blocked by the early return below)
 	end
 
-	-- Iterate from high index to low (front to back)
-	for rootIndex = context.layoutElementTreeRoots.length - 1, 0, -1 do
-		-- If we already hit a CAPTURE element, stop processing background roots
-		if found_capture then break end
-		
-		local root = context.layoutElementTreeRoots.internalArray + rootIndex
-		local rootElement = context.layoutElements.internalArray + root.layoutElementIndex
-
-		local function hitTest(elemIdx)
-			local elem = context.layoutElements.internalArray + elemIdx
-			local mapItem = Llay__GetHashMapItem(elem.id)
-			if not mapItem then return false end
-
-			-- Check for floating passthrough (ignore these for capture blocking)
-			local floatingUnion = Llay__FindElementConfigWithType(elem, Llay__ElementConfigType.FLOATING)
-			if floatingUnion ~= nil then
-				local floatingCfg = floatingUnion.floatingElementConfig
-				if floatingCfg.pointerCaptureMode == Llay_PointerCaptureMode.PASSTHROUGH then
-					return false
-				end
-			end
-			
-			-- TEXT elements are transparent to mouse - don't add to pointerOverIds
-			local isTextElement = Llay__ElementHasConfig(elem, Llay__ElementConfigType.TEXT)
-			
-			local hitChild = false
-			if not isTextElement then
-				for i = elem.childrenOrTextContent.children.length - 1, 0, -1 do
-					if hitTest(elem.childrenOrTextContent.children.elements[i]) then
-						hitChild = true
-						break
-					end
-				end
-			end
-			
-			if hitChild then
-				element_id_array_add(context.pointerOverIds, mapItem.elementId)
-				return true
-			end
-			
-			-- Text elements pass through hits to parent (don't capture)
-			if isTextElement then
-				return M.point_is_inside_rect(position, mapItem.boundingBox)
-			end
-			
-			if M.point_is_inside_rect(position, mapItem.boundingBox) then
-				element_id_array_add(context.pointerOverIds, mapItem.elementId)
-				return true
-			end
-			return false
-		end
+	if context.hitTestIndexValid then
+		Llay__QueryHitTestIndex(context.pointerInfo.position.x, context.pointerInfo.position.y, nil)
+	else
+		-- Plain tree walk when queried mid-frame (between begin_layout and end_layout)
+		-- Iterate from high index to low (front to back)
+		for rootIndex = context.layoutElementTreeRoots.length - 1, 0, -1 do
+			-- If we already hit a CAPTURE element, stop processing background roots
+			if found_capture then break end
 		
-		local hit = hitTest(root.layoutElementIndex)
+			local root = context.layoutElementTreeRoots.internalArray + rootIndex
+			local rootElement = context.layoutElements.internalArray + root.layoutElementIndex
+
+			local hit = Llay__HitTestTree(root.layoutElementIndex, position)
 		
-		-- If this root has CAPTURE mode, block everything behind it
-		if hit then
-			local floatingUnion = Llay__FindElementConfigWithType(rootElement, Llay__ElementConfigType.FLOATING)
-			if floatingUnion ~= nil then
-				local floatingCfg = floatingUnion.floatingElementConfig
-				if floatingCfg.pointerCaptureMode == Llay_PointerCaptureMode.CAPTURE then
-					found_capture = true
-					-- Continue to next iteration (which we break at top) to block background
+			-- If this root has CAPTURE mode, block everything behind it
+			if hit then
+				local floatingUnion = Llay__FindElementConfigWithType(rootElement, Llay__ElementConfigType.FLOATING)
+				if floatingUnion ~= nil then
+					local floatingCfg = floatingUnion.floatingElementConfig
+					if floatingCfg.pointerCaptureMode == Llay_PointerCaptureMode.CAPTURE then
+						found_capture = true
+						-- Continue to next iteration (which we break at top) to block background
+					end
 				end
 			end
 		end
@@ -2690,13 +4384,27 @@ function M.set_pointer_state(position, isPointerDown)
 			context.pointerInfo.state = Llay_PointerDataInteractionState.RELEASED_THIS_FRAME
 		end
 	end
+	-- Moving within the same elements changes nothing a frame would show
+	if context.pointerInfo.state ~= state or context.pointerOverHash ~= previousOverHash then
+		context.needsFrame = true
+	end
+end
+
+function M.set_pointer_state(position, isPointerDown)
+	if profiling then
+		local start = Llay__ProfileNow()
+		Llay__SetPointerState(position, isPointerDown)
+		Llay__ProfilePhase("pointerStateMs", start)
+		return
+	end
+	Llay__SetPointerState(position, isPointerDown)
 end
 
 -- ==================================================================================
 -- SCROLL SYSTEM
 -- ==================================================================================
 
-function M.update_scroll_containers(enableDragScrolling, scrollDelta, deltaTime)
+local function Llay__UpdateScrollContainers(enableDragScrolling, scrollDelta, deltaTime)
 	local isPointerActive = enableDragScrolling and (context.pointerInfo.state <= 1) -- PRESSED_THIS_FRAME or PRESSED
 	local highestPriorityScrollData = nil
 	local changed = false
@@ -2706,7 +4414,7 @@ function M.update_scroll_containers(enableDragScrolling, scrollDelta, deltaTime)
 
 	for i = 0, context.scrollContainerDatas.length - 1 do
 		local scrollData = context.scrollContainerDatas.internalArray + i
-		if not scrollData.openThisFrame then goto next_scroll end
+		if scrollData.openGeneration ~= context.generation then goto next_scroll end
 
 		-- If we have a capture owner, only process if this scroll container IS the owner
 		-- This prevents background scrollers from stealing events during capture
@@ -2714,7 +4422,6 @@ function M.update_scroll_containers(enableDragScrolling, scrollDelta, deltaTime)
 			goto next_scroll
 		end
 
-		scrollData.openThisFrame = false
 		local hashMapItem = Llay__GetHashMapItem(scrollData.elementId)
 		if not hashMapItem then goto next_scroll end
 
@@ -2858,49 +4565,91 @@ function M.update_scroll_containers(enableDragScrolling, scrollDelta, deltaTime)
 		return changed
 end
 
+function M.update_scroll_containers(enableDragScrolling, scrollDelta, deltaTime)
+	if profiling then
+		local start = Llay__ProfileNow()
+		local changed = Llay__UpdateScrollContainers(enableDragScrolling, scrollDelta, deltaTime)
+		Llay__ProfilePhase("scrollUpdateMs", start)
+		context.needsFrame = context.needsFrame or changed
+		return changed
+	end
+	local changed = Llay__UpdateScrollContainers(enableDragScrolling, scrollDelta, deltaTime)
+	context.needsFrame = context.needsFrame or changed
+	return changed
+end
+
 -- ==================================================================================
 -- FLOATING & Z-SORT
 -- ==================================================================================
 
+-- Sort ASCENDING (lower z first) so that lower z-index renders FIRST
+-- Rendering processes in array order, so last element (highest z) renders on top
+-- Front windows have LOWER z-index and render LAST (on top)
+-- Roots are declared in order far more often than not, so configure_open_element flags
+-- the frame only when a root arrives with a lower zIndex than the one before it.
+-- Otherwise a stable bottom-up merge sort ping-pongs between the roots and a scratch
+-- array, so hundreds of floating roots sort in O(n log n) without allocating.
 function M.sort_roots_by_z()
 	local count = context.layoutElementTreeRoots.length
-	if count <= 1 then return end
-	-- Stable Bubble Sort for small number of roots (common in UI)
-	-- Sort ASCENDING (lower z first) so that lower z-index renders FIRST
-	-- Rendering processes in array order, so last element (highest z) renders on top
-	-- Front windows have LOWER z-index and render LAST (on top)
-	local sorted = false
-	while not sorted do
-		sorted = true
-		for i = 0, count - 2 do
-			local current = context.layoutElementTreeRoots.internalArray[i]
-			local next = context.layoutElementTreeRoots.internalArray[i+1]
-			-- Use < for ascending sort (lower z first)
-			if next.zIndex < current.zIndex then
-				local tmp = ffi.new("Clay__LayoutElementTreeRoot", current)
-				context.layoutElementTreeRoots.internalArray[i] = next
-				context.layoutElementTreeRoots.internalArray[i+1] = tmp
-				sorted = false
+	if not context.treeRootsUnsorted or count <= 1 then return end
+	context.treeRootsUnsorted = false
+	local inScratch = false
+	local width = 1
+	while width < count do
+		local src = inScratch and context.layoutElementTreeRootsScratch.internalArray or context.layoutElementTreeRoots.internalArray
+		local dst = inScratch and context.layoutElementTreeRoots.internalArray or context.layoutElementTreeRootsScratch.internalArray
+		for lo = 0, count - 1, width * 2 do
+			local mid = math.min(lo + width, count)
+			local hi = math.min(lo + width * 2, count)
+			if mid >= hi or src[mid - 1].zIndex <= src[mid].zIndex then
+				-- Runs already in order (or a lone trailing run): copy them across whole
+				ffi.copy(dst + lo, src + lo, (hi - lo) * ffi.sizeof(_EMPTY_TREE_ROOT))
+			else
+				local i, j = lo, mid
+				for k = lo, hi - 1 do
+					-- <= keeps roots with equal z in declaration order
+					if j >= hi or (i < mid and src[i].zIndex <= src[j].zIndex) then
+						dst[k] = src[i]
+						i = i + 1
+					else
+						dst[k] = src[j]
+						j = j + 1
+					end
+				end
 			end
 		end
+		inScratch = not inScratch
+		width = width * 2
+	end
+	if inScratch then
+		ffi.copy(
+			context.layoutElementTreeRoots.internalArray,
+			context.layoutElementTreeRootsScratch.internalArray,
+			count * ffi.sizeof(_EMPTY_TREE_ROOT)
+		)
 	end
 end
 
 -- Helper functions for public API
-function M.open_text_element(text, textConfig)
-	if context.layoutElements.length >= context.layoutElements.capacity - 1 then return end
+-- text is a Lua string, a Clay_String, or a char pointer with its byte length
+-- (stream replay)
+function M.open_text_element(text, textConfig, length)
+	if length == nil and type(text) == "cdata" then
+		text, length = text.chars, text.length
+	end
+	if context.booleanWarnings.maxElementsExceeded or context.layoutElements.length >= context.layoutElements.capacity then
+		Llay__ArrayOverflow(context.layoutElements)
+		return
+	end
 	
 	local parent = Llay__GetOpenLayoutElement()
 	local elemIdx = context.layoutElements.length
-	local elem = array_add(context.layoutElements, ffi.new("Clay_LayoutElement"))
-	
-	-- Zero memory to prevent garbage in elementConfigs.length
-	ffi.fill(elem, ffi.sizeof("Clay_LayoutElement"))
+	local elem = array_add(context.layoutElements, _EMPTY_LAYOUT_ELEMENT)
 	
 	-- Hash ID based on parent + child index
-	local elementId = Llay__HashNumber(parent.childrenOrTextContent.children.length + parent.floatingChildrenCount, parent.id)
+	local elementId = Llay__HashNumberInto(_SCRATCH_ELEMENT_ID, parent.childrenOrTextContent.children.length + parent.floatingChildrenCount, parent.id)
 	elem.id = elementId.id
-	Llay__AddHashMapItem(elementId, elem)
+	Llay__AddHashMapItem(elementId, elem, elemIdx)
 	
 	-- Set default layout config
 	elem.layoutConfig = context.layoutConfigs.internalArray
@@ -2911,30 +4660,41 @@ function M.open_text_element(text, textConfig)
 	
 	-- FIX: Copy text content to arena
 	-- Lua strings passed to FFI are not anchored. We must copy them to the arena.
-	local charsPtr, len = Llay__AllocateStringInArena(text)
+	local charsPtr, len = Llay__AllocateStringInArena(text, length)
 	
+	local textData = array_add(context.textElementData, _EMPTY_TEXT_DATA)
+	textData.text.length = len
+	textData.text.chars = charsPtr
+	textData.text.isStaticallyAllocated = true
+	textData.measureId = Llay__HashWithConfig(Llay__HashChars(charsPtr, len, not length and text), storedCfg)
+
 	-- Measure (pass the arena pointer)
-	local clayString = ffi.new("Clay_String", { length = len, chars = charsPtr, isStaticallyAllocated = true })
-	local measured = Llay__MeasureTextCached(clayString, storedCfg)
+	local measured = Llay__MeasureTextCached(textData.text, storedCfg, textData.measureId)
 	
 	elem.dimensions.width = measured.unwrappedDimensions.width
 	elem.dimensions.height = (storedCfg.lineHeight > 0) and storedCfg.lineHeight or measured.unwrappedDimensions.height
 	elem.minDimensions.width = measured.minWidth
 	elem.minDimensions.height = elem.dimensions.height
 	
-	local textData = array_add(context.textElementData, ffi.new("Clay__TextElementData"))
-	textData.text = clayString
 	textData.preferredDimensions = measured.unwrappedDimensions
+	textData.measured = measured
 	textData.elementIndex = elemIdx
 	elem.childrenOrTextContent.textElementData = textData
 	
 	-- Configs (store pointer to arena-owned config)
-	local cfg = array_add(context.elementConfigs, ffi.new("Clay_ElementConfig"))
+	local cfg = array_add(context.elementConfigs, _EMPTY_ELEMENT_CONFIG)
 	cfg.type = Llay__ElementConfigType.TEXT
 	cfg.config.textElementConfig = storedCfg
 	
 	elem.elementConfigs.internalArray = cfg
 	elem.elementConfigs.length = 1
+	local configIndex = context.layoutElementConfigIndexes.internalArray[elemIdx]
+	configIndex.mask = bit.lshift(1, Llay__ElementConfigType.TEXT)
+	configIndex.slots[Llay__ElementConfigType.TEXT] = 0
+
+	if context.incrementalLayoutEnabled then
+		Llay__HashTextElement(elemIdx, measured, storedCfg)
+	end
 	
 	-- Parent link
 	parent.childrenOrTextContent.children.length = parent.childrenOrTextContent.children.length + 1
@@ -2971,8 +4731,13 @@ function M.get_parent_element_id()
 	return context.layoutElements.internalArray[parentIdx].id
 end
 
+-- Returns an interned, reusable Clay_ElementId cdata (do not mutate it)
 function M.Llay__GetElementId(str)
-	return Llay__HashString(str, 0)
+	return Llay__GetInternedId(str)
+end
+
+function M.Llay__GetElementIdWithIndex(str, index)
+	return Llay__GetInternedIdWithIndex(str, index)
 end
 
 function M.Llay__HashStringWithOffset(str, offset, seed)
@@ -3005,12 +4770,73 @@ M.Llay_PointerDataInteractionState = Llay_PointerDataInteractionState
 M.Llay_PointerCaptureMode = Llay_PointerCaptureMode
 M.Llay_FloatingAttachToElement = Llay_FloatingAttachToElement
 
+-- Ignored under autosize, which sizes the element arrays itself
 function M.set_max_element_count(count)
-	if context then
+	if context and not _ANCHORS.sizing then
 		context.maxElementCount = count
 	end
 end
 
+-- Capacities of the active layout's arrays and arena. `arrays` maps each per-frame
+-- array to { capacity, used }; under autosize tuned arrays also report `peak`, their
+-- high-water mark over the current shrink window.
+function M.get_arena_sizing()
+	local sizing = _ANCHORS.sizing
+	local used, bytes = Llay__ArenaUsage()
+	local result = {
+		autosize = sizing ~= nil,
+		elements = context.maxElementCount,
+		words = context.maxMeasureTextCacheWordCount,
+		bytes = bytes,
+		bytesUsed = used,
+		arrays = {},
+	}
+	for _, spec in ipairs(LLAY__EPHEMERAL_ARRAYS) do
+		local array = context[spec.field]
+		result.arrays[spec.field] = {
+			capacity = array.capacity,
+			used = array.length,
+			peak = sizing and sizing.peak[spec.field],
+		}
+	end
+	if sizing then
+		result.text = { capacity = sizing.capacity.text, peak = sizing.peak.text }
+		result.headroom = sizing.headroom
+		result.shrinkAfter = sizing.shrinkAfter
+		result.overflows = sizing.overflows
+		result.resizes = sizing.resizes
+	end
+	return result
+end
+
+-- Slot use of the element id hash map: `slots` have been handed out so far, `live`
+-- hold an id and `free` wait for reuse. `evictions` counts every slot freed, and
+-- `longestChain` is the longest bucket chain a lookup can walk.
+function M.get_id_map_stats()
+	local map = context.layoutElementsHashMapInternal
+	local buckets = context.layoutElementsHashMap
+	local free = context.layoutElementsHashMapFreeList.length
+	local longestChain = 0
+	for b = 0, buckets.capacity - 1 do
+		local chain = 0
+		local index = buckets.internalArray[b]
+		while index ~= -1 do
+			chain = chain + 1
+			index = map.internalArray[index].nextIndex
+		end
+		longestChain = LLAY__MAX(longestChain, chain)
+	end
+	return {
+		capacity = map.capacity,
+		slots = map.length,
+		live = map.length - free,
+		free = free,
+		evictions = context.hashMapEvictionCount,
+		evictAfter = context.hashMapEvictAfter,
+		longestChain = longestChain,
+	}
+end
+
 function M.set_culling_enabled(enabled)
 	if context then
 		context.disableCulling = not enabled
@@ -3023,9 +4849,22 @@ function M.set_debug_mode_enabled(enabled)
 	end
 end
 
+-- Reuse sizes and child positions of subtrees that are unchanged since the previous frame.
+-- Toggle between frames, not between begin_layout and end_layout.
+function M.set_incremental_layout_enabled(enabled)
+	if context then
+		context.incrementalLayoutEnabled = enabled
+	end
+end
+
+-- Number of elements whose sizing was restored from the memo in the last layout.
+function M.get_layout_memo_reused_count()
+	return context.layoutMemoReusedCount
+end
+
 function M.get_element_data(id)
 	local item = Llay__GetHashMapItem(id)
-	if item == nil then
+	if item == nil or not cull.is_placed(context, item) then
 		return { found = false, boundingBox = { x = 0, y = 0, width = 0, height = 0 } }
 	end
 	return {
@@ -3043,15 +4882,20 @@ end
 -- CAPTURE API - Input capture management for deep module architecture
 -- ==================================================================================
 
-local current_capture = nil  -- element_id or nil
-local _capture_is_manual = false
+local _hit_scratch = {}
 
 function M.capture(element_id)
+    if current_capture ~= element_id then
+        context.needsFrame = true
+    end
     current_capture = element_id
     _capture_is_manual = true
 end
 
 function M.release_capture()
+    if current_capture ~= nil then
+        context.needsFrame = true
+    end
     current_capture = nil
     _capture_is_manual = false
 end
@@ -3065,8 +4909,15 @@ function M.is_captured(element_id)
 end
 
 -- Hit test (does not consider capture)
--- Returns the topmost element ID under the pointer, or nil if nothing is under it.
+-- Returns the topmost element ID under (x, y), or nil if nothing is under it.
+-- Without coordinates, falls back to the last set_pointer_state result.
 function M.hit_test(x, y)
+    if x and y and context.hitTestIndexValid then
+        local hits = _hit_scratch
+        for i = #hits, 1, -1 do hits[i] = nil end
+        Llay__QueryHitTestIndex(x, y, hits)
+        return hits[1]
+    end
     -- Return topmost from pointerOverIds (index 0 is frontmost after sorting)
     if context.pointerOverIds.length > 0 then
         return context.pointerOverIds.internalArray[0].id
@@ -3074,11 +4925,32 @@ function M.hit_test(x, y)
     return nil
 end
 
+-- Batch query: one hit path per point, front to back, ignoring capture.
+-- points = { {x=, y=}, ... }; pass `out` from a previous call to reuse its tables.
+function M.query_points(points, out)
+    out = out or {}
+    for i = 1, #points do
+        local path = out[i]
+        if path then
+            for j = #path, 1, -1 do path[j] = nil end
+        else
+            path = {}
+            out[i] = path
+        end
+        if context.hitTestIndexValid then
+            Llay__QueryHitTestIndex(points[i].x, points[i].y, path)
+        end
+    end
+    for i = #out, #points + 1, -1 do out[i] = nil end
+    return out
+end
+
 -- Check if point is inside element's bounding box
 function M.point_in_element(x, y, element_id)
     local item = Llay__GetHashMapItem(element_id)
-    if not item then return false end
-    return M.point_is_inside_rect({x = x, y = y}, item.boundingBox)
+    if not item or not cull.is_placed(context, item) then return false end
+    local box = item.boundingBox
+    return x >= box.x and x <= box.x + box.width and y >= box.y and y <= box.y + box.height
 end
 
 -- ==================================================================================
@@ -3116,17 +4988,112 @@ end
 -- Returns array of element IDs ordered from topmost (front) to bottom (back)
 -- This includes all hovered elements with proper parent bubbling
 function M.get_hit_path(x, y)
-	-- Use the already-computed pointerOverIds from set_pointer_state
-	-- Returns IDs in order: [0] = topmost/front, [n] = bottom/back
+	-- Returns IDs in order: [1] = topmost/front, [n] = bottom/back
 	local result = {}
+	if x and y and context.hitTestIndexValid then
+		Llay__QueryHitTestIndex(x, y, result)
+		return result
+	end
+	-- Use the already-computed pointerOverIds from set_pointer_state
 	for i = 0, context.pointerOverIds.length - 1 do
 		result[i + 1] = context.pointerOverIds.internalArray[i].id
 	end
 	return result
 end
 
+-- ==================================================================================
+-- CONTEXTS - Independent layouts (windows, surfaces) sharing one module
+-- ==================================================================================
+
+-- Every engine table lives on the Clay_Context cdata; the upvalues below are the rest
+-- of a layout's state. Switching saves them into the outgoing state table and loads
+-- the incoming one, so the hot paths keep reading plain upvalues.
+local _activeContextState = {}
+
+local function Llay__SaveContextState(state)
+	state.anchors = _ANCHORS
+	state.context = context
+	state.measureTextFn = measure_text_fn
+	state.measureTextBatchFn = measure_text_batch_fn
+	state.measureTextBatchUserData = measure_text_batch_user_data
+	state.glyphTables = glyph_tables
+	state.queryScrollOffsetFn = query_scroll_offset_fn
+	state.nextElementId = next_element_id
+	state.profiling = profiling
+	state.frameStats = _frameStats
+	state.lastFrameStats = _lastFrameStats
+	state.statsRing = _statsRing
+	state.statsRingCapacity = _statsRingCapacity
+	state.statsRingCount = _statsRingCount
+	state.statsRingHead = _statsRingHead
+	state.profileFrame = _profileFrame
+	state.capture = current_capture
+	state.captureIsManual = _capture_is_manual
+end
+
+local function Llay__LoadContextState(state)
+	_ANCHORS = state.anchors
+	context = state.context
+	measure_text_fn = state.measureTextFn
+	measure_text_batch_fn = state.measureTextBatchFn
+	measure_text_batch_user_data = state.measureTextBatchUserData
+	glyph_tables = state.glyphTables
+	query_scroll_offset_fn = state.queryScrollOffsetFn
+	next_element_id = state.nextElementId
+	profiling = state.profiling
+	_frameStats = state.frameStats
+	_lastFrameStats = state.lastFrameStats
+	_statsRing = state.statsRing
+	_statsRingCapacity = state.statsRingCapacity
+	_statsRingCount = state.statsRingCount
+	_statsRingHead = state.statsRingHead
+	_profileFrame = state.profileFrame
+	current_capture = state.capture
+	_capture_is_manual = state.captureIsManual
+	_activeContextState = state
+end
+
+-- Makes `state` (from M.new_context) the layout every other function operates on
+function M.use_context(state)
+	if state ~= _activeContextState then
+		Llay__SaveContextState(_activeContextState)
+		Llay__LoadContextState(state)
+	end
+end
+
+-- The state table of the active layout; the one M.initialize set up by default
+function M.get_context()
+	return _activeContextState
+end
+
+-- Creates and initializes a new layout without touching the active one
+function M.new_context(capacity, dims)
+	local previous = _activeContextState
+	Llay__SaveContextState(previous)
+	Llay__LoadContextState({
+		anchors = { arena_memory = nil, context = nil, callbacks = {} },
+		glyphTables = {},
+		nextElementId = 1,
+		profiling = false,
+		frameStats = ffi.new("Llay_FrameStats"),
+		lastFrameStats = ffi.new("Llay_FrameStats"),
+		statsRingCapacity = 0,
+		statsRingCount = 0,
+		statsRingHead = -1,
+		profileFrame = 0,
+		captureIsManual = false,
+	})
+	local state = _activeContextState
+	M.initialize(capacity, dims)
+	Llay__SaveContextState(state)
+	Llay__LoadContextState(previous)
+	return state
+end
+
 -- Export internal functions for advanced usage
 M.Llay__GetHashMapItem = Llay__GetHashMapItem
+M.Llay__AddMeasuredWordValues = Llay__AddMeasuredWordValues
+M.int32_array_remove_swapback = int32_array_remove_swapback
 M.Llay__FindElementConfigWithType = Llay__FindElementConfigWithType
 
 return M
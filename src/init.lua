@@ -3,19 +3,193 @@ local shell = require("shell")
 
 local M = {}
 
+local lua_engine = core
+local engine_name = "lua"
+
+-- A Context is one independent layout (window, surface): its own arena, element and
+-- measure caches, scroll, pointer and capture state, and Custom render callbacks.
+-- Module functions act on the active context; context methods activate it first.
+local Context = {}
+local ContextMethods = setmetatable({}, {
+	__index = function(methods, key)
+		local fn = M[key]
+		if type(fn) ~= "function" then
+			return nil
+		end
+		local method = function(ctx, ...)
+			M.use_context(ctx)
+			return fn(...)
+		end
+		methods[key] = method
+		return method
+	end,
+})
+Context.__index = ContextMethods
+
+function ContextMethods.use(ctx)
+	M.use_context(ctx)
+end
+
+local function new_context_object(state)
+	return setmetatable({ _state = state, _engine = lua_engine, _engine_name = "lua", _render_callbacks = {}, _virtual_lists = {} }, Context)
+end
+
+local default_context = new_context_object(lua_engine.get_context())
+local active_context = default_context
+shell._use_render_callbacks(default_context._render_callbacks)
+shell._use_virtual_lists(default_context._virtual_lists)
+
 -- ==================================================================================
 -- Lifecycle API
 -- ==================================================================================
 
+-- JIT settings for layout: longer traces with more constants, so whole layout passes
+-- compile, and side exits that keep retrying until the branches a frame takes have
+-- traces instead of falling back to the interpreter (which boxes every cdata value
+-- it touches)
+local LAYOUT_JIT = {
+	"maxrecord=20000",
+	"maxirconst=4000",
+	"maxsnap=2000",
+	"maxside=1000",
+	"maxtrace=4000",
+	"maxmcode=16384",
+	"hotexit=4",
+	"tryside=1000",
+}
+
+-- Opt-in: tunes LuaJIT so that layout passes compile whole, which cuts the heap a
+-- warm frame allocates. The settings are process-wide and every compiled trace is
+-- flushed, so call it once at startup, before the host's own code warms up.
+-- Returns false without LuaJIT.
+function M.tune_jit_for_layout()
+	if not jit then
+		return false
+	end
+	jit.opt.start(unpack(LAYOUT_JIT))
+	-- Traces recorded under the old limits would keep their exits
+	jit.flush()
+	return true
+end
+
+-- init(capacity, dims) or init({ capacity, width, height, engine, library, shim,
+-- elements, words, autosize, evict_after }).
+-- engine = "native" runs layout in the compiled Clay library (see llay_native.lua).
+-- autosize lets the arena follow each array's high-water mark (see core.initialize).
 function M.init(capacity, dims)
+	local engine = lua_engine
+	local name = "lua"
 	-- Helper to handle optional args
 	if type(capacity) == "table" and dims == nil then
-		dims = capacity
-		capacity = nil
+		local options = capacity
+		dims = options
+		capacity = options.capacity
+		if options.engine == "native" then
+			if active_context ~= default_context then
+				error("llay: the native engine only runs in the default context", 2)
+			end
+			local err
+			engine, err = require("llay_native").load(options)
+			if not engine then
+				error(err, 2)
+			end
+			name = "native"
+		elseif options.engine ~= nil and options.engine ~= "lua" then
+			error("llay: unknown engine '" .. tostring(options.engine) .. "'", 2)
+		end
 	end
+	core = engine
+	engine_name = name
+	active_context._engine = engine
+	active_context._engine_name = name
+	shell._set_engine(engine)
 	return core.initialize(capacity, dims)
 end
 
+-- new_context({ capacity, dims = { width, height }, elements, words, autosize,
+-- evict_after });
+-- width/height may also be given directly. The new context is initialized but not
+-- made active.
+function M.new_context(options)
+	options = options or {}
+	if options.engine ~= nil and options.engine ~= "lua" then
+		error("llay: new_context only supports the lua engine", 2)
+	end
+	local dims = options.dims or options
+	local state = lua_engine.new_context(options.capacity, {
+		width = dims.width or dims[1],
+		height = dims.height or dims[2],
+		elements = options.elements,
+		words = options.words,
+		autosize = options.autosize,
+		evict_after = options.evict_after,
+	})
+	return new_context_object(state)
+end
+
+-- Switching only swaps a handful of references; caches stay warm in each context
+function M.use_context(ctx)
+	if ctx == active_context then
+		return
+	end
+	active_context = ctx
+	core = ctx._engine
+	engine_name = ctx._engine_name
+	shell._set_engine(core)
+	shell._use_render_callbacks(ctx._render_callbacks)
+	shell._use_virtual_lists(ctx._virtual_lists)
+	if ctx._state then
+		lua_engine.use_context(ctx._state)
+	end
+end
+
+-- The active context; the default one is what init() set up
+function M.get_context()
+	return active_context
+end
+
+-- ==================================================================================
+-- Declaration Streams & Worker Threads
+-- ==================================================================================
+
+-- A context that records declarations instead of laying them out; its end_layout()
+-- returns the stream (see llay_stream.lua). options.hover_source (e.g. a worker)
+-- answers pointer_over while recording.
+function M.new_recorder(options)
+	options = options or {}
+	local recorder = require("llay_stream").new_recorder(options.stream)
+	if options.hover_source then
+		recorder.set_hover_source(options.hover_source)
+	end
+	local ctx = new_context_object(nil)
+	ctx._engine = recorder
+	ctx._engine_name = "record"
+	return ctx
+end
+
+-- Lays a recorded stream out in the active context and returns its render commands
+function M.replay(stream)
+	if active_context._engine ~= lua_engine then
+		error("llay: replay needs an active Lua engine context", 2)
+	end
+	return require("llay_stream").replay(stream)
+end
+
+function M.load_stream(path)
+	return require("llay_stream").load_stream(path)
+end
+
+-- Starts a worker thread that lays streams out in its own LuaJIT state; see
+-- llay_worker.lua for the options
+function M.new_worker(options)
+	return require("llay_worker").start(options)
+end
+
+-- "lua" or "native"
+function M.get_engine()
+	return engine_name
+end
+
 M.initialize = M.init
 
 function M.begin_layout()
@@ -27,6 +201,20 @@ function M.end_layout()
 	return core.end_layout()
 end
 
+-- False when running a frame now would reproduce the last one; see docs/API.md
+function M.needs_frame()
+	return core.needs_frame()
+end
+
+-- Hash of the last end_layout()'s render commands
+function M.get_render_fingerprint()
+	return core.get_render_fingerprint()
+end
+
+function M.invalidate()
+	core.invalidate()
+end
+
 function M.set_dimensions(width, height)
 	core.set_dimensions(width, height)
 end
@@ -43,6 +231,22 @@ function M.set_max_element_count(count)
 	core.set_max_element_count(count)
 end
 
+function M.get_arena_sizing()
+	return core.get_arena_sizing()
+end
+
+function M.get_id_map_stats()
+	return core.get_id_map_stats()
+end
+
+function M.set_incremental_layout_enabled(enabled)
+	core.set_incremental_layout_enabled(enabled)
+end
+
+function M.get_layout_memo_reused_count()
+	return core.get_layout_memo_reused_count()
+end
+
 function M.get_element_data(id_variant)
 	local id
 	if type(id_variant) == "string" then
@@ -98,6 +302,49 @@ function M.set_measure_text_function(fn, userData)
 	core.set_measure_text(fn, userData)
 end
 
+function M.set_measure_text_batch_function(fn, userData)
+	core.set_measure_text_batch(fn, userData)
+end
+
+function M.set_glyph_advances(fontId, fontSize, advances, options)
+	core.set_glyph_advances(fontId, fontSize, advances, options)
+end
+
+function M.clear_glyph_advances(fontId)
+	core.clear_glyph_advances(fontId)
+end
+
+-- Measure cache snapshots: save what this run measured, load it before the first
+-- begin_layout() of a later run. tag names the font set; a snapshot saved under
+-- another tag is rejected.
+function M.snapshot_measure_cache(tag)
+	return core.snapshot_measure_cache(tag)
+end
+
+function M.restore_measure_cache(bytes, tag)
+	return core.restore_measure_cache(bytes, tag)
+end
+
+function M.save_measure_cache(path, tag)
+	local bytes = core.snapshot_measure_cache(tag)
+	local file = assert(io.open(path, "wb"))
+	file:write(bytes)
+	file:close()
+	return #bytes
+end
+
+-- Returns the number of entries loaded, or nil and a reason (missing file, not a
+-- snapshot, tag mismatch); either way the cache is usable
+function M.load_measure_cache(path, tag)
+	local file, err = io.open(path, "rb")
+	if not file then
+		return nil, err
+	end
+	local bytes = file:read("*a")
+	file:close()
+	return core.restore_measure_cache(bytes, tag)
+end
+
 function M.set_query_scroll_offset_function(fn, userData)
 	core.set_query_scroll_offset(fn, userData)
 end
@@ -115,6 +362,14 @@ M.Text = shell.Text
 -- Custom element with render callback for framework rendering
 M.Custom = shell.Custom
 
+-- Scrolling list that only declares the items in view
+M.VirtualList = shell.VirtualList
+
+-- Pre-parse a config table once; pass the handle to Element/Text/Custom
+M.compile = shell.compile
+M.style = shell.style
+M.is_compiled = shell.is_compiled
+
 -- ==================================================================================
 -- Constants & Enums
 -- ==================================================================================
@@ -132,12 +387,17 @@ M.FloatingClipToElement = shell.FloatingClipToElement
 -- Interaction API
 -- ==================================================================================
 
+-- Both engines copy the vector out before returning, so one table serves every call
+local _vector = { x = 0, y = 0 }
+
 function M.set_pointer_state(x, y, is_down)
-	core.set_pointer_state({ x = x, y = y }, is_down)
+	_vector.x, _vector.y = x, y
+	core.set_pointer_state(_vector, is_down)
 end
 
 function M.update_scroll_containers(enable_drag, dx, dy, dt)
-	return core.update_scroll_containers(enable_drag, { x = dx, y = dy }, dt)
+	_vector.x, _vector.y = dx, dy
+	return core.update_scroll_containers(enable_drag, _vector, dt)
 end
 
 -- ==================================================================================
@@ -164,6 +424,11 @@ function M.hit_test(x, y)
 	return core.hit_test(x, y)
 end
 
+-- Batch hit paths for many points (multitouch, remote cursors); see docs/API.md
+function M.query_points(points, out)
+	return core.query_points(points, out)
+end
+
 function M.pointer_over(id_string)
 	local id
 	if type(id_string) == "string" then
@@ -215,8 +480,22 @@ M.RenderCommandType = {
 	CUSTOM = 5,
 	SCISSOR_START = 6,
 	SCISSOR_END = 7,
+	LAYER_BEGIN = 8,
+	LAYER_END = 9,
 }
 
+-- Reusable structure-of-arrays view of a frame's render commands, grouped into
+-- draw batches; batches:build(commands) after each end_layout() (see llay_batch.lua)
+function M.new_render_batches(capacity)
+	return require("llay_batch").new(capacity)
+end
+
+-- Headless software renderer: raster:draw(commands) paints a frame into an RGBA
+-- buffer, raster:write_ppm/write_png save it (see llay_raster.lua)
+function M.new_raster(width, height)
+	return require("llay_raster").new(width, height)
+end
+
 function M.get_scroll_offset()
 	return core.get_scroll_offset()
 end
@@ -250,6 +529,20 @@ end
 -- Debug / Internals
 -- ==================================================================================
 
+M.Inspector = core.Inspector
+
+function M.set_profiling_enabled(enabled, historyFrames)
+	core.Inspector.set_profiling(enabled, historyFrames)
+end
+
+function M.get_frame_stats()
+	return core.Inspector.get_frame_stats()
+end
+
+function M.get_frame_stats_history()
+	return core.Inspector.get_stats_history()
+end
+
 M._core = core
 
 return M
@@ -0,0 +1,282 @@
+local ffi = require("ffi")
+local core = require("core")
+require("llay_ffi")
+
+-- Render batches: a frame's render commands regrouped into structure-of-arrays
+-- buffers a backend can upload as instance data, one draw call per batch.
+--
+-- Every drawable command becomes one instance. Instances of a batch are contiguous:
+--   rect[4i..]    x, y, width, height
+--   color[4i..]   r, g, b, a (0-255)
+--   radius[4i..]  topLeft, topRight, bottomLeft, bottomRight
+--   extra[4i..]   BORDER: left, right, top, bottom widths
+--                 TEXT: fontSize, letterSpacing, lineHeight, fontId
+--                 SCISSOR_START: horizontal, vertical
+--                 LAYER_BEGIN/END: dirty (0 or 1), commandCount
+--   chars[i], length[i]   TEXT string (points into the layout arena)
+--   data[i]               IMAGE imageData, CUSTOM customData
+--   command[i]            index of the source render command
+--
+-- A batch holds commands of one kind and key (fontId for TEXT, imageData for
+-- IMAGE). A command joins an earlier batch of its kind only when it overlaps
+-- nothing drawn by the batches it would jump over, so painter's order is kept
+-- wherever it is visible. SCISSOR_START/END, LAYER_BEGIN/END and CUSTOM commands
+-- are batches of their own that nothing moves across.
+--
+-- Everything lives in FFI buffers owned by the Batches object and reused across
+-- frames; chars/data stay valid until the next end_layout().
+
+local M = {}
+
+ffi.cdef([[
+	typedef struct Llay_RenderBatch {
+		int32_t kind;
+		int32_t first;
+		int32_t count;
+		int32_t fontId;
+		void *imageData;
+	} Llay_RenderBatch;
+]])
+
+local CommandType = core.Llay_RenderCommandType
+local RECTANGLE = CommandType.RECTANGLE
+local BORDER = CommandType.BORDER
+local TEXT = CommandType.TEXT
+local IMAGE = CommandType.IMAGE
+local CUSTOM = CommandType.CUSTOM
+local SCISSOR_START = CommandType.SCISSOR_START
+local SCISSOR_END = CommandType.SCISSOR_END
+local LAYER_BEGIN = CommandType.LAYER_BEGIN
+local LAYER_END = CommandType.LAYER_END
+local NONE = CommandType.NONE
+
+-- How many batches back a command may travel to find its kind
+local LOOKBACK = 16
+
+local Batches = {}
+Batches.__index = Batches
+
+local function allocate_instances(self, capacity)
+	self.instanceCapacity = capacity
+	self.rect = ffi.new("float[?]", capacity * 4)
+	self.color = ffi.new("float[?]", capacity * 4)
+	self.radius = ffi.new("float[?]", capacity * 4)
+	self.extra = ffi.new("float[?]", capacity * 4)
+	self.chars = ffi.new("const char*[?]", capacity)
+	self.length = ffi.new("int32_t[?]", capacity)
+	self.data = ffi.new("void*[?]", capacity)
+	self.command = ffi.new("int32_t[?]", capacity)
+	-- Batch of each command, filled by the first pass
+	self._assigned = ffi.new("int32_t[?]", capacity)
+end
+
+local function allocate_batches(self, capacity)
+	local batch = ffi.new("Llay_RenderBatch[?]", capacity)
+	local bounds = ffi.new("float[?]", capacity * 4)
+	local cursor = ffi.new("int32_t[?]", capacity)
+	if self.batch then
+		ffi.copy(batch, self.batch, ffi.sizeof("Llay_RenderBatch") * self.count)
+		ffi.copy(bounds, self._bounds, ffi.sizeof("float") * 4 * self.count)
+	end
+	self.batchCapacity = capacity
+	self.batch = batch
+	self._bounds = bounds
+	self._cursor = cursor
+end
+
+function M.new(capacity)
+	capacity = capacity or 1024
+	local self = setmetatable({ count = 0, instanceCount = 0 }, Batches)
+	allocate_instances(self, capacity)
+	allocate_batches(self, capacity)
+	return self
+end
+
+local function new_batch(self, kind, fontId, imageData, box)
+	local index = self.count
+	if index >= self.batchCapacity then
+		allocate_batches(self, self.batchCapacity * 2)
+	end
+	local batch = self.batch[index]
+	batch.kind = kind
+	batch.first = 0
+	batch.count = 0
+	batch.fontId = fontId
+	batch.imageData = imageData
+	local bounds = self._bounds + index * 4
+	bounds[0] = box.x
+	bounds[1] = box.y
+	bounds[2] = box.x + box.width
+	bounds[3] = box.y + box.height
+	self.count = index + 1
+	return index
+end
+
+local function overlaps(bounds, box)
+	return box.x < bounds[2] and bounds[0] < box.x + box.width and box.y < bounds[3] and bounds[1] < box.y + box.height
+end
+
+local function grow_bounds(bounds, box)
+	if box.x < bounds[0] then
+		bounds[0] = box.x
+	end
+	if box.y < bounds[1] then
+		bounds[1] = box.y
+	end
+	local right, bottom = box.x + box.width, box.y + box.height
+	if right > bounds[2] then
+		bounds[2] = right
+	end
+	if bottom > bounds[3] then
+		bounds[3] = bottom
+	end
+end
+
+-- Regroups commands (the result of end_layout) into this object's buffers
+function Batches:build(commands)
+	local length = tonumber(commands.length)
+	local array = commands.internalArray
+	if length > self.instanceCapacity then
+		local capacity = self.instanceCapacity * 2
+		while capacity < length do
+			capacity = capacity * 2
+		end
+		allocate_instances(self, capacity)
+	end
+
+	-- Pass 1: pick a batch for every command
+	self.count = 0
+	local assigned = self._assigned
+	local barrier = 0
+	for i = 0, length - 1 do
+		local cmd = array[i]
+		local kind = cmd.commandType
+		local box = cmd.boundingBox
+		if kind == NONE then
+			assigned[i] = -1
+		elseif kind == SCISSOR_START or kind == SCISSOR_END or kind == CUSTOM or kind == LAYER_BEGIN or kind == LAYER_END then
+			assigned[i] = new_batch(self, kind, 0, nil, box)
+			barrier = self.count
+		else
+			local fontId = kind == TEXT and cmd.renderData.text.fontId or 0
+			local imageData = kind == IMAGE and cmd.renderData.image.imageData or nil
+			local target = -1
+			local stop = math.max(barrier, self.count - LOOKBACK)
+			for b = self.count - 1, stop, -1 do
+				local batch = self.batch[b]
+				if batch.kind == kind and batch.fontId == fontId and batch.imageData == imageData then
+					target = b
+					break
+				end
+				if overlaps(self._bounds + b * 4, box) then
+					break
+				end
+			end
+			if target < 0 then
+				target = new_batch(self, kind, fontId, imageData, box)
+			else
+				grow_bounds(self._bounds + target * 4, box)
+			end
+			assigned[i] = target
+		end
+	end
+
+	-- Pass 2: lay instances out batch by batch
+	local batch = self.batch
+	for b = 0, self.count - 1 do
+		batch[b].count = 0
+	end
+	for i = 0, length - 1 do
+		local b = assigned[i]
+		if b >= 0 then
+			batch[b].count = batch[b].count + 1
+		end
+	end
+	local cursor = self._cursor
+	local total = 0
+	for b = 0, self.count - 1 do
+		batch[b].first = total
+		cursor[b] = total
+		total = total + batch[b].count
+	end
+	self.instanceCount = total
+
+	local rect, color, radius, extra = self.rect, self.color, self.radius, self.extra
+	for i = 0, length - 1 do
+		local b = assigned[i]
+		if b >= 0 then
+			local slot = cursor[b]
+			cursor[b] = slot + 1
+			local cmd = array[i]
+			local kind = cmd.commandType
+			local box = cmd.boundingBox
+			local o = slot * 4
+			rect[o] = box.x
+			rect[o + 1] = box.y
+			rect[o + 2] = box.width
+			rect[o + 3] = box.height
+			self.command[slot] = i
+			local c, r
+			if kind == RECTANGLE then
+				local data = cmd.renderData.rectangle
+				c, r = data.backgroundColor, data.cornerRadius
+			elseif kind == TEXT then
+				local data = cmd.renderData.text
+				c = data.textColor
+				extra[o] = data.fontSize
+				extra[o + 1] = data.letterSpacing
+				extra[o + 2] = data.lineHeight
+				extra[o + 3] = data.fontId
+				self.chars[slot] = data.stringContents.chars
+				self.length[slot] = data.stringContents.length
+			elseif kind == BORDER then
+				local data = cmd.renderData.border
+				c, r = data.color, data.cornerRadius
+				extra[o] = data.width.left
+				extra[o + 1] = data.width.right
+				extra[o + 2] = data.width.top
+				extra[o + 3] = data.width.bottom
+			elseif kind == IMAGE then
+				local data = cmd.renderData.image
+				c, r = data.backgroundColor, data.cornerRadius
+				self.data[slot] = data.imageData
+			elseif kind == CUSTOM then
+				local data = cmd.renderData.custom
+				c, r = data.backgroundColor, data.cornerRadius
+				self.data[slot] = data.customData
+			elseif kind == SCISSOR_START then
+				extra[o] = cmd.renderData.clip.horizontal and 1 or 0
+				extra[o + 1] = cmd.renderData.clip.vertical and 1 or 0
+			elseif kind == LAYER_BEGIN or kind == LAYER_END then
+				extra[o] = cmd.renderData.layer.dirty and 1 or 0
+				extra[o + 1] = cmd.renderData.layer.commandCount
+			end
+			if c then
+				color[o] = c.r
+				color[o + 1] = c.g
+				color[o + 2] = c.b
+				color[o + 3] = c.a
+			end
+			if r then
+				radius[o] = r.topLeft
+				radius[o + 1] = r.topRight
+				radius[o + 2] = r.bottomLeft
+				radius[o + 3] = r.bottomRight
+			else
+				radius[o] = 0
+				radius[o + 1] = 0
+				radius[o + 2] = 0
+				radius[o + 3] = 0
+			end
+		end
+	end
+	return self
+end
+
+-- String of a TEXT instance (allocates; backends that take pointers should use
+-- chars/length directly)
+function Batches:text(instance)
+	return ffi.string(self.chars[instance], self.length[instance])
+end
+
+return M
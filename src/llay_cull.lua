@@ -0,0 +1,92 @@
+require("llay_ffi")
+
+-- Render pass culling and placement tracking.
+--
+-- The cull rect starts as the viewport and narrows to a clip element's box (on the
+-- axes it clips) while that element's subtree is drawn. Elements outside it emit no
+-- commands, and subtrees that can't overflow back into it are not visited at all.
+--
+-- Every element the render pass visits gets its hash map item's box and is stamped
+-- with the pass generation. Elements in skipped subtrees keep an older box, so
+-- queries only trust a box whose stamp is current.
+--
+-- Every function works on the context passed in, which must be the active one.
+
+local M = {}
+
+local max, min = math.max, math.min
+
+-- Starts a render pass: the whole viewport is visible and nothing is placed yet
+function M.begin_pass(context)
+	context.cullClipStack.length = 0
+	context.placedGeneration = context.generation
+	local rect = context.cullRect
+	rect.left = 0
+	rect.top = 0
+	rect.right = context.layoutDimensions.width
+	rect.bottom = context.layoutDimensions.height
+end
+
+-- Whether a box lies outside the cull rect horizontally and vertically
+function M.offscreen_axes(context, boundingBox)
+	if context.disableCulling then
+		return false, false
+	end
+	local rect = context.cullRect
+	return boundingBox.x > rect.right or boundingBox.x + boundingBox.width < rect.left,
+		boundingBox.y > rect.bottom or boundingBox.y + boundingBox.height < rect.top
+end
+
+-- Narrows the cull rect to a clip element's box until pop_clip for the same node.
+-- Past the stack's capacity the rect just stays wider, which culls less.
+function M.push_clip(context, nodeIndex, boundingBox, clipConfig)
+	local cullClips = context.cullClipStack
+	if context.disableCulling or cullClips.length >= cullClips.capacity then
+		return
+	end
+	local entry = cullClips.internalArray + cullClips.length
+	cullClips.length = cullClips.length + 1
+	entry.nodeIndex = nodeIndex
+	local rect = context.cullRect
+	entry.previous = rect
+	if clipConfig.horizontal then
+		rect.left = max(rect.left, boundingBox.x)
+		rect.right = min(rect.right, boundingBox.x + boundingBox.width)
+	end
+	if clipConfig.vertical then
+		rect.top = max(rect.top, boundingBox.y)
+		rect.bottom = min(rect.bottom, boundingBox.y + boundingBox.height)
+	end
+end
+
+-- Called on the backtrack of every node: restores the cull rect if the node pushed one
+function M.pop_clip(context, nodeIndex)
+	local cullClips = context.cullClipStack
+	if cullClips.length > 0 and cullClips.internalArray[cullClips.length - 1].nodeIndex == nodeIndex then
+		cullClips.length = cullClips.length - 1
+		context.cullRect = cullClips.internalArray[cullClips.length].previous
+	end
+end
+
+-- Records where the render pass put an element
+function M.place(context, item, boundingBox)
+	item.boundingBox = boundingBox
+	item.placedGeneration = context.generation
+end
+
+function M.placed_this_frame(context, item)
+	return item.placedGeneration == context.generation
+end
+
+function M.placed_last_frame(context, item)
+	return item.placedGeneration == context.generation - 1
+end
+
+-- Whether an item's box is current for queries: placed by the last render pass, or
+-- by the one of the frame the element was last declared in
+function M.is_placed(context, item)
+	return item.placedGeneration == context.placedGeneration
+		or item.placedGeneration == item.generation - 1
+end
+
+return M
@@ -115,7 +115,9 @@ if not clay_ffi_defined then
         CLAY_RENDER_COMMAND_TYPE_IMAGE,
         CLAY_RENDER_COMMAND_TYPE_SCISSOR_START,
         CLAY_RENDER_COMMAND_TYPE_SCISSOR_END,
-        CLAY_RENDER_COMMAND_TYPE_CUSTOM
+        CLAY_RENDER_COMMAND_TYPE_CUSTOM,
+        CLAY_RENDER_COMMAND_TYPE_LAYER_BEGIN,
+        CLAY_RENDER_COMMAND_TYPE_LAYER_END
     } Clay_RenderCommandType;
 
     typedef enum {
@@ -235,6 +237,8 @@ if not clay_ffi_defined then
         Clay_Color backgroundColor;
         Clay_CornerRadius cornerRadius;
         void* userData;
+        // llay: wrap the element's commands in LAYER_BEGIN / LAYER_END
+        bool layer;
     } Clay_SharedElementConfig;
 
     typedef struct Clay_ElementDeclaration {
@@ -248,6 +252,7 @@ if not clay_ffi_defined then
         Clay_ClipElementConfig clip;
         Clay_BorderElementConfig border;
         void *userData;
+        bool layer;
     } Clay_ElementDeclaration;
 
     // =========================================================================
@@ -284,6 +289,8 @@ if not clay_ffi_defined then
         Clay_Dimensions preferredDimensions;
         int32_t elementIndex;
         Clay__WrappedTextLineArraySlice wrappedLines;
+        uint32_t measureId;
+        struct Clay__MeasureTextCacheItem *measured;
     } Clay__TextElementData;
 
     typedef struct {
@@ -346,6 +353,15 @@ if not clay_ffi_defined then
         Clay_BorderWidth width;
     } Clay_BorderRenderData;
 
+    // LAYER_BEGIN / LAYER_END: fingerprint of the layer's commands relative to its
+    // origin, how many commands sit between the two, and whether the fingerprint
+    // differs from the one the layer had the last time it was emitted
+    typedef struct Llay_LayerRenderData {
+        int32_t fingerprint;
+        int32_t commandCount;
+        bool dirty;
+    } Llay_LayerRenderData;
+
     typedef union Clay_RenderData {
         Clay_RectangleRenderData rectangle;
         Clay_TextRenderData text;
@@ -353,6 +369,7 @@ if not clay_ffi_defined then
         Clay_CustomRenderData custom;
         Clay_BorderRenderData border;
         Clay_ClipRenderData clip;
+        Llay_LayerRenderData layer;
     } Clay_RenderData;
 
     typedef struct Clay_RenderCommand {
@@ -381,6 +398,9 @@ if not clay_ffi_defined then
         uint32_t elementId;
         bool openThisFrame;
         bool pointerScrollActive;
+        // Llay: generation of the last frame that declared it, which stays current
+        // while the host skips frames (openThisFrame would lapse after one update)
+        uint32_t openGeneration;
     } Clay__ScrollContainerDataInternal;
 
     typedef struct Clay__DebugElementData {
@@ -406,6 +426,10 @@ if not clay_ffi_defined then
         int32_t nextIndex;
         uint32_t generation;
         Clay__DebugElementData *debugData;
+        // Fingerprint the element's layer had when last emitted (0: never)
+        int32_t layerFingerprint;
+        // Frame whose render pass last placed boundingBox; older inside skipped subtrees
+        uint32_t placedGeneration;
     } Clay_LayoutElementHashMapItem;
 
     typedef struct Clay__MeasuredWord {
@@ -419,10 +443,17 @@ if not clay_ffi_defined then
         Clay_Dimensions unwrappedDimensions;
         int32_t measuredWordsStartIndex;
         float minWidth;
+        float spaceWidth;
         bool containsNewlines;
         uint32_t id;
         int32_t nextIndex;
         uint32_t generation;
+        // Llay: lines of the last wrap, kept until the width changes or the item is evicted
+        float wrapWidth;
+        int32_t wrappedLinesStartIndex;
+        int32_t wrappedLineCount;
+        // Llay: length of the measured text, so a restored snapshot's words can be checked
+        int32_t textLength;
     } Clay__MeasureTextCacheItem;
 
     typedef struct Clay__LayoutElementTreeNode {
@@ -520,6 +551,118 @@ if not clay_ffi_defined then
     typedef struct { int32_t capacity; int32_t length; Clay__LayoutElementTreeRoot *internalArray; } Clay__LayoutElementTreeRootArray;
     typedef struct { int32_t capacity; int32_t length; Clay__Warning *internalArray; } Clay__WarningArray;
 
+    // =========================================================================
+    // LLAY EXTENSIONS (not part of clay.h)
+    // =========================================================================
+
+    // One word of a string handed to the batched text measurement callback.
+    // startOffset/length index into the string; the callback fills width/height.
+    typedef struct Llay_MeasureTextWord {
+        int32_t startOffset;
+        int32_t length;
+        float width;
+        float height;
+    } Llay_MeasureTextWord;
+
+    // One cached wrapped line: a span of the text, chained like Clay__MeasuredWord.
+    typedef struct Llay__WrappedLineSpan {
+        int32_t startOffset;
+        int32_t length;
+        float width;
+        int32_t next;
+    } Llay__WrappedLineSpan;
+    typedef struct { int32_t capacity; int32_t length; Llay__WrappedLineSpan *internalArray; } Llay__WrappedLineSpanArray;
+
+    // A layer whose LAYER_END is still to come in the render pass
+    typedef struct Llay__OpenLayer {
+        int32_t nodeIndex;
+        int32_t commandIndex;
+        int32_t outerTextFingerprint;
+    } Llay__OpenLayer;
+    typedef struct { int32_t capacity; int32_t length; Llay__OpenLayer *internalArray; } Llay__OpenLayerArray;
+
+    // Render pass culling bounds: the viewport narrowed by every clip element on the
+    // DFS stack. Each clip saves the bounds it narrowed so its backtrack restores them.
+    typedef struct Llay__CullRect {
+        float left, top, right, bottom;
+    } Llay__CullRect;
+    typedef struct Llay__CullClip {
+        int32_t nodeIndex;
+        Llay__CullRect previous;
+    } Llay__CullClip;
+    typedef struct { int32_t capacity; int32_t length; Llay__CullClip *internalArray; } Llay__CullClipArray;
+
+    // Per-element layout results kept across frames for incremental layout.
+    // Indexed by the element's slot in layoutElementsHashMapInternal.
+    typedef struct Llay__LayoutMemoItem {
+        int32_t contentHash;
+        uint32_t generation;
+        Clay_Dimensions dimensions;
+        float contentHeight;
+        Clay_Vector2 relativePosition;
+    } Llay__LayoutMemoItem;
+
+    typedef struct { int32_t capacity; int32_t length; Llay__LayoutMemoItem *internalArray; } Llay__LayoutMemoItemArray;
+
+    // Config lookup for one element, indexed like layoutElements: a bit
+    // (1 << Llay__ElementConfigType) per attached config, and where the first config
+    // of each type sits in the element's elementConfigs
+    typedef struct Llay__ElementConfigIndex {
+        uint16_t mask;
+        uint8_t slots[9];
+    } Llay__ElementConfigIndex;
+
+    typedef struct { int32_t capacity; int32_t length; Llay__ElementConfigIndex *internalArray; } Llay__ElementConfigIndexArray;
+
+    // Pointer hit-test index built at end_layout, indexed like layoutElements.
+    // subtreeBounds is the union of the element's box and every hittable descendant's.
+    typedef struct Llay__HitTestNode {
+        Clay_BoundingBox subtreeBounds;
+        int32_t hashMapIndex;
+        int32_t flags;
+    } Llay__HitTestNode;
+
+    typedef struct { int32_t capacity; int32_t length; Llay__HitTestNode *internalArray; } Llay__HitTestNodeArray;
+
+    // One frame of profiler output (Inspector.set_profiling). Times are wall-clock
+    // milliseconds; a frame runs from one end_layout to the next, so pointer and
+    // scroll updates issued before begin_layout count toward the frame they precede.
+    typedef struct Llay_FrameStats {
+        uint32_t frame;
+        double declareMs;
+        double sizeXMs;
+        double textWrapMs;
+        double aspectRatioMs;
+        double heightDfsMs;
+        double sizeYMs;
+        double renderCommandsMs;
+        double endLayoutMs;
+        double pointerStateMs;
+        double scrollUpdateMs;
+        int32_t elementCount;
+        int32_t textElementCount;
+        int32_t renderCommandCount;
+        int32_t wrappedLines;
+        int32_t measureCacheHits;
+        int32_t measureCacheMisses;
+        int32_t measureCacheEvictions;
+        int32_t measureTextCalls;
+        int32_t measureCacheOccupancy;
+        int32_t measureCacheCapacity;
+        int32_t hashMapOccupancy;
+        int32_t hashMapCapacity;
+        int32_t hashMapEvictions;
+        int32_t wrapCacheHits;
+        int32_t wrapCacheMisses;
+        int32_t layersDirty;
+        int32_t layersClean;
+        int32_t elementsEmitted;
+        int32_t elementsCulled;
+        int32_t elementsSkipped;
+        double arenaBytesUsed;
+        double arenaCapacity;
+    } Llay_FrameStats;
+
     // =========================================================================
     // CONTEXT (The Memory Blob)
     // =========================================================================
@@ -573,6 +716,10 @@ if not clay_ffi_defined then
         Clay__WrappedTextLineArray wrappedTextLines;
         Clay__LayoutElementTreeNodeArray layoutElementTreeNodeArray1;
         Clay__LayoutElementTreeRootArray layoutElementTreeRoots;
+        // Merge sort scratch for the roots; the sort is skipped unless a root was
+        // declared with a lower zIndex than the root before it
+        Clay__LayoutElementTreeRootArray layoutElementTreeRootsScratch;
+        bool treeRootsUnsorted;
 
         // Hash Maps & Caches
         Clay__LayoutElementHashMapItemArray layoutElementsHashMapInternal;
@@ -589,6 +736,45 @@ if not clay_ffi_defined then
         Clay__boolArray treeNodeVisited;
         Clay__charArray dynamicStringData;
         Clay__DebugElementDataArray debugElementData;
+
+        // Llay extensions
+        bool incrementalLayoutEnabled;
+        int32_t layoutMemoReusedCount;
+        Clay__int32_tArray layoutElementContentHashes;
+        Clay__int32_tArray layoutElementMemoIndexes;
+        Clay__int32_tArray layoutElementMemoFlags;
+        Llay__LayoutMemoItemArray layoutMemo;
+        // Each element's id hash map slot, kept across frames (see Llay__AddHashMapItem)
+        Clay__int32_tArray layoutElementHashMapIndexes;
+        // Element index of each node in layoutElementTreeNodeArray1
+        Clay__int32_tArray treeNodeElementIndexes;
+        Llay__ElementConfigIndexArray layoutElementConfigIndexes;
+        bool hitTestIndexValid;
+        Llay__HitTestNodeArray hitTestNodes;
+        // Id hash map slots freed by eviction, and the sweep that frees them
+        Clay__int32_tArray layoutElementsHashMapFreeList;
+        int32_t hashMapEvictAfter;
+        int32_t hashMapSweepStep;
+        int32_t hashMapSweepCursor;
+        int32_t hashMapSeenCount;
+        uint32_t hashMapEvictionCount;
+        // Wrapped lines cached per measure cache item (see Clay__MeasureTextCacheItem)
+        Llay__WrappedLineSpanArray wrappedLineCache;
+        Clay__int32_tArray wrappedLineCacheFreeList;
+        // Frame skipping: set by anything that can change the next frame's output
+        bool needsFrame;
+        bool renderFingerprintPending;
+        int32_t renderFingerprint;
+        int32_t textFingerprint;
+        int32_t pointerOverHash;
+        // Layers opened by the render pass; invalidate() bumps the epoch so every
+        // layer comes out dirty
+        Llay__OpenLayerArray openLayerStack;
+        uint32_t layerEpoch;
+        Llay__CullRect cullRect;
+        Llay__CullClipArray cullClipStack;
+        // Generation of the last render pass; boxes placed by an older one are stale
+        uint32_t placedGeneration;
     } Clay_Context;
 ]])
 	end)
@@ -0,0 +1,189 @@
+local ffi = require("ffi")
+local core = require("core")
+require("llay_ffi")
+
+-- Measure cache snapshots: every live cache entry as 32-bit words, so a later run can
+-- start with the measurements instead of calling the measure function again.
+--   header  magic, format, tag length, tag chars padded to 4, entry count
+--   entry   u32 id, f32 width, f32 height, f32 minWidth, f32 spaceWidth,
+--           u32 containsNewlines, u32 text length, u32 word count, then per word
+--           i32 startOffset, i32 length, f32 width
+-- Entries are keyed by the text and config hash; the caller's tag (font set
+-- version) must match on load or the snapshot is rejected. Wrapped lines are not
+-- kept: they are rebuilt from the words on first use.
+--
+-- Both functions work on the context passed in, which must be the active one.
+
+local M = {}
+
+local SNAPSHOT_MAGIC = 0x434d4c4c -- "LLMC"
+local SNAPSHOT_FORMAT = 2
+
+-- Chain head for the words of the entry being restored
+local _WORDS_HEAD = ffi.new("Clay__MeasuredWord")
+
+function M.snapshot(context, tag)
+	tag = tostring(tag or "")
+	local map = context.measureTextHashMap
+	local items = context.measureTextHashMapInternal.internalArray
+	local words = context.measuredWords.internalArray
+
+	-- Pass 1: size
+	local entryCount, wordCount = 0, 0
+	for bucket = 0, map.capacity - 1 do
+		local index = map.internalArray[bucket]
+		while index ~= 0 do
+			entryCount = entryCount + 1
+			local wordIndex = items[index].measuredWordsStartIndex
+			while wordIndex ~= -1 do
+				wordCount = wordCount + 1
+				wordIndex = words[wordIndex].next
+			end
+			index = items[index].nextIndex
+		end
+	end
+
+	local tagWords = math.ceil(#tag / 4)
+	local size = 4 + tagWords + 8 * entryCount + 3 * wordCount
+	local buffer = ffi.new("uint32_t[?]", size)
+	local floats = ffi.cast("float*", buffer)
+	buffer[0] = SNAPSHOT_MAGIC
+	buffer[1] = SNAPSHOT_FORMAT
+	buffer[2] = #tag
+	ffi.copy(buffer + 3, tag, #tag)
+	buffer[3 + tagWords] = entryCount
+
+	-- Pass 2: entries
+	local at = 4 + tagWords
+	for bucket = 0, map.capacity - 1 do
+		local index = map.internalArray[bucket]
+		while index ~= 0 do
+			local item = items + index
+			buffer[at] = item.id
+			floats[at + 1] = item.unwrappedDimensions.width
+			floats[at + 2] = item.unwrappedDimensions.height
+			floats[at + 3] = item.minWidth
+			floats[at + 4] = item.spaceWidth
+			buffer[at + 5] = item.containsNewlines and 1 or 0
+			buffer[at + 6] = item.textLength
+			local countAt = at + 7
+			at = at + 8
+			local wordIndex = item.measuredWordsStartIndex
+			while wordIndex ~= -1 do
+				local word = words + wordIndex
+				buffer[at] = word.startOffset
+				buffer[at + 1] = word.length
+				floats[at + 2] = word.width
+				at = at + 3
+				wordIndex = word.next
+			end
+			buffer[countAt] = (at - countAt - 1) / 3
+			index = item.nextIndex
+		end
+	end
+	return ffi.string(buffer, size * 4)
+end
+
+-- Adds a snapshot's entries to the measure cache, skipping texts already cached.
+-- Returns the number of entries added (stopping early once the cache is full), or
+-- nil and a reason when the bytes aren't a snapshot, were taken under another tag or
+-- hold words outside their text.
+function M.restore(context, bytes, tag)
+	tag = tostring(tag or "")
+	local size = math.floor(#bytes / 4)
+	local buffer = ffi.new("uint32_t[?]", size + 1)
+	ffi.copy(buffer, bytes, size * 4)
+	local floats = ffi.cast("float*", buffer)
+	if size < 4 or buffer[0] ~= SNAPSHOT_MAGIC or buffer[1] ~= SNAPSHOT_FORMAT then
+		return nil, "not a measure cache snapshot"
+	end
+	local tagWords = math.ceil(buffer[2] / 4)
+	if 4 + tagWords > size then
+		return nil, "truncated measure cache snapshot"
+	end
+	if ffi.string(buffer + 3, buffer[2]) ~= tag then
+		return nil, "measure cache snapshot tag mismatch"
+	end
+
+	-- Check the whole snapshot before touching the cache
+	local entryCount = buffer[3 + tagWords]
+	local at = 4 + tagWords
+	for _ = 1, entryCount do
+		if at + 8 > size or at + 8 + buffer[at + 7] * 3 > size then
+			return nil, "truncated measure cache snapshot"
+		end
+		local textLength, wordCount = buffer[at + 6], buffer[at + 7]
+		if textLength > 0x7fffffff or wordCount > context.measuredWords.capacity then
+			return nil, "corrupt measure cache snapshot"
+		end
+		-- Offsets are read unsigned, so a negative one fails the bound as well
+		for wordAt = at + 8, at + 5 + wordCount * 3, 3 do
+			if buffer[wordAt] + buffer[wordAt + 1] > textLength then
+				return nil, "corrupt measure cache snapshot"
+			end
+		end
+		at = at + 8 + wordCount * 3
+	end
+
+	local itemArray = context.measureTextHashMapInternal
+	local itemFreeList = context.measureTextHashMapInternalFreeList
+	local wordArray = context.measuredWords
+	local buckets = context.maxMeasureTextCacheWordCount / 32
+	local added = 0
+	at = 4 + tagWords
+	for _ = 1, entryCount do
+		local id = buffer[at]
+		local wordCount = buffer[at + 7]
+		local bucket = id % buckets
+
+		local cached = false
+		local index = context.measureTextHashMap.internalArray[bucket]
+		while index ~= 0 do
+			if itemArray.internalArray[index].id == id then
+				cached = true
+				break
+			end
+			index = itemArray.internalArray[index].nextIndex
+		end
+
+		if not cached then
+			if (itemFreeList.length == 0 and itemArray.length >= itemArray.capacity)
+				or wordArray.capacity - wordArray.length + context.measuredWordsFreeList.length < wordCount then
+				break
+			end
+			local newItemIndex
+			if itemFreeList.length > 0 then
+				newItemIndex = core.int32_array_remove_swapback(itemFreeList, itemFreeList.length - 1)
+			else
+				newItemIndex = itemArray.length
+				itemArray.length = itemArray.length + 1
+			end
+			local measured = itemArray.internalArray + newItemIndex
+			measured.unwrappedDimensions.width = floats[at + 1]
+			measured.unwrappedDimensions.height = floats[at + 2]
+			measured.minWidth = floats[at + 3]
+			measured.spaceWidth = floats[at + 4]
+			measured.containsNewlines = buffer[at + 5] ~= 0
+			measured.wrappedLinesStartIndex = -1
+			measured.wrappedLineCount = 0
+			measured.textLength = buffer[at + 6]
+			measured.id = id
+			measured.generation = context.generation
+			measured.nextIndex = context.measureTextHashMap.internalArray[bucket]
+			context.measureTextHashMap.internalArray[bucket] = newItemIndex
+
+			local previousWord = _WORDS_HEAD
+			previousWord.next = -1
+			for w = 0, wordCount - 1 do
+				local wordAt = at + 8 + w * 3
+				previousWord = core.Llay__AddMeasuredWordValues(buffer[wordAt], buffer[wordAt + 1], floats[wordAt + 2], previousWord)
+			end
+			measured.measuredWordsStartIndex = _WORDS_HEAD.next
+			added = added + 1
+		end
+		at = at + 8 + wordCount * 3
+	end
+	return added
+end
+
+return M
@@ -0,0 +1,642 @@
+local ffi = require("ffi")
+local core = require("core")
+require("llay_ffi")
+
+-- Native engine: the same surface init.lua and shell.lua call on core, forwarded to
+-- a compiled Clay (libclay_ref.so) over FFI.
+--
+-- clay.h declares its enums packed (one byte) and orders Clay_String differently, so
+-- the structs that carry them are mirrored here as Llay__Native* and converted at the
+-- boundary: declarations and text configs on the way in, render commands on the way
+-- out. Structs without enums or strings are shared with llay_ffi.
+--
+-- Selected with llay.init({ engine = "native" }).
+
+local M = {}
+
+if not package.loaded["llay_native_ffi_loaded"] then
+	pcall(function()
+		ffi.cdef([[
+    typedef struct Llay__NativeString {
+        bool isStaticallyAllocated;
+        int32_t length;
+        const char *chars;
+    } Llay__NativeString;
+
+    typedef struct Llay__NativeElementId {
+        uint32_t id;
+        uint32_t offset;
+        uint32_t baseId;
+        Llay__NativeString stringId;
+    } Llay__NativeElementId;
+
+    typedef struct { int32_t capacity; int32_t length; Llay__NativeElementId *internalArray; } Llay__NativeElementIdArray;
+
+    typedef struct Llay__NativeSizingAxis {
+        union {
+            Clay_SizingMinMax minMax;
+            float percent;
+        } size;
+        uint8_t type;
+    } Llay__NativeSizingAxis;
+
+    typedef struct Llay__NativeLayoutConfig {
+        Llay__NativeSizingAxis width;
+        Llay__NativeSizingAxis height;
+        Clay_Padding padding;
+        uint16_t childGap;
+        uint8_t childAlignmentX;
+        uint8_t childAlignmentY;
+        uint8_t layoutDirection;
+    } Llay__NativeLayoutConfig;
+
+    typedef struct Llay__NativeTextElementConfig {
+        void *userData;
+        Clay_Color textColor;
+        uint16_t fontId;
+        uint16_t fontSize;
+        uint16_t letterSpacing;
+        uint16_t lineHeight;
+        uint8_t wrapMode;
+        uint8_t textAlignment;
+    } Llay__NativeTextElementConfig;
+
+    typedef struct Llay__NativeFloatingElementConfig {
+        Clay_Vector2 offset;
+        Clay_Dimensions expand;
+        uint32_t parentId;
+        int16_t zIndex;
+        uint8_t attachPointElement;
+        uint8_t attachPointParent;
+        uint8_t pointerCaptureMode;
+        uint8_t attachTo;
+        uint8_t clipTo;
+    } Llay__NativeFloatingElementConfig;
+
+    typedef struct Llay__NativeElementDeclaration {
+        Llay__NativeLayoutConfig layout;
+        Clay_Color backgroundColor;
+        Clay_CornerRadius cornerRadius;
+        Clay_AspectRatioElementConfig aspectRatio;
+        Clay_ImageElementConfig image;
+        Llay__NativeFloatingElementConfig floating;
+        Clay_CustomElementConfig custom;
+        Clay_ClipElementConfig clip;
+        Clay_BorderElementConfig border;
+        void *userData;
+    } Llay__NativeElementDeclaration;
+
+    typedef struct Llay__NativeRenderCommand {
+        Clay_BoundingBox boundingBox;
+        Clay_RenderData renderData;
+        void *userData;
+        uint32_t id;
+        int16_t zIndex;
+        uint8_t commandType;
+    } Llay__NativeRenderCommand;
+
+    typedef struct { int32_t capacity; int32_t length; Llay__NativeRenderCommand *internalArray; } Llay__NativeRenderCommandArray;
+
+    typedef struct Llay__NativeElementData {
+        Clay_BoundingBox boundingBox;
+        bool found;
+    } Llay__NativeElementData;
+
+    typedef struct Llay__NativeScrollContainerData {
+        Clay_Vector2 *scrollPosition;
+        Clay_Dimensions scrollContainerDimensions;
+        Clay_Dimensions contentDimensions;
+        Clay_ClipElementConfig config;
+        bool found;
+    } Llay__NativeScrollContainerData;
+
+    typedef struct Llay__NativeErrorHandler {
+        void *errorHandlerFunction;
+        void *userData;
+    } Llay__NativeErrorHandler;
+
+    typedef void (*Llay__NativeMeasureFn)(const char *chars, int32_t length, Llay__NativeTextElementConfig *config, void *userData, Clay_Dimensions *out);
+    typedef Clay_Dimensions (*Llay__NativeClayMeasureFn)(Clay_StringSlice text, Llay__NativeTextElementConfig *config, void *userData);
+
+    uint32_t Clay_MinMemorySize(void);
+    Clay_Arena Clay_CreateArenaWithCapacityAndMemory(size_t capacity, void *memory);
+    void *Clay_Initialize(Clay_Arena arena, Clay_Dimensions layoutDimensions, Llay__NativeErrorHandler errorHandler);
+    void Clay_SetLayoutDimensions(Clay_Dimensions dimensions);
+    void Clay_SetPointerState(Clay_Vector2 position, bool pointerDown);
+    void Clay_UpdateScrollContainers(bool enableDragScrolling, Clay_Vector2 scrollDelta, float deltaTime);
+    void Clay_SetMeasureTextFunction(Llay__NativeClayMeasureFn measureTextFunction, void *userData);
+    void Clay_BeginLayout(void);
+    Llay__NativeRenderCommandArray Clay_EndLayout(void);
+    Llay__NativeElementData Clay_GetElementData(Llay__NativeElementId id);
+    bool Clay_Hovered(void);
+    bool Clay_PointerOver(Llay__NativeElementId elementId);
+    Llay__NativeElementIdArray Clay_GetPointerOverIds(void);
+    Llay__NativeScrollContainerData Clay_GetScrollContainerData(Llay__NativeElementId id);
+    Clay_Vector2 Clay_GetScrollOffset(void);
+    void Clay_SetCullingEnabled(bool enabled);
+    void Clay_SetDebugModeEnabled(bool enabled);
+    void Clay_SetMaxElementCount(int32_t maxElementCount);
+    void Clay__OpenElement(void);
+    void Clay__OpenElementWithId(Llay__NativeElementId elementId);
+    void Clay__ConfigureOpenElementPtr(const Llay__NativeElementDeclaration *config);
+    void Clay__CloseElement(void);
+    Llay__NativeTextElementConfig *Clay__StoreTextElementConfig(Llay__NativeTextElementConfig config);
+    void Clay__OpenTextElement(Llay__NativeString text, Llay__NativeTextElementConfig *textConfig);
+    uint32_t Clay__GetParentElementId(void);
+
+    void Llay_NativeSetMeasureText(Llay__NativeMeasureFn fn);
+    Clay_Dimensions Llay_NativeMeasureText(Clay_StringSlice text, Llay__NativeTextElementConfig *config, void *userData);
+]])
+	end)
+	package.loaded["llay_native_ffi_loaded"] = true
+end
+
+-- ==================================================================================
+-- Library Loading
+-- ==================================================================================
+
+local DEFAULT_LIBRARIES = { "tests/clay_ref/libclay_ref.so", "clay_ref" }
+local DEFAULT_SHIMS = { "tests/clay_ref/libllay_native.so", "llay_native" }
+
+local clay = nil
+local shim = nil
+
+local function load_first(candidates)
+	local errors = {}
+	for _, name in ipairs(candidates) do
+		local ok, lib = pcall(ffi.load, name)
+		if ok then
+			return lib
+		end
+		errors[#errors + 1] = tostring(lib)
+	end
+	return nil, table.concat(errors, "; ")
+end
+
+local function candidates(explicit, env, defaults)
+	if explicit then
+		return { explicit }
+	end
+	local list = {}
+	if os.getenv(env) then
+		list[1] = os.getenv(env)
+	end
+	for _, name in ipairs(defaults) do
+		list[#list + 1] = name
+	end
+	return list
+end
+
+-- options.library / options.shim (or LLAY_CLAY_LIB / LLAY_NATIVE_SHIM) override the
+-- search paths. Returns the engine, or nil and a message when the libraries are missing.
+function M.load(options)
+	options = options or {}
+	if clay == nil then
+		local lib, err = load_first(candidates(options.library, "LLAY_CLAY_LIB", DEFAULT_LIBRARIES))
+		if not lib then
+			return nil, "llay: native engine needs libclay_ref.so (make native): " .. err
+		end
+		local shimLib, shimErr = load_first(candidates(options.shim, "LLAY_NATIVE_SHIM", DEFAULT_SHIMS))
+		if not shimLib then
+			return nil, "llay: native engine needs libllay_native.so (make native): " .. shimErr
+		end
+		clay, shim = lib, shimLib
+	end
+	return M
+end
+
+-- ==================================================================================
+-- Engine State
+-- ==================================================================================
+
+local _ANCHORS = {}
+local _frameStrings = {}
+local _frameStringCount = 0
+local _scratchId = ffi.new("Llay__NativeElementId")
+local _scratchString = ffi.new("Llay__NativeString")
+local _scratchVector = ffi.new("Clay_Vector2")
+local _scratchDimensions = ffi.new("Clay_Dimensions")
+local _noErrorHandler = ffi.new("Llay__NativeErrorHandler")
+local _nativeDeclaration = ffi.new("Llay__NativeElementDeclaration")
+local _nativeTextConfig = ffi.new("Llay__NativeTextElementConfig")
+local _measureTextConfig = ffi.new("Clay_TextElementConfig")
+local _commands = ffi.new("Clay_RenderCommandArray")
+local RENDER_DATA_SIZE = ffi.sizeof("Clay_RenderData")
+
+local measure_text_fn = nil
+local measure_text_user_data = nil
+local query_scroll_offset_fn = nil
+
+-- Created once; C calls it for every word Clay measures
+local _measureCallback = ffi.cast("Llay__NativeMeasureFn", function(chars, length, config, userData, out)
+	if measure_text_fn == nil then
+		return
+	end
+	local cfg = _measureTextConfig
+	cfg.userData = config.userData
+	cfg.textColor = config.textColor
+	cfg.fontId = config.fontId
+	cfg.fontSize = config.fontSize
+	cfg.letterSpacing = config.letterSpacing
+	cfg.lineHeight = config.lineHeight
+	cfg.wrapMode = config.wrapMode
+	cfg.textAlignment = config.textAlignment
+	local dims = measure_text_fn(ffi.string(chars, length), cfg, measure_text_user_data)
+	out.width = dims.width
+	out.height = dims.height
+end)
+
+-- llay orders alignment START, CENTER, END; clay.h orders it START, END, CENTER
+local LLAY_TO_NATIVE_ALIGN = { [0] = 0, 2, 1 }
+
+-- clay.h orders SCISSOR_START, SCISSOR_END, CUSTOM after IMAGE; llay puts CUSTOM first
+local NATIVE_TO_LLAY_COMMAND_TYPE = { [0] = 0, 1, 2, 3, 4, 6, 7, 5 }
+
+local function unsupported(name)
+	return function()
+		error("llay: " .. name .. " is not available with engine = \"native\"", 2)
+	end
+end
+
+local function to_native_id(elementId)
+	local id = _scratchId
+	local stringId = elementId.stringId
+	id.id = elementId.id
+	id.offset = elementId.offset or 0
+	id.baseId = elementId.baseId or elementId.id
+	id.stringId.isStaticallyAllocated = true
+	id.stringId.length = stringId and stringId.length or 0
+	id.stringId.chars = stringId and stringId.chars or nil
+	return id
+end
+
+local function native_id_for(id)
+	_scratchId.id = id
+	_scratchId.offset = 0
+	_scratchId.baseId = id
+	_scratchId.stringId.length = 0
+	_scratchId.stringId.chars = nil
+	return _scratchId
+end
+
+local function to_native_axis(dst, src)
+	dst.size.minMax.min = src.size.minMax.min
+	dst.size.minMax.max = src.size.minMax.max
+	dst.type = src.type
+end
+
+local function to_native_declaration(d)
+	local n = _nativeDeclaration
+	local layout, nativeLayout = d.layout, n.layout
+	to_native_axis(nativeLayout.width, layout.sizing.width)
+	to_native_axis(nativeLayout.height, layout.sizing.height)
+	nativeLayout.padding = layout.padding
+	nativeLayout.childGap = layout.childGap
+	nativeLayout.childAlignmentX = LLAY_TO_NATIVE_ALIGN[tonumber(layout.childAlignment.x)]
+	nativeLayout.childAlignmentY = LLAY_TO_NATIVE_ALIGN[tonumber(layout.childAlignment.y)]
+	nativeLayout.layoutDirection = layout.layoutDirection
+	n.backgroundColor = d.backgroundColor
+	n.cornerRadius = d.cornerRadius
+	n.aspectRatio = d.aspectRatio
+	n.image = d.image
+	local floating, nativeFloating = d.floating, n.floating
+	nativeFloating.offset = floating.offset
+	nativeFloating.expand = floating.expand
+	nativeFloating.parentId = floating.parentId
+	nativeFloating.zIndex = floating.zIndex
+	nativeFloating.attachPointElement = floating.attachPoints.element
+	nativeFloating.attachPointParent = floating.attachPoints.parent
+	nativeFloating.pointerCaptureMode = floating.pointerCaptureMode
+	nativeFloating.attachTo = floating.attachTo
+	nativeFloating.clipTo = floating.clipTo
+	n.custom = d.custom
+	n.clip = d.clip
+	n.border = d.border
+	n.userData = d.userData
+	return n
+end
+
+local function to_native_text_config(c)
+	local n = _nativeTextConfig
+	n.userData = c.userData
+	n.textColor = c.textColor
+	n.fontId = c.fontId
+	n.fontSize = c.fontSize
+	n.letterSpacing = c.letterSpacing
+	n.lineHeight = c.lineHeight
+	n.wrapMode = c.wrapMode
+	n.textAlignment = c.textAlignment
+	return n
+end
+
+-- Copies Clay's commands into a llay-layout array that is reused across frames
+local function to_llay_commands(native)
+	local count = native.length
+	if _commands.capacity < count then
+		local capacity = math.max(count, _commands.capacity * 2, 256)
+		_ANCHORS.commands = ffi.new("Clay_RenderCommand[?]", capacity)
+		_commands.internalArray = _ANCHORS.commands
+		_commands.capacity = capacity
+	end
+	local src, dst = native.internalArray, _commands.internalArray
+	for i = 0, count - 1 do
+		local from, to = src[i], dst[i]
+		to.boundingBox = from.boundingBox
+		ffi.copy(to.renderData, from.renderData, RENDER_DATA_SIZE)
+		to.userData = from.userData
+		to.id = from.id
+		to.zIndex = from.zIndex
+		to.commandType = NATIVE_TO_LLAY_COMMAND_TYPE[from.commandType]
+	end
+	_commands.length = count
+	return _commands
+end
+
+-- Accepts the same id variants as core: cdata/table with .id, a string or a number
+local function resolve_id(element_id)
+	if type(element_id) == "table" or type(element_id) == "cdata" then
+		return element_id.id
+	elseif type(element_id) == "string" then
+		return core.Llay__GetElementId(element_id).id
+	end
+	return element_id
+end
+
+-- ==================================================================================
+-- Lifecycle
+-- ==================================================================================
+
+function M.initialize(capacity, dims)
+	capacity = math.max(capacity or (1024 * 1024 * 16), tonumber(clay.Clay_MinMemorySize()))
+
+	_ANCHORS.arena_memory = ffi.new("uint8_t[?]", capacity)
+	local arena = clay.Clay_CreateArenaWithCapacityAndMemory(capacity, _ANCHORS.arena_memory)
+	_scratchDimensions.width = dims and dims.width or 800
+	_scratchDimensions.height = dims and dims.height or 600
+	local context = clay.Clay_Initialize(arena, _scratchDimensions, _noErrorHandler)
+
+	shim.Llay_NativeSetMeasureText(_measureCallback)
+	clay.Clay_SetMeasureTextFunction(ffi.cast("Llay__NativeClayMeasureFn", shim.Llay_NativeMeasureText), nil)
+	return context
+end
+
+function M.begin_layout()
+	-- Text render commands point into these strings until the next frame starts
+	for i = 1, _frameStringCount do
+		_frameStrings[i] = nil
+	end
+	_frameStringCount = 0
+	clay.Clay_BeginLayout()
+end
+
+function M.end_layout()
+	return to_llay_commands(clay.Clay_EndLayout())
+end
+
+function M.set_dimensions(w, h)
+	_scratchDimensions.width = w
+	_scratchDimensions.height = h
+	clay.Clay_SetLayoutDimensions(_scratchDimensions)
+end
+
+function M.get_layout_dimensions()
+	return _scratchDimensions.width, _scratchDimensions.height
+end
+
+function M.set_max_element_count(count)
+	clay.Clay_SetMaxElementCount(count)
+end
+
+function M.set_culling_enabled(enabled)
+	clay.Clay_SetCullingEnabled(enabled and true or false)
+end
+
+function M.set_debug_mode_enabled(enabled)
+	clay.Clay_SetDebugModeEnabled(enabled and true or false)
+end
+
+function M.set_measure_text(fn, userData)
+	measure_text_fn = fn
+	measure_text_user_data = userData
+end
+
+function M.set_query_scroll_offset(fn, userData)
+	query_scroll_offset_fn = fn
+end
+
+-- ==================================================================================
+-- Declarations
+-- ==================================================================================
+
+function M.open_element()
+	clay.Clay__OpenElement()
+end
+
+function M.open_element_with_id(elementId)
+	clay.Clay__OpenElementWithId(to_native_id(elementId))
+end
+
+function M.configure_open_element(declaration)
+	clay.Clay__ConfigureOpenElementPtr(to_native_declaration(declaration))
+end
+
+function M.close_element()
+	clay.Clay__CloseElement()
+end
+
+function M.open_text_element(text, textConfig, length)
+	_frameStringCount = _frameStringCount + 1
+	_frameStrings[_frameStringCount] = text
+	if length == nil and type(text) == "cdata" then
+		text, length = text.chars, text.length
+	end
+	local str = _scratchString
+	str.isStaticallyAllocated = false
+	str.length = length or #text
+	str.chars = text
+	clay.Clay__OpenTextElement(str, clay.Clay__StoreTextElementConfig(to_native_text_config(textConfig)))
+end
+
+function M.get_parent_element_id()
+	return clay.Clay__GetParentElementId()
+end
+
+-- ==================================================================================
+-- Interaction & Scrolling
+-- ==================================================================================
+
+function M.set_pointer_state(position, isPointerDown)
+	_scratchVector.x = position.x
+	_scratchVector.y = position.y
+	clay.Clay_SetPointerState(_scratchVector, isPointerDown and true or false)
+end
+
+function M.update_scroll_containers(enableDragScrolling, scrollDelta, deltaTime)
+	_scratchVector.x = scrollDelta.x or 0
+	_scratchVector.y = scrollDelta.y or 0
+	clay.Clay_UpdateScrollContainers(enableDragScrolling and true or false, _scratchVector, deltaTime or 0)
+	return true
+end
+
+function M.pointer_over(id)
+	return clay.Clay_PointerOver(native_id_for(id))
+end
+
+function M.hovered()
+	return clay.Clay_Hovered()
+end
+
+-- Clay appends parents before children and roots in z order, so the front is last;
+-- llay reports front to back.
+function M.get_all_hovered_ids()
+	local ids = clay.Clay_GetPointerOverIds()
+	local result = {}
+	for i = 0, ids.length - 1 do
+		result[ids.length - i] = ids.internalArray[i].id
+	end
+	return result
+end
+
+function M.hit_test(x, y)
+	if x and y then
+		error("llay: hit_test(x, y) is not available with engine = \"native\"; use set_pointer_state", 2)
+	end
+	local ids = clay.Clay_GetPointerOverIds()
+	if ids.length == 0 then
+		return nil
+	end
+	return ids.internalArray[ids.length - 1].id
+end
+
+function M.get_hit_path(x, y)
+	if x and y then
+		error("llay: get_hit_path(x, y) is not available with engine = \"native\"; use set_pointer_state", 2)
+	end
+	return M.get_all_hovered_ids()
+end
+
+function M.get_element_data(id)
+	local data = clay.Clay_GetElementData(native_id_for(id))
+	local bb = data.boundingBox
+	return {
+		found = data.found,
+		boundingBox = { x = bb.x, y = bb.y, width = bb.width, height = bb.height },
+	}
+end
+
+function M.get_scroll_offset()
+	if query_scroll_offset_fn then
+		return query_scroll_offset_fn()
+	end
+	local offset = clay.Clay_GetScrollOffset()
+	return { x = offset.x, y = offset.y }
+end
+
+local function scroll_data_for(element_id)
+	local id = element_id and resolve_id(element_id)
+	if not id or id == 0 then
+		return nil, id
+	end
+	local data = clay.Clay_GetScrollContainerData(native_id_for(id))
+	if not data.found then
+		return nil, id
+	end
+	return data, id
+end
+
+function M.get_scroll_offset_for(element_id)
+	local data = scroll_data_for(element_id)
+	if not data then
+		return { x = 0, y = 0 }
+	end
+	return { x = data.scrollPosition.x, y = data.scrollPosition.y }
+end
+
+function M.get_scroll_info_for(element_id)
+	local data, id = scroll_data_for(element_id)
+	if not data then
+		return { found = false }
+	end
+	local bb = clay.Clay_GetElementData(native_id_for(id)).boundingBox
+	return {
+		found = true,
+		id = id,
+		boundingBox = { x = bb.x, y = bb.y, width = bb.width, height = bb.height },
+		viewport = {
+			width = data.scrollContainerDimensions.width,
+			height = data.scrollContainerDimensions.height,
+		},
+		contentSize = {
+			width = data.contentDimensions.width,
+			height = data.contentDimensions.height,
+		},
+		scrollPosition = { x = data.scrollPosition.x, y = data.scrollPosition.y },
+		-- clay.h keeps momentum private
+		scrollMomentum = { x = 0, y = 0 },
+		clip = { horizontal = data.config.horizontal, vertical = data.config.vertical },
+	}
+end
+
+function M.set_scroll_offset_for(element_id, x, y)
+	local data = scroll_data_for(element_id)
+	if not data then
+		return { x = 0, y = 0 }
+	end
+	local nx = data.config.horizontal and (x or data.scrollPosition.x) or 0
+	local ny = data.config.vertical and (y or data.scrollPosition.y) or 0
+	local maxScrollX = -math.max(data.contentDimensions.width - data.scrollContainerDimensions.width, 0)
+	local maxScrollY = -math.max(data.contentDimensions.height - data.scrollContainerDimensions.height, 0)
+	nx = math.max(math.min(nx, 0), maxScrollX)
+	ny = math.max(math.min(ny, 0), maxScrollY)
+	data.scrollPosition.x = nx
+	data.scrollPosition.y = ny
+	return { x = nx, y = ny }
+end
+
+-- Clay sorts roots inside Clay_EndLayout
+function M.sort_roots_by_z() end
+
+-- ==================================================================================
+-- Shared With The Lua Engine
+-- ==================================================================================
+
+-- Hashing is pure and matches clay.h, so ids come from the same interned cache
+M.Llay__GetElementId = core.Llay__GetElementId
+M.Llay__GetElementIdWithIndex = core.Llay__GetElementIdWithIndex
+M.Llay__HashStringWithOffset = core.Llay__HashStringWithOffset
+M.Llay__HashNumber = core.Llay__HashNumber
+M.Inspector = core.Inspector
+
+function M.set_incremental_layout_enabled(enabled)
+	if enabled then
+		error("llay: incremental layout is not available with engine = \"native\"", 2)
+	end
+end
+
+function M.get_layout_memo_reused_count()
+	return 0
+end
+
+-- Clay doesn't report what changed, so every frame is needed
+function M.needs_frame()
+	return true
+end
+
+function M.invalidate() end
+
+M.set_measure_text_batch = unsupported("set_measure_text_batch_function")
+M.set_glyph_advances = unsupported("set_glyph_advances")
+M.clear_glyph_advances = unsupported("clear_glyph_advances")
+M.snapshot_measure_cache = unsupported("snapshot_measure_cache")
+M.restore_measure_cache = unsupported("restore_measure_cache")
+M.query_points = unsupported("query_points")
+M.get_id_map_stats = unsupported("get_id_map_stats")
+M.get_render_fingerprint = unsupported("get_render_fingerprint")
+M.capture = unsupported("capture")
+M.release_capture = unsupported("release_capture")
+M.get_capture = unsupported("get_capture")
+M.is_captured = unsupported("is_captured")
+M._get_open_element = unsupported("on_hover")
+M._get_hash_map_item = unsupported("on_hover")
+
+return M
@@ -0,0 +1,518 @@
+local ffi = require("ffi")
+local bit = require("bit")
+local core = require("core")
+local shell = require("shell")
+require("llay_ffi")
+
+-- Software rasterizer: draws a frame's render commands into an RGBA buffer with no
+-- window or GPU, for headless frame benchmarks and pixel goldens.
+--
+-- Shapes are filled span by span: a pixel is covered when its center is inside the
+-- shape, so output is exact and repeatable (no anti-aliasing). Colors blend
+-- source-over.
+--   RECTANGLE      rounded rect, one radius per corner
+--   BORDER         outer rounded rect minus the inner one
+--   TEXT           built-in 5x7 bitmap font in an 8 px cell, scaled by fontSize / 8
+--   IMAGE          placeholder: the tint color, or grey when it has no alpha
+--   CUSTOM         llay.get_render_callback(id)(rect, painter, cmd); the painter
+--                  offers rect(r, color, radius) and circle(center, radius, color)
+--   SCISSOR_START  intersects the clip with the command's box until SCISSOR_END
+--   LAYER_*        ignored: a layer's commands are drawn in place
+--
+-- pixels holds width * height pixels of r, g, b, a bytes, row by row. Text is only
+-- laid out right when measured with the same font: use raster.measure_text, or
+-- set_glyph_advances(fontId, nil, raster.glyph_advances, { baseSize = 8 }).
+
+local M = {}
+
+local CommandType = core.Llay_RenderCommandType
+local RECTANGLE = CommandType.RECTANGLE
+local BORDER = CommandType.BORDER
+local TEXT = CommandType.TEXT
+local IMAGE = CommandType.IMAGE
+local CUSTOM = CommandType.CUSTOM
+local SCISSOR_START = CommandType.SCISSOR_START
+local SCISSOR_END = CommandType.SCISSOR_END
+
+local floor, ceil, sqrt = math.floor, math.ceil, math.sqrt
+local max, min = math.max, math.min
+
+-- ==================================================================================
+-- Bitmap Font
+-- ==================================================================================
+-- ASCII 32..126, five column bytes per glyph, bit 0 at the top. Glyphs advance six
+-- columns of the eight-row cell; bytes of a UTF-8 sequence past the first don't
+-- advance, and non-ASCII characters draw as a box.
+
+local FONT_CELL = 8
+local FONT_ADVANCE = 6
+local FONT_HEX = "0000000000" .. "00005f0000" .. "0007000700" .. "147f147f14" .. "242a7f2a12"
+	.. "2313086462" .. "3649562050" .. "0008070300" .. "001c224100" .. "0041221c00"
+	.. "2a1c7f1c2a" .. "08083e0808" .. "0080703000" .. "0808080808" .. "0000606000"
+	.. "2010080402" .. "3e5149453e" .. "00427f4000" .. "7249494946" .. "2141494d33"
+	.. "1814127f10" .. "2745454539" .. "3c4a494931" .. "4121110907" .. "3649494936"
+	.. "464949291e" .. "0000140000" .. "0040340000" .. "0008142241" .. "1414141414"
+	.. "0041221408" .. "0201590906" .. "3e415d594e" .. "7c1211127c" .. "7f49494936"
+	.. "3e41414122" .. "7f4141413e" .. "7f49494941" .. "7f09090901" .. "3e41415173"
+	.. "7f0808087f" .. "00417f4100" .. "2040413f01" .. "7f08142241" .. "7f40404040"
+	.. "7f021c027f" .. "7f0408107f" .. "3e4141413e" .. "7f09090906" .. "3e4151215e"
+	.. "7f09192946" .. "2649494932" .. "03017f0103" .. "3f4040403f" .. "1f2040201f"
+	.. "3f4038403f" .. "6314081463" .. "0304780403" .. "6159494d43" .. "007f414141"
+	.. "0204081020" .. "004141417f" .. "0402010204" .. "4040404040" .. "0003070800"
+	.. "2054547840" .. "7f28444438" .. "3844444428" .. "384444287f" .. "3854545418"
+	.. "00087e0902" .. "18a4a49c78" .. "7f08040478" .. "00447d4000" .. "2040403d00"
+	.. "7f10284400" .. "00417f4000" .. "7c04780478" .. "7c08040478" .. "3844444438"
+	.. "fc18242418" .. "18242418fc" .. "7c08040408" .. "4854545424" .. "04043f4424"
+	.. "3c4040207c" .. "1c2040201c" .. "3c4030403c" .. "4428102844" .. "4c9090907c"
+	.. "4464544c44" .. "0008364100" .. "0000770000" .. "0041360800" .. "0201020402"
+
+-- Column bytes per byte value; 0x7f..0xbf (DEL and UTF-8 continuation bytes) stay
+-- empty, 0xc0 and up get the box
+local GLYPHS = ffi.new("uint8_t[256][5]")
+for c = 32, 126 do
+	for col = 0, 4 do
+		local at = (c - 32) * 10 + col * 2 + 1
+		GLYPHS[c][col] = tonumber(FONT_HEX:sub(at, at + 1), 16)
+	end
+end
+for c = 0xc0, 0xff do
+	GLYPHS[c][0], GLYPHS[c][1], GLYPHS[c][2], GLYPHS[c][3], GLYPHS[c][4] = 0x7f, 0x41, 0x41, 0x41, 0x7f
+end
+
+-- Advance per byte at baseSize 8, for set_glyph_advances
+local GLYPH_ADVANCES = ffi.new("float[256]")
+for c = 0, 255 do
+	if (c >= 32 and c < 127) or c >= 0xc0 then
+		GLYPH_ADVANCES[c] = FONT_ADVANCE
+	end
+end
+
+-- A measure function (set_measure_text_function) matching what TEXT draws
+local function measure_text(text, config)
+	local scale = config.fontSize / FONT_CELL
+	local width = 0
+	for i = 1, #text do
+		local advance = GLYPH_ADVANCES[text:byte(i)]
+		if advance > 0 then
+			width = width + advance * scale + config.letterSpacing
+		end
+	end
+	return { width = width, height = config.fontSize }
+end
+
+-- ==================================================================================
+-- Raster
+-- ==================================================================================
+
+local Raster = {}
+Raster.__index = Raster
+Raster.measure_text = measure_text
+Raster.glyph_advances = GLYPH_ADVANCES
+
+-- A pixel's four bytes as one word, whatever the byte order
+local _pack = ffi.new("uint8_t[4]")
+local _packWord = ffi.cast("uint32_t*", _pack)
+local function pack(r, g, b, a)
+	_pack[0], _pack[1], _pack[2], _pack[3] = r, g, b, a
+	return _packWord[0]
+end
+
+local function to_byte(value)
+	return max(0, min(255, floor(value + 0.5)))
+end
+
+function M.new(width, height)
+	width, height = floor(width), floor(height)
+	local self = setmetatable({ width = width, height = height }, Raster)
+	self.pixels = ffi.new("uint8_t[?]", width * height * 4)
+	self._words = ffi.cast("uint32_t*", self.pixels)
+	-- Clip stack as pixel bounds, [left, right) x [top, bottom); entry 0 is the raster
+	self._clips = ffi.new("int32_t[?]", 4 * 65)
+	self._clipDepth = 0
+	self._clips[0], self._clips[1], self._clips[2], self._clips[3] = 0, 0, width, height
+	self._painter = { raster = self, rect = Raster.painter_rect, circle = Raster.painter_circle }
+	self._paintRect = ffi.new("Clay_BoundingBox")
+	return self
+end
+
+function Raster:clear(r, g, b, a)
+	local word = pack(r or 0, g or 0, b or 0, a or 255)
+	local words = self._words
+	for i = 0, self.width * self.height - 1 do
+		words[i] = word
+	end
+end
+
+-- Current brush: the word to store when opaque, else the channels to blend in
+function Raster:_set_color(r, g, b, a)
+	local alpha = to_byte(a)
+	self._r, self._g, self._b, self._a = to_byte(r), to_byte(g), to_byte(b), alpha
+	self._word = pack(self._r, self._g, self._b, 255)
+	self._opaque = alpha == 255
+	return alpha > 0
+end
+
+-- Fills pixels [x0, x1) of row y, already inside the clip
+function Raster:_span(y, x0, x1)
+	if self._opaque then
+		local words = self._words
+		local word = self._word
+		local row = y * self.width
+		for x = row + x0, row + x1 - 1 do
+			words[x] = word
+		end
+		return
+	end
+	local pixels = self.pixels
+	local alpha = self._a / 255
+	local keep = 1 - alpha
+	local r, g, b = self._r * alpha, self._g * alpha, self._b * alpha
+	local a = self._a
+	for i = (y * self.width + x0) * 4, (y * self.width + x1) * 4 - 1, 4 do
+		pixels[i] = floor(r + pixels[i] * keep + 0.5)
+		pixels[i + 1] = floor(g + pixels[i + 1] * keep + 0.5)
+		pixels[i + 2] = floor(b + pixels[i + 2] * keep + 0.5)
+		pixels[i + 3] = floor(a + pixels[i + 3] * keep + 0.5)
+	end
+end
+
+-- Rows whose centers fall in [top, bottom), clipped
+function Raster:_rows(top, bottom)
+	local clips, o = self._clips, self._clipDepth * 4
+	return max(ceil(top - 0.5), clips[o + 1]), min(ceil(bottom - 0.5), clips[o + 3]) - 1
+end
+
+-- Fills columns whose centers fall in [left, right) of row y, clipped
+function Raster:_fill_between(y, left, right)
+	local clips, o = self._clips, self._clipDepth * 4
+	local x0 = max(ceil(left - 0.5), clips[o])
+	local x1 = min(ceil(right - 0.5), clips[o + 2])
+	if x1 > x0 then
+		self:_span(y, x0, x1)
+	end
+end
+
+-- Horizontal extent of a rounded rect at height cy
+local function rounded_extent(x, y, w, h, tl, tr, bl, br, cy)
+	local left, right = x, x + w
+	if cy < y + tl then
+		local dy = y + tl - cy
+		left = x + tl - sqrt(max(0, tl * tl - dy * dy))
+	elseif cy > y + h - bl then
+		local dy = cy - (y + h - bl)
+		left = x + bl - sqrt(max(0, bl * bl - dy * dy))
+	end
+	if cy < y + tr then
+		local dy = y + tr - cy
+		right = x + w - tr + sqrt(max(0, tr * tr - dy * dy))
+	elseif cy > y + h - br then
+		local dy = cy - (y + h - br)
+		right = x + w - br + sqrt(max(0, br * br - dy * dy))
+	end
+	return left, right
+end
+
+-- Radii are clamped to half the shorter side, as renderers do
+local function clamp_radii(w, h, tl, tr, bl, br)
+	local limit = min(w, h) / 2
+	return min(tl, limit), min(tr, limit), min(bl, limit), min(br, limit)
+end
+
+function Raster:fill_rect(x, y, w, h, tl, tr, bl, br)
+	if w <= 0 or h <= 0 then
+		return
+	end
+	local y0, y1 = self:_rows(y, y + h)
+	if tl == 0 and tr == 0 and bl == 0 and br == 0 then
+		for row = y0, y1 do
+			self:_fill_between(row, x, x + w)
+		end
+		return
+	end
+	tl, tr, bl, br = clamp_radii(w, h, tl, tr, bl, br)
+	for row = y0, y1 do
+		self:_fill_between(row, rounded_extent(x, y, w, h, tl, tr, bl, br, row + 0.5))
+	end
+end
+
+function Raster:fill_border(x, y, w, h, radius, width)
+	if w <= 0 or h <= 0 then
+		return
+	end
+	local tl, tr, bl, br = clamp_radii(w, h, radius.topLeft, radius.topRight, radius.bottomLeft, radius.bottomRight)
+	local wl, wr, wt, wb = width.left, width.right, width.top, width.bottom
+	local ix, iy = x + wl, y + wt
+	local iw, ih = w - wl - wr, h - wt - wb
+	local itl, itr = max(0, tl - max(wl, wt)), max(0, tr - max(wr, wt))
+	local ibl, ibr = max(0, bl - max(wl, wb)), max(0, br - max(wr, wb))
+	local y0, y1 = self:_rows(y, y + h)
+	for row = y0, y1 do
+		local cy = row + 0.5
+		local left, right = rounded_extent(x, y, w, h, tl, tr, bl, br, cy)
+		if iw > 0 and cy >= iy and cy < iy + ih then
+			local innerLeft, innerRight = rounded_extent(ix, iy, iw, ih, itl, itr, ibl, ibr, cy)
+			self:_fill_between(row, left, innerLeft)
+			self:_fill_between(row, innerRight, right)
+		else
+			self:_fill_between(row, left, right)
+		end
+	end
+end
+
+function Raster:fill_circle(cx, cy, radius)
+	local y0, y1 = self:_rows(cy - radius, cy + radius)
+	for row = y0, y1 do
+		local dy = row + 0.5 - cy
+		local half = sqrt(max(0, radius * radius - dy * dy))
+		self:_fill_between(row, cx - half, cx + half)
+	end
+end
+
+-- Draws length bytes at chars from (x, y); each run of set bits in a glyph column
+-- is one rect
+function Raster:draw_text(chars, length, x, y, fontSize, letterSpacing, lineHeight)
+	chars = ffi.cast("const uint8_t*", chars)
+	local scale = fontSize / FONT_CELL
+	if lineHeight > fontSize then
+		y = y + (lineHeight - fontSize) / 2
+	end
+	local penX = x
+	for i = 0, length - 1 do
+		local c = chars[i]
+		local advance = GLYPH_ADVANCES[c]
+		if advance > 0 then
+			local glyph = GLYPHS[c]
+			for col = 0, 4 do
+				local bits = glyph[col]
+				local row = 0
+				while bits ~= 0 do
+					if bit.band(bits, 1) == 0 then
+						bits = bit.rshift(bits, 1)
+						row = row + 1
+					else
+						local run = 0
+						while bit.band(bits, 1) ~= 0 do
+							bits = bit.rshift(bits, 1)
+							run = run + 1
+						end
+						self:fill_rect(penX + col * scale, y + row * scale, scale, run * scale, 0, 0, 0, 0)
+						row = row + run
+					end
+				end
+			end
+			penX = penX + advance * scale + letterSpacing
+		end
+	end
+end
+
+function Raster:push_clip(x, y, w, h)
+	if self._clipDepth >= 64 then
+		return
+	end
+	local clips, o = self._clips, self._clipDepth * 4
+	self._clipDepth = self._clipDepth + 1
+	clips[o + 4] = max(clips[o], ceil(x - 0.5))
+	clips[o + 5] = max(clips[o + 1], ceil(y - 0.5))
+	clips[o + 6] = min(clips[o + 2], ceil(x + w - 0.5))
+	clips[o + 7] = min(clips[o + 3], ceil(y + h - 0.5))
+end
+
+function Raster:pop_clip()
+	if self._clipDepth > 0 then
+		self._clipDepth = self._clipDepth - 1
+	end
+end
+
+-- Painter colors are { r, g, b, a } tables with named or positional fields
+local function color_channels(color)
+	return color.r or color[1] or 0, color.g or color[2] or 0, color.b or color[3] or 0, color.a or color[4] or 255
+end
+
+function Raster.painter_rect(painter, r, color, radius)
+	local self = painter.raster
+	if self:_set_color(color_channels(color)) then
+		radius = radius or 0
+		self:fill_rect(r.x, r.y, r.width, r.height, radius, radius, radius, radius)
+	end
+end
+
+function Raster.painter_circle(painter, center, radius, color)
+	local self = painter.raster
+	if self:_set_color(color_channels(color)) then
+		self:fill_circle(center.x, center.y, radius)
+	end
+end
+
+-- Draws commands (the result of end_layout). get_callback(id) finds CUSTOM
+-- callbacks; it defaults to llay.get_render_callback.
+function Raster:draw(commands, get_callback)
+	get_callback = get_callback or shell.get_render_callback
+	self._clipDepth = 0
+	local array = commands.internalArray
+	for i = 0, tonumber(commands.length) - 1 do
+		local cmd = array[i]
+		local kind = cmd.commandType
+		local box = cmd.boundingBox
+		if kind == RECTANGLE then
+			local data = cmd.renderData.rectangle
+			local c, r = data.backgroundColor, data.cornerRadius
+			if self:_set_color(c.r, c.g, c.b, c.a) then
+				self:fill_rect(box.x, box.y, box.width, box.height, r.topLeft, r.topRight, r.bottomLeft, r.bottomRight)
+			end
+		elseif kind == BORDER then
+			local data = cmd.renderData.border
+			local c = data.color
+			if self:_set_color(c.r, c.g, c.b, c.a) then
+				self:fill_border(box.x, box.y, box.width, box.height, data.cornerRadius, data.width)
+			end
+		elseif kind == TEXT then
+			local data = cmd.renderData.text
+			local c = data.textColor
+			if self:_set_color(c.r, c.g, c.b, c.a) then
+				self:draw_text(
+					data.stringContents.chars,
+					data.stringContents.length,
+					box.x,
+					box.y,
+					data.fontSize,
+					data.letterSpacing,
+					data.lineHeight
+				)
+			end
+		elseif kind == IMAGE then
+			local data = cmd.renderData.image
+			local c, r = data.backgroundColor, data.cornerRadius
+			local visible
+			if c.a > 0 then
+				visible = self:_set_color(c.r, c.g, c.b, c.a)
+			else
+				visible = self:_set_color(160, 160, 160, 255)
+			end
+			if visible then
+				self:fill_rect(box.x, box.y, box.width, box.height, r.topLeft, r.topRight, r.bottomLeft, r.bottomRight)
+			end
+		elseif kind == CUSTOM then
+			local callback = get_callback(cmd.id)
+			if callback then
+				local rect = self._paintRect
+				rect.x, rect.y, rect.width, rect.height = box.x, box.y, box.width, box.height
+				callback(rect, self._painter, cmd)
+			end
+		elseif kind == SCISSOR_START then
+			self:push_clip(box.x, box.y, box.width, box.height)
+		elseif kind == SCISSOR_END then
+			self:pop_clip()
+		end
+	end
+	return self
+end
+
+function Raster:pixel(x, y)
+	local i = (y * self.width + x) * 4
+	local pixels = self.pixels
+	return pixels[i], pixels[i + 1], pixels[i + 2], pixels[i + 3]
+end
+
+-- ==================================================================================
+-- Image Files
+-- ==================================================================================
+
+-- Binary PPM (P6): RGB, alpha dropped
+function Raster:to_ppm()
+	local count = self.width * self.height
+	local rgb = ffi.new("uint8_t[?]", count * 3)
+	local pixels = self.pixels
+	for i = 0, count - 1 do
+		rgb[i * 3] = pixels[i * 4]
+		rgb[i * 3 + 1] = pixels[i * 4 + 1]
+		rgb[i * 3 + 2] = pixels[i * 4 + 2]
+	end
+	return string.format("P6\n%d %d\n255\n", self.width, self.height) .. ffi.string(rgb, count * 3)
+end
+
+local CRC_TABLE = ffi.new("uint32_t[256]")
+for n = 0, 255 do
+	local c = n
+	for _ = 1, 8 do
+		if bit.band(c, 1) ~= 0 then
+			c = bit.bxor(0xedb88320, bit.rshift(c, 1))
+		else
+			c = bit.rshift(c, 1)
+		end
+	end
+	CRC_TABLE[n] = bit.tobit(c)
+end
+
+local function crc32(data)
+	local c = -1
+	for i = 1, #data do
+		c = bit.bxor(CRC_TABLE[bit.band(bit.bxor(c, data:byte(i)), 0xff)], bit.rshift(c, 8))
+	end
+	return bit.bnot(c)
+end
+
+local function be32(value)
+	return string.char(
+		bit.band(bit.rshift(value, 24), 0xff),
+		bit.band(bit.rshift(value, 16), 0xff),
+		bit.band(bit.rshift(value, 8), 0xff),
+		bit.band(value, 0xff)
+	)
+end
+
+local function png_chunk(kind, data)
+	return be32(#data) .. kind .. data .. be32(crc32(kind .. data))
+end
+
+-- PNG, RGBA, stored without compression (zlib "stored" blocks)
+function Raster:to_png()
+	local rowBytes = self.width * 4 + 1
+	local raw = ffi.new("uint8_t[?]", rowBytes * self.height)
+	for y = 0, self.height - 1 do
+		-- Filter byte 0 (none), then the row
+		ffi.copy(raw + y * rowBytes + 1, self.pixels + y * self.width * 4, self.width * 4)
+	end
+	local size = rowBytes * self.height
+
+	local parts = { "\120\1" }
+	local a, b = 1, 0
+	for i = 0, size - 1 do
+		a = (a + raw[i]) % 65521
+		b = (b + a) % 65521
+	end
+	for offset = 0, size - 1, 65535 do
+		local length = min(65535, size - offset)
+		local final = offset + length >= size and 1 or 0
+		parts[#parts + 1] = string.char(final, bit.band(length, 0xff), bit.rshift(length, 8),
+			bit.band(bit.bnot(length), 0xff), bit.band(bit.rshift(bit.bnot(length), 8), 0xff))
+		parts[#parts + 1] = ffi.string(raw + offset, length)
+	end
+	if size == 0 then
+		parts[#parts + 1] = "\1\0\0\255\255"
+	end
+	parts[#parts + 1] = be32(b * 65536 + a)
+
+	return "\137PNG\r\n\26\n"
+		.. png_chunk("IHDR", be32(self.width) .. be32(self.height) .. "\8\6\0\0\0")
+		.. png_chunk("IDAT", table.concat(parts))
+		.. png_chunk("IEND", "")
+end
+
+local function write_file(path, bytes)
+	local file = assert(io.open(path, "wb"))
+	file:write(bytes)
+	file:close()
+end
+
+function Raster:write_ppm(path)
+	write_file(path, self:to_ppm())
+end
+
+function Raster:write_png(path)
+	write_file(path, self:to_png())
+end
+
+M.measure_text = measure_text
+M.glyph_advances = GLYPH_ADVANCES
+
+return M
@@ -0,0 +1,353 @@
+local ffi = require("ffi")
+local bit = require("bit")
+local core = require("core")
+require("llay_ffi")
+
+-- Declaration streams: a frame's open/configure/text/close sequence recorded as flat
+-- bytes, then replayed into any context (this one, another LuaJIT state on a worker
+-- thread, or a benchmark reading a saved file).
+--
+-- Every record is a run of 32-bit words: an opcode, then its payload.
+--   DIMENSIONS  f32 width, f32 height
+--   POINTER     f32 x, f32 y, u32 isDown
+--   SCROLL      u32 enableDrag, f32 dx, f32 dy, f32 dt
+--   BEGIN
+--   OPEN
+--   OPEN_ID     u32 id, u32 offset, u32 baseId   (pre-hashed)
+--   CONFIGURE   raw Clay_ElementDeclaration bytes
+--   TEXT        u32 length, raw Clay_TextElementConfig bytes, chars padded to 4
+--   CLOSE
+--   END
+-- A header (magic, version, struct sizes) opens each frame so a stream from another
+-- build is rejected instead of misread. Pointer fields inside declarations (userData,
+-- image and custom data) are copied verbatim: their owners must outlive the replay.
+--
+-- Selected with llay.new_recorder(); llay.replay(stream) lays a stream out.
+
+local M = {}
+
+local MAGIC = 0x5453534c -- "LLST"
+local VERSION = 1
+
+local OP_DIMENSIONS = 1
+local OP_POINTER = 2
+local OP_SCROLL = 3
+local OP_BEGIN = 4
+local OP_OPEN = 5
+local OP_OPEN_ID = 6
+local OP_CONFIGURE = 7
+local OP_TEXT = 8
+local OP_CLOSE = 9
+local OP_END = 10
+
+local DECLARATION_SIZE = ffi.sizeof("Clay_ElementDeclaration")
+local TEXT_CONFIG_SIZE = ffi.sizeof("Clay_TextElementConfig")
+local HEADER_WORDS = 4
+
+local uint32_ptr = ffi.typeof("uint32_t*")
+local float_ptr = ffi.typeof("float*")
+
+-- ==================================================================================
+-- Stream Buffer
+-- ==================================================================================
+
+local Stream = {}
+Stream.__index = Stream
+
+function M.new_stream(capacity)
+	capacity = capacity or 64 * 1024
+	return setmetatable({
+		data = ffi.new("uint8_t[?]", capacity),
+		capacity = capacity,
+		size = 0,
+		complete = false,
+	}, Stream)
+end
+
+-- Makes room for n more bytes; returns the write offset
+local function reserve(stream, n)
+	local offset = stream.size
+	local needed = offset + n
+	if needed > stream.capacity then
+		local capacity = stream.capacity * 2
+		while capacity < needed do
+			capacity = capacity * 2
+		end
+		local data = ffi.new("uint8_t[?]", capacity)
+		ffi.copy(data, stream.data, offset)
+		stream.data = data
+		stream.capacity = capacity
+	end
+	stream.size = needed
+	return offset
+end
+
+local function write_u32(stream, value)
+	local offset = reserve(stream, 4)
+	ffi.cast(uint32_ptr, stream.data + offset)[0] = value
+end
+
+local function write_f32(stream, value)
+	local offset = reserve(stream, 4)
+	ffi.cast(float_ptr, stream.data + offset)[0] = value
+end
+
+local function write_bytes(stream, ptr, n)
+	local offset = reserve(stream, bit.band(n + 3, -4))
+	ffi.copy(stream.data + offset, ptr, n)
+end
+
+local function write_header(stream)
+	stream.size = 0
+	stream.complete = false
+	write_u32(stream, MAGIC)
+	write_u32(stream, VERSION)
+	write_u32(stream, DECLARATION_SIZE)
+	write_u32(stream, TEXT_CONFIG_SIZE)
+end
+
+-- Pointer and size of the recorded bytes (valid until the next record)
+function Stream:bytes()
+	return self.data, self.size
+end
+
+function Stream:save(path)
+	local file = assert(io.open(path, "wb"))
+	file:write(ffi.string(self.data, self.size))
+	file:close()
+end
+
+function M.load_stream(path)
+	local file = assert(io.open(path, "rb"))
+	local bytes = file:read("*a")
+	file:close()
+	local stream = M.new_stream(math.max(#bytes, 16))
+	ffi.copy(stream.data, bytes, #bytes)
+	stream.size = #bytes
+	stream.complete = true
+	return stream
+end
+
+-- ==================================================================================
+-- Recorder Engine
+-- ==================================================================================
+
+-- The same surface init.lua and shell.lua call on core, writing records instead of
+-- laying out. end_layout() returns the stream.
+function M.new_recorder(stream)
+	local R = {}
+	stream = stream or M.new_stream()
+	local openIds = {}
+	local openDepth = 0
+	local hoverSource = nil
+	-- NaN marks "use the element's scroll offset"; replay resolves it
+	local scrollSentinel = { x = 0 / 0, y = 0 / 0 }
+
+	-- Pointer and scroll input recorded after end_layout belongs to the next frame
+	local function frame_stream()
+		if stream.complete or stream.size == 0 then
+			write_header(stream)
+		end
+		return stream
+	end
+
+	function R.stream()
+		return stream
+	end
+
+	-- Source of pointer_over answers, e.g. the worker laying this stream out
+	function R.set_hover_source(source)
+		hoverSource = source
+	end
+
+	function R.set_dimensions(width, height)
+		local s = frame_stream()
+		write_u32(s, OP_DIMENSIONS)
+		write_f32(s, width)
+		write_f32(s, height)
+	end
+
+	function R.set_pointer_state(position, isPointerDown)
+		local s = frame_stream()
+		write_u32(s, OP_POINTER)
+		write_f32(s, position.x)
+		write_f32(s, position.y)
+		write_u32(s, isPointerDown and 1 or 0)
+	end
+
+	function R.update_scroll_containers(enableDragScrolling, scrollDelta, deltaTime)
+		local s = frame_stream()
+		write_u32(s, OP_SCROLL)
+		write_u32(s, enableDragScrolling and 1 or 0)
+		write_f32(s, scrollDelta.x)
+		write_f32(s, scrollDelta.y)
+		write_f32(s, deltaTime)
+	end
+
+	function R.begin_layout()
+		write_u32(frame_stream(), OP_BEGIN)
+		openDepth = 0
+	end
+
+	function R.end_layout()
+		write_u32(stream, OP_END)
+		stream.complete = true
+		return stream
+	end
+
+	function R.open_element()
+		write_u32(stream, OP_OPEN)
+		openDepth = openDepth + 1
+		openIds[openDepth] = 0
+	end
+
+	function R.open_element_with_id(elementId)
+		write_u32(stream, OP_OPEN_ID)
+		write_u32(stream, elementId.id)
+		write_u32(stream, elementId.offset or 0)
+		write_u32(stream, elementId.baseId or 0)
+		openDepth = openDepth + 1
+		openIds[openDepth] = elementId.id
+	end
+
+	function R.configure_open_element(declaration)
+		write_u32(stream, OP_CONFIGURE)
+		write_bytes(stream, declaration, DECLARATION_SIZE)
+	end
+
+	function R.close_element()
+		write_u32(stream, OP_CLOSE)
+		openDepth = openDepth - 1
+	end
+
+	-- Takes text like core.open_text_element: a Lua string, a Clay_String, or a char
+	-- pointer with its byte length
+	function R.open_text_element(text, textConfig, length)
+		if length == nil then
+			if type(text) == "cdata" then
+				text, length = text.chars, text.length
+			else
+				length = #text
+			end
+		end
+		write_u32(stream, OP_TEXT)
+		write_u32(stream, length)
+		write_bytes(stream, textConfig, TEXT_CONFIG_SIZE)
+		write_bytes(stream, text, length)
+	end
+
+	function R.get_scroll_offset()
+		return scrollSentinel
+	end
+
+	-- Anonymous ids are assigned by the engine at replay, so only explicit ids are known
+	function R.get_parent_element_id()
+		local id = openIds[openDepth]
+		if not id or id == 0 then
+			error("llay: ID_LOCAL needs a parent with an explicit id while recording", 3)
+		end
+		return id
+	end
+
+	function R.pointer_over(id)
+		return hoverSource ~= nil and hoverSource:pointer_over(id)
+	end
+
+	R.Llay__GetElementId = core.Llay__GetElementId
+	R.Llay__GetElementIdWithIndex = core.Llay__GetElementIdWithIndex
+	R.Llay__HashStringWithOffset = core.Llay__HashStringWithOffset
+	R.Llay__HashNumber = core.Llay__HashNumber
+	R.Inspector = core.Inspector
+
+	return setmetatable(R, {
+		__index = function(_, name)
+			return function()
+				error("llay: " .. name .. " is not available while recording", 2)
+			end
+		end,
+	})
+end
+
+-- ==================================================================================
+-- Replay
+-- ==================================================================================
+
+local _declaration = ffi.new("Clay_ElementDeclaration")
+local _textConfig = ffi.new("Clay_TextElementConfig")
+local _elementId = ffi.new("Clay_ElementId")
+local _vector = ffi.new("Clay_Vector2")
+
+-- Replays size bytes at data into engine (core by default, i.e. the active Lua
+-- context). Returns the render commands of the frame's END record, if any.
+function M.replay_bytes(data, size, engine)
+	engine = engine or core
+	local words = ffi.cast(uint32_ptr, data)
+	local floats = ffi.cast(float_ptr, data)
+	local count = math.floor(size / 4)
+	if count < HEADER_WORDS or words[0] ~= MAGIC then
+		error("llay: not a declaration stream", 2)
+	end
+	if words[1] ~= VERSION or words[2] ~= DECLARATION_SIZE or words[3] ~= TEXT_CONFIG_SIZE then
+		error("llay: declaration stream was recorded by an incompatible build", 2)
+	end
+
+	local commands = nil
+	local i = HEADER_WORDS
+	while i < count do
+		local op = words[i]
+		i = i + 1
+		if op == OP_OPEN then
+			engine.open_element()
+		elseif op == OP_OPEN_ID then
+			_elementId.id = words[i]
+			_elementId.offset = words[i + 1]
+			_elementId.baseId = words[i + 2]
+			i = i + 3
+			engine.open_element_with_id(_elementId)
+		elseif op == OP_CONFIGURE then
+			ffi.copy(_declaration, words + i, DECLARATION_SIZE)
+			i = i + DECLARATION_SIZE / 4
+			local offset = _declaration.clip.childOffset
+			if offset.x ~= offset.x then
+				local live = engine.get_scroll_offset()
+				offset.x = live.x
+				offset.y = live.y
+			end
+			engine.configure_open_element(_declaration)
+		elseif op == OP_CLOSE then
+			engine.close_element()
+		elseif op == OP_TEXT then
+			local length = words[i]
+			ffi.copy(_textConfig, words + i + 1, TEXT_CONFIG_SIZE)
+			i = i + 1 + TEXT_CONFIG_SIZE / 4
+			engine.open_text_element(ffi.cast("const char*", words + i), _textConfig, length)
+			i = i + bit.rshift(length + 3, 2)
+		elseif op == OP_BEGIN then
+			engine.begin_layout()
+		elseif op == OP_END then
+			commands = engine.end_layout()
+		elseif op == OP_POINTER then
+			_vector.x = floats[i]
+			_vector.y = floats[i + 1]
+			engine.set_pointer_state(_vector, words[i + 2] ~= 0)
+			i = i + 3
+		elseif op == OP_SCROLL then
+			_vector.x = floats[i + 1]
+			_vector.y = floats[i + 2]
+			engine.update_scroll_containers(words[i] ~= 0, _vector, floats[i + 3])
+			i = i + 4
+		elseif op == OP_DIMENSIONS then
+			engine.set_dimensions(floats[i], floats[i + 1])
+			i = i + 2
+		else
+			error(string.format("llay: bad declaration stream opcode %d at byte %d", tonumber(op), (i - 1) * 4), 2)
+		end
+	end
+	return commands
+end
+
+function M.replay(stream, engine)
+	return M.replay_bytes(stream.data, stream.size, engine)
+end
+
+return M
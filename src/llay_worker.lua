@@ -0,0 +1,468 @@
+local ffi = require("ffi")
+require("llay_ffi")
+
+-- Worker threads: a second LuaJIT state on a pthread that replays declaration
+-- streams (llay_stream.lua) into its own context, so layout of frame N+1 overlaps
+-- rendering of frame N on the calling thread.
+--
+-- Everything goes through FFI: the worker state is created with luaL_newstate, and
+-- its thread entry is an FFI callback created inside that state, so it only ever
+-- runs there. The two sides share one C-allocated Llay__WorkerShared guarded by a
+-- mutex and condition variable:
+--   input   one slot; submit() waits until the worker has copied the previous stream
+--   frames  two slots; the worker fills the one the caller is not holding, poll()
+--           takes the newest finished one. Text is copied into the slot, so a held
+--           frame stays valid until the next poll()/wait().
+--
+-- Started with llay.new_worker(); see docs/API.md.
+
+local M = {}
+
+if not package.loaded["llay_worker_ffi_loaded"] then
+	ffi.cdef([[
+    typedef struct lua_State lua_State;
+    lua_State *luaL_newstate(void);
+    void luaL_openlibs(lua_State *L);
+    int luaL_loadstring(lua_State *L, const char *s);
+    int lua_pcall(lua_State *L, int nargs, int nresults, int errfunc);
+    void lua_pushnumber(lua_State *L, double n);
+    void lua_pushstring(lua_State *L, const char *s);
+    void lua_pushnil(lua_State *L);
+    double lua_tonumber(lua_State *L, int idx);
+    const char *lua_tolstring(lua_State *L, int idx, size_t *len);
+    void lua_settop(lua_State *L, int idx);
+    void lua_close(lua_State *L);
+
+    // pthread types are opaque and at most 64 bytes on the platforms LuaJIT targets
+    typedef union { uint8_t bytes[64]; int64_t align; } Llay__WorkerMutex;
+    typedef union { uint8_t bytes[64]; int64_t align; } Llay__WorkerCond;
+    int pthread_create(unsigned long *thread, const void *attr, void *start, void *arg);
+    int pthread_join(unsigned long thread, void **retval);
+    int pthread_detach(unsigned long thread);
+    int pthread_mutex_init(Llay__WorkerMutex *mutex, const void *attr);
+    int pthread_mutex_destroy(Llay__WorkerMutex *mutex);
+    int pthread_mutex_lock(Llay__WorkerMutex *mutex);
+    int pthread_mutex_unlock(Llay__WorkerMutex *mutex);
+    int pthread_cond_init(Llay__WorkerCond *cond, const void *attr);
+    int pthread_cond_destroy(Llay__WorkerCond *cond);
+    int pthread_cond_wait(Llay__WorkerCond *cond, Llay__WorkerMutex *mutex);
+    int pthread_cond_broadcast(Llay__WorkerCond *cond);
+    void *calloc(size_t count, size_t size);
+    void *realloc(void *ptr, size_t size);
+    void free(void *ptr);
+
+    typedef struct Llay__WorkerFrame {
+        uint32_t frame;
+        int32_t commandCount, commandCapacity;
+        int32_t hoveredCount, hoveredCapacity;
+        int32_t textSize, textCapacity;
+        Clay_RenderCommand *commands;
+        uint32_t *hovered;
+        char *text;
+    } Llay__WorkerFrame;
+
+    typedef struct Llay__WorkerShared {
+        Llay__WorkerMutex mutex;
+        Llay__WorkerCond cond;
+        int32_t quit, failed, inputReady;
+        // Set by a collected Worker: the thread frees the block itself on quitting
+        int32_t detached;
+        uint32_t inputSize, inputCapacity;
+        uint8_t *input;
+        uint32_t submitted, completed;
+        int32_t published, held;
+        Llay__WorkerFrame frames[2];
+        char error[256];
+    } Llay__WorkerShared;
+    ]])
+	package.loaded["llay_worker_ffi_loaded"] = true
+end
+
+local C = ffi.C
+
+-- The pthread and Lua C API symbols are in the process when luajit links them in
+-- dynamically (pthread is part of libc since glibc 2.34); otherwise load the shared
+-- libraries. nil when neither has them; M.start then fails with a clear error.
+local function find_library(symbol, names)
+	if pcall(function() return C[symbol] end) then
+		return C
+	end
+	for _, name in ipairs(names) do
+		local ok, lib = pcall(ffi.load, name)
+		if ok and pcall(function() return lib[symbol] end) then
+			return lib
+		end
+	end
+	return nil
+end
+local PT = find_library("pthread_create", { "pthread", "libpthread.so.0" })
+local LUA = find_library("luaL_newstate", { "luajit-5.1", "libluajit-5.1.so.2", "lua51" })
+local RENDER_COMMAND_SIZE = ffi.sizeof("Clay_RenderCommand")
+local TEXT_COMMAND = 3
+
+-- Grows a C buffer owned by the shared block; only the side that owns it calls this
+local function grow(ptr, capacity, needed, elementSize)
+	if needed <= capacity then
+		return ptr, capacity
+	end
+	local newCapacity = math.max(needed, capacity * 2, 64)
+	local grown = C.realloc(ptr, newCapacity * elementSize)
+	if grown == nil then
+		error("llay: worker out of memory")
+	end
+	return grown, newCapacity
+end
+
+-- Frees the shared block; the worker thread must not be using it
+local function free_shared(shared)
+	for i = 0, 1 do
+		C.free(shared.frames[i].commands)
+		C.free(shared.frames[i].hovered)
+		C.free(shared.frames[i].text)
+	end
+	C.free(shared.input)
+	PT.pthread_cond_destroy(shared.cond)
+	PT.pthread_mutex_destroy(shared.mutex)
+	C.free(shared)
+end
+
+-- ==================================================================================
+-- Worker Side (runs in the worker's LuaJIT state)
+-- ==================================================================================
+
+local function publish(shared, commands, frameNumber, core)
+	PT.pthread_mutex_lock(shared.mutex)
+	-- Never the held slot; otherwise keep an unread published frame if possible
+	local slot = 0
+	if shared.held >= 0 then
+		slot = 1 - shared.held
+	elseif shared.published >= 0 then
+		slot = 1 - shared.published
+	end
+	if shared.published == slot then
+		shared.published = -1
+	end
+	PT.pthread_mutex_unlock(shared.mutex)
+
+	local frame = shared.frames[slot]
+	local count = commands and tonumber(commands.length) or 0
+	local ptr, capacity = grow(frame.commands, frame.commandCapacity, count, RENDER_COMMAND_SIZE)
+	frame.commands, frame.commandCapacity = ffi.cast("Clay_RenderCommand*", ptr), capacity
+	if count > 0 then
+		ffi.copy(frame.commands, commands.internalArray, count * RENDER_COMMAND_SIZE)
+	end
+	frame.commandCount = count
+
+	-- Text points into the worker's arena; copy it next to the commands
+	local textSize = 0
+	for i = 0, count - 1 do
+		local cmd = frame.commands[i]
+		if cmd.commandType == TEXT_COMMAND then
+			local contents = cmd.renderData.text.stringContents
+			local length = contents.length
+			ptr, capacity = grow(frame.text, frame.textCapacity, textSize + length, 1)
+			frame.text, frame.textCapacity = ffi.cast("char*", ptr), capacity
+			ffi.copy(frame.text + textSize, contents.chars, length)
+			textSize = textSize + length
+		end
+	end
+	frame.textSize = textSize
+	local offset = 0
+	for i = 0, count - 1 do
+		local cmd = frame.commands[i]
+		if cmd.commandType == TEXT_COMMAND then
+			local contents = cmd.renderData.text.stringContents
+			contents.chars = frame.text + offset
+			contents.baseChars = contents.chars
+			offset = offset + contents.length
+		end
+	end
+
+	local hovered = core.get_all_hovered_ids()
+	ptr, capacity = grow(frame.hovered, frame.hoveredCapacity, #hovered, 4)
+	frame.hovered, frame.hoveredCapacity = ffi.cast("uint32_t*", ptr), capacity
+	for i = 1, #hovered do
+		frame.hovered[i - 1] = hovered[i]
+	end
+	frame.hoveredCount = #hovered
+	frame.frame = frameNumber
+
+	PT.pthread_mutex_lock(shared.mutex)
+	shared.published = slot
+	shared.completed = frameNumber
+	PT.pthread_cond_broadcast(shared.cond)
+	PT.pthread_mutex_unlock(shared.mutex)
+end
+
+local function worker_loop(shared)
+	local core = require("core")
+	local stream = require("llay_stream")
+	local inputCapacity = 64 * 1024
+	local input = ffi.new("uint8_t[?]", inputCapacity)
+	while true do
+		PT.pthread_mutex_lock(shared.mutex)
+		while shared.inputReady == 0 and shared.quit == 0 do
+			PT.pthread_cond_wait(shared.cond, shared.mutex)
+		end
+		if shared.quit ~= 0 then
+			PT.pthread_mutex_unlock(shared.mutex)
+			return
+		end
+		local size = shared.inputSize
+		if size > inputCapacity then
+			inputCapacity = size * 2
+			input = ffi.new("uint8_t[?]", inputCapacity)
+		end
+		ffi.copy(input, shared.input, size)
+		local frameNumber = shared.submitted
+		shared.inputReady = 0
+		PT.pthread_cond_broadcast(shared.cond)
+		PT.pthread_mutex_unlock(shared.mutex)
+
+		publish(shared, stream.replay_bytes(input, size), frameNumber, core)
+	end
+end
+
+-- Called inside the new state by M.start: sets up the context, then returns the
+-- address of the thread entry (an FFI callback owned by this state)
+function M._thread_entry(address, setup, capacity, width, height)
+	local shared = ffi.cast("Llay__WorkerShared*", address)
+	local llay = require("init")
+	llay.init(capacity, { width = width, height = height })
+	if setup then
+		local configure = require(setup)
+		if type(configure) == "function" then
+			configure(llay)
+		end
+	end
+	M._entry = ffi.cast("void *(*)(void *)", function()
+		local ok, err = pcall(worker_loop, shared)
+		if ok and shared.detached ~= 0 then
+			-- Nobody holds the worker anymore; its state stays behind until exit
+			free_shared(shared)
+		elseif not ok then
+			PT.pthread_mutex_lock(shared.mutex)
+			ffi.copy(shared.error, tostring(err):sub(1, 255))
+			shared.failed = 1
+			PT.pthread_cond_broadcast(shared.cond)
+			PT.pthread_mutex_unlock(shared.mutex)
+		end
+		return nil
+	end)
+	return tonumber(ffi.cast("uintptr_t", M._entry))
+end
+
+-- ==================================================================================
+-- Caller Side
+-- ==================================================================================
+
+local Worker = {}
+Worker.__index = Worker
+
+-- Asks the thread to quit, joins it and releases everything it used
+local function shutdown(shared, L, thread)
+	PT.pthread_mutex_lock(shared.mutex)
+	shared.quit = 1
+	PT.pthread_cond_broadcast(shared.cond)
+	PT.pthread_mutex_unlock(shared.mutex)
+	PT.pthread_join(thread, nil)
+	LUA.lua_close(L)
+	free_shared(shared)
+end
+
+-- Finalizer of a Worker dropped without stop(). Never blocks the collector: the
+-- thread is told to quit and detached, and frees the shared block when it does.
+-- A thread that already failed has returned, so it is joined and freed here. Takes
+-- the raw handles rather than the Worker, so the finalizer doesn't keep it alive.
+local function abandon(shared, L, thread)
+	PT.pthread_mutex_lock(shared.mutex)
+	if shared.failed ~= 0 then
+		PT.pthread_mutex_unlock(shared.mutex)
+		shutdown(shared, L, thread)
+		return
+	end
+	shared.detached = 1
+	shared.quit = 1
+	PT.pthread_cond_broadcast(shared.cond)
+	PT.pthread_mutex_unlock(shared.mutex)
+	PT.pthread_detach(thread)
+end
+
+local WORKER_CHUNK = [[
+local path, address, setup, capacity, width, height = ...
+package.path = path
+return require("llay_worker")._thread_entry(address, setup, capacity, width, height)
+]]
+
+-- options: capacity, dims = { width, height } (or width/height), and setup, a module
+-- name required inside the worker state to configure its llay (measure text, glyph
+-- tables); if it returns a function, that is called with the worker's llay.
+function M.start(options)
+	if not PT or not LUA then
+		error("llay: worker threads need the pthread and LuaJIT C API symbols; "
+			.. "run a dynamically linked luajit or install libluajit-5.1", 2)
+	end
+	options = options or {}
+	local dims = options.dims or options
+	local shared = ffi.cast("Llay__WorkerShared*", C.calloc(1, ffi.sizeof("Llay__WorkerShared")))
+	PT.pthread_mutex_init(shared.mutex, nil)
+	PT.pthread_cond_init(shared.cond, nil)
+	shared.published = -1
+	shared.held = -1
+
+	local L = LUA.luaL_newstate()
+	LUA.luaL_openlibs(L)
+	local status = LUA.luaL_loadstring(L, WORKER_CHUNK)
+	if status == 0 then
+		LUA.lua_pushstring(L, package.path)
+		LUA.lua_pushnumber(L, tonumber(ffi.cast("uintptr_t", shared)))
+		if options.setup then
+			LUA.lua_pushstring(L, options.setup)
+		else
+			LUA.lua_pushnil(L)
+		end
+		LUA.lua_pushnumber(L, options.capacity or 1024 * 1024 * 16)
+		LUA.lua_pushnumber(L, dims.width or dims[1] or 800)
+		LUA.lua_pushnumber(L, dims.height or dims[2] or 600)
+		status = LUA.lua_pcall(L, 6, 1, 0)
+	end
+	if status ~= 0 then
+		local message = ffi.string(LUA.lua_tolstring(L, -1, nil))
+		LUA.lua_close(L)
+		free_shared(shared)
+		error("llay: worker failed to start: " .. message, 2)
+	end
+	local entry = LUA.lua_tonumber(L, -1)
+	LUA.lua_settop(L, 0)
+
+	local thread = ffi.new("unsigned long[1]")
+	if PT.pthread_create(thread, nil, ffi.cast("void*", entry), nil) ~= 0 then
+		LUA.lua_close(L)
+		free_shared(shared)
+		error("llay: pthread_create failed", 2)
+	end
+
+	-- A worker dropped without stop() is told to quit when it is collected
+	local threadId = thread[0]
+	local guard = ffi.gc(ffi.new("uint8_t[1]"), function()
+		abandon(shared, L, threadId)
+	end)
+
+	return setmetatable({
+		_shared = shared,
+		_state = L,
+		_thread = threadId,
+		_guard = guard,
+		_view = ffi.new("Clay_RenderCommandArray"),
+		_held = nil,
+	}, Worker)
+end
+
+local function check_failed(shared)
+	if shared.failed ~= 0 then
+		error("llay: worker failed: " .. ffi.string(shared.error), 3)
+	end
+end
+
+-- Hands a complete recorded frame to the worker; blocks only while the worker is
+-- still copying the previous one
+function Worker:submit(stream)
+	if not stream.complete then
+		error("llay: submit needs a stream ending in end_layout()", 2)
+	end
+	local shared = self._shared
+	PT.pthread_mutex_lock(shared.mutex)
+	while shared.inputReady ~= 0 and shared.failed == 0 do
+		PT.pthread_cond_wait(shared.cond, shared.mutex)
+	end
+	if shared.failed == 0 then
+		local ptr, capacity = grow(shared.input, shared.inputCapacity, stream.size, 1)
+		shared.input, shared.inputCapacity = ffi.cast("uint8_t*", ptr), capacity
+		ffi.copy(shared.input, stream.data, stream.size)
+		shared.inputSize = stream.size
+		shared.submitted = shared.submitted + 1
+		shared.inputReady = 1
+		PT.pthread_cond_broadcast(shared.cond)
+	end
+	PT.pthread_mutex_unlock(shared.mutex)
+	check_failed(shared)
+	return shared.submitted
+end
+
+-- Takes the newest finished frame; returns its render commands, or nil when nothing
+-- new is ready. The previous frame's commands become invalid.
+function Worker:poll()
+	local shared = self._shared
+	check_failed(shared)
+	PT.pthread_mutex_lock(shared.mutex)
+	local slot = shared.published
+	if slot >= 0 then
+		shared.held = slot
+		shared.published = -1
+	end
+	PT.pthread_mutex_unlock(shared.mutex)
+	if slot < 0 then
+		return nil
+	end
+	local frame = shared.frames[slot]
+	self._held = frame
+	self._view.length = frame.commandCount
+	self._view.capacity = frame.commandCount
+	self._view.internalArray = frame.commands
+	return self._view, frame.frame
+end
+
+-- Blocks until the last submitted frame is laid out, then returns it like poll()
+function Worker:wait()
+	local shared = self._shared
+	PT.pthread_mutex_lock(shared.mutex)
+	while shared.completed ~= shared.submitted and shared.failed == 0 do
+		PT.pthread_cond_wait(shared.cond, shared.mutex)
+	end
+	PT.pthread_mutex_unlock(shared.mutex)
+	local commands, frame = self:poll()
+	if commands then
+		return commands, frame
+	end
+	return self:latest()
+end
+
+-- The frame taken by the last poll()/wait(), or nil
+function Worker:latest()
+	if not self._held then
+		return nil
+	end
+	return self._view, self._held.frame
+end
+
+-- Hover state of the held frame, so a recorder can answer pointer_over
+function Worker:pointer_over(id)
+	local frame = self._held
+	if not frame then
+		return false
+	end
+	if type(id) == "string" then
+		id = require("core").Llay__GetElementId(id).id
+	end
+	for i = 0, frame.hoveredCount - 1 do
+		if frame.hovered[i] == id then
+			return true
+		end
+	end
+	return false
+end
+
+-- Joins the thread and frees the shared memory; the worker is unusable afterwards
+function Worker:stop()
+	local shared = self._shared
+	if shared == nil then
+		return
+	end
+	ffi.gc(self._guard, nil)
+	shutdown(shared, self._state, self._thread)
+	self._shared = nil
+	self._guard = nil
+	self._held = nil
+end
+
+return M
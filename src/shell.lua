@@ -10,6 +10,16 @@ local M = {}
 
 local _render_callbacks = {}
 
+-- init.lua swaps in the native engine, which exposes the same functions as core
+function M._set_engine(engine)
+	core = engine
+end
+
+-- Each llay context keeps its own registry; init.lua swaps it in with the context
+function M._use_render_callbacks(callbacks)
+	_render_callbacks = callbacks
+end
+
 function M._reset_render_callbacks()
 	for k in pairs(_render_callbacks) do
 		_render_callbacks[k] = nil
@@ -237,7 +247,7 @@ end
 
 -- ID with Index (for loops)
 function M.IDI(str, index)
-	return core.Llay__HashStringWithOffset(str, index, 0)
+	return core.Llay__GetElementIdWithIndex(str, index)
 end
 
 -- Local ID (scoped to parent)
@@ -252,21 +262,192 @@ function M.IDI_LOCAL(str, index)
 	return core.Llay__HashStringWithOffset(str, index, parentId)
 end
 
+-- ==================================================================================
+-- Declaration Builders
+-- ==================================================================================
+
+local function resolve_config_id(cid)
+	local cid_type = type(cid)
+	if cid_type == "string" then
+		return core.Llay__GetElementId(cid)
+	elseif cid_type == "number" then
+		return core.Llay__HashNumber(cid, 0)
+	elseif cid_type == "table" or cid_type == "cdata" then
+		return cid
+	end
+	return nil
+end
+
+-- layout defaults to config.layout; Custom passes its own (see M.Custom)
+local function fill_declaration(declaration, config, layout)
+	declaration.layout = parse_layout_config(layout or config.layout)
+	declaration.backgroundColor = parse_color(config.backgroundColor)
+	if config.cornerRadius then
+		declaration.cornerRadius = parse_corner_radius(config.cornerRadius)
+	end
+	if config.border then
+		declaration.border = parse_border_config(config.border)
+	end
+	if config.floating then
+		declaration.floating = parse_floating_config(config.floating)
+	end
+	if config.clip then
+		declaration.clip = parse_clip_config(config.clip)
+	end
+
+	local aspect_ratio = config.aspectRatio or (config.layout and config.layout.aspectRatio)
+	if aspect_ratio and aspect_ratio ~= 0 then
+		declaration.aspectRatio.aspectRatio = aspect_ratio
+	end
+
+	if config.image then
+		declaration.image.imageData = config.image.imageData
+	end
+
+	if config.custom then
+		declaration.custom.customData = config.custom.customData
+	end
+	if config.userData then
+		declaration.userData = config.userData
+	end
+	if config.layer then
+		declaration.layer = true
+	end
+end
+
+-- ==================================================================================
+-- Compiled Styles
+-- ==================================================================================
+-- llay.compile(config) parses a config table once into a Clay_ElementDeclaration
+-- (plus a text config for Text). Each use copies it into a scratch declaration,
+-- because core patches some fields while configuring (floating parentId) and
+-- per-frame overrides are written on top. No cdata is allocated per element.
+
+local CompiledStyle = {}
+CompiledStyle.__index = CompiledStyle
+CompiledStyle.__newindex = function()
+	error("Compiled styles are immutable", 2)
+end
+
+local DECLARATION_SIZE = ffi.sizeof("Clay_ElementDeclaration")
+local TEXT_CONFIG_SIZE = ffi.sizeof("Clay_TextElementConfig")
+local _scratch_declaration = ffi.new("Clay_ElementDeclaration")
+local _scratch_text_config = ffi.new("Clay_TextElementConfig")
+local CUSTOM_DATA_MARKER = ffi.cast("void*", 1)
+
+function M.compile(config)
+	if getmetatable(config) == CompiledStyle then
+		return config
+	end
+	config = config or {}
+
+	local declaration = ffi.new("Clay_ElementDeclaration")
+	fill_declaration(declaration, config)
+
+	local clip = config.clip
+	local style = {
+		declaration = declaration,
+		textConfig = parse_text_config(config),
+		elementId = config.id and resolve_config_id(config.id) or false,
+		-- Custom also reads layout fields from the top level of its config
+		customLayout = config.layout == nil and parse_layout_config(config) or false,
+		-- Clip containers without an explicit childOffset query it every frame
+		autoChildOffset = clip ~= nil and (clip.childOffset == nil or type(clip.childOffset) == "function"),
+		childOffsetFn = clip ~= nil and type(clip.childOffset) == "function" and clip.childOffset or false,
+	}
+	return setmetatable(style, CompiledStyle)
+end
+
+M.style = M.compile
+
+function M.is_compiled(value)
+	return getmetatable(value) == CompiledStyle
+end
+
+-- Writes a color table into an existing Clay_Color without allocating
+local function write_color(dst, val)
+	dst.r = val[1] or val.r or 0
+	dst.g = val[2] or val.g or 0
+	dst.b = val[3] or val.b or 0
+	dst.a = val[4] or val.a or 255
+end
+
+-- Per-frame overrides applied on top of a compiled declaration.
+-- Supported: backgroundColor, childOffset, floatingOffset, zIndex, userData.
+local function apply_overrides(declaration, overrides)
+	if overrides.backgroundColor then
+		write_color(declaration.backgroundColor, overrides.backgroundColor)
+	end
+	if overrides.childOffset then
+		declaration.clip.childOffset.x = overrides.childOffset.x or 0
+		declaration.clip.childOffset.y = overrides.childOffset.y or 0
+	end
+	if overrides.floatingOffset then
+		declaration.floating.offset.x = overrides.floatingOffset.x or 0
+		declaration.floating.offset.y = overrides.floatingOffset.y or 0
+	end
+	if overrides.zIndex then
+		declaration.floating.zIndex = overrides.zIndex
+	end
+	if overrides.userData then
+		declaration.userData = overrides.userData
+	end
+end
+
+local function element_compiled(id, style, overrides, children_fn)
+	id = id or style.elementId
+	if id then
+		core.open_element_with_id(id)
+	else
+		core.open_element()
+	end
+
+	local declaration = _scratch_declaration
+	ffi.copy(declaration, style.declaration, DECLARATION_SIZE)
+
+	-- Same as the table path: must run after open_element
+	if style.autoChildOffset and not (overrides and overrides.childOffset) then
+		local offset
+		if style.childOffsetFn then
+			offset = style.childOffsetFn()
+		else
+			offset = core.get_scroll_offset()
+		end
+		declaration.clip.childOffset.x = offset.x or 0
+		declaration.clip.childOffset.y = offset.y or 0
+	end
+
+	if overrides then
+		apply_overrides(declaration, overrides)
+	end
+
+	core.configure_open_element(declaration)
+
+	if children_fn then
+		children_fn()
+	end
+
+	core.close_element()
+end
+
 -- ==================================================================================
 -- Element Constructors
 -- ==================================================================================
 
-function M.Element(arg1, arg2, arg3)
+function M.Element(arg1, arg2, arg3, arg4)
 	-- Handle multiple patterns for compatibility:
 	-- 1. CLAY(id, config) { children } -> Element(id, config, children_fn) - C API style
 	-- 2. CLAY(string_id, config) { children } -> Element(string, config, children_fn) - Auto-hash
 	-- 3. CLAY(number_id, config) { children } -> Element(number, config, children_fn) - Auto-hash
 	-- 4. CLAY(config) { children } -> Element(config, children_fn) - Lua convenience style
 	-- 5. Element(config) -> Element(config) - No children
+	-- Any config may be a compiled style, optionally followed by an overrides table:
+	-- Element([id,] style, [overrides,] children_fn)
 
 	local id = nil
 	local config = nil
 	local children_fn = nil
+	local rest1, rest2 = arg2, arg3
 
 	-- Pattern detection
 	local arg1_type = type(arg1)
@@ -275,68 +456,44 @@ function M.Element(arg1, arg2, arg3)
 		id = core.Llay__GetElementId(arg1)
 		config = arg2
 		children_fn = arg3
+		rest1, rest2 = arg3, arg4
 	elseif arg1_type == "number" then
 		-- Pattern 3: First arg is a number ID, hash it with seed 0
 		id = core.Llay__HashNumber(arg1, 0)
 		config = arg2
 		children_fn = arg3
-	elseif arg1_type == "table" and arg1.id ~= nil and type(arg1.id) == "number" then
+		rest1, rest2 = arg3, arg4
+	elseif getmetatable(arg1) == CompiledStyle then
+		config = arg1
+	elseif arg1_type == "cdata" or (arg1_type == "table" and arg1.id ~= nil and type(arg1.id) == "number") then
 		-- Pattern 1: First arg is Clay_ElementId (table or cdata)
 		id = arg1
 		config = arg2
 		children_fn = arg3
+		rest1, rest2 = arg3, arg4
 	elseif arg1_type == "table" then
 		-- Pattern 4 or 5: First arg is config table
 		config = arg1
 		children_fn = arg2
 	end
 
+	if getmetatable(config) == CompiledStyle then
+		-- A nil overrides slot is allowed, e.g. Element(style, active and hot or nil, fn)
+		if type(rest1) == "table" or (rest1 == nil and rest2 ~= nil) then
+			return element_compiled(id, config, rest1, rest2)
+		end
+		return element_compiled(id, config, nil, rest1)
+	end
+
 	-- Parse config
 	local declaration = ffi.new("Clay_ElementDeclaration")
 
 	if config then
-		local layout_config = parse_layout_config(config.layout)
-		declaration.layout = layout_config
-		declaration.backgroundColor = parse_color(config.backgroundColor)
-		if config.cornerRadius then
-			declaration.cornerRadius = parse_corner_radius(config.cornerRadius)
-		end
-		if config.border then
-			declaration.border = parse_border_config(config.border)
-		end
-		if config.floating then
-			declaration.floating = parse_floating_config(config.floating)
-		end
-		if config.clip then
-			declaration.clip = parse_clip_config(config.clip)
-		end
-
-		local aspect_ratio = config.aspectRatio or (config.layout and config.layout.aspectRatio)
-		if aspect_ratio and aspect_ratio ~= 0 then
-			declaration.aspectRatio.aspectRatio = aspect_ratio
-		end
-
-		if config.image then
-			declaration.image.imageData = config.image.imageData
-		end
-
-		if config.custom then
-			declaration.custom.customData = config.custom.customData
-		end
-		if config.userData then
-			declaration.userData = config.userData
-		end
+		fill_declaration(declaration, config)
 
 		-- Check if config has an id field - convenience pattern
 		if config.id and not id then
-			local cid = config.id
-			if type(cid) == "string" then
-				id = core.Llay__GetElementId(cid)
-			elseif type(cid) == "number" then
-				id = core.Llay__HashNumber(cid, 0)
-			elseif type(cid) == "table" or type(cid) == "cdata" then
-				id = cid
-			end
+			id = resolve_config_id(config.id)
 		end
 	end
 
@@ -349,7 +506,8 @@ function M.Element(arg1, arg2, arg3)
 
 	-- Auto-fill childOffset if clip is enabled but not provided
 	-- This must happen AFTER open_element because get_scroll_offset() queries the open element
-	local needsChildOffset = config.clip
+	local needsChildOffset = config
+		and config.clip
 		and (config.clip.childOffset == nil or type(config.clip.childOffset) == "function")
 	if needsChildOffset then
 		local offset
@@ -372,21 +530,32 @@ function M.Element(arg1, arg2, arg3)
 	core.close_element()
 end
 
-function M.Text(text, config)
+function M.Text(text, config, overrides)
+	if getmetatable(config) == CompiledStyle then
+		local textCfg = config.textConfig
+		if overrides and overrides.color then
+			textCfg = _scratch_text_config
+			ffi.copy(textCfg, config.textConfig, TEXT_CONFIG_SIZE)
+			write_color(textCfg.textColor, overrides.color)
+		end
+		-- core copies the config into the arena, so sharing it is safe
+		core.open_text_element(text, textCfg)
+		return
+	end
+
 	local textCfg = parse_text_config(config or {})
 	-- Use the new core function
 	core.open_text_element(text, textCfg)
 end
 
 function M.Custom(config, render_fn)
+	local compiled = getmetatable(config) == CompiledStyle
+
 	local id_obj
-	if config.id then
-		if type(config.id) == "string" then
-			id_obj = core.Llay__GetElementId(config.id)
-		else
-			-- Assume it is an ID object (table or cdata)
-			id_obj = config.id
-		end
+	if compiled and config.elementId then
+		id_obj = config.elementId
+	elseif not compiled and config.id then
+		id_obj = resolve_config_id(config.id)
 	else
 		local id_str = "auto_cust_" .. tostring(#_render_callbacks)
 		id_obj = core.Llay__GetElementId(id_str)
@@ -394,20 +563,223 @@ function M.Custom(config, render_fn)
 
 	_render_callbacks[id_obj.id] = render_fn
 
-	local declaration = ffi.new("Clay_ElementDeclaration")
-	declaration.layout = parse_layout_config(config.layout or config)
-	if config.backgroundColor then
-		declaration.backgroundColor = parse_color(config.backgroundColor)
-	end
-	if config.cornerRadius then
-		declaration.cornerRadius = parse_corner_radius(config.cornerRadius)
+	-- Both paths fill the declaration like compile does, with the layout fields taken
+	-- from config.layout or, without one, from the config itself
+	local declaration
+	if compiled then
+		declaration = _scratch_declaration
+		ffi.copy(declaration, config.declaration, DECLARATION_SIZE)
+		if config.customLayout then
+			declaration.layout = config.customLayout
+		end
+	else
+		declaration = ffi.new("Clay_ElementDeclaration")
+		fill_declaration(declaration, config, config.layout or config)
 	end
 
-	declaration.custom.customData = ffi.cast("void*", 1)
+	declaration.custom.customData = CUSTOM_DATA_MARKER
 
 	core.open_element_with_id(id_obj)
 	core.configure_open_element(declaration)
 	core.close_element()
 end
 
+-- ==================================================================================
+-- Virtual List
+-- ==================================================================================
+-- A scrolling clip container that only opens the items intersecting its viewport
+-- (from the previous frame's bounding box) plus `overscan` items on each side. The
+-- rest of the list is two fixed spacers, so contentSize and scrollbars cover every
+-- item. Items sized by estimate_fn are measured once laid out and cached by index.
+--
+-- Item i (1-based) is wrapped in an element with id HashNumber(i, list id); the
+-- spacers use 0 and count + 1, so no child of the list is anonymous.
+
+-- [list element id] = { sizes, offsets, valid, count, gap, first, last }.
+-- Swapped per context, like the render callbacks.
+local _virtual_lists = {}
+
+function M._use_virtual_lists(lists)
+	_virtual_lists = lists
+end
+
+local _list_declaration = ffi.new("Clay_ElementDeclaration")
+local _item_declaration = ffi.new("Clay_ElementDeclaration")
+local _spacer_declaration = ffi.new("Clay_ElementDeclaration")
+
+-- offsets[i] is where item i starts along the list; entries up to `valid` are current
+local function list_offset(state, i, estimate)
+	local offsets = state.offsets
+	local valid = state.valid
+	if i > valid then
+		local sizes, gap = state.sizes, state.gap
+		local offset = offsets[valid]
+		for k = valid, i - 1 do
+			offset = offset + (sizes[k] or estimate(k)) + gap
+			offsets[k + 1] = offset
+		end
+		state.valid = i
+	end
+	return offsets[i]
+end
+
+-- Last item starting at or before `position`
+local function list_find(state, position, count)
+	local offsets = state.offsets
+	local lo, hi = 1, count
+	while lo < hi do
+		local mid = math.floor((lo + hi + 1) / 2)
+		if offsets[mid] <= position then
+			lo = mid
+		else
+			hi = mid - 1
+		end
+	end
+	return lo
+end
+
+-- Declarations are refilled per element: item_fn may hold a nested VirtualList
+local function open_spacer(index, seed, horizontal, extent)
+	ffi.fill(_spacer_declaration, DECLARATION_SIZE)
+	local sizing = _spacer_declaration.layout.sizing
+	local main = horizontal and sizing.width or sizing.height
+	main.type = M.SizingType.FIXED
+	main.size.minMax.min = extent
+	main.size.minMax.max = extent
+	core.open_element_with_id(core.Llay__HashNumber(index, seed))
+	core.configure_open_element(_spacer_declaration)
+	core.close_element()
+end
+
+-- Grows on the cross axis; fixed to item_size or fitted to its content on the main axis
+local function open_item(index, seed, horizontal, itemSize)
+	ffi.fill(_item_declaration, DECLARATION_SIZE)
+	local sizing = _item_declaration.layout.sizing
+	local cross = horizontal and sizing.height or sizing.width
+	cross.type = M.SizingType.GROW
+	if itemSize then
+		local main = horizontal and sizing.width or sizing.height
+		main.type = M.SizingType.FIXED
+		main.size.minMax.min = itemSize
+		main.size.minMax.max = itemSize
+	end
+	core.open_element_with_id(core.Llay__HashNumber(index, seed))
+	core.configure_open_element(_item_declaration)
+end
+
+-- VirtualList({ id, count, item_size | estimate_fn, direction, overscan, layout, ... }, item_fn)
+-- item_fn(i) declares the contents of item i. Other fields style the container as
+-- in Element; clip and layoutDirection are set from `direction`.
+function M.VirtualList(config, item_fn)
+	local listId = resolve_config_id(config.id)
+	if not listId then
+		error("llay: VirtualList needs an id", 2)
+	end
+	local itemSize = config.item_size
+	local estimate_fn = config.estimate_fn
+	if not itemSize and not estimate_fn then
+		error("llay: VirtualList needs item_size or estimate_fn", 2)
+	end
+	local estimate = estimate_fn or function()
+		return itemSize
+	end
+	local count = config.count or 0
+	local overscan = config.overscan or 2
+	local horizontal = config.direction == M.LayoutDirection.LEFT_TO_RIGHT
+	local seed = listId.id
+
+	local declaration = _list_declaration
+	ffi.fill(declaration, DECLARATION_SIZE)
+	fill_declaration(declaration, config)
+	declaration.layout.layoutDirection = horizontal and M.LayoutDirection.LEFT_TO_RIGHT or M.LayoutDirection.TOP_TO_BOTTOM
+	declaration.clip.horizontal = horizontal
+	declaration.clip.vertical = not horizontal
+	local gap = declaration.layout.childGap
+	local padding = declaration.layout.padding
+	local paddingStart = horizontal and padding.left or padding.top
+	local paddingEnd = horizontal and padding.right or padding.bottom
+
+	local state = _virtual_lists[seed]
+	if not state then
+		state = { sizes = {}, offsets = { 0 }, valid = 1, count = 0, gap = gap, first = 1, last = 0 }
+		_virtual_lists[seed] = state
+	end
+	if state.gap ~= gap or state.itemSize ~= itemSize then
+		state.gap = gap
+		state.itemSize = itemSize
+		state.valid = 1
+	elseif state.count ~= count then
+		state.valid = math.min(state.valid, math.min(state.count, count) + 1)
+	end
+	state.count = count
+
+	-- Measure what was laid out last frame
+	local sizes = state.sizes
+	if not itemSize then
+		for i = state.first, math.min(state.last, count) do
+			local data = core.get_element_data(core.Llay__HashNumber(i, seed).id)
+			if data.found then
+				local size = horizontal and data.boundingBox.width or data.boundingBox.height
+				local known = sizes[i]
+				if known ~= size then
+					sizes[i] = size
+					if (known or estimate(i)) ~= size and i < state.valid then
+						state.valid = i
+					end
+				end
+			end
+		end
+	end
+
+	-- Viewport from last frame's box; before the first layout, assume the whole window
+	local viewport
+	local box = core.get_element_data(seed)
+	if box.found then
+		viewport = (horizontal and box.boundingBox.width or box.boundingBox.height) - paddingStart - paddingEnd
+	else
+		local width, height = core.get_layout_dimensions()
+		viewport = horizontal and width or height
+	end
+
+	core.open_element_with_id(listId)
+	local scroll = core.get_scroll_offset()
+	declaration.clip.childOffset.x = scroll.x or 0
+	declaration.clip.childOffset.y = scroll.y or 0
+	core.configure_open_element(declaration)
+
+	local first, last = 1, 0
+	if count > 0 then
+		local total = list_offset(state, count + 1, estimate) - gap
+		-- The engine clamps the scroll offset after layout; clamp here too so a list
+		-- that just got shorter still fills its viewport
+		local start = math.max(0, math.min(-(horizontal and scroll.x or scroll.y) - paddingStart, total - viewport))
+		local stop = start + viewport
+		first = list_find(state, start, count)
+		last = first
+		while last < count and state.offsets[last + 1] < stop do
+			last = last + 1
+		end
+		first = math.max(1, first - overscan)
+		last = math.min(count, last + overscan)
+
+		local before = state.offsets[first] - gap
+		if before > 0 then
+			open_spacer(0, seed, horizontal, before)
+		end
+		for i = first, last do
+			open_item(i, seed, horizontal, itemSize)
+			item_fn(i)
+			core.close_element()
+		end
+		local after = total - state.offsets[last + 1]
+		if after > 0 then
+			open_spacer(count + 1, seed, horizontal, after)
+		end
+	end
+	state.first = first
+	state.last = last
+
+	core.close_element()
+end
+
 return M
@@ -0,0 +1,155 @@
+-- Render batching benchmark: draw calls a backend issues for one frame when it draws
+-- every command on its own, when it merges consecutive commands of the same kind,
+-- and when it draws llay.new_render_batches() output. Also times the batching pass.
+--
+-- Scenes are a card grid (rect + border + two text runs + badge per card, inside a
+-- scroll container) and every corpus in tests/bench/corpora.lua.
+--
+-- Usage: [CARDS=n] luajit tests/bench/batching.lua [frames]
+package.path = "./src/?.lua;./tests/bench/?.lua;" .. package.path
+
+local llay = require("init")
+local corpora = require("corpora")
+
+local FRAMES = tonumber(arg and arg[1]) or 200
+local CARDS = tonumber(os.getenv("CARDS")) or 400
+
+local RenderCommandType = llay.RenderCommandType
+
+local function measure(text, config, userData)
+	return { width = #text * 8, height = 16 }
+end
+
+local TITLE = { fontId = 1, fontSize = 18, color = { 230, 230, 240, 255 } }
+local BODY = { fontId = 0, fontSize = 14, color = { 160, 160, 170, 255 } }
+
+local function build_cards(frame)
+	llay.Element({
+		id = "Grid",
+		layout = {
+			sizing = { width = "GROW", height = "GROW" },
+			layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM,
+			padding = 8,
+			childGap = 8,
+		},
+		clip = { vertical = true },
+		backgroundColor = { 18, 18, 22, 255 },
+	}, function()
+		for row = 0, CARDS / 8 - 1 do
+			llay.Element({ layout = { sizing = { width = "GROW" }, childGap = 8 } }, function()
+				for col = 1, 8 do
+					local i = row * 8 + col
+					llay.Element({
+						layout = {
+							sizing = { width = "GROW" },
+							layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM,
+							padding = 8,
+							childGap = 4,
+						},
+						backgroundColor = { 34, 36, 46, 255 },
+						cornerRadius = 6,
+						border = { width = 1, color = { 50, 55, 70, 255 } },
+					}, function()
+						llay.Text("Card " .. i, TITLE)
+						llay.Text("status " .. ((i + frame) % 3), BODY)
+						llay.Element({
+							layout = { sizing = { width = 24, height = 6 } },
+							backgroundColor = { 110, 200, 120, 255 },
+						})
+					end)
+				end
+			end)
+		end
+	end)
+end
+
+local function is_drawable(kind)
+	return kind ~= RenderCommandType.NONE
+		and kind ~= RenderCommandType.SCISSOR_START
+		and kind ~= RenderCommandType.SCISSOR_END
+end
+
+-- One draw per drawable command
+local function draws_per_command(commands)
+	local draws = 0
+	for i = 0, tonumber(commands.length) - 1 do
+		if is_drawable(commands.internalArray[i].commandType) then
+			draws = draws + 1
+		end
+	end
+	return draws
+end
+
+-- Consecutive commands of one kind (and font / image) share a draw
+local function draws_in_order(commands)
+	local draws = 0
+	local lastKind, lastKey = nil, nil
+	for i = 0, tonumber(commands.length) - 1 do
+		local cmd = commands.internalArray[i]
+		local kind = cmd.commandType
+		local key = 0
+		if kind == RenderCommandType.TEXT then
+			key = cmd.renderData.text.fontId
+		elseif kind == RenderCommandType.IMAGE then
+			key = tostring(cmd.renderData.image.imageData)
+		end
+		if not is_drawable(kind) then
+			lastKind = nil
+		elseif kind == RenderCommandType.CUSTOM or kind ~= lastKind or key ~= lastKey then
+			draws = draws + 1
+			lastKind, lastKey = kind, key
+		end
+	end
+	return draws
+end
+
+local function draws_batched(batches)
+	local draws = 0
+	for b = 0, batches.count - 1 do
+		local batch = batches.batch[b]
+		if is_drawable(batch.kind) and batch.count > 0 then
+			draws = draws + 1
+		end
+	end
+	return draws
+end
+
+local function run_scene(name, build)
+	llay.init({ capacity = 1024 * 1024 * 64, width = 1920, height = 1080 })
+	llay.set_measure_text_function(measure)
+	local batches = llay.new_render_batches()
+	local commands
+	for f = 1, 30 do
+		llay.begin_layout()
+		build(f)
+		commands = llay.end_layout()
+		batches:build(commands)
+	end
+
+	local elapsed = 0
+	for f = 1, FRAMES do
+		llay.begin_layout()
+		build(f)
+		commands = llay.end_layout()
+		local t0 = os.clock()
+		batches:build(commands)
+		elapsed = elapsed + os.clock() - t0
+	end
+
+	print(string.format(
+		"%-16s %8d %10d %10d %10d %10.3f",
+		name,
+		tonumber(commands.length),
+		draws_per_command(commands),
+		draws_in_order(commands),
+		draws_batched(batches),
+		elapsed * 1000 / FRAMES
+	))
+end
+
+print(string.format("frames/scene: %d%s", FRAMES, jit and (", " .. jit.version) or ""))
+print(string.format("%-16s %8s %10s %10s %10s %10s", "scene", "cmds", "per-cmd", "in-order", "batched", "batch ms"))
+run_scene("cards", build_cards)
+for _, corpus in ipairs(corpora.list) do
+	run_scene(corpus.name, corpus.build)
+end
@@ -0,0 +1,280 @@
+// Native baseline for tests/bench/run.lua: builds the corpora from
+// tests/bench/corpora.lua through the C reference library and prints one JSON
+// object per corpus with the median and p99 frame time in milliseconds.
+//
+// Usage: LD_LIBRARY_PATH=tests/clay_ref tests/bench/clay_bench [frames] [warmup]
+#include "../../clay/clay.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define MAX_FRAMES 10000
+
+static Clay_Dimensions measure_text(Clay_StringSlice text, Clay_TextElementConfig *config, void *userData) {
+    (void)config;
+    (void)userData;
+    return (Clay_Dimensions){
+        .width = (float)text.length * 8,
+        .height = 16
+    };
+}
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+static int compare_double(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static void open_with(Clay_ElementDeclaration *decl) {
+    Clay__OpenElement();
+    Clay__ConfigureOpenElementPtr(decl);
+}
+
+static void open_root(void) {
+    Clay_ElementDeclaration root = CLAY__DEFAULT_STRUCT;
+    root.layout.sizing.width.type = CLAY__SIZING_TYPE_GROW;
+    root.layout.sizing.height.type = CLAY__SIZING_TYPE_GROW;
+    root.layout.layoutDirection = CLAY_TOP_TO_BOTTOM;
+    open_with(&root);
+}
+
+static void set_fixed(Clay_SizingAxis *axis, float size) {
+    axis->type = CLAY__SIZING_TYPE_FIXED;
+    axis->size.minMax.min = size;
+    axis->size.minMax.max = size;
+}
+
+// Deterministic paragraphs matching make_paragraph() in corpora.lua
+static const char *WORDS[] = {
+    "layout", "engine", "frame", "budget", "sizing", "grow", "fit", "padding",
+    "child", "gap", "text", "wraps", "across", "lines", "when", "the", "container",
+    "is", "narrow", "and", "measure", "cache", "hits", "most", "words", "again",
+};
+#define WORD_COUNT (int)(sizeof(WORDS) / sizeof(WORDS[0]))
+static char paragraphs[64][1024];
+
+static void make_paragraphs(void) {
+    for (int p = 1; p <= 64; p++) {
+        char *out = paragraphs[p - 1];
+        out[0] = '\0';
+        for (int i = 1; i <= 80; i++) {
+            if (i > 1) strcat(out, " ");
+            strcat(out, WORDS[(p * 7 + i * 13) % WORD_COUNT]);
+        }
+    }
+}
+
+static Clay_String dynamic_string(const char *chars) {
+    return (Clay_String){ .length = (int32_t)strlen(chars), .chars = chars };
+}
+
+static void build_wide_rows(int frame) {
+    (void)frame;
+    open_root();
+        Clay_ElementDeclaration row = CLAY__DEFAULT_STRUCT;
+        row.layout.sizing.width.type = CLAY__SIZING_TYPE_GROW;
+        set_fixed(&row.layout.sizing.height, 40);
+        row.layout.childGap = 1;
+        open_with(&row);
+        for (int i = 1; i <= 1000; i++) {
+            Clay_ElementDeclaration cell = CLAY__DEFAULT_STRUCT;
+            cell.layout.sizing.width.type = CLAY__SIZING_TYPE_GROW;
+            cell.layout.sizing.height.type = CLAY__SIZING_TYPE_GROW;
+            cell.backgroundColor = (Clay_Color){ (float)(i % 255), 80, 120, 255 };
+            open_with(&cell);
+            Clay__CloseElement();
+        }
+        Clay__CloseElement();
+    Clay__CloseElement();
+}
+
+static void build_deep_level(int depth, int frame) {
+    if (depth == 0) {
+        static char leaf[16];
+        snprintf(leaf, sizeof(leaf), "leaf %d", frame % 10);
+        CLAY_TEXT(dynamic_string(leaf), CLAY_TEXT_CONFIG({ .fontSize = 16 }));
+        return;
+    }
+    Clay_ElementDeclaration level = CLAY__DEFAULT_STRUCT;
+    level.layout.padding = (Clay_Padding){ 1, 1, 1, 1 };
+    level.layout.layoutDirection = depth % 2 == 0 ? CLAY_LEFT_TO_RIGHT : CLAY_TOP_TO_BOTTOM;
+    level.backgroundColor = (Clay_Color){ (float)depth, (float)depth, (float)depth, 255 };
+    open_with(&level);
+    build_deep_level(depth - 1, frame);
+    Clay__CloseElement();
+}
+
+static void build_deep_nesting(int frame) {
+    open_root();
+    build_deep_level(200, frame);
+    Clay__CloseElement();
+}
+
+static void build_text_heavy(int frame) {
+    (void)frame;
+    open_root();
+        Clay_ElementDeclaration column = CLAY__DEFAULT_STRUCT;
+        set_fixed(&column.layout.sizing.width, 600);
+        column.layout.sizing.height.type = CLAY__SIZING_TYPE_FIT;
+        column.layout.layoutDirection = CLAY_TOP_TO_BOTTOM;
+        column.layout.padding = (Clay_Padding){ 8, 8, 8, 8 };
+        column.layout.childGap = 6;
+        open_with(&column);
+        for (int p = 0; p < 64; p++) {
+            CLAY_TEXT(dynamic_string(paragraphs[p]), CLAY_TEXT_CONFIG({ .fontSize = 16, .lineHeight = 20 }));
+        }
+        Clay__CloseElement();
+    Clay__CloseElement();
+}
+
+static void build_floating_roots(int frame) {
+    open_root();
+    for (int i = 1; i <= 500; i++) {
+        Clay_ElementDeclaration panel = CLAY__DEFAULT_STRUCT;
+        set_fixed(&panel.layout.sizing.width, 120);
+        set_fixed(&panel.layout.sizing.height, 40);
+        panel.layout.padding = (Clay_Padding){ 4, 4, 4, 4 };
+        panel.floating.attachTo = CLAY_ATTACH_TO_ROOT;
+        panel.floating.offset = (Clay_Vector2){ (float)((i * 37) % 1800), (float)((i * 53 + frame) % 1000) };
+        panel.floating.zIndex = (int16_t)(i % 16);
+        panel.backgroundColor = (Clay_Color){ 40, 40, 60, 255 };
+        open_with(&panel);
+        CLAY_TEXT(CLAY_STRING("panel"), CLAY_TEXT_CONFIG({ .fontSize = 14 }));
+        Clay__CloseElement();
+    }
+    Clay__CloseElement();
+}
+
+static void build_nested_scroll(int frame) {
+    (void)frame;
+    Clay_ElementDeclaration root = CLAY__DEFAULT_STRUCT;
+    root.layout.sizing.width.type = CLAY__SIZING_TYPE_GROW;
+    root.layout.sizing.height.type = CLAY__SIZING_TYPE_GROW;
+    root.layout.childGap = 4;
+    open_with(&root);
+    for (int s = 1; s <= 8; s++) {
+        Clay_ElementDeclaration pane = CLAY__DEFAULT_STRUCT;
+        pane.layout.sizing.width.type = CLAY__SIZING_TYPE_GROW;
+        pane.layout.sizing.height.type = CLAY__SIZING_TYPE_GROW;
+        pane.layout.layoutDirection = CLAY_TOP_TO_BOTTOM;
+        pane.layout.childGap = 2;
+        pane.clip.vertical = true;
+        Clay__OpenElementWithId(CLAY_IDI("BenchScroll", s));
+        Clay__ConfigureOpenElementPtr(&pane);
+        for (int h = 1; h <= 10; h++) {
+            Clay_ElementDeclaration inner = CLAY__DEFAULT_STRUCT;
+            inner.layout.sizing.width.type = CLAY__SIZING_TYPE_GROW;
+            set_fixed(&inner.layout.sizing.height, 120);
+            inner.layout.childGap = 2;
+            inner.clip.horizontal = true;
+            Clay__OpenElementWithId(CLAY_IDI("BenchScrollInner", s * 100 + h));
+            Clay__ConfigureOpenElementPtr(&inner);
+            for (int r = 1; r <= 20; r++) {
+                Clay_ElementDeclaration row = CLAY__DEFAULT_STRUCT;
+                set_fixed(&row.layout.sizing.width, 80);
+                row.layout.sizing.height.type = CLAY__SIZING_TYPE_GROW;
+                row.backgroundColor = (Clay_Color){ 60, (float)(r * 10), 60, 255 };
+                open_with(&row);
+                Clay__CloseElement();
+            }
+            Clay__CloseElement();
+        }
+        Clay__CloseElement();
+    }
+    Clay__CloseElement();
+}
+
+static void build_near_max(int frame) {
+    (void)frame;
+    open_root();
+    for (int r = 1; r <= 79; r++) {
+        Clay_ElementDeclaration row = CLAY__DEFAULT_STRUCT;
+        row.layout.sizing.width.type = CLAY__SIZING_TYPE_GROW;
+        row.layout.sizing.height.type = CLAY__SIZING_TYPE_GROW;
+        open_with(&row);
+        for (int c = 1; c <= 100; c++) {
+            Clay_ElementDeclaration cell = CLAY__DEFAULT_STRUCT;
+            cell.layout.sizing.width.type = CLAY__SIZING_TYPE_GROW;
+            cell.layout.sizing.height.type = CLAY__SIZING_TYPE_GROW;
+            cell.backgroundColor = (Clay_Color){ (float)r, (float)c, 0, 255 };
+            open_with(&cell);
+            Clay__CloseElement();
+        }
+        Clay__CloseElement();
+    }
+    Clay__CloseElement();
+}
+
+typedef struct {
+    const char *name;
+    void (*build)(int frame);
+} Corpus;
+
+static const Corpus CORPORA[] = {
+    { "wide_rows", build_wide_rows },
+    { "deep_nesting", build_deep_nesting },
+    { "text_heavy", build_text_heavy },
+    { "floating_roots", build_floating_roots },
+    { "nested_scroll", build_nested_scroll },
+    { "near_max", build_near_max },
+};
+
+static double samples[MAX_FRAMES];
+
+int main(int argc, char **argv) {
+    int frames = argc > 1 ? atoi(argv[1]) : 200;
+    int warmup = argc > 2 ? atoi(argv[2]) : 30;
+    if (frames < 1) frames = 1;
+    if (frames > MAX_FRAMES) frames = MAX_FRAMES;
+
+    make_paragraphs();
+
+    size_t arenaSize = 1024 * 1024 * 64;
+    char *arenaMemory = malloc(arenaSize);
+    int corpusCount = (int)(sizeof(CORPORA) / sizeof(CORPORA[0]));
+
+    printf("[\n");
+    for (int c = 0; c < corpusCount; c++) {
+        // Fresh context per corpus, as run.lua does with llay.init
+        Clay_Arena arena = {
+            .capacity = arenaSize,
+            .memory = arenaMemory
+        };
+        Clay_Dimensions dimensions = {.width = 1920, .height = 1080};
+        Clay_Context *context = Clay_Initialize(arena, dimensions, (Clay_ErrorHandler){0});
+        if (context == NULL) {
+            fprintf(stderr, "ERROR: Clay_Initialize returned NULL\n");
+            return 1;
+        }
+        Clay_SetMeasureTextFunction(measure_text, NULL);
+
+        for (int f = 1; f <= warmup; f++) {
+            Clay_BeginLayout();
+            CORPORA[c].build(f);
+            Clay_EndLayout();
+        }
+        for (int f = 1; f <= frames; f++) {
+            double t0 = now_ms();
+            Clay_BeginLayout();
+            CORPORA[c].build(f);
+            Clay_EndLayout();
+            samples[f - 1] = now_ms() - t0;
+        }
+        qsort(samples, (size_t)frames, sizeof(double), compare_double);
+        int p99 = (int)(frames * 0.99);
+        if (p99 >= frames) p99 = frames - 1;
+        printf("  {\"name\": \"%s\", \"median_ms\": %.6f, \"p99_ms\": %.6f}%s\n",
+            CORPORA[c].name, samples[frames / 2], samples[p99], c + 1 < corpusCount ? "," : "");
+    }
+    printf("]\n");
+
+    free(arenaMemory);
+    return 0;
+}
@@ -0,0 +1,183 @@
+-- Benchmark corpora: each entry declares one frame of a stress layout between
+-- begin_layout/end_layout. tests/bench/clay_bench.c builds the same trees for the
+-- native baseline, so keep the two in sync when changing a shape here.
+
+local llay = require("init")
+
+local M = {}
+
+local WORDS = {
+	"layout", "engine", "frame", "budget", "sizing", "grow", "fit", "padding",
+	"child", "gap", "text", "wraps", "across", "lines", "when", "the", "container",
+	"is", "narrow", "and", "measure", "cache", "hits", "most", "words", "again",
+}
+
+-- Deterministic paragraphs so every run (and the C baseline) measures the same text
+local function make_paragraph(seed, word_count)
+	local parts = {}
+	for i = 1, word_count do
+		parts[i] = WORDS[(seed * 7 + i * 13) % #WORDS + 1]
+	end
+	return table.concat(parts, " ")
+end
+
+local PARAGRAPHS = {}
+for p = 1, 64 do
+	PARAGRAPHS[p] = make_paragraph(p, 80)
+end
+
+local ROOT_LAYOUT = {
+	sizing = { width = "GROW", height = "GROW" },
+	layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM,
+}
+
+M.list = {
+	{
+		name = "wide_rows",
+		description = "one row of 1000 GROW siblings",
+		build = function(frame)
+			llay.Element({ layout = ROOT_LAYOUT }, function()
+				llay.Element({
+					layout = { sizing = { width = "GROW", height = 40 }, childGap = 1 },
+				}, function()
+					for i = 1, 1000 do
+						llay.Element({
+							layout = { sizing = { width = "GROW", height = "GROW" } },
+							backgroundColor = { i % 255, 80, 120, 255 },
+						})
+					end
+				end)
+			end)
+		end,
+	},
+	{
+		name = "deep_nesting",
+		description = "200 nested FIT containers around one text leaf",
+		build = function(frame)
+			local function level(depth)
+				if depth == 0 then
+					llay.Text("leaf " .. (frame % 10), { fontSize = 16 })
+					return
+				end
+				llay.Element({
+					layout = {
+						padding = 1,
+						layoutDirection = depth % 2 == 0 and llay.LayoutDirection.LEFT_TO_RIGHT
+							or llay.LayoutDirection.TOP_TO_BOTTOM,
+					},
+					backgroundColor = { depth, depth, depth, 255 },
+				}, function()
+					level(depth - 1)
+				end)
+			end
+			llay.Element({ layout = ROOT_LAYOUT }, function()
+				level(200)
+			end)
+		end,
+	},
+	{
+		name = "text_heavy",
+		description = "64 wrapped 80-word paragraphs in a 600px column",
+		build = function(frame)
+			llay.Element({ layout = ROOT_LAYOUT }, function()
+				llay.Element({
+					layout = {
+						sizing = { width = 600, height = "FIT" },
+						layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM,
+						padding = 8,
+						childGap = 6,
+					},
+				}, function()
+					for p = 1, #PARAGRAPHS do
+						llay.Text(PARAGRAPHS[p], { fontSize = 16, lineHeight = 20 })
+					end
+				end)
+			end)
+		end,
+	},
+	{
+		name = "floating_roots",
+		description = "500 root-attached floating panels with a label each",
+		build = function(frame)
+			llay.Element({ layout = ROOT_LAYOUT }, function()
+				for i = 1, 500 do
+					llay.Element({
+						layout = { sizing = { width = 120, height = 40 }, padding = 4 },
+						floating = {
+							attachTo = llay.FloatingAttachToElement.ROOT,
+							offset = { x = (i * 37) % 1800, y = (i * 53 + frame) % 1000 },
+							zIndex = i % 16,
+						},
+						backgroundColor = { 40, 40, 60, 255 },
+					}, function()
+						llay.Text("panel", { fontSize = 14 })
+					end)
+				end
+			end)
+		end,
+	},
+	{
+		name = "nested_scroll",
+		-- 88 clip containers: scrollContainerDatas holds 100, as in clay.h
+		description = "8 vertical scroll panes, each with 10 horizontal panes of 20 rows",
+		build = function(frame)
+			llay.Element({
+				layout = { sizing = { width = "GROW", height = "GROW" }, childGap = 4 },
+			}, function()
+				for s = 1, 8 do
+					llay.Element({
+						id = llay.IDI("BenchScroll", s),
+						layout = {
+							sizing = { width = "GROW", height = "GROW" },
+							layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM,
+							childGap = 2,
+						},
+						clip = { vertical = true },
+					}, function()
+						for h = 1, 10 do
+							llay.Element({
+								id = llay.IDI("BenchScrollInner", s * 100 + h),
+								layout = { sizing = { width = "GROW", height = 120 }, childGap = 2 },
+								clip = { horizontal = true },
+							}, function()
+								for r = 1, 20 do
+									llay.Element({
+										layout = { sizing = { width = 80, height = "GROW" } },
+										backgroundColor = { 60, r * 10, 60, 255 },
+									})
+								end
+							end)
+						end
+					end)
+				end
+			end)
+		end,
+	},
+	{
+		name = "near_max",
+		description = "79 x 100 grid, just under the 8192 element limit",
+		build = function(frame)
+			llay.Element({ layout = ROOT_LAYOUT }, function()
+				for r = 1, 79 do
+					llay.Element({
+						layout = { sizing = { width = "GROW", height = "GROW" } },
+					}, function()
+						for c = 1, 100 do
+							llay.Element({
+								layout = { sizing = { width = "GROW", height = "GROW" } },
+								backgroundColor = { r, c, 0, 255 },
+							})
+						end
+					end)
+				end
+			end)
+		end,
+	},
+}
+
+M.by_name = {}
+for _, corpus in ipairs(M.list) do
+	M.by_name[corpus.name] = corpus
+end
+
+return M
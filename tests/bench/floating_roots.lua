@@ -0,0 +1,65 @@
+-- Floating roots benchmark: layout and pointer time for a map-style scene with n
+-- floating markers attached to one parent, as n doubles up to 1000. "ordered" declares
+-- the markers in zIndex order so the sort is skipped; "mixed" interleaves zIndex values
+-- so every frame has to sort. Both should grow roughly linearly with n.
+--
+-- Usage: luajit tests/bench/floating_roots.lua [frames] [maxRoots]
+package.path = "./src/?.lua;" .. package.path
+
+local llay = require("init")
+
+local FRAMES = tonumber(arg and arg[1]) or 50
+local MAX_ROOTS = tonumber(arg and arg[2]) or 1000
+
+local function build(n, mixed)
+	llay.Element({
+		id = "Map",
+		layout = { sizing = { width = "GROW", height = "GROW" } },
+		backgroundColor = { 30, 30, 40, 255 },
+	}, function()
+		for i = 0, n - 1 do
+			llay.Element({
+				layout = { sizing = { width = 12, height = 12 } },
+				backgroundColor = { 220, 80, 40, 255 },
+				floating = {
+					attachTo = llay.FloatingAttachToElement.PARENT,
+					zIndex = mixed and (i * 7) % 23 or math.floor(i * 23 / n),
+					attachPoints = { element = 4, parent = 0 },
+					offset = { x = (i * 37) % 1800, y = (i * 53) % 1000 },
+				},
+			})
+		end
+	end)
+end
+
+local function time_frames(n, mixed)
+	for _ = 1, 5 do
+		llay.begin_layout()
+		build(n, mixed)
+		llay.end_layout()
+	end
+	local layout, pointer = 0, 0
+	for f = 1, FRAMES do
+		local t0 = os.clock()
+		llay.begin_layout()
+		build(n, mixed)
+		llay.end_layout()
+		local t1 = os.clock()
+		llay.set_pointer_state(f * 17 % 1800, f * 11 % 1000, false)
+		pointer = pointer + (os.clock() - t1)
+		layout = layout + (t1 - t0)
+	end
+	return layout * 1000 / FRAMES, pointer * 1000 / FRAMES
+end
+
+llay.init({ capacity = 1024 * 1024 * 64, width = 1920, height = 1080 })
+
+print(string.format("frames/size: %d%s", FRAMES, jit and (", " .. jit.version) or ""))
+print(string.format("%8s %12s %12s %12s %12s", "roots", "ordered ms", "pointer ms", "mixed ms", "pointer ms"))
+local n = 125
+while n <= MAX_ROOTS do
+	local ordered, orderedPointer = time_frames(n, false)
+	local mixed, mixedPointer = time_frames(n, true)
+	print(string.format("%8d %12.3f %12.3f %12.3f %12.3f", n, ordered, orderedPointer, mixed, mixedPointer))
+	n = n * 2
+end
@@ -0,0 +1,96 @@
+-- Incremental layout benchmark: a mostly-static dashboard of ~5k elements where one
+-- widget changes every frame. Compares full layout against the subtree memo.
+--
+-- Usage: [PANELS=n] luajit tests/bench/incremental.lua [frames]
+package.path = "./src/?.lua;" .. package.path
+
+local llay = require("init")
+
+local FRAMES = tonumber(arg and arg[1]) or 200
+local PANELS = tonumber(os.getenv("PANELS")) or 26
+local ROWS_PER_PANEL = 40
+
+local function measure(text, config, userData)
+	return { width = #text * 7, height = 14 }
+end
+
+local function build_dashboard(frame)
+	llay.begin_layout()
+	llay.Element({
+		layout = {
+			sizing = { width = "GROW", height = "GROW" },
+			layoutDirection = llay.LayoutDirection.LEFT_TO_RIGHT,
+			padding = 8,
+			childGap = 8,
+		},
+	}, function()
+		for p = 1, PANELS do
+			llay.Element({
+				id = llay.IDI("Panel", p),
+				layout = {
+					sizing = { width = "GROW", height = "GROW" },
+					layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM,
+					padding = 4,
+					childGap = 2,
+				},
+				backgroundColor = { 30, 30, 30, 255 },
+			}, function()
+				for r = 1, ROWS_PER_PANEL do
+					llay.Element({
+						layout = {
+							sizing = { width = "GROW", height = "FIT" },
+							childGap = 4,
+							childAlignment = { llay.AlignX.LEFT, llay.AlignY.CENTER },
+						},
+						backgroundColor = { 50, 50, 50, 255 },
+					}, function()
+						llay.Element({ layout = { sizing = { width = 8, height = 8 } }, backgroundColor = { 0, 200, 0, 255 } })
+						llay.Text("metric")
+						llay.Element({ layout = { sizing = { width = "GROW" } } })
+						-- One live value in the whole dashboard
+						if p == 1 and r == 1 then
+							llay.Text(tostring(frame % 1000))
+						else
+							llay.Text("42")
+						end
+					end)
+				end
+			end)
+		end
+	end)
+	return llay.end_layout()
+end
+
+local function median(samples)
+	table.sort(samples)
+	return samples[math.floor(#samples / 2) + 1]
+end
+
+local function run(incremental)
+	llay.init(1024 * 1024 * 64, { width = 1920, height = 1080 })
+	llay.set_measure_text_function(measure)
+	llay.set_incremental_layout_enabled(incremental)
+
+	local commands
+	for f = 1, 20 do
+		commands = build_dashboard(f)
+	end
+
+	local samples = {}
+	local reused = 0
+	for f = 1, FRAMES do
+		local t0 = os.clock()
+		commands = build_dashboard(f)
+		samples[f] = (os.clock() - t0) * 1000
+		reused = reused + llay.get_layout_memo_reused_count()
+	end
+	return median(samples), tonumber(commands.length), reused / FRAMES
+end
+
+local full_ms, full_cmds = run(false)
+local inc_ms, inc_cmds, reused = run(true)
+
+print(string.format("elements/frame:      ~%d", PANELS * (1 + ROWS_PER_PANEL * 5) + 2))
+print(string.format("full layout:         %.3f ms/frame (median, %d commands)", full_ms, full_cmds))
+print(string.format("incremental layout:  %.3f ms/frame (median, %d commands, %.0f elements reused)", inc_ms, inc_cmds, reused))
+print(string.format("speedup:             %.2fx", full_ms / inc_ms))
@@ -0,0 +1,99 @@
+-- Measure cache warm start benchmark: first-frame latency of a text-dense screen
+-- with an expensive measure function, starting from an empty cache (cold) and from a
+-- snapshot saved by an earlier run (warm). Each start re-initializes the layout, as
+-- an application launch or a screen transition with a fresh context would.
+--
+-- Usage: luajit tests/bench/measure_cache.lua [texts] [costPerChar] [runs]
+package.path = "./src/?.lua;" .. package.path
+
+local llay = require("init")
+
+local TEXTS = tonumber(arg and arg[1]) or 4000
+local COST_PER_CHAR = tonumber(arg and arg[2]) or 200
+local RUNS = tonumber(arg and arg[3]) or 5
+local TAG = "bench-fonts-1"
+
+local WORDS = {
+	"Einstellungen", "Benutzerkonto", "synchronisieren", "Datenschutz", "Verlauf",
+	"preferences", "account", "notifications", "storage", "display", "language",
+	"paramètres", "confidentialité", "téléchargements", "accessibilité", "réseau",
+}
+
+local calls = 0
+-- Stands in for a font backend: shaping cost grows with the text length
+local function measure(text, config, userData)
+	calls = calls + 1
+	local width = 0
+	for i = 1, #text do
+		local advance = (text:byte(i) % 7 + 4) * config.fontSize / 16
+		for _ = 1, COST_PER_CHAR do
+			advance = advance * 1.0000001
+		end
+		width = width + advance
+	end
+	return { width = width, height = config.fontSize * 1.2 }
+end
+
+-- Deterministic labels so every run declares the same texts
+local labels = {}
+local seed = 7
+for i = 1, TEXTS do
+	local words = {}
+	for w = 1, 4 + i % 9 do
+		seed = (seed * 1103515245 + 12345) % 2147483648
+		words[w] = WORDS[math.floor(seed / 65536) % #WORDS + 1]
+	end
+	labels[i] = table.concat(words, " ")
+end
+
+local function frame()
+	llay.begin_layout()
+	llay.Element({
+		layout = { sizing = { width = "GROW", height = "GROW" }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM },
+		clip = { vertical = true },
+	}, function()
+		for i = 1, TEXTS do
+			llay.Element({ layout = { sizing = { width = 360, height = "FIT" }, padding = 4 } }, function()
+				llay.Text(labels[i], { fontSize = 12 + i % 4 * 2 })
+			end)
+		end
+	end)
+	llay.end_layout()
+end
+
+local function start()
+	llay.init({ capacity = 1024 * 1024 * 64, width = 1920, height = 1080, words = 131072 })
+	llay.set_measure_text_function(measure)
+	calls = 0
+end
+
+-- Time one first frame; warm starts load the snapshot first and include it
+local function first_frame(snapshot)
+	start()
+	local t0 = os.clock()
+	if snapshot then
+		assert(llay.restore_measure_cache(snapshot, TAG))
+	end
+	frame()
+	return (os.clock() - t0) * 1000, calls
+end
+
+start()
+frame()
+local snapshot = llay.snapshot_measure_cache(TAG)
+
+local cold, warm = math.huge, math.huge
+local coldCalls, warmCalls
+for _ = 1, RUNS do
+	local ms
+	ms, coldCalls = first_frame(nil)
+	cold = math.min(cold, ms)
+	ms, warmCalls = first_frame(snapshot)
+	warm = math.min(warm, ms)
+end
+
+print(string.format("texts: %d, snapshot: %d KB, best of %d%s", TEXTS, math.floor(#snapshot / 1024), RUNS,
+	jit and (", " .. jit.version) or ""))
+print(string.format("%6s %14s %14s", "start", "first frame ms", "measure calls"))
+print(string.format("%6s %14.2f %14d", "cold", cold, coldCalls))
+print(string.format("%6s %14.2f %14d", "warm", warm, warmCalls))
@@ -0,0 +1,136 @@
+-- Whole-pipeline frame benchmark: lays out a 1080p dashboard-style screen and draws
+-- its render commands with the software rasterizer, so frame cost (layout plus
+-- command consumption) can be measured without a window or GPU.
+--
+-- Usage: luajit tests/bench/raster.lua [cards] [frames] [out.png]
+package.path = "./src/?.lua;" .. package.path
+
+local llay = require("init")
+local raster_module = require("llay_raster")
+
+local CARDS = tonumber(arg and arg[1]) or 60
+local FRAMES = tonumber(arg and arg[2]) or 120
+local OUT = arg and arg[3]
+local WIDTH, HEIGHT = 1920, 1080
+
+llay.init({ capacity = 1024 * 1024 * 64, width = WIDTH, height = HEIGHT })
+llay.set_measure_text_function(raster_module.measure_text)
+
+local PANEL = { 30, 33, 44, 255 }
+local CARD = { 46, 51, 68, 255 }
+local ACCENT = { 90, 160, 240, 255 }
+local TEXT = { 230, 232, 238, 255 }
+local MUTED = { 150, 156, 172, 255 }
+
+local function gauge(rect, painter)
+	local radius = math.min(rect.width, rect.height) / 2
+	local center = { x = rect.x + rect.width / 2, y = rect.y + rect.height / 2 }
+	painter:circle(center, radius, { r = 90, g = 200, b = 120, a = 255 })
+	painter:circle(center, radius * 0.6, CARD)
+end
+
+local function card(i, frame)
+	llay.Element({
+		layout = {
+			sizing = { width = 280, height = 150 },
+			layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM,
+			padding = 12,
+			childGap = 8,
+		},
+		backgroundColor = CARD,
+		cornerRadius = 10,
+		border = { color = i == frame % CARDS + 1 and ACCENT or PANEL, width = 2 },
+	}, function()
+		llay.Element({ layout = { sizing = { width = "GROW" }, childGap = 8 } }, function()
+			llay.Text("Sensor " .. i, { fontSize = 16, color = TEXT })
+			llay.Element({ layout = { sizing = { width = "GROW" } } })
+			llay.Text((i * 37 + frame) % 100 .. "%", { fontSize = 16, color = ACCENT })
+		end)
+		llay.Element({ layout = { sizing = { width = "GROW", height = "GROW" }, childGap = 12 } }, function()
+			llay.Custom({ id = "Gauge" .. i, layout = { sizing = { width = 80, height = 80 } } }, gauge)
+			llay.Text("Readings refresh every frame; the text wraps inside the card body.", {
+				fontSize = 8,
+				lineHeight = 12,
+				color = MUTED,
+			})
+		end)
+	end)
+end
+
+local function frame(n)
+	llay.begin_layout()
+	llay.Element({ layout = { sizing = { width = "GROW", height = "GROW" } }, backgroundColor = PANEL }, function()
+		llay.Element({
+			layout = {
+				sizing = { width = 280, height = "GROW" },
+				layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM,
+				padding = 16,
+				childGap = 6,
+			},
+			backgroundColor = { 22, 24, 32, 255 },
+		}, function()
+			for i = 1, 24 do
+				llay.Element({
+					layout = { sizing = { width = "GROW" }, padding = { 8, 8, 6, 6 } },
+					backgroundColor = i == n % 24 + 1 and ACCENT or { 0, 0, 0, 0 },
+					cornerRadius = 4,
+				}, function()
+					llay.Text("Navigation item " .. i, { fontSize = 16, color = TEXT })
+				end)
+			end
+		end)
+		llay.Element({
+			layout = { sizing = { width = "GROW", height = "GROW" }, padding = 16 },
+			clip = { vertical = true },
+		}, function()
+			llay.Element({
+				layout = { sizing = { width = "GROW" }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM, childGap = 16 },
+			}, function()
+				local perRow = 5
+				for row = 0, math.ceil(CARDS / perRow) - 1 do
+					llay.Element({ layout = { childGap = 16 } }, function()
+						for i = row * perRow + 1, math.min(CARDS, row * perRow + perRow) do
+							card(i, n)
+						end
+					end)
+				end
+			end)
+		end)
+	end)
+	return llay.end_layout()
+end
+
+local raster = llay.new_raster(WIDTH, HEIGHT)
+local function draw(commands)
+	raster:clear(0, 0, 0, 255)
+	raster:draw(commands)
+end
+
+-- Warm up the JIT and the measure cache
+for n = 1, 10 do
+	draw(frame(n))
+end
+
+local layoutTime, rasterTime = 0, 0
+local commandCount = 0
+for n = 1, FRAMES do
+	local t0 = os.clock()
+	local commands = frame(n)
+	local t1 = os.clock()
+	draw(commands)
+	local t2 = os.clock()
+	layoutTime = layoutTime + (t1 - t0)
+	rasterTime = rasterTime + (t2 - t1)
+	commandCount = tonumber(commands.length)
+end
+
+if OUT then
+	raster:write_png(OUT)
+end
+
+local layoutMs = layoutTime * 1000 / FRAMES
+local rasterMs = rasterTime * 1000 / FRAMES
+print(string.format("%dx%d, cards: %d, commands: %d, frames: %d%s", WIDTH, HEIGHT, CARDS, commandCount, FRAMES,
+	jit and (", " .. jit.version) or ""))
+print(string.format("%10s %10s %10s %8s", "layout ms", "raster ms", "frame ms", "fps"))
+print(string.format("%10.2f %10.2f %10.2f %8.1f", layoutMs, rasterMs, layoutMs + rasterMs, 1000 / (layoutMs + rasterMs)))
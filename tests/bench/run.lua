@@ -0,0 +1,267 @@
+-- Benchmark runner: times every corpus in tests/bench/corpora.lua and, when
+-- tests/bench/clay_bench has been built (make bench), the same trees through the C
+-- reference library. When the native engine loads (make native), each corpus is
+-- also timed through llay.init{engine="native"}, i.e. the same Lua declarations
+-- laid out by compiled Clay. Prints a table and writes the results as JSON.
+--
+-- --record=dir saves one frame of each corpus as a declaration stream (dir/name.llst);
+-- --replay=file times laying a saved stream out instead of running the corpora.
+--
+-- Usage: luajit tests/bench/run.lua [--frames=n] [--json=path] [--record=dir] [--replay=file] [corpus ...]
+package.path = "./src/?.lua;./tests/bench/?.lua;" .. package.path
+
+local llay = require("init")
+local corpora = require("corpora")
+
+local FRAMES = 200
+local WARMUP_FRAMES = 30
+local HEAP_FRAMES = 20
+local JSON_PATH = "bench_output.json"
+local NATIVE_BIN = "tests/bench/clay_bench"
+
+local RECORD_DIR = nil
+local REPLAY_PATH = nil
+
+local selected = {}
+for _, a in ipairs(arg or {}) do
+	local key, value = a:match("^%-%-(%w+)=(.*)$")
+	if key == "frames" then
+		FRAMES = tonumber(value)
+	elseif key == "json" then
+		JSON_PATH = value
+	elseif key == "record" then
+		RECORD_DIR = value
+	elseif key == "replay" then
+		REPLAY_PATH = value
+	else
+		local corpus = corpora.by_name[a]
+		if not corpus then
+			io.stderr:write("unknown corpus: " .. a .. "\n")
+			os.exit(1)
+		end
+		selected[#selected + 1] = corpus
+	end
+end
+if #selected == 0 then
+	selected = corpora.list
+end
+
+local function measure(text, config, userData)
+	return { width = #text * 8, height = 16 }
+end
+
+local function percentile(sorted, p)
+	local index = math.min(#sorted, math.floor(#sorted * p) + 1)
+	return sorted[index]
+end
+
+-- Counts trace aborts while fn runs; nil when the VM has no jit.attach
+local function count_trace_aborts(fn)
+	if not (jit and jit.attach) then
+		fn()
+		return nil
+	end
+	local aborts = 0
+	local handler = function(what)
+		if what == "abort" then
+			aborts = aborts + 1
+		end
+	end
+	jit.attach(handler, "trace")
+	fn()
+	jit.attach(handler)
+	return aborts
+end
+
+local function frame(corpus, f)
+	llay.begin_layout()
+	corpus.build(f)
+	return llay.end_layout()
+end
+
+local function run_corpus(corpus, engine)
+	llay.init({ capacity = 1024 * 1024 * 64, width = 1920, height = 1080, engine = engine })
+	llay.set_measure_text_function(measure)
+
+	local commands
+	for f = 1, WARMUP_FRAMES do
+		commands = frame(corpus, f)
+	end
+
+	local samples = {}
+	local aborts = count_trace_aborts(function()
+		for f = 1, FRAMES do
+			local t0 = os.clock()
+			commands = frame(corpus, f)
+			samples[f] = (os.clock() - t0) * 1000
+		end
+	end)
+	table.sort(samples)
+
+	-- Allocation rate with the collector paused, so the delta is what a frame creates
+	collectgarbage("collect")
+	collectgarbage("stop")
+	local heap_before = collectgarbage("count")
+	for f = 1, HEAP_FRAMES do
+		frame(corpus, f)
+	end
+	local heap_kb = (collectgarbage("count") - heap_before) / HEAP_FRAMES
+	collectgarbage("restart")
+	collectgarbage("collect")
+
+	return {
+		name = corpus.name,
+		description = corpus.description,
+		commands = tonumber(commands.length),
+		median_ms = percentile(samples, 0.5),
+		p99_ms = percentile(samples, 0.99),
+		heap_kb_per_frame = heap_kb,
+		trace_aborts = aborts,
+	}
+end
+
+-- Times replaying a saved stream; same statistics as run_corpus
+local function run_replay(path)
+	local stream = llay.load_stream(path)
+	llay.init({ capacity = 1024 * 1024 * 64, width = 1920, height = 1080 })
+	llay.set_measure_text_function(measure)
+	local commands
+	for _ = 1, WARMUP_FRAMES do
+		commands = llay.replay(stream)
+	end
+	local samples = {}
+	for f = 1, FRAMES do
+		local t0 = os.clock()
+		commands = llay.replay(stream)
+		samples[f] = (os.clock() - t0) * 1000
+	end
+	table.sort(samples)
+	print(string.format(
+		"%s: %d bytes, %d cmds, median %.3f ms, p99 %.3f ms over %d frames",
+		path,
+		stream.size,
+		tonumber(commands.length),
+		percentile(samples, 0.5),
+		percentile(samples, 0.99),
+		FRAMES
+	))
+end
+
+local function record_corpus(corpus, dir)
+	local recorder = llay.new_recorder()
+	local previous = llay.get_context()
+	recorder:use()
+	llay.set_dimensions(1920, 1080)
+	local stream = frame(corpus, 1)
+	llay.use_context(previous)
+	local path = dir .. "/" .. corpus.name .. ".llst"
+	stream:save(path)
+	return path
+end
+
+-- The C driver prints one {"name":..,"median_ms":..,"p99_ms":..} object per corpus
+local function run_native()
+	local probe = io.open(NATIVE_BIN, "r")
+	if not probe then
+		return nil
+	end
+	probe:close()
+	local pipe = io.popen(
+		string.format("LD_LIBRARY_PATH=tests/clay_ref %s %d %d", NATIVE_BIN, FRAMES, WARMUP_FRAMES)
+	)
+	local output = pipe:read("*a")
+	pipe:close()
+	local native = {}
+	for name, median, p99 in
+		output:gmatch('"name"%s*:%s*"([%w_]+)"%s*,%s*"median_ms"%s*:%s*([%d%.eE+-]+)%s*,%s*"p99_ms"%s*:%s*([%d%.eE+-]+)')
+	do
+		native[name] = { median_ms = tonumber(median), p99_ms = tonumber(p99) }
+	end
+	return native
+end
+
+local function json_value(v)
+	if v == nil then
+		return "null"
+	elseif type(v) == "number" then
+		return string.format("%.6g", v)
+	elseif type(v) == "string" then
+		return string.format("%q", v)
+	elseif type(v) == "table" then
+		local keys = {}
+		for k in pairs(v) do
+			keys[#keys + 1] = k
+		end
+		table.sort(keys)
+		local parts = {}
+		for i, k in ipairs(keys) do
+			parts[i] = string.format("%q: %s", k, json_value(v[k]))
+		end
+		return "{" .. table.concat(parts, ", ") .. "}"
+	end
+	return tostring(v)
+end
+
+if REPLAY_PATH then
+	run_replay(REPLAY_PATH)
+	return
+end
+
+local results = {}
+for i, corpus in ipairs(selected) do
+	results[i] = run_corpus(corpus)
+end
+
+local native_engine = require("llay_native").load()
+if native_engine then
+	for _, r in ipairs(results) do
+		local n = run_corpus(corpora.by_name[r.name], "native")
+		r.native_engine = { median_ms = n.median_ms, p99_ms = n.p99_ms, heap_kb_per_frame = n.heap_kb_per_frame }
+	end
+end
+
+local native = run_native()
+if native then
+	for _, r in ipairs(results) do
+		r.native = native[r.name]
+	end
+end
+
+print(string.format("frames/corpus: %d (after %d warmup)%s", FRAMES, WARMUP_FRAMES, jit and (", " .. jit.version) or ""))
+print(string.format("%-16s %8s %10s %10s %12s %8s %12s %12s", "corpus", "cmds", "median ms", "p99 ms", "heap KB/fr", "aborts", "engine ms", "native ms"))
+for _, r in ipairs(results) do
+	print(string.format(
+		"%-16s %8d %10.3f %10.3f %12.1f %8s %12s %12s",
+		r.name,
+		r.commands,
+		r.median_ms,
+		r.p99_ms,
+		r.heap_kb_per_frame,
+		r.trace_aborts and tostring(r.trace_aborts) or "n/a",
+		r.native_engine and string.format("%.3f", r.native_engine.median_ms) or "n/a",
+		r.native and string.format("%.3f", r.native.median_ms) or "n/a"
+	))
+end
+if not native_engine then
+	print("native engine: not loaded (make native)")
+end
+if not native then
+	print("native baseline: not built (make bench with the clay submodule checked out)")
+end
+
+if RECORD_DIR then
+	for _, corpus in ipairs(selected) do
+		print("recorded " .. record_corpus(corpus, RECORD_DIR))
+	end
+end
+
+local lines = {}
+for i, r in ipairs(results) do
+	lines[i] = "  " .. json_value(r)
+end
+local out = assert(io.open(JSON_PATH, "w"))
+out:write(string.format('{"frames": %d, "warmup": %d, "results": [\n', FRAMES, WARMUP_FRAMES))
+out:write(table.concat(lines, ",\n"))
+out:write("\n]}\n")
+out:close()
+print("wrote " .. JSON_PATH)
@@ -0,0 +1,84 @@
+-- Wide row benchmark: layout time for one row of k children as k doubles, for a row
+-- with space to hand out (GROW children with mixed min/max) and a row that is too
+-- narrow (GROW children compressed toward their minimums). Every child starts at a
+-- different size, so handing space out one smallest-pair step at a time takes k
+-- steps of k children each; time per child should now stay roughly flat.
+--
+-- Usage: luajit tests/bench/wide_rows.lua [frames] [maxChildren]
+package.path = "./src/?.lua;" .. package.path
+
+local llay = require("init")
+
+local FRAMES = tonumber(arg and arg[1]) or 50
+local MAX_CHILDREN = tonumber(arg and arg[2]) or 3200
+
+local function measure(text, config, userData)
+	return { width = #text * 8, height = 16 }
+end
+
+local function build_grow(k)
+	llay.Element({
+		layout = { sizing = { width = "GROW", height = "GROW" }, childGap = 1 },
+	}, function()
+		for i = 0, k - 1 do
+			llay.Element({
+				layout = {
+					sizing = {
+						width = { type = llay.SizingType.GROW, min = i * 0.1, max = 8 + i * 0.2 },
+						height = 20,
+					},
+				},
+				backgroundColor = { 200, 60, 60, 255 },
+			})
+		end
+	end)
+end
+
+local function build_compress(k)
+	llay.Element({
+		layout = { sizing = { width = "GROW", height = "GROW" } },
+	}, function()
+		for i = 0, k - 1 do
+			llay.Element({
+				layout = {
+					sizing = { width = { type = llay.SizingType.GROW, min = 2 + i % 5 }, height = 20 },
+					padding = 2,
+				},
+				backgroundColor = { 60, 200, 60, 255 },
+			}, function()
+				llay.Element({ layout = { sizing = { width = 20 + i * 0.1, height = 10 } } })
+			end)
+		end
+	end)
+end
+
+local function time_layout(build, k, width)
+	llay.set_dimensions(width, 600)
+	for _ = 1, 5 do
+		llay.begin_layout()
+		build(k)
+		llay.end_layout()
+	end
+	local t0 = os.clock()
+	for _ = 1, FRAMES do
+		llay.begin_layout()
+		build(k)
+		llay.end_layout()
+	end
+	return (os.clock() - t0) * 1000 / FRAMES
+end
+
+llay.init({ capacity = 1024 * 1024 * 64, width = 1920, height = 1080 })
+llay.set_measure_text_function(measure)
+
+print(string.format("frames/size: %d%s", FRAMES, jit and (", " .. jit.version) or ""))
+print(string.format("%8s %12s %12s %12s %12s", "children", "grow ms", "us/child", "compress ms", "us/child"))
+local k = 100
+while k <= MAX_CHILDREN do
+	-- Wide enough that some but not all GROW children reach their maximum; narrow
+	-- enough that every compressed child gives up space
+	local grow = time_layout(build_grow, k, k * (8 + k * 0.15))
+	local compress = time_layout(build_compress, k, k * (12 + k * 0.05))
+	print(string.format("%8d %12.3f %12.3f %12.3f %12.3f", k, grow, grow * 1000 / k, compress, compress * 1000 / k))
+	k = k * 2
+end
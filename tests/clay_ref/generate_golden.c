@@ -558,6 +558,176 @@ void golden_border_between_children() {
     fclose(f);
 }
 
+// 600 children sharing a wide row: GROW with min/max, GROW with min, FIXED, FIT
+void golden_wide_row_grow() {
+    FILE *f = fopen("golden_wide_row_grow.txt", "w");
+    if (!f) return;
+
+    Clay_SetLayoutDimensions((Clay_Dimensions){.width = 12000, .height = 600});
+    Clay_BeginLayout();
+
+    Clay_ElementDeclaration root = CLAY__DEFAULT_STRUCT;
+    root.layout.sizing.width.type = CLAY__SIZING_TYPE_GROW;
+    root.layout.sizing.height.type = CLAY__SIZING_TYPE_GROW;
+    root.layout.layoutDirection = CLAY_LEFT_TO_RIGHT;
+    root.layout.childGap = 1;
+    root.backgroundColor = (Clay_Color){255, 255, 255, 255};
+
+    Clay__OpenElement();
+    Clay__ConfigureOpenElementPtr(&root);
+
+        for (int i = 0; i < 600; i++) {
+            Clay_ElementDeclaration child = CLAY__DEFAULT_STRUCT;
+            switch (i % 4) {
+                case 0:
+                    child.layout.sizing.width.type = CLAY__SIZING_TYPE_GROW;
+                    child.layout.sizing.width.size.minMax.min = (i % 13) * 3;
+                    child.layout.sizing.width.size.minMax.max = 10 + (i % 17) * 2;
+                    child.backgroundColor = (Clay_Color){255, 0, 0, 255};
+                    break;
+                case 1:
+                    child.layout.sizing.width.type = CLAY__SIZING_TYPE_GROW;
+                    child.layout.sizing.width.size.minMax.min = (i % 11) * 2;
+                    child.layout.sizing.width.size.minMax.max = CLAY__MAXFLOAT;
+                    child.backgroundColor = (Clay_Color){0, 255, 0, 255};
+                    break;
+                case 2:
+                    child.layout.sizing.width.type = CLAY__SIZING_TYPE_FIXED;
+                    child.layout.sizing.width.size.minMax.min = 5 + i % 9;
+                    child.layout.sizing.width.size.minMax.max = 5 + i % 9;
+                    child.backgroundColor = (Clay_Color){0, 0, 255, 255};
+                    break;
+                default:
+                    child.backgroundColor = (Clay_Color){128, 128, 128, 255};
+                    break;
+            }
+            if (i % 4 != 3) {
+                child.layout.sizing.height.type = CLAY__SIZING_TYPE_FIXED;
+                child.layout.sizing.height.size.minMax.min = 20;
+                child.layout.sizing.height.size.minMax.max = 20;
+            }
+            Clay__OpenElement();
+            Clay__ConfigureOpenElementPtr(&child);
+
+                if (i % 4 == 3) {
+                    Clay_ElementDeclaration inner = CLAY__DEFAULT_STRUCT;
+                    inner.layout.sizing.width.type = CLAY__SIZING_TYPE_FIXED;
+                    inner.layout.sizing.width.size.minMax.min = 3 + i % 5;
+                    inner.layout.sizing.width.size.minMax.max = 3 + i % 5;
+                    inner.layout.sizing.height.type = CLAY__SIZING_TYPE_FIXED;
+                    inner.layout.sizing.height.size.minMax.min = 10;
+                    inner.layout.sizing.height.size.minMax.max = 10;
+                    inner.backgroundColor = (Clay_Color){0, 0, 0, 255};
+                    Clay__OpenElement();
+                    Clay__ConfigureOpenElementPtr(&inner);
+                    Clay__CloseElement();
+                }
+
+            Clay__CloseElement();
+        }
+
+    Clay__CloseElement();
+
+    Clay_RenderCommandArray commands = Clay_EndLayout();
+    Clay_SetLayoutDimensions((Clay_Dimensions){.width = 800, .height = 600});
+
+    fprintf(f, "commands_count=%d\n", commands.length);
+    for (int i = 0; i < commands.length; i++) {
+        Clay_RenderCommand cmd = commands.internalArray[i];
+        fprintf(f, "cmd[%d]: id=%u type=%d bbox={x=%f,y=%f,w=%f,h=%f}\n",
+            i, cmd.id, cmd.commandType,
+            cmd.boundingBox.x, cmd.boundingBox.y,
+            cmd.boundingBox.width, cmd.boundingBox.height);
+    }
+
+    fclose(f);
+}
+
+// 600 children squeezed into a row narrower than their content: wrapping text,
+// padded FIT containers and GROW children with a minimum
+void golden_wide_row_compress() {
+    FILE *f = fopen("golden_wide_row_compress.txt", "w");
+    if (!f) return;
+
+    // Clay keeps pointers to the strings until the layout is done
+    static char texts[600][24];
+
+    Clay_SetLayoutDimensions((Clay_Dimensions){.width = 16000, .height = 600});
+    Clay_BeginLayout();
+
+    Clay_ElementDeclaration root = CLAY__DEFAULT_STRUCT;
+    root.layout.sizing.width.type = CLAY__SIZING_TYPE_GROW;
+    root.layout.sizing.height.type = CLAY__SIZING_TYPE_GROW;
+    root.layout.layoutDirection = CLAY_LEFT_TO_RIGHT;
+    root.backgroundColor = (Clay_Color){255, 255, 255, 255};
+
+    Clay__OpenElement();
+    Clay__ConfigureOpenElementPtr(&root);
+
+        for (int i = 0; i < 600; i++) {
+            if (i % 3 == 0) {
+                int length = 0;
+                for (int k = 0; k < 1 + i % 4; k++) texts[i][length++] = 'a';
+                texts[i][length++] = ' ';
+                for (int k = 0; k < 2 + i % 6; k++) texts[i][length++] = 'b';
+                texts[i][length++] = ' ';
+                for (int k = 0; k < 1 + i % 3; k++) texts[i][length++] = 'c';
+                Clay_TextElementConfig text = {0};
+                text.fontSize = 16;
+                text.textColor = (Clay_Color){0, 0, 0, 255};
+                Clay__OpenTextElement((Clay_String){.length = length, .chars = texts[i]}, Clay__StoreTextElementConfig(text));
+            } else if (i % 3 == 1) {
+                Clay_ElementDeclaration box = CLAY__DEFAULT_STRUCT;
+                box.layout.padding = (Clay_Padding){2, 2, 2, 2};
+                box.backgroundColor = (Clay_Color){128, 128, 128, 255};
+                Clay__OpenElement();
+                Clay__ConfigureOpenElementPtr(&box);
+
+                    Clay_ElementDeclaration inner = CLAY__DEFAULT_STRUCT;
+                    inner.layout.sizing.width.type = CLAY__SIZING_TYPE_FIXED;
+                    inner.layout.sizing.width.size.minMax.min = 4 + i % 7;
+                    inner.layout.sizing.width.size.minMax.max = 4 + i % 7;
+                    inner.layout.sizing.height.type = CLAY__SIZING_TYPE_FIXED;
+                    inner.layout.sizing.height.size.minMax.min = 10;
+                    inner.layout.sizing.height.size.minMax.max = 10;
+                    inner.backgroundColor = (Clay_Color){0, 0, 0, 255};
+                    Clay__OpenElement();
+                    Clay__ConfigureOpenElementPtr(&inner);
+                    Clay__CloseElement();
+
+                Clay__CloseElement();
+            } else {
+                Clay_ElementDeclaration grow = CLAY__DEFAULT_STRUCT;
+                grow.layout.sizing.width.type = CLAY__SIZING_TYPE_GROW;
+                grow.layout.sizing.width.size.minMax.min = 2 + i % 5;
+                grow.layout.sizing.width.size.minMax.max = CLAY__MAXFLOAT;
+                grow.layout.sizing.height.type = CLAY__SIZING_TYPE_FIXED;
+                grow.layout.sizing.height.size.minMax.min = 20;
+                grow.layout.sizing.height.size.minMax.max = 20;
+                grow.backgroundColor = (Clay_Color){0, 255, 0, 255};
+                Clay__OpenElement();
+                Clay__ConfigureOpenElementPtr(&grow);
+                Clay__CloseElement();
+            }
+        }
+
+    Clay__CloseElement();
+
+    Clay_RenderCommandArray commands = Clay_EndLayout();
+    Clay_SetLayoutDimensions((Clay_Dimensions){.width = 800, .height = 600});
+
+    fprintf(f, "commands_count=%d\n", commands.length);
+    for (int i = 0; i < commands.length; i++) {
+        Clay_RenderCommand cmd = commands.internalArray[i];
+        fprintf(f, "cmd[%d]: id=%u type=%d bbox={x=%f,y=%f,w=%f,h=%f}\n",
+            i, cmd.id, cmd.commandType,
+            cmd.boundingBox.x, cmd.boundingBox.y,
+            cmd.boundingBox.width, cmd.boundingBox.height);
+    }
+
+    fclose(f);
+}
+
 int main() {
     size_t arenaSize = 1024 * 1024 * 16;
     char *arenaMemory = malloc(arenaSize);
@@ -611,6 +781,14 @@ int main() {
     arena.nextAllocation = sizeof(Clay_Context);
     context->generation++;
     golden_border_between_children();
+
+    arena.nextAllocation = sizeof(Clay_Context);
+    context->generation++;
+    golden_wide_row_grow();
+
+    arena.nextAllocation = sizeof(Clay_Context);
+    context->generation++;
+    golden_wide_row_compress();
     
     free(arenaMemory);
     return 0;
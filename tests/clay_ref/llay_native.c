@@ -0,0 +1,35 @@
+// Trampolines for the native engine (src/llay_native.lua).
+//
+// Clay's measure text callback returns Clay_Dimensions by value and takes a
+// Clay_StringSlice by value, which LuaJIT FFI callbacks cannot do. This shim
+// exposes a C function with Clay's signature that forwards to a pointer-only
+// callback created from Lua. It only mirrors the few Clay types it touches, so
+// it builds without clay.h.
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct {
+    float width, height;
+} Llay_NativeDimensions;
+
+typedef struct {
+    int32_t length;
+    const char *chars;
+    const char *baseChars;
+} Llay_NativeStringSlice;
+
+typedef void (*Llay_NativeMeasureFn)(const char *chars, int32_t length, void *config, void *userData, Llay_NativeDimensions *out);
+
+static Llay_NativeMeasureFn measure_fn = NULL;
+
+void Llay_NativeSetMeasureText(Llay_NativeMeasureFn fn) {
+    measure_fn = fn;
+}
+
+Llay_NativeDimensions Llay_NativeMeasureText(Llay_NativeStringSlice text, void *config, void *userData) {
+    Llay_NativeDimensions out = { 0, 0 };
+    if (measure_fn) {
+        measure_fn(text.chars, text.length, config, userData, &out);
+    }
+    return out;
+}
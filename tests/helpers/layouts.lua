@@ -270,4 +270,86 @@ layouts.border_between_children = function()
 	return clay.end_layout()
 end
 
+-- Wide row, grow pass: 600 siblings mixing capped and uncapped GROW, FIXED and FIT.
+-- 12000px wide so nothing is culled.
+layouts.wide_row_grow = function()
+	clay.set_dimensions(12000, 600)
+	clay.begin_layout()
+	clay.Element({
+		layout = {
+			sizing = { width = "GROW", height = "GROW" },
+			layoutDirection = clay.LayoutDirection.LEFT_TO_RIGHT,
+			childGap = 1,
+		},
+		backgroundColor = { 255, 255, 255, 255 },
+	}, function()
+		for i = 0, 599 do
+			local kind = i % 4
+			if kind == 0 then
+				clay.Element({
+					layout = { sizing = { width = { type = clay.SizingType.GROW, min = (i % 13) * 3, max = 10 + (i % 17) * 2 }, height = 20 } },
+					backgroundColor = { 255, 0, 0, 255 },
+				})
+			elseif kind == 1 then
+				clay.Element({
+					layout = { sizing = { width = { type = clay.SizingType.GROW, min = (i % 11) * 2 }, height = 20 } },
+					backgroundColor = { 0, 255, 0, 255 },
+				})
+			elseif kind == 2 then
+				clay.Element({
+					layout = { sizing = { width = 5 + i % 9, height = 20 } },
+					backgroundColor = { 0, 0, 255, 255 },
+				})
+			else
+				clay.Element({ backgroundColor = { 128, 128, 128, 255 } }, function()
+					clay.Element({
+						layout = { sizing = { width = 3 + i % 5, height = 10 } },
+						backgroundColor = { 0, 0, 0, 255 },
+					})
+				end)
+			end
+		end
+	end)
+	local commands = clay.end_layout()
+	clay.set_dimensions(800, 600)
+	return commands
+end
+
+-- Wide row, compress pass: 600 siblings whose content overflows the row. Wrapping
+-- text shrinks toward its longest word; FIT and GROW siblings sit at their minimum.
+layouts.wide_row_compress = function()
+	clay.set_dimensions(16000, 600)
+	clay.begin_layout()
+	clay.Element({
+		layout = {
+			sizing = { width = "GROW", height = "GROW" },
+			layoutDirection = clay.LayoutDirection.LEFT_TO_RIGHT,
+		},
+		backgroundColor = { 255, 255, 255, 255 },
+	}, function()
+		for i = 0, 599 do
+			local kind = i % 3
+			if kind == 0 then
+				local text = string.rep("a", 1 + i % 4) .. " " .. string.rep("b", 2 + i % 6) .. " " .. string.rep("c", 1 + i % 3)
+				clay.Text(text, { fontSize = 16, color = { 0, 0, 0, 255 } })
+			elseif kind == 1 then
+				clay.Element({ layout = { padding = { 2, 2, 2, 2 } }, backgroundColor = { 128, 128, 128, 255 } }, function()
+					clay.Element({
+						layout = { sizing = { width = 4 + i % 7, height = 10 } },
+						backgroundColor = { 0, 0, 0, 255 },
+					})
+				end)
+			else
+				clay.Element({
+					layout = { sizing = { width = { type = clay.SizingType.GROW, min = 2 + i % 5 }, height = 20 } },
+					backgroundColor = { 0, 255, 0, 255 },
+				})
+			end
+		end
+	end)
+	local commands = clay.end_layout()
+	clay.set_dimensions(800, 600)
+	return commands
+end
+
 return layouts
@@ -0,0 +1,107 @@
+local ffi = require("ffi")
+local clay = require("init") -- Uses the public API
+
+-- Small scenes for the pixel goldens (tests/clay_ref/golden_raster_*.ppm): each
+-- returns the frame's render commands and the raster size. Text is measured with
+-- the rasterizer's own font, so run.lua installs llay_raster.measure_text first.
+local scenes = {}
+
+local WIDTH, HEIGHT = 160, 120
+-- Any non-null image handle; the rasterizer draws a placeholder
+local AVATAR = ffi.cast("void*", 1)
+
+-- Rounded rects and borders with per-side widths, a translucent overlay, an image
+-- placeholder, a floating badge and a Custom element drawn through the painter
+scenes.widgets = function()
+	clay.set_dimensions(WIDTH, HEIGHT)
+	clay.begin_layout()
+	clay.Element({
+		layout = {
+			sizing = { width = "GROW", height = "GROW" },
+			layoutDirection = clay.LayoutDirection.TOP_TO_BOTTOM,
+			padding = 6,
+			childGap = 6,
+		},
+		backgroundColor = { 24, 26, 34, 255 },
+	}, function()
+		clay.Element({
+			id = "Card",
+			layout = { sizing = { width = "GROW", height = 44 }, padding = 6, childGap = 6 },
+			backgroundColor = { 52, 58, 84, 255 },
+			cornerRadius = { topLeft = 12, topRight = 4, bottomLeft = 4, bottomRight = 12 },
+			border = { color = { 230, 180, 60, 255 }, width = { left = 4, right = 1, top = 2, bottom = 3 } },
+		}, function()
+			clay.Element({
+				layout = { sizing = { width = 28, height = 28 } },
+				image = { imageData = AVATAR },
+				cornerRadius = 14,
+			})
+			clay.Text("Card title", { fontSize = 8, color = { 240, 240, 240, 255 } })
+			clay.Element({
+				layout = { sizing = { width = 14, height = 10 } },
+				backgroundColor = { 220, 60, 60, 255 },
+				cornerRadius = 5,
+				floating = { attachTo = clay.FloatingAttachToElement.PARENT, attachPoints = { element = 2, parent = 2 }, offset = { x = 4, y = -4 } },
+			})
+		end)
+		clay.Element({ layout = { sizing = { width = "GROW", height = 48 }, childGap = 6 } }, function()
+			clay.Custom({ id = "Gauge", layout = { sizing = { width = 48, height = 48 } } }, function(rect, painter)
+				painter:rect(rect, { r = 40, g = 44, b = 60, a = 255 }, 8)
+				painter:circle({ x = rect.x + 24, y = rect.y + 24 }, 18, { r = 90, g = 200, b = 120, a = 255 })
+				painter:circle({ x = rect.x + 24, y = rect.y + 24 }, 10, { 40, 44, 60, 255 })
+			end)
+			clay.Element({
+				layout = { sizing = { width = "GROW", height = "GROW" } },
+				backgroundColor = { 60, 140, 230, 255 },
+				border = { color = { 255, 255, 255, 255 }, width = 2 },
+				cornerRadius = 6,
+			}, function()
+				clay.Element({
+					layout = { sizing = { width = 40, height = 20 } },
+					backgroundColor = { 255, 255, 255, 96 },
+					floating = { attachTo = clay.FloatingAttachToElement.PARENT, offset = { x = 10, y = 14 } },
+				})
+			end)
+		end)
+	end)
+	return clay.end_layout(), WIDTH, HEIGHT
+end
+
+-- A scrolled, clipped list of text rows at several sizes, spacings and line heights
+scenes.scroll_text = function()
+	clay.set_dimensions(WIDTH, HEIGHT)
+	clay.begin_layout()
+	clay.Element({
+		layout = { sizing = { width = "GROW", height = "GROW" }, padding = 8 },
+		backgroundColor = { 250, 250, 245, 255 },
+	}, function()
+		clay.Element({
+			layout = {
+				sizing = { width = "GROW", height = "GROW" },
+				layoutDirection = clay.LayoutDirection.TOP_TO_BOTTOM,
+				padding = 4,
+				childGap = 2,
+			},
+			backgroundColor = { 230, 232, 240, 255 },
+			border = { color = { 120, 120, 140, 255 }, width = 1 },
+			clip = { vertical = true, childOffset = { x = 0, y = -10 } },
+		}, function()
+			for i = 1, 8 do
+				clay.Element({
+					layout = { sizing = { width = "GROW" }, padding = { 2, 2, 1, 1 } },
+					backgroundColor = i % 2 == 0 and { 210, 214, 228, 255 } or { 0, 0, 0, 0 },
+				}, function()
+					clay.Text("Row " .. i .. ": The quick brown fox", {
+						fontSize = 8 + (i % 3) * 4,
+						letterSpacing = i % 2,
+						lineHeight = i == 4 and 20 or 0,
+						color = { 20 * i, 40, 90, 255 },
+					})
+				end)
+			end
+		end)
+	end)
+	return clay.end_layout(), WIDTH, HEIGHT
+end
+
+return scenes
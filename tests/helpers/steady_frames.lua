@@ -0,0 +1,73 @@
+-- Heap growth of a repeated frame, run in its own process by the steady-frame
+-- regression test so JIT tuning and trace state don't leak into the rest of the suite.
+-- Prints "interpreted=<bytes per frame> compiled=<bytes per frame>".
+package.path = "./src/?.lua;./?.lua;" .. package.path
+local llay = require("init")
+
+llay.tune_jit_for_layout()
+llay.init({ width = 800, height = 600 })
+llay.set_measure_text_function(function(text, config, userData)
+	return { width = #text * 10, height = 20 }
+end)
+
+local column = llay.compile({
+	layout = { sizing = { width = "GROW", height = "GROW" }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM },
+})
+local row = llay.compile({
+	layout = { sizing = { width = "GROW" }, padding = 4, childGap = 4 },
+	backgroundColor = { 50, 50, 60, 255 },
+	cornerRadius = 4,
+	border = { width = 1, color = { 80, 80, 90, 255 } },
+})
+local icon = llay.compile({ layout = { sizing = { width = 10, height = 10 } }, backgroundColor = { 200, 90, 90, 255 } })
+local label = llay.compile({ fontSize = 16, color = { 255, 255, 255, 255 } })
+local labels = {}
+for i = 1, 20 do
+	labels[i] = "Row " .. i .. " label"
+end
+local i = 0
+local function row_children()
+	llay.Element(icon)
+	llay.Text(labels[i], label)
+end
+local function rows()
+	for r = 1, 20 do
+		i = r
+		llay.Element(row, row_children)
+	end
+end
+local function frame()
+	llay.begin_layout()
+	llay.Element(column, rows)
+	llay.end_layout()
+	llay.set_pointer_state(100, 120, false)
+	llay.update_scroll_containers(false, 0, 0, 1 / 60)
+	llay.needs_frame()
+end
+-- One loop for warm-up and measurement, so measuring compiles nothing new
+local function run(frames)
+	for _ = 1, frames do
+		frame()
+	end
+end
+-- The first frame after a full collection still allocates a little, so the window
+-- starts a few frames later
+local function growth(frames)
+	collectgarbage("collect")
+	run(10)
+	collectgarbage("stop")
+	local before = collectgarbage("count")
+	run(frames)
+	local grown = (collectgarbage("count") - before) * 1024
+	collectgarbage("restart")
+	return grown / frames
+end
+
+-- The cold frame and the interpreted window keep cache misses out of the trace
+-- heuristics
+jit.off()
+frame()
+local interpreted = growth(20)
+jit.on()
+run(2000)
+print(string.format("interpreted=%d compiled=%d", interpreted, growth(1000)))
@@ -0,0 +1,6 @@
+-- Setup module for worker tests: runs inside the worker's LuaJIT state
+local mock = require("tests.helpers.mock")
+
+return function(llay)
+	llay.set_measure_text_function(mock.create_mock_measure())
+end
@@ -17,8 +17,8 @@ local function run_test(name, fn)
 	return false
 end
 
-local function compare_with_golden(test_name, golden_file)
-	print("Test: " .. test_name)
+local function compare_with_golden(test_name, golden_file, label)
+	print("Test: " .. (label or test_name))
 
 	-- Run Lua (layout functions handle begin/end_layout internally)
 	local clay = require("init")
@@ -35,7 +35,7 @@ local function compare_with_golden(test_name, golden_file)
 	-- Read golden file
 	local golden = {}
 	for line in io.lines("tests/clay_ref/" .. golden_file) do
-		local id, type_str, bbox_str = line:match("cmd%[(%d)%]: id=.- type=(%d) bbox=(.*)")
+		local id, type_str, bbox_str = line:match("cmd%[(%d+)%]: id=.- type=(%d) bbox=(.*)")
 		if id then
 			local x, y, w, h = bbox_str:match("{x=(.-),y=(.-),w=(.-),h=(.-)}")
 			table.insert(golden, {
@@ -106,6 +106,8 @@ local tests = {
 	{ name = "aspect_ratio", file = "golden_aspect_ratio.txt" },
 	{ name = "fit_sizing", file = "golden_fit_sizing.txt" },
 	{ name = "border_between_children", file = "golden_border_between_children.txt" },
+	{ name = "wide_row_grow", file = "golden_wide_row_grow.txt" },
+	{ name = "wide_row_compress", file = "golden_wide_row_compress.txt" },
 }
 
 for _, test in ipairs(tests) do
@@ -116,6 +118,135 @@ for _, test in ipairs(tests) do
 	end
 end
 
+-- Same golden suite with incremental layout on. Each layout runs once to fill the
+-- subtree memo, so the compared frame is the one served from it.
+clay.set_incremental_layout_enabled(true)
+for _, test in ipairs(tests) do
+	require("tests.helpers.layouts")[test.name]()
+	if compare_with_golden(test.name, test.file, test.name .. " (incremental)") then
+		passed = passed + 1
+	else
+		failed = failed + 1
+	end
+end
+clay.set_incremental_layout_enabled(false)
+
+-- Pixel goldens: scenes from tests/helpers/raster_scenes.lua drawn by the software
+-- rasterizer and compared byte for byte with tests/clay_ref/golden_raster_<scene>.ppm.
+-- LLAY_UPDATE_PIXEL_GOLDENS=1 rewrites the files instead.
+local function compare_pixels(name, scene)
+	print("Test: pixels " .. name)
+	-- Floating elements attach to their parent's box from the previous frame, so the
+	-- second frame is the settled one
+	scene()
+	local commands, width, height = scene()
+	local ppm = clay.new_raster(width, height):draw(commands):to_ppm()
+	local path = "tests/clay_ref/golden_raster_" .. name .. ".ppm"
+
+	if os.getenv("LLAY_UPDATE_PIXEL_GOLDENS") == "1" then
+		local file = assert(io.open(path, "wb"))
+		file:write(ppm)
+		file:close()
+		print("  PASS - Golden written to " .. path)
+		return true
+	end
+
+	local file = io.open(path, "rb")
+	if not file then
+		print("  FAIL: Missing " .. path .. " (run with LLAY_UPDATE_PIXEL_GOLDENS=1)")
+		return false
+	end
+	local golden = file:read("*a")
+	file:close()
+	if #golden ~= #ppm then
+		print(string.format("  FAIL: Image size differs (golden %d bytes, got %d)", #golden, #ppm))
+		return false
+	end
+	local header = #ppm - width * height * 3
+	local differing, first = 0, nil
+	for i = header + 1, #ppm, 3 do
+		if golden:sub(i, i + 2) ~= ppm:sub(i, i + 2) then
+			differing = differing + 1
+			first = first or (i - header - 1) / 3
+		end
+	end
+	if differing > 0 then
+		print(string.format("  FAIL: %d pixels differ, first at (%d, %d)", differing, first % width, math.floor(first / width)))
+		return false
+	end
+	print("  PASS - Pixels match golden")
+	return true
+end
+
+local raster_scenes = require("tests.helpers.raster_scenes")
+clay.set_measure_text_function(require("llay_raster").measure_text)
+for _, name in ipairs({ "widgets", "scroll_text" }) do
+	if compare_pixels(name, raster_scenes[name]) then
+		passed = passed + 1
+	else
+		failed = failed + 1
+	end
+end
+clay.set_measure_text_function(require("tests.helpers.mock").create_mock_measure())
+
+-- Same golden suite on the compiled Clay engine (make native), each frame also
+-- diffed command by command against the Lua engine.
+local function snapshot_commands(cmds)
+	local out = {}
+	for i = 0, tonumber(cmds.length) - 1 do
+		local c = cmds.internalArray[i]
+		local bb = c.boundingBox
+		out[i + 1] = { type = tonumber(c.commandType), x = bb.x, y = bb.y, w = bb.width, h = bb.height }
+	end
+	return out
+end
+
+-- Anonymous element ids are derived differently by the two engines, so only
+-- command type and bounding box are compared here
+local function compare_engines(test_name, expected, cmds)
+	local got = snapshot_commands(cmds)
+	if #got ~= #expected then
+		print(string.format("  FAIL: %s command count differs (lua=%d, native=%d)", test_name, #expected, #got))
+		return false
+	end
+	for i, e in ipairs(expected) do
+		local g = got[i]
+		if g.type ~= e.type or math.abs(g.x - e.x) > 0.01 or math.abs(g.y - e.y) > 0.01
+			or math.abs(g.w - e.w) > 0.01 or math.abs(g.h - e.h) > 0.01 then
+			print(string.format("  FAIL: %s command %d differs between engines (lua type=%d %.1f,%.1f %.1fx%.1f; native type=%d %.1f,%.1f %.1fx%.1f)",
+				test_name, i - 1, e.type, e.x, e.y, e.w, e.h, g.type, g.x, g.y, g.w, g.h))
+			return false
+		end
+	end
+	return true
+end
+
+local native_ok, native_err = require("llay_native").load()
+if native_ok then
+	local lua_snapshots = {}
+	for _, test in ipairs(tests) do
+		lua_snapshots[test.name] = snapshot_commands(require("tests.helpers.layouts")[test.name]())
+	end
+	clay.init({ engine = "native", capacity = 1024 * 1024 * 16 })
+	clay.set_measure_text_function(require("tests.helpers.mock").create_mock_measure())
+	for _, test in ipairs(tests) do
+		local ok = compare_with_golden(test.name, test.file, test.name .. " (native)")
+		if ok then
+			ok = compare_engines(test.name, lua_snapshots[test.name], require("tests.helpers.layouts")[test.name]())
+		end
+		if ok then
+			passed = passed + 1
+		else
+			failed = failed + 1
+		end
+	end
+	clay.init(1024 * 1024 * 16)
+	clay.set_measure_text_function(require("tests.helpers.mock").create_mock_measure())
+else
+	print("Test: native engine parity")
+	print("  SKIP: " .. native_err)
+end
+
 -- Regression tests (engine invariants not covered by the C golden diffs)
 local regressions = require("tests.test_regressions")
 for _, t in ipairs(regressions) do
@@ -609,6 +609,1982 @@ local function run_get_hit_path_parent_bubbling_regression()
 	end
 end
 
+local function build_incremental_scene(variant)
+	llay.begin_layout()
+	llay.Element({
+		layout = {
+			sizing = { width = "GROW", height = "GROW" },
+			layoutDirection = llay.LayoutDirection.LEFT_TO_RIGHT,
+			padding = 8,
+			childGap = 8,
+		},
+	}, function()
+		llay.Element({
+			id = "Sidebar",
+			layout = {
+				sizing = { width = { percent = 0.25 }, height = "GROW" },
+				layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM,
+				childGap = 4,
+				padding = 4,
+			},
+			backgroundColor = { 40, 40, 40, 255 },
+		}, function()
+			for i = 1, 6 do
+				llay.Element({
+					id = llay.IDI("Item", i),
+					layout = { sizing = { width = "GROW", height = 24 }, childAlignment = { llay.AlignX.CENTER, llay.AlignY.CENTER } },
+					backgroundColor = { 80, 80, 80, 255 },
+				}, function()
+					llay.Text("Item " .. i)
+				end)
+			end
+		end)
+		llay.Element({
+			id = "Content",
+			layout = {
+				sizing = { width = "GROW", height = "GROW" },
+				layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM,
+				childGap = 6,
+			},
+			clip = { vertical = true },
+		}, function()
+			for i = 1, 4 do
+				llay.Element({
+					layout = { sizing = { width = "GROW", height = "FIT" }, padding = 4 },
+					border = { color = { 0, 0, 0, 255 }, width = 1 },
+				}, function()
+					llay.Text("the quick brown fox jumps over the lazy dog " .. i, { wrapMode = llay.TextWrap.WORDS })
+				end)
+			end
+			llay.Element({
+				id = "Changing",
+				layout = { sizing = { width = variant * 10, height = 30 } },
+				backgroundColor = { 255, 0, 0, 255 },
+			})
+		end)
+	end)
+	return llay.end_layout()
+end
+
+local function snapshot_commands(commands)
+	local snap = {}
+	for i = 0, tonumber(commands.length) - 1 do
+		local cmd = commands.internalArray[i]
+		local bb = cmd.boundingBox
+		snap[#snap + 1] = string.format("%d %u %.3f %.3f %.3f %.3f", tonumber(cmd.commandType), tonumber(cmd.id), bb.x, bb.y, bb.width, bb.height)
+	end
+	return snap
+end
+
+local function run_incremental_layout_matches_full_layout_regression()
+	local variants = { 5, 5, 5, 12, 12, 5 }
+
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(640, 360)
+	llay.set_measure_text_function(function(text, config, userData)
+		return { width = #text * 10, height = 20 }
+	end)
+	local expected = {}
+	for f, variant in ipairs(variants) do
+		expected[f] = snapshot_commands(build_incremental_scene(variant))
+	end
+
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(640, 360)
+	llay.set_measure_text_function(function(text, config, userData)
+		return { width = #text * 10, height = 20 }
+	end)
+	llay.set_incremental_layout_enabled(true)
+	for f, variant in ipairs(variants) do
+		local got = snapshot_commands(build_incremental_scene(variant))
+		assert(#got == #expected[f], string.format("frame %d: command count %d vs %d", f, #got, #expected[f]))
+		for i = 1, #got do
+			assert(got[i] == expected[f][i], string.format("frame %d cmd %d: expected '%s', got '%s'", f, i, expected[f][i], got[i]))
+		end
+		if f == 2 or f == 3 then
+			assert(llay.get_layout_memo_reused_count() > 0, "expected unchanged subtrees to be reused on frame " .. f)
+		end
+	end
+end
+
+local function build_style_scene(styles, highlight)
+	llay.begin_layout()
+	if styles then
+		llay.Element(styles.root, function()
+			for i = 1, 3 do
+				llay.Element(llay.IDI("Row", i), styles.row, i == highlight and styles.highlight or nil, function()
+					llay.Text("row " .. i, styles.label)
+					llay.Element(styles.badge)
+				end)
+			end
+		end)
+	else
+		llay.Element({
+			layout = { sizing = { width = "GROW", height = "GROW" }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM, padding = 4, childGap = 2 },
+		}, function()
+			for i = 1, 3 do
+				llay.Element(llay.IDI("Row", i), {
+					layout = { sizing = { width = "GROW", height = 30 }, childGap = 4, childAlignment = { llay.AlignX.LEFT, llay.AlignY.CENTER } },
+					backgroundColor = i == highlight and { 200, 100, 0, 255 } or { 60, 60, 60, 255 },
+					cornerRadius = 4,
+				}, function()
+					llay.Text("row " .. i, { fontSize = 16, color = { 255, 255, 255, 255 } })
+					llay.Element({
+						layout = { sizing = { width = 10, height = 10 } },
+						backgroundColor = { 0, 255, 0, 255 },
+						floating = { attachTo = llay.FloatingAttachToElement.PARENT, offset = { x = -5, y = -5 } },
+					})
+				end)
+			end
+		end)
+	end
+	return llay.end_layout()
+end
+
+local function snapshot_commands_with_color(commands)
+	local snap = snapshot_commands(commands)
+	for i = 0, tonumber(commands.length) - 1 do
+		local cmd = commands.internalArray[i]
+		if cmd.commandType == llay._core.Llay_RenderCommandType.RECTANGLE then
+			local c = cmd.renderData.rectangle.backgroundColor
+			snap[i + 1] = snap[i + 1] .. string.format(" rgba(%d,%d,%d,%d)", c.r, c.g, c.b, c.a)
+		end
+	end
+	return snap
+end
+
+local function run_compiled_styles_match_table_configs_regression()
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(320, 200)
+	llay.set_measure_text_function(function(text, config, userData)
+		return { width = #text * 8, height = config.fontSize }
+	end)
+
+	local styles = {
+		root = llay.style({
+			layout = { sizing = { width = "GROW", height = "GROW" }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM, padding = 4, childGap = 2 },
+		}),
+		row = llay.compile({
+			layout = { sizing = { width = "GROW", height = 30 }, childGap = 4, childAlignment = { llay.AlignX.LEFT, llay.AlignY.CENTER } },
+			backgroundColor = { 60, 60, 60, 255 },
+			cornerRadius = 4,
+		}),
+		highlight = { backgroundColor = { 200, 100, 0, 255 } },
+		label = llay.compile({ fontSize = 16, color = { 255, 255, 255, 255 } }),
+		badge = llay.compile({
+			layout = { sizing = { width = 10, height = 10 } },
+			backgroundColor = { 0, 255, 0, 255 },
+			floating = { attachTo = llay.FloatingAttachToElement.PARENT, offset = { x = -5, y = -5 } },
+		}),
+	}
+	assert(llay.is_compiled(styles.row), "compile should return a compiled style")
+	assert(not pcall(function()
+		styles.row.extra = true
+	end), "compiled styles should reject new fields")
+
+	-- Highlight moves between frames; the shared badge style must not keep the previous parentId.
+	-- Floating roots attached to PARENT read last frame's parent bbox, so compare settled frames.
+	for frame, highlight in ipairs({ 1, 2, 2, 3 }) do
+		build_style_scene(nil, highlight)
+		local expected = snapshot_commands_with_color(build_style_scene(nil, highlight))
+		build_style_scene(styles, highlight)
+		local got = snapshot_commands_with_color(build_style_scene(styles, highlight))
+		assert(#got == #expected, string.format("frame %d: command count %d vs %d", frame, #got, #expected))
+		for i = 1, #got do
+			assert(got[i] == expected[i], string.format("frame %d cmd %d: expected '%s', got '%s'", frame, i, expected[i], got[i]))
+		end
+	end
+end
+
+local function run_compiled_custom_matches_table_custom_regression()
+	local CUSTOM = llay._core.Llay_RenderCommandType.CUSTOM
+	local CONFIGS = {
+		{
+			id = "Nested",
+			layout = { sizing = { width = 40, height = 30 }, padding = 2 },
+			backgroundColor = { 10, 20, 30, 255 },
+			cornerRadius = 6,
+			border = { color = { 255, 0, 0, 255 }, width = { left = 1, right = 1, top = 1, bottom = 1 } },
+		},
+		-- Layout fields at the top level, as Custom has always accepted them
+		{ id = "Flat", sizing = { width = 24, height = 12 }, backgroundColor = { 1, 2, 3, 255 } },
+		{ id = 7, layout = { sizing = { width = "GROW", height = 10 } }, cornerRadius = 3 },
+	}
+	local function frame(configs)
+		llay.begin_layout()
+		llay.Element({ layout = { sizing = { width = "GROW", height = "GROW" }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM, childGap = 2 } }, function()
+			for i = 1, #configs do
+				llay.Custom(configs[i], function() end)
+			end
+		end)
+		local commands = llay.end_layout()
+		local snap = snapshot_commands_with_color(commands)
+		for i = 0, tonumber(commands.length) - 1 do
+			local cmd = commands.internalArray[i]
+			if cmd.commandType == CUSTOM then
+				local custom = cmd.renderData.custom
+				local c = custom.backgroundColor
+				snap[i + 1] = snap[i + 1] .. string.format(" rgba(%d,%d,%d,%d) r%.1f", c.r, c.g, c.b, c.a, custom.cornerRadius.topLeft)
+			end
+		end
+		return snap
+	end
+
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(200, 200)
+	local compiled = {}
+	for i = 1, #CONFIGS do
+		compiled[i] = llay.compile(CONFIGS[i])
+	end
+	frame(CONFIGS)
+	local expected = frame(CONFIGS)
+	local got = frame(compiled)
+	for i = 1, math.max(#got, #expected) do
+		assert(got[i] == expected[i], string.format("cmd %d: expected '%s', got '%s'", i, tostring(expected[i]), tostring(got[i])))
+	end
+	assert(expected[5]:find(" 24.000 12.000 ", 1, true), "top-level sizing applies")
+	assert(llay.get_render_callback(llay.ID("Flat").id), "callback registered under the config id")
+	assert(llay.get_render_callback(llay._core.Llay__HashNumber(7, 0).id), "number ids hash like Element's")
+end
+
+local function run_interned_ids_match_uncached_hashes_regression()
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(200, 200)
+	local core = llay._core
+
+	-- CLAY_ID values (Clay__HashString with seed 0)
+	local expected_ids = {
+		Sidebar = 2009917136,
+		Item = 104834035,
+		a = 3392050243,
+		Clay__RootContainer = 2268583112,
+	}
+	for _, name in ipairs({ "Sidebar", "Item", "a", "Clay__RootContainer" }) do
+		local handle = llay.ID(name)
+		assert(type(handle) == "cdata", "ID should return a cdata handle")
+		assert(handle == llay.ID(name), "ID should return the same handle for the same string")
+		assert(handle.id == expected_ids[name], string.format("%s: interned id %u vs %u", name, handle.id, expected_ids[name]))
+		assert(ffi.string(handle.stringId.chars, handle.stringId.length) == name, "interned stringId should reference the name")
+
+		for _, index in ipairs({ 0, 1, 7, 1000 }) do
+			local indexed = llay.IDI(name, index)
+			local expected = core.Llay__HashStringWithOffset(name, index, 0)
+			assert(indexed == llay.IDI(name, index), "IDI should return the same handle for the same pair")
+			assert(indexed.id == expected.id and indexed.baseId == expected.baseId and indexed.offset == index,
+				string.format("%s[%d]: interned id does not match uncached hash", name, index))
+		end
+	end
+
+	-- Handles work as element IDs across frames
+	local box = llay.ID("Box")
+	for _ = 1, 2 do
+		llay.begin_layout()
+		llay.Element(box, { layout = { sizing = { width = 50, height = 40 } } })
+		llay.end_layout()
+	end
+	local rect = llay.get_rect(box)
+	assert(rect and rect.width == 50 and rect.height == 40, "element opened with an interned handle should be found by it")
+	local data = llay.get_element_data("Box")
+	assert(data and data.found, "string lookup should resolve to the interned element")
+end
+
+local function build_text_measure_scene()
+	llay.begin_layout()
+	llay.Element({
+		layout = { sizing = { width = 200, height = "GROW" }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM, childGap = 4 },
+	}, function()
+		llay.Text("the quick brown fox jumps over the lazy dog", { fontSize = 20 })
+		llay.Text("line one\nline  two\n\nend ", { fontSize = 20, wrapMode = llay.TextWrap.NEWLINES })
+		llay.Text("spaced out", { fontSize = 40, letterSpacing = 2 })
+		llay.Text("", { fontSize = 20 })
+	end)
+	return llay.end_layout()
+end
+
+local function run_batched_and_glyph_text_measurement_match_callback_regression()
+	-- Monospace metrics: 10px per char at size 20, scaled with fontSize, plus letterSpacing per char
+	local function width_of(len, config)
+		return len * (10 * config.fontSize / 20 + config.letterSpacing)
+	end
+
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(400, 400)
+	llay.set_measure_text_function(function(text, config, userData)
+		return { width = width_of(#text, config), height = config.fontSize }
+	end)
+	local expected = snapshot_commands(build_text_measure_scene())
+
+	-- Batched: one callback per distinct string, no per-word Lua strings
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(400, 400)
+	llay.set_measure_text_function(function()
+		error("per-word callback should not be used while a batch callback is set")
+	end)
+	local batch_calls = 0
+	llay.set_measure_text_batch_function(function(text, words, count, config, userData)
+		batch_calls = batch_calls + 1
+		assert(userData == "ud", "batch callback should receive its userData")
+		for i = 0, count - 1 do
+			words[i].width = width_of(words[i].length, config)
+			words[i].height = config.fontSize
+		end
+	end, "ud")
+	local got = snapshot_commands(build_text_measure_scene())
+	assert(batch_calls == 3, "expected one batch call per non-empty string, got " .. batch_calls)
+	for i = 1, math.max(#got, #expected) do
+		assert(got[i] == expected[i], string.format("batched cmd %d: expected '%s', got '%s'", i, tostring(expected[i]), tostring(got[i])))
+	end
+	llay.set_measure_text_batch_function(nil)
+
+	-- Glyph tables: measured entirely in FFI, scalable table covers fontSize 40
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(400, 400)
+	local advances = {}
+	for c = 0, 255 do
+		advances[c] = 10
+	end
+	llay.set_glyph_advances(0, nil, advances, { baseSize = 20 })
+	got = snapshot_commands(build_text_measure_scene())
+	for i = 1, math.max(#got, #expected) do
+		assert(got[i] == expected[i], string.format("glyph cmd %d: expected '%s', got '%s'", i, tostring(expected[i]), tostring(got[i])))
+	end
+
+	-- Kerning hook adjusts each adjacent pair inside a word
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(400, 400)
+	llay.set_glyph_advances(0, 20, advances, {
+		kerning = function(prev, cur, fontId, fontSize)
+			return (prev == string.byte("A") and cur == string.byte("V")) and -3 or 0
+		end,
+	})
+	llay.begin_layout()
+	llay.Text("AVA", { fontSize = 20 })
+	local commands = llay.end_layout()
+	assert_close(commands.internalArray[0].boundingBox.width, 27, 0.001, "kerned width")
+	llay.clear_glyph_advances()
+end
+
+local function run_glyph_advances_measure_utf8_bytes_regression()
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(800, 400)
+	-- ASCII bytes advance 10, bytes 0x80 and up advance 4
+	local advances = {}
+	for c = 0, 255 do
+		advances[c] = c < 128 and 10 or 4
+	end
+	local pairs_seen = {}
+	llay.set_glyph_advances(0, 20, advances, {
+		kerning = function(prev, cur, fontId, fontSize)
+			pairs_seen[#pairs_seen + 1] = prev * 256 + cur
+			return 0
+		end,
+	})
+	local text = "h\195\169llo w\195\182rld \195\177"
+	llay.begin_layout()
+	llay.Text(text, { fontSize = 20 })
+	local commands = llay.end_layout()
+	local ascii, high = 0, 0
+	for i = 1, #text do
+		if text:byte(i) < 128 then
+			ascii = ascii + 1
+		else
+			high = high + 1
+		end
+	end
+	assert_close(commands.internalArray[0].boundingBox.width, ascii * 10 + high * 4, 0.001, "non-ASCII width")
+	for _, pair in ipairs(pairs_seen) do
+		assert(pair >= 0 and pair < 65536, "kerning receives unsigned bytes")
+	end
+	assert(#pairs_seen > 0, "kerning hook is called")
+	llay.clear_glyph_advances()
+end
+
+local function build_hit_test_scene()
+	llay.begin_layout()
+	llay.Element({
+		id = "Root",
+		layout = { sizing = { width = "GROW", height = "GROW" }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM, padding = 10, childGap = 10 },
+	}, function()
+		llay.Element({
+			id = "Narrow",
+			layout = { sizing = { width = 100, height = 40 } },
+			backgroundColor = { 50, 50, 50, 255 },
+		}, function()
+			-- Overflows its parent: still hittable outside the parent's box
+			llay.Element({ id = "Wide", layout = { sizing = { width = 180, height = 20 } } })
+		end)
+		llay.Element({
+			id = "Row",
+			layout = { sizing = { width = "GROW", height = 60 }, childGap = 5 },
+		}, function()
+			for i = 1, 5 do
+				llay.Element({ id = llay.IDI("Cell", i), layout = { sizing = { width = 40, height = "GROW" }, padding = 4 } }, function()
+					llay.Text("c" .. i, { fontSize = 10 })
+				end)
+			end
+		end)
+		llay.Element({
+			id = "Modal",
+			layout = { sizing = { width = 80, height = 80 } },
+			floating = { attachTo = llay.FloatingAttachToElement.ROOT, offset = { x = 120, y = 30 }, zIndex = 5 },
+		}, function()
+			llay.Element({ id = "ModalButton", layout = { sizing = { width = 30, height = 30 } } })
+		end)
+		llay.Element({
+			id = "Overlay",
+			layout = { sizing = { width = 60, height = 60 } },
+			floating = {
+				attachTo = llay.FloatingAttachToElement.ROOT,
+				offset = { x = 20, y = 20 },
+				zIndex = 10,
+				pointerCaptureMode = llay.PointerCapture.PASSTHROUGH,
+			},
+		})
+	end)
+	return llay.end_layout()
+end
+
+local function run_hit_test_index_matches_tree_walk_regression()
+	local ctx = llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(300, 200)
+	llay.set_measure_text_function(function(text, config, userData)
+		return { width = #text * 6, height = 10 }
+	end)
+	build_hit_test_scene()
+	build_hit_test_scene()
+
+	local points = {}
+	for y = 0, 200, 7 do
+		for x = 0, 300, 7 do
+			points[#points + 1] = { x = x, y = y }
+		end
+	end
+
+	local batch = llay._core.query_points(points)
+	local wide_hit = false
+	for i, p in ipairs(points) do
+		llay.set_pointer_state(p.x, p.y, false)
+		local indexed = llay.get_all_hovered_ids()
+
+		ctx.hitTestIndexValid = false
+		llay.set_pointer_state(p.x, p.y, false)
+		local walked = llay.get_all_hovered_ids()
+		ctx.hitTestIndexValid = true
+
+		local label = string.format("(%d,%d)", p.x, p.y)
+		assert(#indexed == #walked, label .. ": hit count " .. #indexed .. " vs tree walk " .. #walked)
+		assert(#batch[i] == #walked, label .. ": batch hit count differs from tree walk")
+		for j = 1, #walked do
+			assert(indexed[j] == walked[j], label .. ": pointerOverIds order differs from tree walk at " .. j)
+			assert(batch[i][j] == walked[j], label .. ": batch path differs from tree walk at " .. j)
+		end
+		if p.x > 110 and indexed[1] == llay.ID("Wide").id then
+			wide_hit = true
+		end
+	end
+	assert(wide_hit, "expected overflowing child to be hit outside its parent's box")
+	assert(llay.hit_test(125, 35) == llay.ID("ModalButton").id, "hit_test should query the given point")
+	local path = llay.get_hit_path(125, 35)
+	assert(path[1] == llay.ID("ModalButton").id and path[2] == llay.ID("Modal").id and #path == 2,
+		"CAPTURE floating root should block roots behind it")
+end
+
+local function run_profiler_records_phases_and_counters_regression()
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(400, 300)
+	local calls = 0
+	llay.set_measure_text_function(function(text, config, userData)
+		calls = calls + 1
+		return { width = #text * 6, height = 10 }
+	end)
+	local function frame(label)
+		llay.set_pointer_state(10, 10, false)
+		llay.update_scroll_containers(false, 0, 0, 0.016)
+		llay.begin_layout()
+		llay.Element({ layout = { sizing = { width = 120, height = "FIT" }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM } }, function()
+			llay.Text("alpha beta gamma delta", { fontSize = 10 })
+			llay.Text(label, { fontSize = 10 })
+		end)
+		return llay.end_layout()
+	end
+
+	-- Disabled: nothing is recorded
+	frame("idle")
+	assert(llay.get_frame_stats().frame == 0, "profiler should not record while disabled")
+
+	llay.set_profiling_enabled(true, 4)
+	calls = 0
+	local commands = frame("first")
+	local stats = llay.get_frame_stats()
+	assert(stats.frame == 1, "first profiled frame should be numbered 1")
+	assert(stats.elementCount == 4 and stats.textElementCount == 2, "element counts")
+	assert(stats.renderCommandCount == commands.length, "render command count")
+	assert(stats.measureCacheMisses == 1 and stats.measureCacheHits >= 1, "only the new label should miss the cache")
+	assert(stats.measureTextCalls == calls, "measure callback count " .. stats.measureTextCalls .. " vs " .. calls)
+	assert(stats.wrappedLines == 3, "the 120px column wraps the long text onto two lines")
+	assert(stats.hashMapOccupancy >= 4 and stats.hashMapOccupancy <= stats.hashMapCapacity, "hash map occupancy")
+	assert(stats.arenaBytesUsed > 0 and stats.arenaBytesUsed <= stats.arenaCapacity, "arena usage")
+	local phases = stats.sizeXMs + stats.textWrapMs + stats.aspectRatioMs + stats.heightDfsMs + stats.sizeYMs + stats.renderCommandsMs
+	assert(phases >= 0 and phases <= stats.endLayoutMs + 1e-6, "layout phases must fit inside end_layout")
+	assert(stats.pointerStateMs >= 0 and stats.scrollUpdateMs >= 0 and stats.declareMs >= 0, "phase times")
+
+	-- Ring keeps the newest frames and wraps around
+	for i = 1, 6 do
+		frame("again")
+	end
+	local ring, capacity, count, newest = llay.get_frame_stats_history()
+	assert(capacity == 4 and count == 4, "ring should be full at its capacity")
+	assert(ring[newest].frame == 7 and ring[(newest - 3) % capacity].frame == 4, "ring order")
+	assert(llay.get_frame_stats() == llay.get_frame_stats(), "frame stats struct should be reused")
+
+	llay.set_profiling_enabled(false)
+	frame("off")
+	assert(llay.get_frame_stats().frame == 7, "disabling stops recording")
+end
+
+local function build_engine_parity_scene()
+	llay.begin_layout()
+	llay.Element({
+		id = "Root",
+		layout = { sizing = { width = "GROW", height = "GROW" }, padding = 8, childGap = 8 },
+	}, function()
+		llay.Element({
+			id = "Column",
+			layout = {
+				sizing = { width = 160, height = "FIT" },
+				layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM,
+				childAlignment = { x = llay.AlignX.CENTER },
+				padding = 4,
+			},
+			border = { color = { 255, 0, 0, 255 }, width = { left = 1, right = 1, top = 1, bottom = 1 } },
+		}, function()
+			llay.Text("short label", { fontSize = 10 })
+			llay.Text("two\nlines", { fontSize = 10, wrapMode = llay.TextWrap.NEWLINES })
+			llay.Element({ id = "Small", layout = { sizing = { width = 40, height = 20 } }, backgroundColor = { 1, 2, 3, 255 } })
+		end)
+		llay.Element({
+			id = "Scroll",
+			layout = { sizing = { width = 100, height = 60 }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM },
+			clip = { vertical = true, childOffset = llay.get_scroll_offset() },
+		}, function()
+			for i = 1, 6 do
+				llay.Element({ id = llay.IDI("Item", i), layout = { sizing = { width = "GROW", height = 20 } }, backgroundColor = { 9, 9, 9, 255 } })
+			end
+		end)
+		llay.Element({
+			id = "Popup",
+			layout = { sizing = { width = 50, height = 30 } },
+			floating = {
+				attachTo = llay.FloatingAttachToElement.ELEMENT_WITH_ID,
+				parentId = llay.ID("Small").id,
+				attachPoints = { element = 0, parent = 8 },
+				zIndex = 3,
+			},
+			backgroundColor = { 0, 0, 255, 255 },
+		})
+	end)
+	return llay.end_layout()
+end
+
+local function run_native_engine_matches_lua_engine_regression()
+	if not require("llay_native").load() then
+		return
+	end
+	local function measure(text, config)
+		return { width = #text * 6, height = config.fontSize }
+	end
+	local function frame()
+		llay.set_pointer_state(80, 50, false)
+		llay.update_scroll_containers(false, 0, 0, 0.016)
+		local commands = build_engine_parity_scene()
+		local snap = {}
+		for i = 0, tonumber(commands.length) - 1 do
+			local cmd = commands.internalArray[i]
+			local bb = cmd.boundingBox
+			snap[#snap + 1] = string.format("%d %.3f %.3f %.3f %.3f", tonumber(cmd.commandType), bb.x, bb.y, bb.width, bb.height)
+		end
+		return snap
+	end
+	local function run(options)
+		llay.init(options)
+		llay.set_dimensions(400, 300)
+		llay.set_measure_text_function(measure)
+		-- The Lua engine also culls children scrolled out of their clip; the scene fits
+		-- the viewport, so with culling off both engines emit every element
+		llay.set_culling_enabled(false)
+		frame()
+		llay.set_scroll_offset_for("Scroll", 0, -30)
+		frame()
+		local snap = frame()
+		assert(llay.pointer_over("Small") and llay.pointer_over("Column") and not llay.pointer_over("Scroll"), "pointer_over")
+		local offset = llay.get_scroll_offset_for("Scroll")
+		assert(offset and offset.y == -30, "scroll offset should persist")
+		return snap
+	end
+
+	local expected = run({ capacity = 1024 * 1024 * 16 })
+	local ok, err = pcall(function()
+		local got = run({ capacity = 1024 * 1024 * 16, engine = "native" })
+		assert(llay.get_engine() == "native", "engine should report native")
+		for i = 1, math.max(#got, #expected) do
+			assert(got[i] == expected[i], string.format("native cmd %d: expected '%s', got '%s'", i, tostring(expected[i]), tostring(got[i])))
+		end
+	end)
+	llay.init(1024 * 1024 * 16)
+	assert(ok, err)
+end
+
+local function run_contexts_keep_independent_state_regression()
+	llay.init(1024 * 1024 * 16)
+	local default = llay.get_context()
+	local a = llay.new_context({ capacity = 1024 * 1024 * 8, dims = { width = 300, height = 200 } })
+	local b = llay.new_context({ capacity = 1024 * 1024 * 8, width = 640, height = 480 })
+	assert(llay.get_context() == default, "new_context must not activate the new context")
+
+	local calls = { a = 0, b = 0 }
+	a:set_measure_text_function(function(text, config)
+		calls.a = calls.a + 1
+		return { width = #text * 5, height = 10 }
+	end)
+	b:set_measure_text_function(function(text, config)
+		calls.b = calls.b + 1
+		return { width = #text * 7, height = 14 }
+	end)
+
+	local function frame(ctx, label, pointerY)
+		ctx:set_pointer_state(20, pointerY, false)
+		ctx:update_scroll_containers(false, 0, 0, 0.016)
+		ctx:begin_layout()
+		llay.Element({ id = "Pane", layout = { sizing = { width = "GROW", height = 100 }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM }, clip = { vertical = true, childOffset = llay.get_scroll_offset() } }, function()
+			llay.Text(label, { fontSize = 10 })
+			for i = 1, 10 do
+				llay.Element({ id = llay.IDI("Row", i), layout = { sizing = { width = "GROW", height = 30 } } })
+			end
+		end)
+		llay.Custom({ id = "Canvas", layout = { sizing = { width = 10, height = 10 } } }, function() end)
+		return llay.end_layout()
+	end
+
+	-- Interleave frames: each context keeps its own dims, caches and scroll state
+	for _ = 1, 3 do
+		frame(a, "alpha", 10)
+		frame(b, "beta", 400)
+	end
+	a:set_scroll_offset_for("Pane", 0, -40)
+	local commandsA = frame(a, "alpha", 10)
+	local commandsB = frame(b, "beta", 400)
+	assert(commandsA ~= commandsB, "contexts must not share render command storage")
+
+	a:use()
+	assert(llay.get_context() == a, "use() activates a context")
+	assert(llay.get_element_data("Pane").boundingBox.width == 290, "context a keeps its dims")
+	assert(llay.get_scroll_offset_for("Pane").y == -40, "context a keeps its scroll offset")
+	assert(llay.pointer_over("Pane"), "context a keeps its pointer state")
+	assert(llay.get_render_callback(llay.ID("Canvas").id), "context a keeps its Custom callbacks")
+	b:use()
+	assert(llay.get_element_data("Pane").boundingBox.width == 630, "context b keeps its dims")
+	assert(llay.get_scroll_offset_for("Pane").y == 0, "context b has its own scroll offset")
+	assert(not llay.pointer_over("Pane"), "context b keeps its pointer state")
+	assert(llay.get_render_callback(llay.ID("Canvas").id), "context b keeps its Custom callbacks")
+
+	-- Warm per-context measure caches: no callback on a repeated frame
+	local before = { a = calls.a, b = calls.b }
+	frame(a, "alpha", 10)
+	frame(b, "beta", 400)
+	assert(calls.a == before.a and calls.b == before.b, "measure caches should stay warm across switches")
+	local cmd = find_text_cmd(frame(b, "beta", 400), "beta")
+	assert_close(cmd.boundingBox.width, 28, 0.001, "context b measures with its own function")
+
+	-- Capture is per context
+	a:capture(42)
+	assert(b:get_capture() == nil and a:get_capture() == 42, "capture is per context")
+	a:release_capture()
+
+	llay.use_context(default)
+	llay.init(1024 * 1024 * 16)
+end
+
+local function build_stream_scene(label)
+	llay.Element({
+		id = "Root",
+		layout = { sizing = { width = "GROW", height = "GROW" }, padding = 8, childGap = 4, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM },
+		backgroundColor = { 10, 10, 10, 255 },
+	}, function()
+		llay.Text(label, { fontSize = 20, textColor = { 255, 255, 255, 255 } })
+		llay.Element({ id = "List", layout = { sizing = { width = 120, height = 60 }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM }, clip = { vertical = true } }, function()
+			for i = 1, 5 do
+				llay.Element({ layout = { sizing = { width = "GROW", height = 20 } }, backgroundColor = { i * 40, 0, 0, 255 } })
+			end
+		end)
+		llay.Element({ id = "Badge", layout = { sizing = { width = 30, height = 30 } }, floating = { attachTo = llay.FloatingAttachToElement.PARENT, zIndex = 2 }, border = { color = { 0, 255, 0, 255 }, width = { left = 2 } } })
+	end)
+end
+
+local function snapshot_commands_with_text(commands)
+	local snap = snapshot_commands(commands)
+	for i = 0, tonumber(commands.length) - 1 do
+		local cmd = commands.internalArray[i]
+		if cmd.commandType == llay._core.Llay_RenderCommandType.TEXT then
+			local contents = cmd.renderData.text.stringContents
+			snap[i + 1] = snap[i + 1] .. " " .. ffi.string(contents.chars, contents.length)
+		end
+	end
+	return snap
+end
+
+local function run_declaration_stream_replays_and_worker_matches_regression()
+	local mock = require("tests.helpers.mock")
+	local function frame(n)
+		llay.set_dimensions(400, 300)
+		llay.set_pointer_state(12, 12, false)
+		llay.update_scroll_containers(false, 0, n == 3 and -10 or 0, 0.016)
+		llay.begin_layout()
+		build_stream_scene("frame " .. n)
+		return llay.end_layout()
+	end
+
+	llay.init(1024 * 1024 * 16)
+	llay.set_measure_text_function(mock.create_mock_measure())
+	local default = llay.get_context()
+	local expected = {}
+	for n = 1, 4 do
+		expected[n] = snapshot_commands_with_text(frame(n))
+	end
+	local function check(label, got, want)
+		for i = 1, math.max(#got, #want) do
+			assert(got[i] == want[i], string.format("%s cmd %d: expected '%s', got '%s'", label, i, tostring(want[i]), tostring(got[i])))
+		end
+	end
+
+	-- Standalone: record every frame, replay into a fresh context, and via a file
+	local recorder = llay.new_recorder()
+	local replay = llay.new_context({ width = 400, height = 300 })
+	replay:set_measure_text_function(mock.create_mock_measure())
+	local path = os.tmpname()
+	for n = 1, 4 do
+		recorder:use()
+		local stream = frame(n)
+		assert(llay.get_engine() == "record", "recorder context records")
+		replay:use()
+		check("replay " .. n, snapshot_commands_with_text(llay.replay(stream)), expected[n])
+		if n == 4 then
+			stream:save(path)
+		end
+	end
+	local loaded = llay.load_stream(path)
+	os.remove(path)
+	local reloaded = llay.new_context({ width = 400, height = 300 })
+	reloaded:set_measure_text_function(mock.create_mock_measure())
+	reloaded:use()
+	llay.replay(loaded)
+	assert(#snapshot_commands(llay.replay(loaded)) == #expected[4], "saved stream replays")
+
+	-- Worker thread: same frames laid out off-thread, hover answered from its output
+	local worker = llay.new_worker({ dims = { 400, 300 }, setup = "tests.helpers.worker_setup" })
+	local ok, err = pcall(function()
+		recorder = llay.new_recorder({ hover_source = worker })
+		recorder:use()
+		for n = 1, 4 do
+			worker:submit(frame(n))
+			local commands, number = worker:wait()
+			assert(number == n, "worker frame number")
+			check("worker " .. n, snapshot_commands_with_text(commands), expected[n])
+		end
+		assert(llay.pointer_over("Badge") and not llay.pointer_over("List"), "recorder answers pointer_over from the worker")
+		assert(worker:poll() == nil, "no new frame after wait")
+	end)
+	worker:stop()
+	worker:stop()
+	llay.use_context(default)
+	assert(ok, err)
+
+	-- A worker dropped without stop() is collected, and its finalizer ends the thread
+	local dropped = setmetatable({ llay.new_worker({ dims = { 400, 300 } }) }, { __mode = "v" })
+	collectgarbage("collect")
+	collectgarbage("collect")
+	assert(dropped[1] == nil, "a dropped worker can be collected")
+	llay.init(1024 * 1024 * 16)
+end
+
+local function build_sizing_scene(rows)
+	llay.Element({ id = "Root", layout = { sizing = { width = "GROW", height = "GROW" }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM } }, function()
+		for i = 1, rows do
+			llay.Element({ id = llay.IDI("Row", i), layout = { sizing = { width = "GROW", height = 10 } }, backgroundColor = { 10, 20, 30, 255 } }, function()
+				llay.Text("row label " .. i, { fontSize = 12 })
+			end)
+		end
+	end)
+end
+
+local function run_arena_autosize_grows_and_shrinks_regression()
+	local mock = require("tests.helpers.mock")
+	local function frame(rows)
+		llay.set_pointer_state(5, 15, false)
+		llay.begin_layout()
+		build_sizing_scene(rows)
+		return llay.end_layout()
+	end
+	local function check(label, got, want)
+		for i = 1, math.max(#got, #want) do
+			assert(got[i] == want[i], string.format("%s cmd %d: expected '%s', got '%s'", label, i, tostring(want[i]), tostring(got[i])))
+		end
+	end
+
+	llay.init(1024 * 1024 * 16)
+	llay.set_measure_text_function(mock.create_mock_measure())
+	local expectedSmall = snapshot_commands_with_text(frame(3))
+	local expectedLarge = snapshot_commands_with_text(frame(2000))
+
+	-- A fixed arena that is too small drops the frame instead of erroring
+	llay.init({ capacity = 1024 * 1024 * 4, elements = 64 })
+	llay.set_measure_text_function(mock.create_mock_measure())
+	assert(frame(2000).length == 0, "overflowing frame has no commands")
+	check("fixed after overflow", snapshot_commands_with_text(frame(3)), expectedSmall)
+
+	-- Autosize: start tiny, drop one oversized frame, then lay it out in full
+	llay.init({ autosize = { shrink_after = 10 }, elements = 32, words = 64 })
+	llay.set_measure_text_function(mock.create_mock_measure())
+	check("autosize small", snapshot_commands_with_text(frame(3)), expectedSmall)
+	assert(frame(2000).length == 0, "first oversized frame is dropped")
+	check("autosize grown", snapshot_commands_with_text(frame(2000)), expectedLarge)
+	local grown = llay.get_arena_sizing()
+	assert(grown.autosize and grown.overflows == 1, "one overflow to grow")
+	assert(grown.arrays.layoutElements.capacity > 4000, "element arrays sized from the dropped frame")
+	assert(grown.arrays.treeNodeVisited.capacity == grown.arrays.layoutElements.capacity, "per-element arrays follow layoutElements")
+	assert(grown.elements >= grown.arrays.layoutElements.capacity and grown.words > 64, "persistent arrays grow with the frame")
+	check("autosize warm", snapshot_commands_with_text(frame(2000)), expectedLarge)
+	assert(llay.pointer_over(llay.IDI("Row", 2)), "ids survive the hash map growing")
+
+	-- Sustained small frames hand the memory back
+	for _ = 1, 20 do
+		frame(3)
+	end
+	local shrunk = llay.get_arena_sizing()
+	assert(shrunk.arrays.layoutElements.capacity < 64, "element arrays shrink to the small frames")
+	assert(shrunk.bytes < grown.bytes, "arena shrinks")
+	check("autosize shrunk", snapshot_commands_with_text(frame(3)), expectedSmall)
+	assert(llay.pointer_over(llay.IDI("Row", 2)), "hover after shrinking")
+
+	llay.init(1024 * 1024 * 16)
+end
+
+local function run_virtual_list_declares_only_visible_items_regression()
+	local core = llay._core
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(400, 300)
+	local opened = {}
+	local function frame(count, item_fn)
+		opened = {}
+		llay.begin_layout()
+		llay.VirtualList({
+			id = "Log",
+			count = count,
+			item_size = 20,
+			layout = { sizing = { width = "GROW", height = "GROW" }, childGap = 2 },
+		}, item_fn or function(i)
+			opened[#opened + 1] = i
+		end)
+		return llay.end_layout()
+	end
+	local logId = llay.ID("Log").id
+	local function item_box(seed, i)
+		return core.get_element_data(core.Llay__HashNumber(i, seed).id).boundingBox
+	end
+
+	-- 300px / 22px per row = 14 rows in view, plus 2 overscan after
+	frame(50000)
+	frame(50000)
+	assert(#opened == 16 and opened[1] == 1 and opened[16] == 16, "only visible rows declared, got " .. #opened)
+	local info = llay.get_scroll_info_for("Log")
+	assert_close(info.contentSize.height, 50000 * 22 - 2, 0.5, "contentSize covers every row")
+
+	llay.set_scroll_offset_for("Log", 0, -22000)
+	frame(50000)
+	assert(opened[1] == 999 and opened[#opened] == 1016, "window follows the scroll offset")
+	assert_close(item_box(logId, 1001).y, 0, 0.01, "row 1001 at the top of the viewport")
+	assert_close(llay.get_scroll_info_for("Log").scrollPosition.y, -22000, 0.01, "scroll offset kept")
+
+	-- Shrinking the list clamps the window and the content
+	frame(10)
+	assert(#opened == 10, "short list declares every row")
+	assert_close(llay.get_scroll_info_for("Log").contentSize.height, 10 * 22 - 2, 0.5, "contentSize after shrink")
+
+	-- Variable heights: estimates are replaced by measured sizes on the next frame
+	local estimates = 0
+	local function vframe()
+		opened = {}
+		llay.begin_layout()
+		llay.VirtualList({
+			id = "Feed",
+			count = 1000,
+			estimate_fn = function(i)
+				estimates = estimates + 1
+				return 10
+			end,
+			layout = { sizing = { width = "GROW", height = "GROW" } },
+		}, function(i)
+			opened[#opened + 1] = i
+			llay.Element({ layout = { sizing = { width = 10, height = (i % 3 + 1) * 10 } } })
+		end)
+		return llay.end_layout()
+	end
+	local feedId = llay.ID("Feed").id
+	vframe()
+	assert(#opened == 32, "first frame sizes the window from the estimates")
+	vframe()
+	vframe()
+	local y = 0
+	for i = 1, #opened do
+		assert_close(item_box(feedId, i).y, y, 0.01, "measured row " .. i)
+		y = y + (i % 3 + 1) * 10
+	end
+	assert(y >= 300 and #opened < 20, "window covers the viewport plus overscan")
+	estimates = 0
+	vframe()
+	assert(estimates == 0, "offsets are cached between frames")
+	-- The first frame declared 32 rows; those are measured, the rest keep their estimate
+	local measured = 0
+	for i = 1, 32 do
+		measured = measured + (i % 3 + 1) * 10
+	end
+	local content = llay.get_scroll_info_for("Feed").contentSize.height
+	assert_close(content, measured + (1000 - 32) * 10, 0.5, "unmeasured rows keep their estimate")
+
+	llay.init(1024 * 1024 * 16)
+end
+
+local function run_render_batches_keep_painter_order_regression()
+	local mock = require("tests.helpers.mock")
+	local types = llay.RenderCommandType
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(800, 600)
+	llay.set_measure_text_function(mock.create_mock_measure())
+
+	llay.begin_layout()
+	llay.Element({ id = "Root", layout = { sizing = { width = "GROW", height = "GROW" }, childGap = 8, padding = 8 } }, function()
+		for i = 1, 6 do
+			llay.Element({
+				id = llay.IDI("Card", i),
+				layout = { sizing = { width = "GROW", height = 80 }, padding = 8, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM },
+				backgroundColor = { 30, 30, 40, 255 },
+				cornerRadius = 4,
+				border = { width = 1, color = { 90, 90, 90, 255 } },
+			}, function()
+				llay.Text("Title " .. i, { fontId = 1, fontSize = 16 })
+				llay.Text("body", { fontId = 0, fontSize = 12 })
+			end)
+		end
+		-- A popup over cards 2 and 3: its rect and text must stay above theirs
+		llay.Element({
+			id = "Popup",
+			floating = { attachTo = llay.FloatingAttachToElement.PARENT, offset = { x = 150, y = 20 } },
+			layout = { sizing = { width = 200, height = 40 }, padding = 4 },
+			backgroundColor = { 200, 50, 50, 255 },
+		}, function()
+			llay.Text("Popup", { fontId = 1, fontSize = 16 })
+		end)
+		-- A second popup covering the first one's text: its rect may not join theirs
+		llay.Element({
+			id = "Cover",
+			floating = { attachTo = llay.FloatingAttachToElement.PARENT, offset = { x = 140, y = 10 }, zIndex = 2 },
+			layout = { sizing = { width = 100, height = 60 } },
+			backgroundColor = { 50, 200, 50, 255 },
+		})
+		llay.Element({ id = "Scroll", layout = { sizing = { width = 50, height = "GROW" } }, clip = { vertical = true } }, function()
+			llay.Element({ layout = { sizing = { width = 50, height = 10 } }, backgroundColor = { 1, 2, 3, 255 } })
+		end)
+	end)
+	local commands = llay.end_layout()
+	local batches = llay.new_render_batches(4)
+	batches:build(commands)
+
+	-- Every drawable command lands in exactly one instance carrying its data
+	local drawn = {}
+	local order = {}
+	local drawables = 0
+	for b = 0, batches.count - 1 do
+		local batch = batches.batch[b]
+		for i = batch.first, batch.first + batch.count - 1 do
+			local c = batches.command[i]
+			assert(not drawn[c], "command batched twice")
+			drawn[c] = true
+			order[c] = i
+			local cmd = commands.internalArray[c]
+			assert(cmd.commandType == batch.kind, "batch kind")
+			assert_close(batches.rect[i * 4 + 2], cmd.boundingBox.width, 0.001, "instance width")
+			if batch.kind == types.TEXT then
+				assert(batch.fontId == cmd.renderData.text.fontId, "text batch keyed by font")
+				assert(batches:text(i) == ffi.string(cmd.renderData.text.stringContents.chars, cmd.renderData.text.stringContents.length), "text run")
+			elseif batch.kind == types.RECTANGLE then
+				assert_close(batches.color[i * 4], cmd.renderData.rectangle.backgroundColor.r, 0.001, "rect color")
+				assert_close(batches.radius[i * 4], cmd.renderData.rectangle.cornerRadius.topLeft, 0.001, "rect radius")
+			elseif batch.kind == types.BORDER then
+				assert_close(batches.extra[i * 4], cmd.renderData.border.width.left, 0.001, "border width")
+			end
+		end
+	end
+	for i = 0, tonumber(commands.length) - 1 do
+		drawables = drawables + 1
+		assert(drawn[i], "command " .. i .. " missing from batches")
+	end
+	assert(batches.instanceCount == drawables, "one instance per command")
+
+	-- Overlapping commands draw in their original order; scissors are never crossed
+	local function overlap(a, b)
+		return a.x < b.x + b.width and b.x < a.x + a.width and a.y < b.y + b.height and b.y < a.y + a.height
+	end
+	local function is_scissor(kind)
+		return kind == types.SCISSOR_START or kind == types.SCISSOR_END
+	end
+	for i = 0, tonumber(commands.length) - 1 do
+		local a = commands.internalArray[i]
+		for j = i + 1, tonumber(commands.length) - 1 do
+			local b = commands.internalArray[j]
+			if overlap(a.boundingBox, b.boundingBox) or is_scissor(a.commandType) or is_scissor(b.commandType) then
+				assert(order[i] < order[j], string.format("command %d drawn after overlapping command %d", i, j))
+			end
+		end
+	end
+
+	-- 6 cards of rect + 2 texts + border collapse into a handful of draws
+	assert(batches.count < tonumber(commands.length) / 2, "batches merge non-overlapping commands, got " .. batches.count)
+
+	-- Buffers are reused when the frame fits
+	local rect = batches.rect
+	llay.begin_layout()
+	llay.Element({ layout = { sizing = { width = 10, height = 10 } }, backgroundColor = { 1, 1, 1, 255 } })
+	batches:build(llay.end_layout())
+	assert(batches.rect == rect and batches.count == 1 and batches.instanceCount == 1, "buffers reused")
+
+	llay.init(1024 * 1024 * 16)
+end
+
+-- Runs tests/helpers/steady_frames.lua in its own process: it tunes the JIT, which
+-- would otherwise change trace settings for the rest of the suite
+local function run_steady_frames_stay_compiled_regression()
+	if not jit then
+		return
+	end
+	local interpreter = arg and arg[-1] or "luajit"
+	local pipe = io.popen(interpreter .. " tests/helpers/steady_frames.lua 2>&1")
+	local output = pipe:read("*a")
+	pipe:close()
+	local interpreted, compiled = output:match("interpreted=(%d+) compiled=(%d+)")
+	assert(interpreted, "steady frame probe failed: " .. output)
+	interpreted, compiled = tonumber(interpreted), tonumber(compiled)
+	-- Interpreted, the frame boxes every FFI value it touches (about 1 MB here).
+	-- Compiled, it keeps at most ~15 KB of that, depending on which traces LuaJIT
+	-- settled on; a pass falling back to the interpreter goes well past 50 KB
+	assert(compiled * 20 < interpreted, string.format(
+		"a warm frame allocated %d bytes compiled, %d interpreted", compiled, interpreted))
+end
+
+local function run_id_map_recycles_stale_ids_regression()
+	llay.init({ elements = 64, width = 200, height = 200, evict_after = 4 })
+	llay.set_measure_text_function(function(text, config, userData)
+		return { width = #text * 10, height = 20 }
+	end)
+
+	-- Every frame declares 8 ids never seen before, like a stream of chat messages;
+	-- "Pane" (a scroll container) and "Held" (captured) are only declared in frame 1
+	local function frame(f)
+		llay.begin_layout()
+		llay.Element({ layout = { sizing = { width = "GROW", height = "GROW" } } }, function()
+			if f == 1 then
+				llay.Element({
+					id = "Pane",
+					layout = { sizing = { width = 100, height = 50 } },
+					clip = { vertical = true },
+				}, function()
+					llay.Element({ layout = { sizing = { width = 100, height = 200 } } })
+				end)
+				llay.Element({ id = "Held", layout = { sizing = { width = 10, height = 10 } } })
+			end
+			for k = 1, 8 do
+				llay.Element({ id = llay.IDI("Row", f * 8 + k), layout = { sizing = { width = 10, height = 10 } } })
+			end
+		end)
+		llay.end_layout()
+	end
+
+	frame(1)
+	llay.set_scroll_offset_for("Pane", 0, -20)
+	local held = llay.ID("Held").id
+	llay.capture(held)
+	local evictions = llay.get_id_map_stats().evictions
+	for f = 2, 200 do
+		frame(f)
+		for k = 1, 8 do
+			assert(llay.get_element_data(llay.IDI("Row", f * 8 + k)).found, "new id " .. k .. " found in frame " .. f)
+		end
+		local stats = llay.get_id_map_stats()
+		assert(stats.live + stats.free == stats.slots and stats.slots < stats.capacity, "slots stay bounded")
+		assert(stats.longestChain <= 8, "chains stay short, got " .. stats.longestChain)
+	end
+
+	local stats = llay.get_id_map_stats()
+	assert(stats.evictions - evictions >= 199 * 8 - stats.capacity, "stale ids were evicted, got " .. stats.evictions)
+	assert(not llay.get_element_data(llay.IDI("Row", 16)).found, "an id unseen for 4 frames is gone")
+	assert(llay.get_element_data(llay.IDI("Row", 199 * 8)).found, "an id seen last frame stays")
+	assert(llay.get_element_data("Held").found, "the capture target is kept")
+	assert(llay.get_element_data("Pane").found, "scroll containers are kept")
+	assert(llay.get_scroll_offset_for("Pane").y == -20, "scroll position survives")
+	llay.release_capture()
+
+	-- Profiled frames report evictions and live occupancy
+	llay.Inspector.set_profiling(true)
+	frame(201)
+	frame(202)
+	local frameStats = llay.Inspector.get_frame_stats()
+	assert(frameStats.hashMapEvictions > 0, "frame stats count evictions")
+	assert(frameStats.hashMapOccupancy == llay.get_id_map_stats().live, "occupancy counts live slots")
+	llay.Inspector.set_profiling(false)
+
+	-- evict_after = false keeps every id, and the map fills up as before
+	llay.init({ elements = 64, width = 200, height = 200, evict_after = false })
+	for f = 1, 20 do
+		frame(f)
+	end
+	stats = llay.get_id_map_stats()
+	assert(stats.evictions == 0 and stats.slots == stats.capacity - 1, "no eviction without evict_after")
+
+	llay.init(1024 * 1024 * 16)
+end
+
+local function run_wrap_cache_reuses_lines_regression()
+	local PARAGRAPHS = {
+		"the quick brown fox jumps over the lazy dog",
+		"first line\nsecond line that wraps around\n\nafter a blank line",
+		"a supercalifragilistic word wider than the column",
+	}
+	local function frame(width)
+		llay.set_dimensions(width, 600)
+		llay.begin_layout()
+		llay.Element({ layout = { sizing = { width = "GROW", height = "FIT" }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM } }, function()
+			for i = 1, #PARAGRAPHS do
+				llay.Text(PARAGRAPHS[i], { fontSize = 10, letterSpacing = 1 })
+			end
+			llay.Text("short", { fontSize = 10 })
+		end)
+		return snapshot_commands_with_text(llay.end_layout())
+	end
+	local function setup()
+		llay.init(1024 * 1024 * 16)
+		llay.set_measure_text_function(function(text, config, userData)
+			return { width = #text * 6, height = 10 }
+		end)
+	end
+
+	-- Uncached wraps at two widths, each from a fresh context
+	setup()
+	local wide = frame(130)
+	setup()
+	local narrow = frame(90)
+
+	setup()
+	llay.Inspector.set_profiling(true)
+	assert(table.concat(frame(130), "\n") == table.concat(wide, "\n"), "first wrap")
+	local stats = llay.Inspector.get_frame_stats()
+	assert(stats.wrapCacheMisses == #PARAGRAPHS and stats.wrapCacheHits == 0, "first frame wraps every paragraph")
+
+	assert(table.concat(frame(130), "\n") == table.concat(wide, "\n"), "cached lines match the uncached wrap")
+	stats = llay.Inspector.get_frame_stats()
+	assert(stats.wrapCacheHits == #PARAGRAPHS and stats.wrapCacheMisses == 0, "same width copies cached lines")
+
+	assert(table.concat(frame(90), "\n") == table.concat(narrow, "\n"), "a new width re-wraps")
+	stats = llay.Inspector.get_frame_stats()
+	assert(stats.wrapCacheMisses == #PARAGRAPHS and stats.wrapCacheHits == 0, "width change misses the cache")
+	assert(table.concat(frame(90), "\n") == table.concat(narrow, "\n"), "re-wrapped lines are cached")
+	assert(llay.Inspector.get_frame_stats().wrapCacheHits == #PARAGRAPHS, "hits at the new width")
+	llay.Inspector.set_profiling(false)
+
+	-- Evicted measure items hand their lines back: with room for 256 words, 100 frames
+	-- of fresh paragraphs would run the line pool dry if they leaked
+	llay.init({ elements = 256, words = 256, width = 90, height = 600 })
+	llay.set_measure_text_function(function(text, config, userData)
+		return { width = #text * 6, height = 10 }
+	end)
+	for f = 1, 100 do
+		llay.begin_layout()
+		llay.Element({ layout = { sizing = { width = "GROW", height = "FIT" }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM } }, function()
+			for i = 1, #PARAGRAPHS do
+				llay.Text(PARAGRAPHS[i] .. " " .. f, { fontSize = 10, letterSpacing = 1 })
+			end
+		end)
+		llay.end_layout()
+	end
+	llay.Inspector.set_profiling(true)
+	frame(90)
+	assert(table.concat(frame(90), "\n") == table.concat(narrow, "\n"), "wrap after churn")
+	assert(llay.Inspector.get_frame_stats().wrapCacheHits == #PARAGRAPHS, "line pool still has room after churn")
+	llay.Inspector.set_profiling(false)
+
+	llay.init(1024 * 1024 * 16)
+end
+
+local function run_needs_frame_tracks_visible_changes_regression()
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(300, 200)
+	llay.set_measure_text_function(function(text, config, userData)
+		return { width = #text * 10, height = 20 }
+	end)
+	local label = "count 1"
+	local function frame()
+		llay.begin_layout()
+		llay.Element({ layout = { sizing = { width = "GROW", height = "GROW" } } }, function()
+			llay.Element({
+				id = "Button",
+				layout = { sizing = { width = 100, height = 40 } },
+				backgroundColor = llay.pointer_over("Button") and { 255, 0, 0, 255 } or { 0, 0, 255, 255 },
+			}, function()
+				llay.Text(label, { fontSize = 10 })
+			end)
+			llay.Element({ id = "Pane", layout = { sizing = { width = 100, height = 100 } }, clip = { vertical = true } }, function()
+				llay.Element({ layout = { sizing = { width = 100, height = 400 } }, backgroundColor = { 0, 255, 0, 255 } })
+			end)
+		end)
+		llay.end_layout()
+		return llay.get_render_fingerprint()
+	end
+	-- One host tick: input every time, layout only when asked for
+	local function tick(x, y, down, wheel)
+		llay.set_pointer_state(x, y, down or false)
+		llay.update_scroll_containers(false, 0, wheel or 0, 1 / 60)
+		if llay.needs_frame() then
+			return frame()
+		end
+	end
+	local function settle(x, y)
+		local frames = 0
+		while tick(x, y) do
+			frames = frames + 1
+			assert(frames < 100, "frames should settle")
+		end
+		return frames
+	end
+
+	assert(llay.needs_frame(), "a new context needs its first frame")
+	assert(settle(250, 190) == 2, "first frame, then one that confirms it")
+	assert(not llay.needs_frame(), "idle")
+	local idle = frame()
+	assert(frame() == idle, "identical frames have the same fingerprint")
+	tick(250, 190)
+
+	-- Pointer moves only matter when they change what is under the pointer
+	assert(tick(260, 180) == nil, "moving over the background needs no frame")
+	assert(tick(50, 20) ~= nil, "entering the button does")
+	assert(llay.needs_frame(), "hover color changed the output")
+	settle(50, 20)
+	local hovered = frame()
+	assert(hovered ~= idle, "hover changed the fingerprint")
+	assert(tick(60, 25) == nil, "moving within the button needs no frame")
+	assert(tick(60, 25, true) ~= nil, "pressing does")
+	settle(60, 25)
+	assert(tick(250, 190) ~= nil, "leaving does")
+	settle(250, 190)
+	assert(frame() == idle, "back to the idle output")
+
+	-- Same length, new characters: text commands are compared by content
+	label = "count 2"
+	assert(frame() ~= idle, "new text changes the fingerprint")
+	label = "count 1"
+	frame()
+	settle(250, 190)
+
+	llay.set_dimensions(300, 200)
+	assert(not llay.needs_frame(), "setting the same size")
+	llay.set_dimensions(320, 200)
+	assert(llay.needs_frame(), "resizing")
+	settle(250, 190)
+
+	llay.capture(llay.ID("Button").id)
+	assert(llay.needs_frame(), "capture")
+	settle(250, 190)
+	llay.release_capture()
+	assert(llay.needs_frame(), "release")
+	settle(250, 190)
+
+	-- Wheel over the pane scrolls it
+	assert(tick(150, 50, false, -30) ~= nil, "scrolling")
+	assert(settle(150, 50) > 0, "the scrolled output is new")
+	assert(llay.get_scroll_offset_for("Pane").y < 0, "pane scrolled")
+
+	llay.invalidate()
+	assert(llay.needs_frame(), "invalidate")
+	llay.begin_layout()
+	llay.invalidate()
+	llay.end_layout()
+	assert(llay.needs_frame(), "invalidate during the declaration asks for the next frame")
+
+	llay.init(1024 * 1024 * 16)
+end
+
+local function run_floating_roots_sort_stably_by_z_regression()
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(400, 300)
+	local COUNT = 300
+	local function zOf(i)
+		return (i * 7) % 11 - 5
+	end
+	local function frame()
+		llay.begin_layout()
+		llay.Element({ layout = { sizing = { width = "GROW", height = "GROW" }, padding = { left = 10, top = 20 } } }, function()
+			llay.Element({ id = "Map", layout = { sizing = { width = 200, height = 100 } } }, function()
+				for i = 1, COUNT do
+					llay.Element({
+						layout = { sizing = { width = 4, height = 6 } },
+						backgroundColor = { i % 256, math.floor(i / 256), 1, 255 },
+						floating = {
+							attachTo = llay.FloatingAttachToElement.PARENT,
+							zIndex = zOf(i),
+							attachPoints = { element = i % 9, parent = (i * 4) % 9 },
+							offset = { x = i % 5, y = 0 },
+						},
+					})
+				end
+			end)
+		end)
+		return llay.end_layout()
+	end
+	-- Floating positions read the parent's box from the previous frame
+	frame()
+	local commands = frame()
+
+	local expected = {}
+	for i = 1, COUNT do
+		expected[i] = i
+	end
+	table.sort(expected, function(a, b)
+		if zOf(a) ~= zOf(b) then
+			return zOf(a) < zOf(b)
+		end
+		return a < b
+	end)
+	local seen = 0
+	for i = 0, tonumber(commands.length) - 1 do
+		local cmd = commands.internalArray[i]
+		if cmd.commandType == llay._core.Llay_RenderCommandType.RECTANGLE then
+			local c = cmd.renderData.rectangle.backgroundColor
+			seen = seen + 1
+			local index = c.r + c.g * 256
+			assert(index == expected[seen], "floating roots should render in stable z order")
+			local p, e = (index * 4) % 9, index % 9
+			local x = 10 + 200 * (p % 3) / 2 - 4 * (e % 3) / 2 + index % 5
+			local y = 20 + 100 * math.floor(p / 3) / 2 - 6 * math.floor(e / 3) / 2
+			assert(cmd.boundingBox.x == x and cmd.boundingBox.y == y, "floating root attached at its attach points")
+		end
+	end
+	assert(seen == COUNT, "every floating root rendered")
+
+	-- Already ordered roots are left alone and stay in declaration order
+	llay.sort_z_order()
+	local again = frame()
+	assert(again.length == commands.length, "same command count")
+	for i = 0, tonumber(commands.length) - 1 do
+		assert(again.internalArray[i].renderData.rectangle.backgroundColor.r == commands.internalArray[i].renderData.rectangle.backgroundColor.r, "same order")
+	end
+end
+
+local function run_layers_track_dirty_content_regression()
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(300, 200)
+	llay.set_measure_text_function(function(text, config, userData)
+		return { width = #text * 10, height = 20 }
+	end)
+	local LAYER_BEGIN = llay.RenderCommandType.LAYER_BEGIN
+	local LAYER_END = llay.RenderCommandType.LAYER_END
+	local scrollY, color, badge = 0, 40, "3"
+	local function frame(custom)
+		llay.begin_layout()
+		llay.Element({ layout = { sizing = { width = "GROW", height = "GROW" } }, clip = { vertical = true, childOffset = { x = 0, y = scrollY } } }, function()
+			llay.Element({ layout = { sizing = { width = 10, height = 60 } } })
+			llay.Element({
+				id = "Sidebar",
+				layer = true,
+				layout = { sizing = { width = 200, height = 120 }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM, padding = 5 },
+				backgroundColor = { 20, 20, 30, 255 },
+				border = { color = { 90, 90, 90, 255 }, width = 1 },
+			}, function()
+				llay.Element({ layout = { sizing = { width = 50, height = 30 } }, backgroundColor = { color, 0, 0, 255 } })
+				llay.Text("Projects", { fontSize = 10 })
+				llay.Element({ id = "Badge", layer = true, layout = { sizing = { width = 40, height = 20 } } }, function()
+					llay.Text(badge, { fontSize = 10 })
+				end)
+				if custom then
+					llay.Custom({ id = "Chart", layout = { sizing = { width = 20, height = 20 } } }, function() end)
+				end
+			end)
+		end)
+		local commands = llay.end_layout()
+		local layers = {}
+		for i = 0, tonumber(commands.length) - 1 do
+			local cmd = commands.internalArray[i]
+			if cmd.commandType == LAYER_BEGIN then
+				local last = commands.internalArray[i + cmd.renderData.layer.commandCount + 1]
+				assert(last.commandType == LAYER_END and last.id == cmd.id, "LAYER_END closes its LAYER_BEGIN")
+				assert(last.renderData.layer.fingerprint == cmd.renderData.layer.fingerprint, "both ends carry the fingerprint")
+				layers[#layers + 1] = {
+					y = cmd.boundingBox.y,
+					count = cmd.renderData.layer.commandCount,
+					fingerprint = cmd.renderData.layer.fingerprint,
+					dirty = cmd.renderData.layer.dirty,
+				}
+			end
+		end
+		assert(#layers == 2, "a layer and the layer nested in it")
+		return layers[1], layers[2]
+	end
+
+	local sidebar, nested = frame()
+	assert(sidebar.dirty and nested.dirty, "new layers are dirty")
+	assert(sidebar.count > nested.count + 2, "the outer layer holds the nested one")
+	local again = frame()
+	assert(not again.dirty and again.fingerprint == sidebar.fingerprint, "unchanged layer is clean")
+
+	-- Scrolling moves the layer, partly out of view, without changing it
+	scrollY = -110.37
+	local moved, movedNested = frame()
+	assert(moved.y ~= sidebar.y, "layer moved")
+	assert(not moved.dirty and not movedNested.dirty, "translation keeps layers clean")
+	assert(moved.count == sidebar.count, "nothing inside a layer is culled")
+	assert(moved.fingerprint == sidebar.fingerprint, "fingerprint is relative to the layer origin")
+
+	color = 41
+	local recolored, recoloredNested = frame()
+	assert(recolored.dirty and not recoloredNested.dirty, "a changed child dirties only its layer")
+	badge = "4"
+	local relabeled, relabeledNested = frame()
+	assert(relabeledNested.dirty and relabeled.dirty, "a dirty nested layer dirties the enclosing one")
+	assert(not frame().dirty, "clean again")
+
+	llay.invalidate()
+	assert(frame().dirty, "invalidate() dirties every layer")
+	frame(true)
+	assert(frame(true).dirty, "a layer with a render callback is redrawn every frame")
+
+	-- Layer commands are barriers for render batches
+	local batches = llay.new_render_batches()
+	llay.begin_layout()
+	llay.Element({ layer = true, layout = { sizing = { width = 20, height = 20 } }, backgroundColor = { 1, 2, 3, 255 } })
+	llay.Element({ layout = { sizing = { width = 20, height = 20 } }, backgroundColor = { 1, 2, 3, 255 } })
+	batches:build(llay.end_layout())
+	assert(batches.count == 4, "rectangles on either side of a LAYER_END are not merged")
+end
+
+local function run_culling_skips_offscreen_subtrees_regression()
+	local RECTANGLE = llay.RenderCommandType.RECTANGLE
+	local scrollY, dotWidth = -200, 20
+	local function frame()
+		llay.begin_layout()
+		llay.Element({
+			id = "List",
+			layout = { sizing = { width = 200, height = 100 }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM },
+			clip = { vertical = true, childOffset = { x = 0, y = scrollY } },
+		}, function()
+			for i = 0, 49 do
+				llay.Element({
+					id = llay.IDI("Row", i),
+					layout = { sizing = { width = "GROW", height = 20 }, childAlignment = { x = llay.AlignX.CENTER } },
+					backgroundColor = { 30, 30, 30, 255 },
+				}, function()
+					llay.Element({
+						id = llay.IDI("Dot", i),
+						layout = { sizing = { width = dotWidth, height = 10 } },
+						backgroundColor = { 200, 0, 0, 255 },
+					})
+				end)
+			end
+		end)
+		local commands = llay.end_layout()
+		local rects = {}
+		for i = 0, tonumber(commands.length) - 1 do
+			local cmd = commands.internalArray[i]
+			if cmd.commandType == RECTANGLE then
+				local bb = cmd.boundingBox
+				rects[#rects + 1] = string.format("%d %.2f %.2f %.2f %.2f", tonumber(cmd.id), bb.x, bb.y, bb.width, bb.height)
+			end
+		end
+		return rects
+	end
+	local function visible(rects)
+		local out = {}
+		for _, line in ipairs(rects) do
+			local y, h = line:match("^%d+ %S+ (%S+) %S+ (%S+)$")
+			if tonumber(y) <= 100 and tonumber(y) + tonumber(h) >= 0 then
+				out[#out + 1] = line
+			end
+		end
+		return out
+	end
+
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(400, 300)
+	llay.set_culling_enabled(false)
+	local full = frame()
+	assert(#full == 100, "without culling every row and dot is emitted")
+
+	llay.set_culling_enabled(true)
+	llay.set_profiling_enabled(true, 4)
+	frame()
+	local culled = frame()
+	local stats = llay.get_frame_stats()
+	llay.set_profiling_enabled(false)
+	-- Rows 9..15 touch the clip (0..100 after scrolling 200), as do the dots of rows
+	-- 10..15; the other rows are culled and their dots never visited
+	assert(#culled == 13, "only rows meeting the clip should be emitted, got " .. #culled)
+	local expected = visible(full)
+	for i = 1, math.max(#culled, #expected) do
+		assert(culled[i] == expected[i], string.format("rect %d: expected '%s', got '%s'", i, tostring(expected[i]), tostring(culled[i])))
+	end
+	assert(stats.elementsEmitted == 15, "root, list, 7 rows and 6 dots are emitted, got " .. stats.elementsEmitted)
+	assert(stats.elementsCulled == 44, "43 rows and one dot are culled, got " .. stats.elementsCulled)
+	assert(stats.elementsSkipped == 43, "43 dots are skipped, got " .. stats.elementsSkipped)
+	assert(stats.elementsEmitted + stats.elementsCulled + stats.elementsSkipped == stats.elementCount, "counts cover every element")
+
+	-- Culled rows are still placed; skipped dots keep an old box and can't be hit
+	llay.set_pointer_state(100, 145, false)
+	assert(llay.pointer_over(llay.IDI("Row", 17)), "culled row keeps its box")
+	assert(not llay.pointer_over(llay.IDI("Dot", 17)), "skipped dot must not be hit")
+	local row = llay.get_rect(llay.IDI("Row", 17))
+	assert(row.found and row.y == 140, "culled row is placed this frame")
+
+	-- Positions memoized while visible must not be reused after the dots changed
+	-- while skipped
+	local function sequence(incremental)
+		llay.init(1024 * 1024 * 16)
+		llay.set_dimensions(400, 300)
+		llay.set_incremental_layout_enabled(incremental)
+		scrollY, dotWidth = 0, 20
+		frame()
+		frame()
+		scrollY, dotWidth = -400, 40
+		frame()
+		frame()
+		scrollY = 0
+		frame()
+		return frame()
+	end
+	local plain = sequence(false)
+	local memoized = sequence(true)
+	for i = 1, math.max(#plain, #memoized) do
+		assert(memoized[i] == plain[i], string.format("incremental rect %d: expected '%s', got '%s'", i, tostring(plain[i]), tostring(memoized[i])))
+	end
+	llay.init(1024 * 1024 * 16)
+end
+
+local function run_measure_cache_snapshot_warm_starts_regression()
+	local calls = 0
+	local function measure(text, config)
+		calls = calls + 1
+		return { width = #text * 7 + config.fontSize, height = config.fontSize }
+	end
+	local function frame()
+		llay.begin_layout()
+		llay.Element({ layout = { sizing = { width = 300, height = "GROW" }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM } }, function()
+			llay.Text("Warm starts skip the measure function", { fontSize = 12 })
+			llay.Text("Two lines\nof text", { fontSize = 16 })
+			llay.Text("", { fontSize = 12 })
+			for i = 1, 20 do
+				llay.Text("Row " .. i .. " with several short words to wrap around", { fontSize = 10 + i % 3 })
+			end
+		end)
+		return snapshot_commands_with_text(llay.end_layout())
+	end
+	local function start()
+		llay.init(1024 * 1024 * 16)
+		llay.set_dimensions(400, 600)
+		llay.set_measure_text_function(measure)
+		calls = 0
+	end
+
+	start()
+	local cold = frame()
+	assert(calls > 0, "a cold start measures")
+	local path = os.tmpname()
+	assert(llay.save_measure_cache(path, "fonts-v1") > 0, "snapshot written")
+	local bytes = llay.snapshot_measure_cache("fonts-v1")
+
+	start()
+	local loaded = llay.load_measure_cache(path, "fonts-v1")
+	os.remove(path)
+	assert(loaded == 23, "every cached text is loaded, got " .. tostring(loaded))
+	local warm = frame()
+	assert(calls == 0, "a warm start measures nothing, got " .. calls .. " calls")
+	for i = 1, math.max(#cold, #warm) do
+		assert(warm[i] == cold[i], string.format("cmd %d: expected '%s', got '%s'", i, tostring(cold[i]), tostring(warm[i])))
+	end
+	assert(llay.restore_measure_cache(bytes, "fonts-v1") == 0, "cached texts are not loaded twice")
+
+	start()
+	local count, err = llay.restore_measure_cache(bytes, "fonts-v2")
+	assert(count == nil and err:find("tag"), "a snapshot of another font set is rejected")
+	assert(llay.restore_measure_cache("not a snapshot", "fonts-v1") == nil, "garbage is rejected")
+	assert(llay.restore_measure_cache(bytes:sub(1, #bytes - 8), "fonts-v1") == nil, "truncated snapshots are rejected")
+	-- Push the last word of the last entry past its text: rejected before anything is added
+	local ffi = require("ffi")
+	local corrupt = ffi.new("uint32_t[?]", #bytes / 4)
+	ffi.copy(corrupt, bytes, #bytes)
+	corrupt[#bytes / 4 - 3] = 1000
+	count, err = llay.restore_measure_cache(ffi.string(corrupt, #bytes), "fonts-v1")
+	assert(count == nil and err:find("corrupt"), "a word outside its text is rejected")
+	corrupt[#bytes / 4 - 3] = 0xffffffff
+	assert(llay.restore_measure_cache(ffi.string(corrupt, #bytes), "fonts-v1") == nil, "a negative word offset is rejected")
+	assert(llay.load_measure_cache(path, "fonts-v1") == nil, "a missing file loads nothing")
+	frame()
+	assert(calls > 0, "a rejected snapshot leaves a cold cache")
+	llay.init(1024 * 1024 * 16)
+end
+
+local function run_raster_draws_commands_regression()
+	local raster_module = require("llay_raster")
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(64, 48)
+	llay.set_measure_text_function(raster_module.measure_text)
+
+	local painted
+	llay.begin_layout()
+	llay.Element({ layout = { sizing = { width = "GROW", height = "GROW" }, padding = 4, childGap = 4 } }, function()
+		llay.Element({
+			id = "Rounded",
+			layout = { sizing = { width = 20, height = 20 } },
+			backgroundColor = { 255, 0, 0, 255 },
+			cornerRadius = 8,
+		}, function()
+			llay.Element({
+				layout = { sizing = { width = 10, height = 10 } },
+				backgroundColor = { 0, 0, 255, 128 },
+				floating = { attachTo = llay.FloatingAttachToElement.ROOT, offset = { x = 40, y = 30 } },
+			})
+		end)
+		llay.Element({ layout = { sizing = { width = 12, height = 12 } }, clip = { horizontal = true, vertical = true } }, function()
+			llay.Element({ layout = { sizing = { width = 30, height = 30 } }, backgroundColor = { 0, 255, 0, 255 } })
+		end)
+		llay.Custom({ id = "Painted", layout = { sizing = { width = 8, height = 8 } } }, function(rect, painter)
+			painted = rect.x
+			painter:rect(rect, { r = 255, g = 255, b = 0, a = 255 })
+		end)
+	end)
+	local commands = llay.end_layout()
+
+	local raster = llay.new_raster(64, 48)
+	raster:clear(0, 0, 0, 255)
+	raster:draw(commands)
+	local function expect(x, y, r, g, b, label)
+		local pr, pg, pb = raster:pixel(x, y)
+		assert(pr == r and pg == g and pb == b,
+			string.format("%s: pixel (%d, %d) expected %d,%d,%d, got %d,%d,%d", label, x, y, r, g, b, pr, pg, pb))
+	end
+	expect(14, 14, 255, 0, 0, "rect interior")
+	expect(4, 4, 0, 0, 0, "outside the rounded corner")
+	expect(30, 10, 0, 255, 0, "clipped child inside the scissor")
+	expect(40, 10, 0, 0, 0, "clipped child beyond the scissor")
+	expect(44, 34, 0, 0, 128, "translucent overlay blends over the clear color")
+	assert(painted == 44, "custom callback receives its box, got " .. tostring(painted))
+	expect(46, 6, 255, 255, 0, "custom painter")
+
+	local ppm = raster:to_ppm()
+	assert(ppm:sub(1, 12) == "P6\n64 48\n255" and #ppm == 13 + 64 * 48 * 3, "ppm header and size")
+	assert(raster:to_png():sub(1, 8) == "\137PNG\r\n\26\n", "png signature")
+	llay.init(1024 * 1024 * 16)
+end
+
+local function run_culled_subtree_rects_not_stale_regression()
+	local scrollY = 0
+	local function frame()
+		llay.begin_layout()
+		llay.Element({
+			id = "List",
+			layout = { sizing = { width = 200, height = 100 }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM },
+			clip = { vertical = true, childOffset = { x = 0, y = scrollY } },
+		}, function()
+			for i = 0, 49 do
+				llay.Element({ id = llay.IDI("Row", i), layout = { sizing = { width = "GROW", height = 20 }, padding = 5 } }, function()
+					llay.Element({ id = llay.IDI("Inner", i), layout = { sizing = { width = 10, height = 10 } } })
+				end)
+			end
+		end)
+		llay.end_layout()
+	end
+
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(400, 300)
+	frame()
+	local inner = llay.get_rect(llay.IDI("Inner", 2))
+	assert(inner.found and inner.y == 45, "visible grandchild is placed, got " .. tostring(inner.y))
+
+	-- Row 2 scrolls out of the clip: it is culled and its subtree skipped
+	scrollY = -990
+	frame()
+	local row = llay.get_rect(llay.IDI("Row", 2))
+	assert(row.found and row.y == -950, "culled row is placed this frame, got " .. tostring(row.y))
+	assert(not llay.get_rect(llay.IDI("Inner", 2)).found, "skipped grandchild must not report last frame's box")
+	assert(not llay.get_element_data(llay.IDI("Inner", 2)).found, "get_element_data agrees with get_rect")
+	inner = llay.get_rect(llay.IDI("Inner", 49))
+	assert(inner.found and inner.y == 5 + 49 * 20 - 990, "visible grandchild follows the scroll, got " .. tostring(inner.y))
+
+	-- While the next frame is declared, boxes from the last layout still count
+	llay.begin_layout()
+	assert(llay.get_rect(llay.IDI("Inner", 49)).found, "mid-frame reads see the last layout")
+	assert(not llay.get_rect(llay.IDI("Inner", 2)).found, "mid-frame reads skip stale boxes")
+	llay.end_layout()
+
+	-- Scrolling back places the grandchild again
+	scrollY = 0
+	frame()
+	inner = llay.get_rect(llay.IDI("Inner", 2))
+	assert(inner.found and inner.y == 45, "grandchild is placed again, got " .. tostring(inner.y))
+	llay.init(1024 * 1024 * 16)
+end
+
+local function run_layer_with_clip_stays_clean_when_moved_regression()
+	llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(300, 200)
+	local scrollY = 0
+	local function frame()
+		llay.begin_layout()
+		llay.Element({ layout = { sizing = { width = "GROW", height = "GROW" } }, clip = { vertical = true, childOffset = { x = 0, y = scrollY } } }, function()
+			llay.Element({ layout = { sizing = { width = 10, height = 60 } } })
+			llay.Element({
+				id = "Panel",
+				layer = true,
+				layout = { sizing = { width = 200, height = 120 }, padding = 5 },
+				backgroundColor = { 20, 20, 30, 255 },
+			}, function()
+				llay.Element({ layout = { sizing = { width = 100, height = 50 } }, clip = { vertical = true } }, function()
+					llay.Element({ layout = { sizing = { width = 100, height = 80 } }, backgroundColor = { 200, 0, 0, 255 } })
+				end)
+			end)
+		end)
+		local commands = llay.end_layout()
+		for i = 0, tonumber(commands.length) - 1 do
+			local cmd = commands.internalArray[i]
+			if cmd.commandType == llay.RenderCommandType.LAYER_BEGIN then
+				return cmd.renderData.layer.dirty, cmd.boundingBox.y
+			end
+		end
+		error("the panel emits a layer")
+	end
+
+	assert(frame(), "a new layer is dirty")
+	assert(not frame(), "an unchanged layer is clean")
+	scrollY = -30
+	local dirty, y = frame()
+	assert(y == -30, "the layer moved, got " .. y)
+	assert(not dirty, "moving a layer with a clip inside keeps it clean")
+	scrollY = -45.5
+	assert(not frame(), "moving it again keeps it clean")
+	llay.init(1024 * 1024 * 16)
+end
+
+local function run_interned_id_strings_survive_cache_wipe_regression()
+	local context = llay.init(1024 * 1024 * 16)
+	llay.set_dimensions(400, 300)
+	llay.begin_layout()
+	llay.Element({ layout = { sizing = { width = "GROW", height = "GROW" } } }, function()
+		for i = 1, 8 do
+			llay.Element({ id = llay.ID("Row_" .. i), layout = { sizing = { width = 10, height = 10 } } })
+		end
+		-- Wipe the ID cache mid-frame, then let the rows' handles and strings be
+		-- collected and their memory reused
+		for i = 1, 16384 do
+			llay.ID("Churn_" .. i)
+		end
+		collectgarbage("collect")
+		collectgarbage("collect")
+		local fill = {}
+		for i = 1, 20000 do
+			fill[i] = string.format("%-6d", i)
+		end
+	end)
+	llay.end_layout()
+
+	local idStrings = context.layoutElementIdStrings
+	local names = {}
+	for i = 0, idStrings.length - 1 do
+		local s = idStrings.internalArray[i]
+		if s.length > 0 then
+			names[#names + 1] = ffi.string(s.chars, s.length)
+		end
+	end
+	for i = 1, 8 do
+		assert(names[i + 1] == "Row_" .. i, string.format("id string %d: expected 'Row_%d', got '%s'", i, i, tostring(names[i + 1])))
+	end
+	-- Hash-map items persist across frames, so they keep no pointer to the string
+	for i = 1, 8 do
+		local item = llay._core._get_hash_map_item(llay.ID("Row_" .. i).id)
+		assert(item ~= nil and item.elementId.stringId.chars == nil and item.elementId.stringId.length == 0,
+			"hash-map item " .. i .. " holds no string pointer")
+	end
+	llay.init(1024 * 1024 * 16)
+end
+
+local function run_recorder_accepts_clay_string_text_regression()
+	local mock = require("tests.helpers.mock")
+	local label = "Clay string label"
+	local clayString = ffi.new("Clay_String", { length = #label, chars = label })
+	local function frame(text)
+		llay.set_dimensions(400, 300)
+		llay.begin_layout()
+		llay.Element({ layout = { sizing = { width = "GROW", height = "GROW" }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM } }, function()
+			llay.Text(text, { fontSize = 20 })
+			llay.Text("plain", { fontSize = 16 })
+		end)
+		return llay.end_layout()
+	end
+
+	llay.init(1024 * 1024 * 16)
+	llay.set_measure_text_function(mock.create_mock_measure())
+	local default = llay.get_context()
+	local expected = snapshot_commands_with_text(frame(label))
+	local direct = snapshot_commands_with_text(frame(clayString))
+
+	local recorder = llay.new_recorder()
+	recorder:use()
+	local stream = frame(clayString)
+	llay.use_context(default)
+	local replayed = snapshot_commands_with_text(llay.replay(stream))
+	for i = 1, math.max(#expected, #direct, #replayed) do
+		assert(direct[i] == expected[i], string.format("direct cmd %d: expected '%s', got '%s'", i, tostring(expected[i]), tostring(direct[i])))
+		assert(replayed[i] == expected[i], string.format("replayed cmd %d: expected '%s', got '%s'", i, tostring(expected[i]), tostring(replayed[i])))
+	end
+	llay.init(1024 * 1024 * 16)
+end
+
+-- Lines as Clay wraps them into a 60px column at 6px per character: a line closed
+-- by the next word drops its trailing space, text that fits as measured keeps its
+-- own width, and a word wider than the column gets a line to itself
+local function build_wrap_scene()
+	llay.begin_layout()
+	llay.Element({ layout = { sizing = { width = 60, height = "FIT" }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM } }, function()
+		llay.Text("aaa bbb ccc dd", { fontSize = 10 })
+		llay.Text("fits", { fontSize = 10 })
+		llay.Text("trailing ", { fontSize = 10 })
+		llay.Text("one\ntwo three four", { fontSize = 10, letterSpacing = 2 })
+		llay.Text("supercalifragilistic word", { fontSize = 10 })
+	end)
+	local commands = llay.end_layout()
+	local lines = {}
+	for i = 0, tonumber(commands.length) - 1 do
+		local cmd = commands.internalArray[i]
+		local bb = cmd.boundingBox
+		local contents = cmd.renderData.text.stringContents
+		lines[#lines + 1] = string.format("%.3f %.3f %.3f %.3f '%s'", bb.x, bb.y, bb.width, bb.height, ffi.string(contents.chars, contents.length))
+	end
+	return lines
+end
+
+local function run_wrapped_lines_match_clay_regression()
+	local CLAY_LINES = {
+		"0.000 0.000 42.000 10.000 'aaa bbb'",
+		"0.000 10.000 36.000 10.000 'ccc dd'",
+		"0.000 20.000 24.000 10.000 'fits'",
+		"0.000 30.000 54.000 10.000 'trailing '",
+		"0.000 40.000 20.000 10.000 'one'",
+		"0.000 50.000 20.000 10.000 'two'",
+		"0.000 60.000 32.000 10.000 'three'",
+		"0.000 70.000 24.000 10.000 'four'",
+		"0.000 80.000 126.000 10.000 'supercalifragilistic '",
+		"0.000 90.000 24.000 10.000 'word'",
+	}
+	local function run(options)
+		llay.init(options)
+		llay.set_dimensions(400, 300)
+		llay.set_measure_text_function(function(text, config)
+			return { width = #text * 6, height = config.fontSize }
+		end)
+		build_wrap_scene()
+		local lines = build_wrap_scene()
+		for i = 1, math.max(#lines, #CLAY_LINES) do
+			assert(lines[i] == CLAY_LINES[i], string.format("line %d: expected \"%s\", got \"%s\"", i, tostring(CLAY_LINES[i]), tostring(lines[i])))
+		end
+	end
+
+	run(1024 * 1024 * 16)
+	-- Keeps CLAY_LINES honest when the native engine is built
+	if require("llay_native").load() then
+		local ok, err = pcall(run, { capacity = 1024 * 1024 * 16, engine = "native" })
+		llay.init(1024 * 1024 * 16)
+		assert(ok, err)
+	end
+	llay.init(1024 * 1024 * 16)
+end
+
+-- Anonymous siblings of every kind, including a text sibling right after a box and
+-- siblings after a floating element
+local function build_anonymous_id_scene()
+	llay.begin_layout()
+	llay.Element({ layout = { sizing = { width = 60, height = "FIT" }, layoutDirection = llay.LayoutDirection.TOP_TO_BOTTOM } }, function()
+		llay.Element({ layout = { sizing = { width = 10, height = 10 } }, backgroundColor = { 1, 2, 3, 255 } })
+		llay.Text("after a box", { fontSize = 10 })
+		llay.Element({ layout = { sizing = { width = 10, height = 10 } }, backgroundColor = { 1, 2, 3, 255 } }, function()
+			llay.Text("x", { fontSize = 10 })
+			llay.Element({ layout = { sizing = { width = 5, height = 5 } }, backgroundColor = { 1, 2, 3, 255 } })
+		end)
+		llay.Element({
+			layout = { sizing = { width = 5, height = 5 } },
+			floating = { attachTo = llay.FloatingAttachToElement.PARENT },
+			backgroundColor = { 1, 2, 3, 255 },
+		})
+		llay.Text("after a float", { fontSize = 10 })
+		llay.Element({ layout = { sizing = { width = 10, height = 10 } }, backgroundColor = { 1, 2, 3, 255 } })
+	end)
+	return llay.end_layout()
+end
+
+local function run_anonymous_ids_match_clay_regression()
+	-- Command type and id per command, as Clay emits them
+	local CLAY_IDS = {
+		"1 805335866",
+		"3 1365369013",
+		"3 2184102474",
+		"1 1332490773",
+		"3 3249732723",
+		"1 1430038197",
+		"3 3302871641",
+		"3 3616896968",
+		"1 1579372423",
+		"1 969705178",
+	}
+	local TEXT = llay._core.Llay_RenderCommandType.TEXT
+	local function run(options, incremental)
+		llay.init(options)
+		llay.set_dimensions(400, 300)
+		llay.set_measure_text_function(function(text, config)
+			return { width = #text * 6, height = config.fontSize }
+		end)
+		-- Incremental layout serves the second frame from the subtree memo
+		llay.set_incremental_layout_enabled(incremental)
+		build_anonymous_id_scene()
+		local commands = build_anonymous_id_scene()
+		local line, lastId = 0, nil
+		for i = 0, tonumber(commands.length) - 1 do
+			local cmd = commands.internalArray[i]
+			local id = tonumber(cmd.id)
+			-- Clay ids line n of a text element HashNumber(n, element id); llay keeps the
+			-- element's id on every line so the element can be looked up from it
+			if cmd.commandType == TEXT and llay.get_engine() ~= "native" then
+				line = id == lastId and line + 1 or 0
+				lastId = id
+				id = llay._core.Llay__HashNumber(line, id).id
+			end
+			local got = string.format("%d %u", tonumber(cmd.commandType), id)
+			assert(got == CLAY_IDS[i + 1], string.format("cmd %d: expected '%s', got '%s'", i, tostring(CLAY_IDS[i + 1]), got))
+		end
+		assert(tonumber(commands.length) == #CLAY_IDS, "command count")
+	end
+
+	run(1024 * 1024 * 16, false)
+	run(1024 * 1024 * 16, true)
+	llay.set_incremental_layout_enabled(false)
+	-- Keeps CLAY_IDS honest when the native engine is built
+	if require("llay_native").load() then
+		local ok, err = pcall(run, { capacity = 1024 * 1024 * 16, engine = "native" }, false)
+		llay.init(1024 * 1024 * 16)
+		assert(ok, err)
+	end
+	llay.init(1024 * 1024 * 16)
+end
+
 return {
 	{
 		name = "regression_text_element_bbox_matches_measured",
@@ -654,4 +2630,120 @@ return {
 		name = "regression_get_hit_path_parent_bubbling",
 		fn = run_get_hit_path_parent_bubbling_regression,
 	},
+	{
+		name = "regression_incremental_layout_matches_full_layout",
+		fn = run_incremental_layout_matches_full_layout_regression,
+	},
+	{
+		name = "regression_compiled_styles_match_table_configs",
+		fn = run_compiled_styles_match_table_configs_regression,
+	},
+	{
+		name = "regression_compiled_custom_matches_table_custom",
+		fn = run_compiled_custom_matches_table_custom_regression,
+	},
+	{
+		name = "regression_interned_ids_match_uncached_hashes",
+		fn = run_interned_ids_match_uncached_hashes_regression,
+	},
+	{
+		name = "regression_batched_and_glyph_text_measurement_match_callback",
+		fn = run_batched_and_glyph_text_measurement_match_callback_regression,
+	},
+	{
+		name = "regression_glyph_advances_measure_utf8_bytes",
+		fn = run_glyph_advances_measure_utf8_bytes_regression,
+	},
+	{
+		name = "regression_hit_test_index_matches_tree_walk",
+		fn = run_hit_test_index_matches_tree_walk_regression,
+	},
+	{
+		name = "regression_profiler_records_phases_and_counters",
+		fn = run_profiler_records_phases_and_counters_regression,
+	},
+	{
+		name = "regression_native_engine_matches_lua_engine",
+		fn = run_native_engine_matches_lua_engine_regression,
+	},
+	{
+		name = "regression_contexts_keep_independent_state",
+		fn = run_contexts_keep_independent_state_regression,
+	},
+	{
+		name = "regression_declaration_stream_replays_and_worker_matches",
+		fn = run_declaration_stream_replays_and_worker_matches_regression,
+	},
+	{
+		name = "regression_arena_autosize_grows_and_shrinks",
+		fn = run_arena_autosize_grows_and_shrinks_regression,
+	},
+	{
+		name = "regression_virtual_list_declares_only_visible_items",
+		fn = run_virtual_list_declares_only_visible_items_regression,
+	},
+	{
+		name = "regression_render_batches_keep_painter_order",
+		fn = run_render_batches_keep_painter_order_regression,
+	},
+	{
+		name = "regression_steady_frames_stay_compiled",
+		fn = run_steady_frames_stay_compiled_regression,
+	},
+	{
+		name = "regression_id_map_recycles_stale_ids",
+		fn = run_id_map_recycles_stale_ids_regression,
+	},
+	{
+		name = "regression_wrap_cache_reuses_lines",
+		fn = run_wrap_cache_reuses_lines_regression,
+	},
+	{
+		name = "regression_needs_frame_tracks_visible_changes",
+		fn = run_needs_frame_tracks_visible_changes_regression,
+	},
+	{
+		name = "regression_floating_roots_sort_stably_by_z",
+		fn = run_floating_roots_sort_stably_by_z_regression,
+	},
+	{
+		name = "regression_layers_track_dirty_content",
+		fn = run_layers_track_dirty_content_regression,
+	},
+	{
+		name = "regression_culling_skips_offscreen_subtrees",
+		fn = run_culling_skips_offscreen_subtrees_regression,
+	},
+	{
+		name = "regression_measure_cache_snapshot_warm_starts",
+		fn = run_measure_cache_snapshot_warm_starts_regression,
+	},
+	{
+		name = "regression_raster_draws_commands",
+		fn = run_raster_draws_commands_regression,
+	},
+	{
+		name = "regression_culled_subtree_rects_not_stale",
+		fn = run_culled_subtree_rects_not_stale_regression,
+	},
+	{
+		name = "regression_layer_with_clip_stays_clean_when_moved",
+		fn = run_layer_with_clip_stays_clean_when_moved_regression,
+	},
+	{
+		name = "regression_interned_id_strings_survive_cache_wipe",
+		fn = run_interned_id_strings_survive_cache_wipe_regression,
+	},
+	{
+		name = "regression_recorder_accepts_clay_string_text",
+		fn = run_recorder_accepts_clay_string_text_regression,
+	},
+	{
+		name = "regression_wrapped_lines_match_clay",
+		fn = run_wrapped_lines_match_clay_regression,
+	},
+	{
+		name = "regression_anonymous_ids_match_clay",
+		fn = run_anonymous_ids_match_clay_regression,
+	},
 }